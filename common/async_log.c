@@ -0,0 +1,371 @@
+/**
+ * Asynchronous Logging Implementation
+ *
+ * Every thread that logs gets a ring of fixed-size records on first use.
+ * The thread is the ring's only producer and the flusher its only
+ * consumer, so head and tail are plain atomics with acquire/release
+ * ordering. Rings of exited threads are freed by the flusher once drained.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "async_log.h"
+
+// Constants
+#define RING_SLOTS 256              // Records per thread, must be a power of two
+#define RECORD_TEXT 232             // Message bytes per record; longer ones are cut
+#define CACHE_LINE_SIZE 64
+#define FLUSH_INTERVAL_MS 10        // Flusher sleep when every ring is empty
+#define WRITE_BUFFER_SIZE 65536     // Bytes gathered per write(2)
+#define LINE_PREFIX_SIZE 32         // "YYYY-MM-DD HH:MM:SS.mmm LEVEL "
+
+// One formatted message waiting for the flusher
+typedef struct {
+    struct timespec time;
+    async_log_level_t level;
+    unsigned int length;
+    char text[RECORD_TEXT];
+} log_record_t;
+
+// Per-thread record ring
+typedef struct log_ring {
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head;   // Next record to flush
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail;   // Next record to fill
+    atomic_size_t dropped;          // Messages lost to a full ring
+    atomic_int orphaned;            // Owning thread has exited
+    struct log_ring *next;          // Link in the ring registry
+    log_record_t records[RING_SLOTS];
+} log_ring_t;
+
+// Global variables
+atomic_int async_log_threshold = ASYNC_LOG_INFO;
+
+static const char *level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+static atomic_int logger_running = 0;
+static atomic_int flusher_stop = 0;
+static pthread_t flusher_thread;
+static int output_fd = -1;
+static log_ring_t *rings = NULL;
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local log_ring_t *local_ring = NULL;
+
+/**
+ * Mark the ring of an exiting thread for the flusher to free
+ * @param arg Ring of the exiting thread
+ */
+static void release_ring(void *arg) {
+    log_ring_t *ring = (log_ring_t *)arg;
+    atomic_store_explicit(&ring->orphaned, 1, memory_order_release);
+}
+
+// Create the key whose destructor orphans a thread's ring
+static void make_ring_key(void) {
+    if (pthread_key_create(&ring_key, release_ring) != 0) {
+        perror("Failed to create log ring key");
+    }
+}
+
+/**
+ * Get the calling thread's ring, registering a new one on first use
+ * @return Ring, NULL on error
+ */
+static log_ring_t *get_local_ring(void) {
+    log_ring_t *ring;
+
+    if (local_ring != NULL) {
+        return local_ring;
+    }
+
+    pthread_once(&ring_key_once, make_ring_key);
+
+    ring = aligned_alloc(CACHE_LINE_SIZE, sizeof(*ring));
+    if (!ring) {
+        return NULL;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->orphaned, 0);
+    pthread_setspecific(ring_key, ring);
+
+    pthread_mutex_lock(&rings_mutex);
+    ring->next = rings;
+    rings = ring;
+    pthread_mutex_unlock(&rings_mutex);
+
+    local_ring = ring;
+    return ring;
+}
+
+/**
+ * Format the timestamp and level that start each line
+ * @param buffer Output, at least LINE_PREFIX_SIZE bytes
+ * @param time Message time
+ * @param level Message level
+ * @return Length of the prefix
+ */
+static int format_prefix(char *buffer, const struct timespec *time, async_log_level_t level) {
+    static _Thread_local time_t cached_second = -1;
+    static _Thread_local char cached_date[20];
+    struct tm tm;
+
+    // localtime_r is the expensive part; lines mostly share a second
+    if (time->tv_sec != cached_second) {
+        localtime_r(&time->tv_sec, &tm);
+        strftime(cached_date, sizeof(cached_date), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_second = time->tv_sec;
+    }
+
+    return snprintf(buffer, LINE_PREFIX_SIZE, "%s.%03ld %-5s ",
+                    cached_date, time->tv_nsec / 1000000, level_names[level]);
+}
+
+/**
+ * Write out a buffer completely
+ * @param buffer Data
+ * @param length Data length
+ */
+static void write_all(const char *buffer, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(output_fd, buffer, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        buffer += written;
+        length -= (size_t)written;
+    }
+}
+
+/**
+ * Drain one ring into the write buffer, flushing the buffer when it fills
+ * @param ring Ring to drain
+ * @param buffer Write buffer of WRITE_BUFFER_SIZE bytes
+ * @param used Bytes already in the buffer, updated
+ * @return Number of records drained
+ */
+static size_t drain_ring(log_ring_t *ring, char *buffer, size_t *used) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+    size_t count = tail - head;
+
+    for (; head != tail; head++) {
+        const log_record_t *record = &ring->records[head & (RING_SLOTS - 1)];
+
+        if (*used + LINE_PREFIX_SIZE + record->length + 1 > WRITE_BUFFER_SIZE) {
+            write_all(buffer, *used);
+            *used = 0;
+        }
+        *used += (size_t)format_prefix(buffer + *used, &record->time, record->level);
+        memcpy(buffer + *used, record->text, record->length);
+        *used += record->length;
+        buffer[(*used)++] = '\n';
+
+        // Hand the slot back to the producer
+        atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    }
+
+    if (dropped > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        if (*used + LINE_PREFIX_SIZE + 64 > WRITE_BUFFER_SIZE) {
+            write_all(buffer, *used);
+            *used = 0;
+        }
+        *used += (size_t)format_prefix(buffer + *used, &now, ASYNC_LOG_WARN);
+        *used += (size_t)snprintf(buffer + *used, 64, "%zu log messages dropped\n", dropped);
+    }
+
+    return count;
+}
+
+/**
+ * Drain every ring once and free drained rings of exited threads
+ * @param buffer Write buffer of WRITE_BUFFER_SIZE bytes
+ * @return Number of records written
+ */
+static size_t flush_rings(char *buffer) {
+    log_ring_t **link;
+    size_t used = 0;
+    size_t total = 0;
+
+    pthread_mutex_lock(&rings_mutex);
+    link = &rings;
+    while (*link) {
+        log_ring_t *ring = *link;
+        // Read the flag first: once set, the owner will not write again
+        int orphaned = atomic_load_explicit(&ring->orphaned, memory_order_acquire);
+
+        total += drain_ring(ring, buffer, &used);
+        if (orphaned) {
+            *link = ring->next;
+            free(ring);
+        } else {
+            link = &ring->next;
+        }
+    }
+    pthread_mutex_unlock(&rings_mutex);
+
+    if (used > 0) {
+        write_all(buffer, used);
+    }
+    return total;
+}
+
+/**
+ * Flusher thread: drains the rings until shutdown
+ * @param arg Unused
+ * @return NULL
+ */
+static void *flusher_main(void *arg) {
+    static char buffer[WRITE_BUFFER_SIZE];
+    struct timespec interval = { 0, FLUSH_INTERVAL_MS * 1000000L };
+
+    (void)arg;
+
+    while (!atomic_load(&flusher_stop)) {
+        if (flush_rings(buffer) == 0) {
+            nanosleep(&interval, NULL);
+        }
+    }
+
+    // Final drain
+    while (flush_rings(buffer) > 0) {
+    }
+
+    return NULL;
+}
+
+/**
+ * Parse a level name
+ * @param name Level name, case-insensitive
+ * @return Level, -1 if unknown
+ */
+static int parse_level(const char *name) {
+    for (int i = ASYNC_LOG_DEBUG; i <= ASYNC_LOG_ERROR; i++) {
+        if (strcasecmp(name, level_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int async_log_init(const char *path, async_log_level_t level) {
+    const char *env = getenv("LOG_LEVEL");
+    int result;
+
+    if (atomic_load(&logger_running)) {
+        return 0;
+    }
+
+    if (env != NULL && parse_level(env) >= 0) {
+        level = (async_log_level_t)parse_level(env);
+    }
+    async_log_set_level(level);
+
+    if (path == NULL) {
+        output_fd = STDOUT_FILENO;
+    } else {
+        output_fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (output_fd < 0) {
+            perror("Failed to open log file");
+            return -1;
+        }
+    }
+
+    atomic_store(&flusher_stop, 0);
+    result = pthread_create(&flusher_thread, NULL, flusher_main, NULL);
+    if (result != 0) {
+        errno = result;
+        perror("Failed to create log flusher");
+        if (output_fd != STDOUT_FILENO) {
+            close(output_fd);
+        }
+        output_fd = -1;
+        return -1;
+    }
+
+    atomic_store(&logger_running, 1);
+    return 0;
+}
+
+void async_log_shutdown(void) {
+    if (!atomic_exchange(&logger_running, 0)) {
+        return;
+    }
+
+    atomic_store(&flusher_stop, 1);
+    pthread_join(flusher_thread, NULL);
+
+    if (output_fd != STDOUT_FILENO) {
+        close(output_fd);
+    }
+    output_fd = -1;
+}
+
+void async_log_set_level(async_log_level_t level) {
+    atomic_store_explicit(&async_log_threshold, (int)level, memory_order_relaxed);
+}
+
+void async_log_write(async_log_level_t level, const char *format, ...) {
+    log_ring_t *ring;
+    log_record_t *record;
+    size_t head;
+    size_t tail;
+    va_list args;
+    int length;
+
+    if (!async_log_enabled(level)) {
+        return;
+    }
+
+    // Not started: write this one line synchronously
+    if (!atomic_load_explicit(&logger_running, memory_order_acquire) ||
+        (ring = get_local_ring()) == NULL) {
+        char line[LINE_PREFIX_SIZE + RECORD_TEXT];
+        struct timespec now;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        length = format_prefix(line, &now, level);
+        va_start(args, format);
+        vsnprintf(line + length, sizeof(line) - (size_t)length, format, args);
+        va_end(args);
+        fprintf(stderr, "%s\n", line);
+        return;
+    }
+
+    tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head == RING_SLOTS) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    record = &ring->records[tail & (RING_SLOTS - 1)];
+    clock_gettime(CLOCK_REALTIME, &record->time);
+    record->level = level;
+    va_start(args, format);
+    length = vsnprintf(record->text, RECORD_TEXT, format, args);
+    va_end(args);
+    if (length < 0) {
+        length = 0;
+    }
+    record->length = (length < RECORD_TEXT) ? (unsigned int)length : RECORD_TEXT - 1;
+
+    // Publish the record to the flusher
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
@@ -0,0 +1,325 @@
+/**
+ * Benchmark Harness Implementation
+ *
+ * The histogram keeps values below 16 exactly and splits every larger
+ * power of two into 16 buckets, so percentiles are within about 6% at
+ * any scale for a fixed 8 KiB per histogram. Text output prints a header
+ * line before the first result of a process. CSV on stdout does the same,
+ * while a CSV file gets its header only while it is still empty, so
+ * several programs can append to one file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "bench.h"
+
+// Constants
+#define DEFAULT_WARMUP 1
+#define DEFAULT_REPETITIONS 5
+
+static const char *csv_header =
+    "suite,name,repetitions,ops,seconds,ops_per_sec,ops_per_sec_min,ops_per_sec_max,"
+    "samples,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+
+static int header_printed = 0;
+
+// Integer environment variable, or the default if unset or invalid
+static long env_long(const char *name, long fallback, long min) {
+    const char *value = getenv(name);
+    char *end;
+    long parsed;
+
+    if (!value || !*value) {
+        return fallback;
+    }
+    parsed = strtol(value, &end, 10);
+    if (*end != '\0' || parsed < min) {
+        fprintf(stderr, "Ignoring invalid %s=%s\n", name, value);
+        return fallback;
+    }
+    return parsed;
+}
+
+void bench_config_init(bench_config_t *config, const char *suite) {
+    const char *format = getenv("BENCH_FORMAT");
+    const char *scale = getenv("BENCH_SCALE");
+    const char *output = getenv("BENCH_OUTPUT");
+
+    config->suite = suite;
+    config->warmup = (int)env_long("BENCH_WARMUP", DEFAULT_WARMUP, 0);
+    config->repetitions = (int)env_long("BENCH_REPS", DEFAULT_REPETITIONS, 1);
+    config->scale = 1.0;
+    config->format = BENCH_FORMAT_TEXT;
+    config->output = output && *output ? output : NULL;
+
+    if (scale && *scale) {
+        char *end;
+        double parsed = strtod(scale, &end);
+        if (*end == '\0' && parsed > 0) {
+            config->scale = parsed;
+        } else {
+            fprintf(stderr, "Ignoring invalid BENCH_SCALE=%s\n", scale);
+        }
+    }
+    if (format && *format) {
+        if (strcasecmp(format, "csv") == 0) {
+            config->format = BENCH_FORMAT_CSV;
+        } else if (strcasecmp(format, "json") == 0) {
+            config->format = BENCH_FORMAT_JSON;
+        } else if (strcasecmp(format, "text") != 0) {
+            fprintf(stderr, "Ignoring unknown BENCH_FORMAT=%s\n", format);
+        }
+    }
+}
+
+long bench_scaled(const bench_config_t *config, long count) {
+    double scaled = count * config->scale;
+    return scaled < 1 ? 1 : (long)scaled;
+}
+
+// Bucket of a value: exact below BENCH_HIST_SUB, then 16 per power of two
+static int hist_bucket(uint64_t value) {
+    if (value < BENCH_HIST_SUB) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int sub = (int)((value >> (msb - BENCH_HIST_SUB_BITS)) & (BENCH_HIST_SUB - 1));
+    return (msb - BENCH_HIST_SUB_BITS + 1) * BENCH_HIST_SUB + sub;
+}
+
+uint64_t bench_histogram_bucket_low(int bucket) {
+    if (bucket < BENCH_HIST_SUB) {
+        return (uint64_t)bucket;
+    }
+    int msb = bucket / BENCH_HIST_SUB + BENCH_HIST_SUB_BITS - 1;
+    uint64_t sub = bucket % BENCH_HIST_SUB;
+    return (1ULL << msb) | (sub << (msb - BENCH_HIST_SUB_BITS));
+}
+
+void bench_histogram_init(bench_histogram_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+void bench_histogram_add(bench_histogram_t *h, uint64_t ns) {
+    h->counts[hist_bucket(ns)]++;
+    h->count++;
+    h->sum += (double)ns;
+    if (ns < h->min) h->min = ns;
+    if (ns > h->max) h->max = ns;
+}
+
+void bench_histogram_merge(bench_histogram_t *into, const bench_histogram_t *from) {
+    if (from->count == 0) {
+        return;
+    }
+    for (int b = 0; b < BENCH_HIST_BUCKETS; b++) {
+        into->counts[b] += from->counts[b];
+    }
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+}
+
+uint64_t bench_histogram_quantile(const bench_histogram_t *h, double q) {
+    uint64_t rank = (uint64_t)(q * (double)(h->count - 1)) + 1;
+    uint64_t seen = 0;
+
+    for (int b = 0; b < BENCH_HIST_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            // Middle of the bucket, clamped to the observed range
+            uint64_t low = bench_histogram_bucket_low(b);
+            uint64_t high = b + 1 < BENCH_HIST_BUCKETS ? bench_histogram_bucket_low(b + 1)
+                                                       : UINT64_MAX;
+            uint64_t value = low + (high - low) / 2;
+            return value < h->min ? h->min : value > h->max ? h->max : value;
+        }
+    }
+    return h->max;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int bench_run(const bench_config_t *config, const char *name, bench_fn fn, void *arg,
+              bench_result_t *result) {
+    bench_histogram_t *samples = malloc(sizeof(*samples));
+    bench_histogram_t *fallback = malloc(sizeof(*fallback));
+    double *rates = malloc(config->repetitions * sizeof(*rates));
+    int status = -1;
+
+    memset(result, 0, sizeof(*result));
+    result->name = name;
+    if (!samples || !fallback || !rates) {
+        perror("Failed to allocate benchmark state");
+        goto out;
+    }
+    bench_histogram_init(samples);
+    bench_histogram_init(fallback);
+
+    for (int rep = 0; rep < config->warmup + config->repetitions; rep++) {
+        int timed = rep >= config->warmup;
+        bench_histogram_t *latency = timed ? samples : fallback;
+        uint64_t recorded = latency->count;
+        uint64_t start = bench_now_ns();
+        long ops = fn(arg, latency);
+        uint64_t elapsed = bench_now_ns() - start;
+
+        if (ops < 0) {
+            fprintf(stderr, "%s: repetition %d failed\n", name, rep + 1);
+            goto out;
+        }
+        if (!timed) {
+            // Warmup samples are discarded
+            bench_histogram_init(fallback);
+            continue;
+        }
+
+        // Without per-operation samples, use this repetition's mean
+        if (latency->count == recorded && ops > 0) {
+            bench_histogram_add(fallback, elapsed / (uint64_t)ops);
+        }
+        rates[result->repetitions++] = ops > 0 ? ops / (elapsed / 1e9) : 0;
+        result->ops += (uint64_t)ops;
+        result->seconds += elapsed / 1e9;
+    }
+
+    qsort(rates, result->repetitions, sizeof(*rates), compare_double);
+    result->ops_per_sec = rates[result->repetitions / 2];
+    result->ops_per_sec_min = rates[0];
+    result->ops_per_sec_max = rates[result->repetitions - 1];
+
+    // Per-operation samples win over per-repetition means
+    bench_histogram_t *latency = samples->count > 0 ? samples : fallback;
+    result->samples = latency->count;
+    if (latency->count > 0) {
+        result->mean_ns = latency->sum / latency->count;
+        result->min_ns = latency->min;
+        result->p50_ns = bench_histogram_quantile(latency, 0.50);
+        result->p90_ns = bench_histogram_quantile(latency, 0.90);
+        result->p99_ns = bench_histogram_quantile(latency, 0.99);
+        result->p999_ns = bench_histogram_quantile(latency, 0.999);
+        result->max_ns = latency->max;
+    }
+    status = result->repetitions > 0 ? 0 : -1;
+
+out:
+    free(samples);
+    free(fallback);
+    free(rates);
+    return status;
+}
+
+// Write a JSON string, escaping quotes, backslashes and control characters
+static void json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(out, "\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*s);
+        } else {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Write a CSV field, quoting it if it contains separators or quotes
+static void csv_field(FILE *out, const char *s) {
+    if (!strpbrk(s, ",\"\n")) {
+        fputs(s, out);
+        return;
+    }
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"') {
+            fputc('"', out);
+        }
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+int bench_report(const bench_config_t *config, const bench_result_t *r) {
+    FILE *out = stdout;
+
+    if (config->output) {
+        out = fopen(config->output, "a");
+        if (!out) {
+            perror("Failed to open benchmark output");
+            return -1;
+        }
+    }
+
+    switch (config->format) {
+    case BENCH_FORMAT_CSV:
+        // An empty destination gets the header first
+        if (out != stdout ? fseek(out, 0, SEEK_END) == 0 && ftell(out) == 0 : !header_printed) {
+            fputs(csv_header, out);
+            header_printed = 1;
+        }
+        csv_field(out, config->suite);
+        fputc(',', out);
+        csv_field(out, r->name);
+        fprintf(out, ",%d,%llu,%.6f,%.1f,%.1f,%.1f,%llu,%.1f,%llu,%llu,%llu,%llu,%llu,%llu\n",
+                r->repetitions, (unsigned long long)r->ops, r->seconds,
+                r->ops_per_sec, r->ops_per_sec_min, r->ops_per_sec_max,
+                (unsigned long long)r->samples, r->mean_ns,
+                (unsigned long long)r->min_ns, (unsigned long long)r->p50_ns,
+                (unsigned long long)r->p90_ns, (unsigned long long)r->p99_ns,
+                (unsigned long long)r->p999_ns, (unsigned long long)r->max_ns);
+        break;
+    case BENCH_FORMAT_JSON:
+        fputs("{\"suite\":", out);
+        json_string(out, config->suite);
+        fputs(",\"name\":", out);
+        json_string(out, r->name);
+        fprintf(out, ",\"repetitions\":%d,\"ops\":%llu,\"seconds\":%.6f,"
+                "\"ops_per_sec\":%.1f,\"ops_per_sec_min\":%.1f,\"ops_per_sec_max\":%.1f,"
+                "\"samples\":%llu,\"mean_ns\":%.1f,\"min_ns\":%llu,\"p50_ns\":%llu,"
+                "\"p90_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu}\n",
+                r->repetitions, (unsigned long long)r->ops, r->seconds,
+                r->ops_per_sec, r->ops_per_sec_min, r->ops_per_sec_max,
+                (unsigned long long)r->samples, r->mean_ns,
+                (unsigned long long)r->min_ns, (unsigned long long)r->p50_ns,
+                (unsigned long long)r->p90_ns, (unsigned long long)r->p99_ns,
+                (unsigned long long)r->p999_ns, (unsigned long long)r->max_ns);
+        break;
+    default:
+        if (!header_printed) {
+            fprintf(out, "%-20s %-34s %14s %10s %10s %10s %10s\n", "suite", "benchmark",
+                    "ops/s", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+            header_printed = 1;
+        }
+        fprintf(out, "%-20s %-34s %14.0f %10llu %10llu %10llu %10llu\n",
+                config->suite, r->name, r->ops_per_sec,
+                (unsigned long long)r->p50_ns, (unsigned long long)r->p99_ns,
+                (unsigned long long)r->p999_ns, (unsigned long long)r->max_ns);
+        break;
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    } else {
+        fflush(out);
+    }
+    return 0;
+}
+
+int bench_case(const bench_config_t *config, const char *name, bench_fn fn, void *arg) {
+    bench_result_t result;
+
+    if (bench_run(config, name, fn, arg, &result) != 0) {
+        return -1;
+    }
+    return bench_report(config, &result);
+}
@@ -0,0 +1,178 @@
+/**
+ * Benchmark Harness Interface
+ *
+ * One way to time things across the threads, synchronization, IPC and
+ * network programs, so their --bench modes report comparable numbers.
+ * Features include:
+ * - Untimed warmup repetitions followed by timed repetitions
+ * - Operations per second, as the median over the timed repetitions
+ * - Latency percentiles from a log-linear histogram; benchmarks record
+ *   per-operation samples, or the harness falls back to the mean
+ *   operation time of each repetition
+ * - Text, CSV or JSON Lines output, to stdout or appended to a file
+ *
+ * Every program reads the same parameters from the environment, which is
+ * how the top-level `make bench` passes them down:
+ *   BENCH_WARMUP  untimed repetitions (default 1)
+ *   BENCH_REPS    timed repetitions (default 5)
+ *   BENCH_SCALE   multiplier for each benchmark's default workload (1.0)
+ *   BENCH_FORMAT  text, csv or json (text)
+ *   BENCH_OUTPUT  file to append results to (stdout)
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Constants
+#define BENCH_HIST_SUB_BITS 4   // 16 buckets per power of two, about 6% resolution
+#define BENCH_HIST_SUB (1 << BENCH_HIST_SUB_BITS)
+#define BENCH_HIST_BUCKETS ((64 - BENCH_HIST_SUB_BITS + 1) * BENCH_HIST_SUB)
+
+typedef enum {
+    BENCH_FORMAT_TEXT,
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON
+} bench_format_t;
+
+// Parameters shared by every benchmark of a program
+typedef struct {
+    const char *suite;      // Program name, first field of every record
+    int warmup;
+    int repetitions;
+    double scale;
+    bench_format_t format;
+    const char *output;     // NULL for stdout
+} bench_config_t;
+
+// Latency histogram in nanoseconds; merge per-thread ones after joining
+typedef struct {
+    uint64_t counts[BENCH_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} bench_histogram_t;
+
+// Result of one benchmark
+typedef struct {
+    const char *name;
+    int repetitions;
+    uint64_t ops;           // Over all timed repetitions
+    double seconds;         // Over all timed repetitions
+    double ops_per_sec;     // Median repetition
+    double ops_per_sec_min; // Slowest repetition
+    double ops_per_sec_max; // Fastest repetition
+    uint64_t samples;       // Latency samples behind the percentiles
+    double mean_ns;
+    uint64_t min_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} bench_result_t;
+
+/**
+ * Run one repetition of a benchmark
+ * @param arg Benchmark argument
+ * @param latency Histogram for per-operation samples; may be left empty
+ * @return Operations performed, -1 on error
+ */
+typedef long (*bench_fn)(void *arg, bench_histogram_t *latency);
+
+/**
+ * Current CLOCK_MONOTONIC time
+ * @return Nanoseconds
+ */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Initialize a configuration from the defaults and the BENCH_* variables
+ * @param config Configuration to fill
+ * @param suite Program name used in every record
+ */
+void bench_config_init(bench_config_t *config, const char *suite);
+
+/**
+ * Scale a default workload size by BENCH_SCALE
+ * @param config Configuration
+ * @param count Default size
+ * @return Scaled size, at least 1
+ */
+long bench_scaled(const bench_config_t *config, long count);
+
+/**
+ * Empty a histogram
+ * @param h Histogram to reset
+ */
+void bench_histogram_init(bench_histogram_t *h);
+
+/**
+ * Record one latency sample
+ * @param h Histogram
+ * @param ns Latency in nanoseconds
+ */
+void bench_histogram_add(bench_histogram_t *h, uint64_t ns);
+
+/**
+ * Add every sample of one histogram to another
+ * @param into Destination
+ * @param from Source
+ */
+void bench_histogram_merge(bench_histogram_t *into, const bench_histogram_t *from);
+
+/**
+ * Smallest value that falls into a histogram bucket, e.g. for printing
+ * bucket ranges
+ * @param bucket Bucket index, below BENCH_HIST_BUCKETS
+ * @return Lower bound in nanoseconds
+ */
+uint64_t bench_histogram_bucket_low(int bucket);
+
+/**
+ * Latency at a quantile, to bucket resolution
+ * @param h Histogram with at least one sample
+ * @param q Quantile between 0 and 1
+ * @return Nanoseconds
+ */
+uint64_t bench_histogram_quantile(const bench_histogram_t *h, double q);
+
+/**
+ * Run a benchmark: config->warmup untimed repetitions, then
+ * config->repetitions timed ones
+ * @param config Configuration
+ * @param name Benchmark name, e.g. "adaptive/threads=8"
+ * @param fn Repetition body
+ * @param arg Argument for fn
+ * @param result Filled with the measurements
+ * @return 0 on success, -1 if a repetition failed
+ */
+int bench_run(const bench_config_t *config, const char *name, bench_fn fn, void *arg,
+              bench_result_t *result);
+
+/**
+ * Print or append one result in the configured format
+ * @param config Configuration
+ * @param result Result to report
+ * @return 0 on success, -1 on error
+ */
+int bench_report(const bench_config_t *config, const bench_result_t *result);
+
+/**
+ * Run a benchmark and report it
+ * @param config Configuration
+ * @param name Benchmark name
+ * @param fn Repetition body
+ * @param arg Argument for fn
+ * @return 0 on success, -1 on error
+ */
+int bench_case(const bench_config_t *config, const char *name, bench_fn fn, void *arg);
+
+#endif // BENCH_H
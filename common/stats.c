@@ -0,0 +1,301 @@
+/**
+ * Hot-Path Statistics Implementation
+ *
+ * The page is a POSIX shared-memory object sized for STATS_MAX_SLOTS
+ * threads. A thread claims a free slot with one compare-and-swap on its
+ * first recorded event and gives it back from a thread-specific data
+ * destructor when it exits; the counts stay, so a slot's totals cover
+ * every thread that has used it. Lock class names are kept in a private
+ * table as well, so locks can register before the page exists.
+ */
+
+#define _GNU_SOURCE             // pthread_getname_np, gettid
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+
+stats_page_t *stats_page = NULL;
+_Thread_local stats_slot_t *stats_thread_slot = NULL;
+_Thread_local unsigned int stats_sample_tick = 0;
+
+// Set once a thread has found every slot taken, so it stops looking
+static _Thread_local int thread_dropped = 0;
+
+static char page_name[64];
+static char lock_names[STATS_MAX_LOCK_CLASSES][STATS_NAME_SIZE];
+static int lock_count = 0;
+static pthread_mutex_t lock_names_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t slot_key;
+static pthread_once_t slot_key_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Give an exiting thread's slot back for the next thread to adopt
+ * @param arg Slot of the exiting thread
+ */
+static void release_slot(void *arg) {
+    stats_slot_t *slot = (stats_slot_t *)arg;
+
+    atomic_store_explicit(&slot->owner, 0, memory_order_release);
+}
+
+// Create the key whose destructor releases a thread's slot
+static void make_slot_key(void) {
+    if (pthread_key_create(&slot_key, release_slot) != 0) {
+        perror("Failed to create stats key");
+    }
+}
+
+stats_slot_t *stats_claim_slot(void) {
+    stats_page_t *page = stats_page;
+    int tid = (int)gettid();
+
+    if (page == NULL || thread_dropped) {
+        return NULL;
+    }
+
+    pthread_once(&slot_key_once, make_slot_key);
+    for (int i = 0; i < STATS_MAX_SLOTS; i++) {
+        stats_slot_t *slot = &page->slots[i];
+        int expected = 0;
+
+        if (atomic_load_explicit(&slot->owner, memory_order_relaxed) == 0 &&
+            atomic_compare_exchange_strong_explicit(&slot->owner, &expected, tid,
+                                                    memory_order_acquire,
+                                                    memory_order_relaxed)) {
+            pthread_getname_np(pthread_self(), slot->thread_name, sizeof(slot->thread_name));
+            pthread_setspecific(slot_key, slot);
+            stats_thread_slot = slot;
+            return slot;
+        }
+    }
+
+    atomic_fetch_add(&page->dropped_threads, 1);
+    thread_dropped = 1;
+    return NULL;
+}
+
+int stats_init(const char *program) {
+    const char *setting = getenv("STATS");
+    stats_page_t *page;
+    int fd;
+
+    if (stats_page != NULL ||
+        (setting && (strcasecmp(setting, "off") == 0 || strcmp(setting, "0") == 0))) {
+        return 0;
+    }
+
+    snprintf(page_name, sizeof(page_name), STATS_SHM_PREFIX "%d", (int)getpid());
+    fd = shm_open(page_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("shm_open failed");
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(stats_page_t)) < 0) {
+        perror("ftruncate failed");
+        close(fd);
+        shm_unlink(page_name);
+        return -1;
+    }
+    page = mmap(NULL, sizeof(stats_page_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        perror("mmap failed");
+        shm_unlink(page_name);
+        return -1;
+    }
+
+    // ftruncate zeroed the page, so only the header needs filling in
+    page->version = STATS_VERSION;
+    page->pid = getpid();
+    snprintf(page->program, sizeof(page->program), "%s", program);
+    page->start_ns = stats_now_ns();
+
+    pthread_mutex_lock(&lock_names_mutex);
+    memcpy(page->lock_names, lock_names, sizeof(lock_names));
+    atomic_store(&page->lock_classes, (uint32_t)lock_count);
+    pthread_mutex_unlock(&lock_names_mutex);
+
+    // Readers check the magic last, once the header is complete
+    atomic_thread_fence(memory_order_release);
+    page->magic = STATS_MAGIC;
+    stats_page = page;
+
+    atexit(stats_shutdown);
+    return 0;
+}
+
+void stats_shutdown(void) {
+    if (page_name[0] != '\0') {
+        shm_unlink(page_name);
+        page_name[0] = '\0';
+    }
+}
+
+int stats_lock_class(const char *name) {
+    int id = -1;
+
+    pthread_mutex_lock(&lock_names_mutex);
+    for (int i = 0; i < lock_count; i++) {
+        if (strncmp(lock_names[i], name, STATS_NAME_SIZE - 1) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0 && lock_count < STATS_MAX_LOCK_CLASSES) {
+        id = lock_count++;
+        snprintf(lock_names[id], STATS_NAME_SIZE, "%s", name);
+        if (stats_page != NULL) {
+            memcpy(stats_page->lock_names[id], lock_names[id], STATS_NAME_SIZE);
+            atomic_store(&stats_page->lock_classes, (uint32_t)lock_count);
+        }
+    }
+    pthread_mutex_unlock(&lock_names_mutex);
+
+    return id;
+}
+
+int stats_list(pid_t *pids, int max) {
+    size_t prefix = strlen(STATS_SHM_PREFIX) - 1;   // Without the leading '/'
+    struct dirent *entry;
+    DIR *dir = opendir("/dev/shm");
+    int count = 0;
+
+    if (!dir) {
+        perror("Failed to open /dev/shm");
+        return -1;
+    }
+
+    while ((entry = readdir(dir)) != NULL && count < max) {
+        char *end;
+        long pid;
+
+        if (strncmp(entry->d_name, STATS_SHM_PREFIX + 1, prefix) != 0) {
+            continue;
+        }
+        pid = strtol(entry->d_name + prefix, &end, 10);
+        if (*end != '\0' || pid <= 0) {
+            continue;
+        }
+
+        // A page left behind by a crashed process
+        if (kill((pid_t)pid, 0) < 0 && errno == ESRCH) {
+            char name[64];
+            snprintf(name, sizeof(name), STATS_SHM_PREFIX "%ld", pid);
+            shm_unlink(name);
+            continue;
+        }
+        pids[count++] = (pid_t)pid;
+    }
+
+    closedir(dir);
+    return count;
+}
+
+const stats_page_t *stats_attach(pid_t pid) {
+    char name[64];
+    stats_page_t *page;
+    struct stat st;
+    int fd;
+
+    snprintf(name, sizeof(name), STATS_SHM_PREFIX "%d", (int)pid);
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(stats_page_t)) {
+        close(fd);
+        return NULL;
+    }
+    page = mmap(NULL, sizeof(stats_page_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        perror("mmap failed");
+        return NULL;
+    }
+
+    if (page->magic != STATS_MAGIC || page->version != STATS_VERSION) {
+        munmap(page, sizeof(stats_page_t));
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return page;
+}
+
+void stats_detach(const stats_page_t *page) {
+    if (page) {
+        munmap((void *)page, sizeof(stats_page_t));
+    }
+}
+
+void stats_sum(const stats_page_t *page, stats_totals_t *totals) {
+    memset(totals, 0, sizeof(*totals));
+    totals->lock_classes = (int)atomic_load(&page->lock_classes);
+    if (totals->lock_classes > STATS_MAX_LOCK_CLASSES) {
+        totals->lock_classes = STATS_MAX_LOCK_CLASSES;
+    }
+
+    for (int i = 0; i < STATS_MAX_SLOTS; i++) {
+        const stats_slot_t *slot = &page->slots[i];
+        uint64_t high_water;
+
+        if (atomic_load_explicit(&slot->owner, memory_order_relaxed) != 0) {
+            totals->threads++;
+        }
+        for (int c = 0; c < STATS_COUNTERS; c++) {
+            totals->counters[c] += atomic_load_explicit(&slot->counters[c],
+                                                        memory_order_relaxed);
+        }
+        high_water = atomic_load_explicit(&slot->queue_high_water, memory_order_relaxed);
+        if (high_water > totals->queue_high_water) {
+            totals->queue_high_water = high_water;
+        }
+        for (int l = 0; l < totals->lock_classes; l++) {
+            const stats_lock_counters_t *lock = &slot->locks[l];
+            totals->locks[l].acquires += atomic_load_explicit(&lock->acquires,
+                                                              memory_order_relaxed);
+            totals->locks[l].contended += atomic_load_explicit(&lock->contended,
+                                                               memory_order_relaxed);
+            totals->locks[l].wait_ns += atomic_load_explicit(&lock->wait_ns,
+                                                             memory_order_relaxed);
+        }
+        for (int h = 0; h < STATS_HISTOGRAMS; h++) {
+            for (int b = 0; b < STATS_HIST_BUCKETS; b++) {
+                totals->histograms[h][b] += atomic_load_explicit(&slot->histograms[h][b],
+                                                                 memory_order_relaxed);
+            }
+        }
+    }
+}
+
+uint64_t stats_quantile(const uint64_t *buckets, double q) {
+    uint64_t total = 0;
+    uint64_t seen = 0;
+    uint64_t rank;
+
+    for (int b = 0; b < STATS_HIST_BUCKETS; b++) {
+        total += buckets[b];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    rank = (uint64_t)(q * (double)(total - 1)) + 1;
+    for (int b = 0; b < STATS_HIST_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            return b == 0 ? 0 : b >= 63 ? UINT64_MAX : (1ULL << b) - 1;
+        }
+    }
+    return UINT64_MAX;
+}
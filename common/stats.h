@@ -0,0 +1,309 @@
+/**
+ * Hot-Path Statistics Interface
+ *
+ * Counters for the thread pool, the locks and the network servers that
+ * are cheap enough to leave on. Features include:
+ * - One slot per thread in a shared-memory page; only the owning thread
+ *   writes its slot, with relaxed loads and stores, so recording takes no
+ *   atomic read-modify-write and shares no cache line with other threads
+ * - Readers aggregate by summing the slots, from this process or another
+ * - Per lock class: acquisitions, contended acquisitions and wait time
+ * - Tasks submitted, started and completed; queue depth is submitted minus
+ *   started, so it needs no shared counter either
+ * - Sampled submit-to-start and start-to-end task latency histograms
+ * - Network bytes and packets in each direction (datagrams for UDP,
+ *   recv/send calls for TCP)
+ *
+ * stats_init publishes the page as /dev/shm/os_stats.<pid>, where the
+ * Live Statistics screen of ui/menu finds it. Until stats_init is called,
+ * or with STATS=off in the environment, the hooks record nothing.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <time.h>
+
+// Constants
+#define STATS_MAGIC 0x53544154u         // "STAT"
+#define STATS_VERSION 1
+#define STATS_SHM_PREFIX "/os_stats."   // Followed by the pid
+#define STATS_MAX_SLOTS 128             // Threads recorded at once; later ones are dropped
+#define STATS_MAX_LOCK_CLASSES 16
+#define STATS_NAME_SIZE 24
+#define STATS_HIST_BUCKETS 64           // Bucket b holds [2^(b-1), 2^b) ns
+#define STATS_SAMPLE_INTERVAL 64        // One task in this many is timed, a power of two
+#define STATS_CACHE_LINE 64
+
+// Event counters, summed over threads
+typedef enum {
+    STATS_TASKS_SUBMITTED,
+    STATS_TASKS_STARTED,
+    STATS_TASKS_COMPLETED,
+    STATS_NET_RX_PACKETS,
+    STATS_NET_RX_BYTES,
+    STATS_NET_TX_PACKETS,
+    STATS_NET_TX_BYTES,
+    STATS_COUNTERS
+} stats_counter_t;
+
+// Latency histograms in nanoseconds
+typedef enum {
+    STATS_HIST_LOCK_WAIT,   // Contended acquisitions, all lock classes
+    STATS_HIST_TASK_QUEUED, // Submit to start, sampled
+    STATS_HIST_TASK_RUN,    // Start to end, sampled
+    STATS_HISTOGRAMS
+} stats_histogram_t;
+
+// Per-lock-class counters of one thread
+typedef struct {
+    _Atomic uint64_t acquires;
+    _Atomic uint64_t contended;     // Acquisitions that had to wait
+    _Atomic uint64_t wait_ns;
+} stats_lock_counters_t;
+
+// Counters of one thread, written only by that thread
+typedef struct {
+    _Alignas(STATS_CACHE_LINE) _Atomic int owner;  // Thread id, 0 when free
+    char thread_name[16];
+    _Atomic uint64_t counters[STATS_COUNTERS];
+    _Atomic uint64_t queue_high_water;             // Deepest shared queue seen
+    stats_lock_counters_t locks[STATS_MAX_LOCK_CLASSES];
+    _Atomic uint64_t histograms[STATS_HISTOGRAMS][STATS_HIST_BUCKETS];
+} stats_slot_t;
+
+// The shared page; slots keep their counts when their thread exits and
+// the next new thread carries on from them
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    pid_t pid;
+    char program[STATS_NAME_SIZE];
+    uint64_t start_ns;                  // CLOCK_MONOTONIC at stats_init
+    _Atomic uint32_t dropped_threads;   // Threads that found every slot taken
+    _Atomic uint32_t lock_classes;
+    char lock_names[STATS_MAX_LOCK_CLASSES][STATS_NAME_SIZE];
+    stats_slot_t slots[STATS_MAX_SLOTS];
+} stats_page_t;
+
+// Sum of every slot of a page
+typedef struct {
+    int threads;                        // Slots owned by a live thread
+    int lock_classes;
+    uint64_t counters[STATS_COUNTERS];
+    uint64_t queue_high_water;
+    struct {
+        uint64_t acquires;
+        uint64_t contended;
+        uint64_t wait_ns;
+    } locks[STATS_MAX_LOCK_CLASSES];
+    uint64_t histograms[STATS_HISTOGRAMS][STATS_HIST_BUCKETS];
+} stats_totals_t;
+
+// Page of this process, NULL while disabled
+extern stats_page_t *stats_page;
+
+// Slot of the calling thread, claimed on first use
+extern _Thread_local stats_slot_t *stats_thread_slot;
+
+// Per-thread task counter for sampling
+extern _Thread_local unsigned int stats_sample_tick;
+
+/**
+ * Claim a slot for the calling thread (slow path of stats_slot)
+ * @return Slot, NULL if disabled or every slot is taken
+ */
+stats_slot_t *stats_claim_slot(void);
+
+/**
+ * Current CLOCK_MONOTONIC time
+ * @return Nanoseconds
+ */
+static inline uint64_t stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Get the calling thread's slot
+ * @return Slot, NULL if statistics are off
+ */
+static inline stats_slot_t *stats_slot(void) {
+    stats_slot_t *slot = stats_thread_slot;
+
+    if (__builtin_expect(slot == NULL, 0) && stats_page != NULL) {
+        slot = stats_claim_slot();
+    }
+    return slot;
+}
+
+// Single-writer add: a plain load and store, no locked instruction
+static inline void stats_add_to(_Atomic uint64_t *counter, uint64_t value) {
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
+
+/**
+ * Add to one of the calling thread's counters
+ * @param counter Counter
+ * @param value Amount to add
+ */
+static inline void stats_add(stats_counter_t counter, uint64_t value) {
+    stats_slot_t *slot = stats_slot();
+
+    if (slot) {
+        stats_add_to(&slot->counters[counter], value);
+    }
+}
+
+// Histogram bucket of a latency; the last bucket also takes anything larger
+static inline int stats_bucket(uint64_t ns) {
+    int bucket = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+    return bucket < STATS_HIST_BUCKETS ? bucket : STATS_HIST_BUCKETS - 1;
+}
+
+/**
+ * Record a latency in one of the calling thread's histograms
+ * @param histogram Histogram
+ * @param ns Latency in nanoseconds
+ */
+static inline void stats_record(stats_histogram_t histogram, uint64_t ns) {
+    stats_slot_t *slot = stats_slot();
+
+    if (slot) {
+        stats_add_to(&slot->histograms[histogram][stats_bucket(ns)], 1);
+    }
+}
+
+/**
+ * Record the depth of a queue seen by the calling thread
+ * @param depth Queue length
+ */
+static inline void stats_queue_depth(uint64_t depth) {
+    stats_slot_t *slot = stats_slot();
+
+    if (slot && depth > atomic_load_explicit(&slot->queue_high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&slot->queue_high_water, depth, memory_order_relaxed);
+    }
+}
+
+/**
+ * Start timing a sampled operation
+ * @return Current time for one call in STATS_SAMPLE_INTERVAL, 0 otherwise
+ */
+static inline uint64_t stats_sample_start(void) {
+    if (stats_page == NULL ||
+        (++stats_sample_tick & (STATS_SAMPLE_INTERVAL - 1)) != 0) {
+        return 0;
+    }
+    return stats_now_ns();
+}
+
+/**
+ * Record one lock acquisition
+ * @param lock_class Class from stats_lock_class, ignored if negative
+ * @param wait_ns Time spent waiting, 0 if the lock was free
+ */
+static inline void stats_lock_acquired(int lock_class, uint64_t wait_ns) {
+    stats_slot_t *slot;
+
+    if (lock_class < 0 || (slot = stats_slot()) == NULL) {
+        return;
+    }
+    stats_add_to(&slot->locks[lock_class].acquires, 1);
+    if (wait_ns > 0) {
+        stats_add_to(&slot->locks[lock_class].contended, 1);
+        stats_add_to(&slot->locks[lock_class].wait_ns, wait_ns);
+        stats_add_to(&slot->histograms[STATS_HIST_LOCK_WAIT][stats_bucket(wait_ns)], 1);
+    }
+}
+
+/**
+ * Lock a mutex, recording whether and how long the caller waited
+ *
+ * The clock is only read when the lock is already held.
+ * @param mutex Mutex to lock
+ * @param lock_class Class from stats_lock_class
+ */
+static inline void stats_mutex_lock(pthread_mutex_t *mutex, int lock_class) {
+    uint64_t start;
+
+    if (pthread_mutex_trylock(mutex) == 0) {
+        stats_lock_acquired(lock_class, 0);
+        return;
+    }
+    if (stats_page == NULL) {
+        pthread_mutex_lock(mutex);
+        return;
+    }
+    start = stats_now_ns();
+    pthread_mutex_lock(mutex);
+    // At least 1 ns, so a wait shorter than the clock still counts as contended
+    stats_lock_acquired(lock_class, stats_now_ns() - start + 1);
+}
+
+/**
+ * Publish this process's statistics page and start recording
+ *
+ * The page is unlinked again at exit. Does nothing when STATS=off.
+ * @param program Name shown by readers
+ * @return 0 on success or when disabled, -1 on error
+ */
+int stats_init(const char *program);
+
+/**
+ * Unlink the page; recording continues into the private mapping
+ */
+void stats_shutdown(void);
+
+/**
+ * Get the class id for a lock name, registering it if new
+ * Works before stats_init; classes are published when the page is.
+ * @param name Lock class name, e.g. "thread_pool.queue"
+ * @return Class id, -1 if the table is full
+ */
+int stats_lock_class(const char *name);
+
+/**
+ * Find processes with a published page; removes pages of dead processes
+ * @param pids Receives the process ids
+ * @param max Capacity of pids
+ * @return Number of processes found, -1 on error
+ */
+int stats_list(pid_t *pids, int max);
+
+/**
+ * Map another process's page read-only
+ * @param pid Process id
+ * @return Page, NULL on error
+ */
+const stats_page_t *stats_attach(pid_t pid);
+
+/**
+ * Unmap a page from stats_attach
+ * @param page Page to unmap
+ */
+void stats_detach(const stats_page_t *page);
+
+/**
+ * Sum every slot of a page
+ * @param page Page to read
+ * @param totals Receives the sums
+ */
+void stats_sum(const stats_page_t *page, stats_totals_t *totals);
+
+/**
+ * Latency at a quantile of a histogram, as its bucket's upper bound
+ * @param buckets STATS_HIST_BUCKETS counts
+ * @param q Quantile between 0 and 1
+ * @return Nanoseconds, 0 if the histogram is empty
+ */
+uint64_t stats_quantile(const uint64_t *buckets, double q);
+
+#endif // STATS_H
@@ -0,0 +1,626 @@
+/**
+ * Load Generator Implementation
+ *
+ * The connections are opened up front and split evenly over the worker
+ * threads. Each worker runs one epoll loop: it issues whatever requests
+ * are due, waits for answers or for the next due time, and after the
+ * sending time keeps collecting answers until nothing is in flight or
+ * LOAD_DRAIN_MS has passed. In open-loop mode connection i of n sends its
+ * first request i/n of an interval after the start, so the combined rate
+ * is smooth instead of arriving in bursts.
+ *
+ * A TCP answer is recognized by its length, since the server echoes every
+ * byte; requests the socket cannot take yet wait in the connection's
+ * output buffer, which holds one pipeline of messages. A UDP connection
+ * that hears nothing for LOAD_LOSS_TIMEOUT_MS counts its in-flight
+ * requests as lost so a dropped datagram cannot block its pipeline, and
+ * answers that arrive after that are ignored.
+ */
+
+#define _GNU_SOURCE             // epoll_pwait2
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "load_gen.h"
+
+// Constants
+#define DEFAULT_HOST "127.0.0.1"
+#define DEFAULT_PORT 8080
+#define MAX_THREADS 256
+#define MAX_EVENTS 64
+#define READ_BUFFER_SIZE 65536
+#define LOAD_DRAIN_MS 1000          // Time allowed for answers after sending stops
+#define LOAD_LOSS_TIMEOUT_MS 200    // UDP silence after which in-flight requests are lost
+#define NS_PER_MS 1000000ULL
+
+// Start of every request; the rest of the message is padding
+typedef struct {
+    uint64_t seq;
+    uint64_t due_ns;                // Latency is measured from here
+} load_header_t;
+
+// One connection
+typedef struct {
+    int fd;
+    int in_flight;
+    uint64_t seq;                   // Sequence number of the next request
+    uint64_t lost_below;            // UDP: answers to earlier requests are ignored
+    uint64_t next_due_ns;           // Open loop: when the next request is due
+    uint64_t last_answer_ns;        // UDP: start of the current silence
+    unsigned char in_header[LOAD_HEADER_SIZE];
+    size_t in_len;                  // TCP: bytes received of the current answer
+    unsigned char *out;             // TCP: requests not yet taken by the socket
+    size_t out_off;
+    size_t out_len;
+    int writing;                    // TCP: EPOLLOUT is registered
+} load_conn_t;
+
+// One worker thread and its share of the connections
+typedef struct {
+    const load_config_t *config;
+    load_conn_t *conns;
+    int first;                      // Index of conns[0] among all connections
+    int count;
+    bench_histogram_t latency;
+    unsigned long answered;
+    unsigned long lost;
+    int failed;
+    pthread_t thread;
+} load_worker_t;
+
+/**
+ * Open one non-blocking connection to the server
+ * @param config Load configuration
+ * @param conn Connection to fill
+ * @return 0 on success, -1 on error
+ */
+static int load_connect(const load_config_t *config, load_conn_t *conn) {
+    int stream = config->socket_type == SOCK_STREAM;
+    int one = 1;
+
+    memset(conn, 0, sizeof(*conn));
+    conn->fd = socket(AF_INET, config->socket_type, 0);
+    if (conn->fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    // A UDP socket is connected too, so it only hears from the server
+    if (connect(conn->fd, (const struct sockaddr *)&config->server,
+                sizeof(config->server)) < 0) {
+        perror("connect");
+        close(conn->fd);
+        return -1;
+    }
+
+    // Pipelined requests must not wait for earlier ones to be acknowledged
+    if (stream && setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) < 0) {
+        perror("setsockopt TCP_NODELAY");
+    }
+    if (fcntl(conn->fd, F_SETFL, fcntl(conn->fd, F_GETFL) | O_NONBLOCK) < 0) {
+        perror("fcntl");
+        close(conn->fd);
+        return -1;
+    }
+
+    if (stream) {
+        conn->out = malloc((size_t)config->pipeline * config->message_size);
+        if (!conn->out) {
+            perror("Failed to allocate output buffer");
+            close(conn->fd);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Close a connection from load_connect
+static void load_disconnect(load_conn_t *conn) {
+    close(conn->fd);
+    free(conn->out);
+}
+
+/**
+ * Send what the socket will take of a TCP connection's buffered requests
+ * @param epfd Worker's epoll instance
+ * @param conn Connection
+ * @return 0 on success, -1 on error
+ */
+static int load_flush(int epfd, load_conn_t *conn) {
+    int want_write;
+
+    while (conn->out_len > 0) {
+        ssize_t sent = send(conn->fd, conn->out + conn->out_off, conn->out_len, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            perror("send");
+            return -1;
+        }
+        conn->out_off += (size_t)sent;
+        conn->out_len -= (size_t)sent;
+    }
+    if (conn->out_len == 0) {
+        conn->out_off = 0;
+    }
+
+    // Only ask for EPOLLOUT while something is waiting to go out
+    want_write = conn->out_len > 0;
+    if (want_write != conn->writing) {
+        struct epoll_event event = { .events = EPOLLIN | (want_write ? EPOLLOUT : 0),
+                                     .data.ptr = conn };
+        if (epoll_ctl(epfd, EPOLL_CTL_MOD, conn->fd, &event) < 0) {
+            perror("epoll_ctl");
+            return -1;
+        }
+        conn->writing = want_write;
+    }
+    return 0;
+}
+
+/**
+ * Issue one request
+ * @param worker Calling worker
+ * @param conn Connection to send on
+ * @param message Message template, message_size bytes
+ * @param due_ns When the request was due
+ * @return 1 if issued, 0 if the socket is full, -1 on error
+ */
+static int load_send(load_worker_t *worker, load_conn_t *conn, unsigned char *message,
+                     uint64_t due_ns) {
+    const load_config_t *config = worker->config;
+    load_header_t header = { conn->seq, due_ns };
+
+    memcpy(message, &header, sizeof(header));
+
+    if (config->socket_type == SOCK_DGRAM) {
+        if (send(conn->fd, message, config->message_size, 0) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ||
+                errno == EINTR) {
+                return 0;
+            }
+            perror("send");
+            return -1;
+        }
+    } else {
+        // The buffer holds a pipeline, so there is always room after compacting
+        if (conn->out_off + conn->out_len + config->message_size >
+            (size_t)config->pipeline * config->message_size) {
+            memmove(conn->out, conn->out + conn->out_off, conn->out_len);
+            conn->out_off = 0;
+        }
+        memcpy(conn->out + conn->out_off + conn->out_len, message, config->message_size);
+        conn->out_len += config->message_size;
+    }
+
+    conn->seq++;
+    conn->in_flight++;
+    return 1;
+}
+
+/**
+ * Issue every request a connection has due and room for
+ * @param worker Calling worker
+ * @param epfd Worker's epoll instance
+ * @param conn Connection
+ * @param message Message template
+ * @param now Current time
+ * @param interval Open loop: time between requests per connection; 0 for closed loop
+ * @return 0 on success, -1 on error
+ */
+static int load_issue(load_worker_t *worker, int epfd, load_conn_t *conn,
+                      unsigned char *message, uint64_t now, uint64_t interval) {
+    while (conn->in_flight < worker->config->pipeline) {
+        uint64_t due = now;
+        int result;
+
+        if (interval != 0) {
+            if (conn->next_due_ns > now) {
+                break;
+            }
+            due = conn->next_due_ns;
+        }
+
+        result = load_send(worker, conn, message, due);
+        if (result <= 0) {
+            return result;
+        }
+        if (conn->in_flight == 1) {
+            conn->last_answer_ns = now;
+        }
+        conn->next_due_ns += interval;
+    }
+
+    // Requests queued behind a full socket go out on EPOLLOUT instead
+    if (conn->out_len > 0 && !conn->writing) {
+        return load_flush(epfd, conn);
+    }
+    return 0;
+}
+
+/**
+ * Account for one answer
+ * @param worker Calling worker
+ * @param conn Connection it arrived on
+ * @param bytes First LOAD_HEADER_SIZE bytes of the answer
+ * @param now Current time
+ */
+static void load_answer(load_worker_t *worker, load_conn_t *conn, const unsigned char *bytes,
+                        uint64_t now) {
+    load_header_t header;
+
+    memcpy(&header, bytes, sizeof(header));
+    if (header.seq < conn->lost_below || header.seq >= conn->seq || conn->in_flight == 0) {
+        return;
+    }
+
+    bench_histogram_add(&worker->latency, now > header.due_ns ? now - header.due_ns : 0);
+    worker->answered++;
+    conn->in_flight--;
+    conn->last_answer_ns = now;
+}
+
+/**
+ * Read every answer waiting on a connection
+ * @param worker Calling worker
+ * @param conn Readable connection
+ * @param buffer READ_BUFFER_SIZE bytes of scratch space
+ * @param now Current time
+ * @return 0 on success, -1 if the connection failed
+ */
+static int load_receive(load_worker_t *worker, load_conn_t *conn, unsigned char *buffer,
+                        uint64_t now) {
+    size_t size = worker->config->message_size;
+    int stream = worker->config->socket_type == SOCK_STREAM;
+
+    for (;;) {
+        ssize_t received = recv(conn->fd, buffer, READ_BUFFER_SIZE, 0);
+
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            perror(errno == ECONNREFUSED ? "Server not listening" : "recv");
+            return -1;
+        }
+        if (received == 0 && stream) {
+            fprintf(stderr, "Server closed a connection\n");
+            return -1;
+        }
+
+        if (!stream) {
+            if ((size_t)received >= LOAD_HEADER_SIZE) {
+                load_answer(worker, conn, buffer, now);
+            }
+            continue;
+        }
+
+        // Split the byte stream back into messages
+        for (size_t offset = 0; offset < (size_t)received; ) {
+            size_t take = size - conn->in_len;
+
+            if (take > (size_t)received - offset) {
+                take = (size_t)received - offset;
+            }
+            if (conn->in_len < LOAD_HEADER_SIZE) {
+                size_t header = LOAD_HEADER_SIZE - conn->in_len;
+                memcpy(conn->in_header + conn->in_len, buffer + offset,
+                       header < take ? header : take);
+            }
+            conn->in_len += take;
+            offset += take;
+            if (conn->in_len == size) {
+                load_answer(worker, conn, conn->in_header, now);
+                conn->in_len = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Worker thread: drive this worker's connections for one run
+ * @param arg Worker
+ * @return NULL
+ */
+static void *load_worker_thread(void *arg) {
+    load_worker_t *worker = (load_worker_t *)arg;
+    const load_config_t *config = worker->config;
+    struct epoll_event events[MAX_EVENTS];
+    unsigned char *buffer = malloc(READ_BUFFER_SIZE);
+    unsigned char *message = calloc(1, config->message_size);
+    uint64_t interval = 0;
+    uint64_t start, end, stop;
+    int epfd = epoll_create1(0);
+
+    if (!buffer || !message || epfd < 0) {
+        perror("Failed to set up load worker");
+        goto fail;
+    }
+    for (int i = 0; i < worker->count; i++) {
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = &worker->conns[i] };
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, worker->conns[i].fd, &event) < 0) {
+            perror("epoll_ctl");
+            goto fail;
+        }
+    }
+
+    start = bench_now_ns();
+    end = start + (uint64_t)(config->seconds * 1e9);
+    stop = end + LOAD_DRAIN_MS * NS_PER_MS;
+    if (config->rate > 0) {
+        interval = (uint64_t)(1e9 * config->connections / config->rate);
+        if (interval == 0) {
+            interval = 1;
+        }
+        for (int i = 0; i < worker->count; i++) {
+            worker->conns[i].next_due_ns =
+                start + interval * (uint64_t)(worker->first + i) / (uint64_t)config->connections;
+        }
+    }
+
+    for (;;) {
+        uint64_t now = bench_now_ns();
+        uint64_t wake = now < end ? end : stop;
+        struct timespec timeout;
+        long pending = 0;
+        int count;
+
+        for (int i = 0; i < worker->count; i++) {
+            load_conn_t *conn = &worker->conns[i];
+
+            if (now < end && load_issue(worker, epfd, conn, message, now, interval) < 0) {
+                goto fail;
+            }
+            if (config->socket_type == SOCK_DGRAM && conn->in_flight > 0) {
+                uint64_t give_up = conn->last_answer_ns + LOAD_LOSS_TIMEOUT_MS * NS_PER_MS;
+                if (now >= give_up) {
+                    worker->lost += (unsigned long)conn->in_flight;
+                    conn->lost_below = conn->seq;
+                    conn->in_flight = 0;
+                } else if (give_up < wake) {
+                    wake = give_up;
+                }
+            }
+            pending += conn->in_flight;
+            if (interval != 0 && now < end && conn->in_flight < config->pipeline &&
+                conn->next_due_ns < wake) {
+                wake = conn->next_due_ns;
+            }
+        }
+        if (now >= end && (pending == 0 || now >= stop)) {
+            break;
+        }
+
+        timeout.tv_sec = wake > now ? (time_t)((wake - now) / 1000000000ULL) : 0;
+        timeout.tv_nsec = wake > now ? (long)((wake - now) % 1000000000ULL) : 0;
+        count = epoll_pwait2(epfd, events, MAX_EVENTS, &timeout, NULL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_pwait2");
+            goto fail;
+        }
+
+        now = bench_now_ns();
+        for (int i = 0; i < count; i++) {
+            load_conn_t *conn = events[i].data.ptr;
+
+            if ((events[i].events & EPOLLOUT) && load_flush(epfd, conn) < 0) {
+                goto fail;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) &&
+                load_receive(worker, conn, buffer, now) < 0) {
+                goto fail;
+            }
+        }
+    }
+
+    // Whatever is still in flight never got an answer
+    for (int i = 0; i < worker->count; i++) {
+        worker->lost += (unsigned long)worker->conns[i].in_flight;
+    }
+    goto out;
+
+fail:
+    worker->failed = 1;
+out:
+    if (epfd >= 0) {
+        close(epfd);
+    }
+    free(buffer);
+    free(message);
+    return NULL;
+}
+
+long load_run(const load_config_t *config, bench_histogram_t *latency, unsigned long *lost) {
+    load_worker_t *workers = calloc((size_t)config->threads, sizeof(*workers));
+    load_conn_t *conns = calloc((size_t)config->connections, sizeof(*conns));
+    int connected = 0;
+    int started = 0;
+    long answered = 0;
+    int failed = 0;
+
+    if (lost) {
+        *lost = 0;
+    }
+    if (!workers || !conns) {
+        perror("Failed to allocate load generator");
+        free(workers);
+        free(conns);
+        return -1;
+    }
+
+    // Connect everything before the clock starts
+    for (; connected < config->connections; connected++) {
+        if (load_connect(config, &conns[connected]) < 0) {
+            failed = 1;
+            break;
+        }
+    }
+
+    for (int t = 0; !failed && t < config->threads; t++) {
+        load_worker_t *worker = &workers[t];
+        int first = (int)((long)t * config->connections / config->threads);
+        int last = (int)((long)(t + 1) * config->connections / config->threads);
+        int result;
+
+        worker->config = config;
+        worker->conns = &conns[first];
+        worker->first = first;
+        worker->count = last - first;
+        bench_histogram_init(&worker->latency);
+
+        result = pthread_create(&worker->thread, NULL, load_worker_thread, worker);
+        if (result != 0) {
+            errno = result;
+            perror("Failed to create load worker");
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t].thread, NULL);
+        failed |= workers[t].failed;
+        bench_histogram_merge(latency, &workers[t].latency);
+        answered += (long)workers[t].answered;
+        if (lost) {
+            *lost += workers[t].lost;
+        }
+    }
+
+    for (int i = 0; i < connected; i++) {
+        load_disconnect(&conns[i]);
+    }
+    free(conns);
+    free(workers);
+    return failed ? -1 : answered;
+}
+
+// Harness body: one run of the configured load
+static long load_repetition(void *arg, bench_histogram_t *latency) {
+    unsigned long lost;
+    long answered = load_run((const load_config_t *)arg, latency, &lost);
+
+    if (lost > 0) {
+        fprintf(stderr, "%lu requests got no answer\n", lost);
+    }
+    return answered;
+}
+
+// Print the --load options
+static void load_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s --load [-c connections] [-t threads] [-p pipeline] [-r rate]\n"
+            "       [-d seconds] [-s bytes] [host] [port]\n"
+            "  -c  connections in total (default %d)\n"
+            "  -t  worker threads (default one per CPU, at most one per connection)\n"
+            "  -p  requests in flight per connection (default %d)\n"
+            "  -r  open loop at this many requests per second in total (default closed loop)\n"
+            "  -d  sending time per repetition (default %.1f s, scaled by BENCH_SCALE)\n"
+            "  -s  message size, %d to %d bytes (default %d)\n",
+            program, LOAD_DEFAULT_CONNECTIONS, LOAD_DEFAULT_PIPELINE, LOAD_DEFAULT_SECONDS,
+            LOAD_HEADER_SIZE, LOAD_MAX_MESSAGE, LOAD_DEFAULT_MESSAGE);
+}
+
+int load_main(int socket_type, int argc, char *argv[]) {
+    load_config_t config = {
+        .socket_type = socket_type,
+        .connections = LOAD_DEFAULT_CONNECTIONS,
+        .pipeline = LOAD_DEFAULT_PIPELINE,
+        .message_size = LOAD_DEFAULT_MESSAGE,
+        .seconds = LOAD_DEFAULT_SECONDS,
+    };
+    const char *program = socket_type == SOCK_STREAM ? "tcp_client" : "udp_client";
+    const char *host = DEFAULT_HOST;
+    int port = DEFAULT_PORT;
+    bench_config_t bench;
+    char name[96];
+    char mode[32];
+    long cpus;
+    int opt;
+
+    optind = 1;
+    while ((opt = getopt(argc, argv, "c:t:p:r:d:s:")) != -1) {
+        switch (opt) {
+        case 'c': config.connections = atoi(optarg); break;
+        case 't': config.threads = atoi(optarg); break;
+        case 'p': config.pipeline = atoi(optarg); break;
+        case 'r': config.rate = atof(optarg); break;
+        case 'd': config.seconds = atof(optarg); break;
+        case 's': config.message_size = strtoul(optarg, NULL, 10); break;
+        default:
+            load_usage(program);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind < argc) {
+        host = argv[optind++];
+    }
+    if (optind < argc) {
+        port = atoi(argv[optind++]);
+    }
+
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (config.threads == 0) {
+        config.threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (config.threads > config.connections) {
+        config.threads = config.connections;
+    }
+    if (optind < argc || config.connections < 1 || config.pipeline < 1 ||
+        config.threads < 1 || config.threads > MAX_THREADS || config.rate < 0 ||
+        config.seconds <= 0 || config.message_size < LOAD_HEADER_SIZE ||
+        config.message_size > LOAD_MAX_MESSAGE || port <= 0 || port > 65535) {
+        load_usage(program);
+        return EXIT_FAILURE;
+    }
+
+    memset(&config.server, 0, sizeof(config.server));
+    config.server.sin_family = AF_INET;
+    config.server.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host, &config.server.sin_addr) <= 0) {
+        fprintf(stderr, "Invalid address: %s\n", host);
+        return EXIT_FAILURE;
+    }
+
+    bench_config_init(&bench, program);
+    config.seconds *= bench.scale;
+
+    if (config.rate > 0) {
+        snprintf(mode, sizeof(mode), "open=%.0f/s", config.rate);
+    } else {
+        snprintf(mode, sizeof(mode), "closed");
+    }
+    snprintf(name, sizeof(name), "%s/conns=%d/pipeline=%d/%s",
+             socket_type == SOCK_STREAM ? "tcp" : "udp", config.connections,
+             config.pipeline, mode);
+
+    // On stderr so CSV or JSON on stdout stays parseable
+    fprintf(stderr, "Load on %s:%d: %d connections over %d threads, %zu-byte messages, "
+            "%.2f s per repetition\n", host, port, config.connections, config.threads,
+            config.message_size, config.seconds);
+
+    return bench_case(&bench, name, load_repetition, &config) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,68 @@
+/**
+ * Load Generator Interface
+ *
+ * Drives an echo server over many connections at once, for the --load
+ * modes of tcp_client and udp_client. Features include:
+ * - Connections spread over worker threads, each running an epoll loop
+ * - A configurable number of requests in flight per connection
+ * - Closed loop (keep every pipeline full) or open loop at a constant
+ *   total rate; open-loop latency is measured from when each request was
+ *   due, not when it was sent, so a stalled server cannot hide its
+ *   queueing delay (no coordinated omission)
+ * - Per-request latency in the log-linear histogram from bench.h, with
+ *   results reported through the shared benchmark harness
+ *
+ * Every request carries a sequence number and its due time in the first
+ * 16 bytes, which the server echoes back unchanged.
+ */
+
+#ifndef LOAD_GEN_H
+#define LOAD_GEN_H
+
+#include <stddef.h>
+#include <netinet/in.h>
+
+#include "bench.h"
+
+// Constants
+#define LOAD_HEADER_SIZE 16             // Sequence number and due time
+#define LOAD_MAX_MESSAGE 65507          // Largest UDP payload
+#define LOAD_DEFAULT_CONNECTIONS 16
+#define LOAD_DEFAULT_PIPELINE 1
+#define LOAD_DEFAULT_MESSAGE 64
+#define LOAD_DEFAULT_SECONDS 1.0        // Per repetition, scaled by BENCH_SCALE
+
+// Load to generate
+typedef struct {
+    int socket_type;            // SOCK_STREAM or SOCK_DGRAM
+    struct sockaddr_in server;
+    int threads;
+    int connections;            // Over all threads
+    int pipeline;               // Requests in flight per connection
+    size_t message_size;
+    double rate;                // Requests per second over all connections, 0 for closed loop
+    double seconds;             // Sending time per repetition
+} load_config_t;
+
+/**
+ * Parse the options of a --load mode and run it through the harness
+ *
+ * Options: -c connections, -t threads, -p pipeline depth, -r total rate
+ * (open loop), -d seconds, -s message bytes, then optional host and port.
+ * @param socket_type SOCK_STREAM or SOCK_DGRAM
+ * @param argc Argument count, starting at the --load argument
+ * @param argv Arguments, starting at the --load argument
+ * @return Exit status
+ */
+int load_main(int socket_type, int argc, char *argv[]);
+
+/**
+ * Generate load once, as one benchmark repetition
+ * @param config Load to generate
+ * @param latency Receives one sample per answered request
+ * @param lost Receives the requests that got no answer, may be NULL
+ * @return Answered requests, -1 on error
+ */
+long load_run(const load_config_t *config, bench_histogram_t *latency, unsigned long *lost);
+
+#endif // LOAD_GEN_H
@@ -6,7 +6,11 @@
  * - Error handling and logging
  * - Resource management
  * - Message processing
+ * - Batched receive with recvmmsg, plus UDP GRO
  * - Graceful shutdown
+ *
+ * Usage: multicast_receiver [batch]
+ *        batch is the number of datagrams per syscall (default 32)
  */
 
 #include <stdio.h>
@@ -18,11 +22,16 @@
 #include <arpa/inet.h>
 #include <signal.h>
 #include <errno.h>
+#include <poll.h>
+
+#include "udp_batch.h"
+#include "stats.h"
 
 // Constants
 #define BUFFER_SIZE 1024
 #define MULTICAST_GROUP "239.0.0.1"
 #define MULTICAST_PORT 8888
+#define POLL_TIMEOUT_MS 1000        // How often an idle receiver checks for shutdown
 
 // Global variables
 static volatile sig_atomic_t running = 1;
@@ -46,8 +55,8 @@ static int init_receiver(void) {
     struct ip_mreq mreq;
     int reuse = 1;
 
-    // Create socket
-    receiver_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    // Create socket; non-blocking so batches can drain it
+    receiver_socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
     if (receiver_socket < 0) {
         perror("socket");
         return -1;
@@ -89,61 +98,97 @@ static int init_receiver(void) {
 }
 
 /**
- * Receive multicast message
- * @param buffer Buffer to store received message
- * @param max_length Maximum length of buffer
- * @return Number of bytes received, -1 on error
+ * Receive a batch of multicast messages
+ * Waits up to POLL_TIMEOUT_MS for the first one.
+ * @param batch Message ring to fill
+ * @return Number of messages received (0 on timeout or signal), -1 on error
  */
-static ssize_t receive_multicast(char *buffer, size_t max_length) {
-    ssize_t bytes_received = recvfrom(receiver_socket, buffer, max_length - 1, 0,
-                                     NULL, NULL);
-    if (bytes_received < 0) {
+static int receive_multicast(udp_batch_t *batch) {
+    struct pollfd receiver_poll = { .fd = receiver_socket, .events = POLLIN };
+
+    if (poll(&receiver_poll, 1, POLL_TIMEOUT_MS) < 0) {
         if (errno == EINTR) {
             return 0;
         }
-        perror("recvfrom");
+        perror("poll");
         return -1;
     }
-    buffer[bytes_received] = '\0';
-    return bytes_received;
+
+    return udp_batch_recv(receiver_socket, batch);
+}
+
+/**
+ * Print every datagram of a received message, splitting GRO segments
+ * @param batch Message ring
+ * @param index Message index
+ */
+static void print_message(const udp_batch_t *batch, unsigned int index) {
+    const char *data = udp_batch_data(batch, index);
+    size_t length = udp_batch_length(batch, index);
+    size_t segment = udp_batch_segment_size(batch, index);
+
+    for (size_t offset = 0; offset < length; offset += segment) {
+        size_t part = (length - offset < segment) ? length - offset : segment;
+        printf("Received message: %.*s\n", (int)part, data + offset);
+    }
 }
 
 /**
  * Main function implementing multicast receiver
+ * @param argc Argument count
+ * @param argv Arguments: optional batch size
  * @return 0 on success, 1 on error
  */
-int main(void) {
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_received;
+int main(int argc, char *argv[]) {
+    udp_batch_t batch;
+    int batch_size = UDP_BATCH_DEFAULT;
+    int gro;
+    int count;
+
+    if (argc > 1) {
+        batch_size = atoi(argv[1]);
+    }
 
     // Set up signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
+    // Publish byte and packet counters for ui/menu; optional
+    stats_init("multicast_receiver");
+
     // Initialize receiver
     if (init_receiver() < 0) {
         return 1;
     }
 
+    gro = (batch_size > 1 && udp_enable_gro(receiver_socket) == 0);
+    if (udp_batch_init(&batch, (unsigned int)(batch_size > 0 ? batch_size : 1),
+                       gro ? UDP_GRO_BUFFER_SIZE : BUFFER_SIZE - 1, gro) < 0) {
+        close(receiver_socket);
+        return 1;
+    }
+
     printf("Multicast Receiver started\n");
     printf("Group: %s, Port: %d\n", MULTICAST_GROUP, MULTICAST_PORT);
     printf("Press Ctrl+C to exit\n");
 
     // Main receiver loop
     while (running) {
-        bytes_received = receive_multicast(buffer, BUFFER_SIZE);
-        if (bytes_received < 0) {
+        count = receive_multicast(&batch);
+        if (count < 0) {
             break;
-        } else if (bytes_received > 0) {
-            printf("Received message: %s\n", buffer);
+        }
+        for (int i = 0; i < count; i++) {
+            print_message(&batch, (unsigned int)i);
         }
     }
 
     // Cleanup
     printf("Shutting down multicast receiver...\n");
+    udp_batch_free(&batch);
     if (receiver_socket != -1) {
         close(receiver_socket);
     }
 
     return 0;
-} 
\ No newline at end of file
+}
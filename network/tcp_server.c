@@ -1,49 +1,94 @@
 /**
  * TCP Server Implementation with Enhanced Features
- * 
+ *
  * This program demonstrates a robust TCP server implementation with:
- * - Multiple client handling
+ * - Multiple client handling on epoll event loops
+ * - Reactor threads sharded with SO_REUSEPORT
+ * - Non-blocking, edge-triggered client sockets
+ * - Idle client timeouts on a timer wheel per reactor
  * - Graceful shutdown
  * - Error handling and logging
  * - Resource management
  * - Client connection tracking
+ * - Optional zero-copy echo through a pipe with splice(2)
+ * - Byte and packet counters published through stats.h
+ *
+ * Usage: tcp_server [--splice] [--buffer bytes] [port] [reactors]
+ * reactors defaults to the number of online CPUs. --buffer sets how many
+ * bytes are moved per recv/send (or splice) call.
  */
 
+#define _GNU_SOURCE             // accept4, splice, F_SETPIPE_SZ
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <pthread.h>
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+
+#include "timer_wheel.h"
+#include "async_log.h"
+#include "stats.h"
 
 #define LOG_FILE "tcp_server.log"
 
 // Constants
-#define MAX_CLIENTS 10
-#define BUFFER_SIZE 1024
+#define MAX_CLIENTS 65536           // Concurrent clients across all reactors
+#define BUFFER_SIZE 65536           // Default bytes moved per echo call
+#define MIN_BUFFER_SIZE 1024
+#define MAX_BUFFER_SIZE (16 * 1024 * 1024)
 #define PORT 8080
-#define BACKLOG 5
-#define TIMEOUT_SECONDS 30
+#define BACKLOG SOMAXCONN
+#define MAX_REACTORS 64
+#define MAX_EVENTS 256              // Events handled per epoll_wait call
+#define ACCEPT_BATCH 64             // Connections accepted per listener wakeup
+#define EPOLL_TIMEOUT_MS 1000       // How often idle reactors check for shutdown
+#define TIMEOUT_SECONDS 30          // Idle time after which a client is dropped
+#define TIMER_TICK_MS 100           // Resolution of the idle timeout
 
 // Structure to hold client information
-typedef struct {
+typedef struct client_info {
     int socket;
     struct sockaddr_in address;
-    time_t last_activity;
-    pthread_t thread_id;
-    int active;
+    uint64_t last_activity;         // Reactor time of the last received data, in ms
+    timer_node_t idle_timer;
+    char *pending;                  // Echo bytes the socket has not taken yet, allocated on first use
+    size_t pending_len;
+    size_t pending_off;
+    int pipe_fds[2];                // Splice mode: pipe holding the echo in flight
+    size_t piped;                   // Bytes in the pipe not yet spliced out
+    struct client_info *prev;       // Links in the owning reactor's client list
+    struct client_info *next;
 } client_info_t;
 
+// One event loop with its own listening socket and clients
+typedef struct {
+    int listen_socket;
+    int epoll_fd;
+    int reserve_fd;                 // Spare descriptor given up to shed clients at EMFILE
+    pthread_t thread;
+    char *buffer;                   // Receive buffer for copy mode, buffer_size bytes
+    client_info_t *clients;
+    timer_wheel_t timers;           // Idle timers of this reactor's clients
+    uint64_t now_ms;                // Time of the last epoll_wait return
+} reactor_t;
+
 // Global variables
-static client_info_t clients[MAX_CLIENTS];
-static pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
-static int server_socket;
+static reactor_t reactors[MAX_REACTORS];
+static atomic_int active_clients = 0;
 static volatile sig_atomic_t running = 1;
+static size_t buffer_size = BUFFER_SIZE;
+static int splice_mode = 0;
 
 /**
  * Signal handler for graceful shutdown
@@ -55,213 +100,641 @@ static void signal_handler(int sig) {
 }
 
 /**
- * Initialize client information
+ * Raise the open file limit to the hard limit so MAX_CLIENTS is reachable
  */
-static void init_clients(void) {
-    pthread_mutex_lock(&clients_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        clients[i].socket = -1;
-        clients[i].active = 0;
+static void raise_fd_limit(void) {
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+            perror("setrlimit");
+        }
+    }
+}
+
+/**
+ * Create a non-blocking listening socket in the SO_REUSEPORT group
+ * @param port Server port number
+ * @return Socket on success, -1 on error
+ */
+static int create_listen_socket(int port) {
+    struct sockaddr_in server_addr;
+    int opt = 1;
+    int listen_socket;
+
+    // Create server socket
+    listen_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_socket < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    // Set socket options; SO_REUSEPORT lets the kernel spread incoming
+    // connections across one listening socket per reactor
+    if (setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0 ||
+        setsockopt(listen_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt");
+        close(listen_socket);
+        return -1;
+    }
+
+    // Initialize server address structure
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+
+    // Bind socket
+    if (bind(listen_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        perror("bind");
+        close(listen_socket);
+        return -1;
     }
-    pthread_mutex_unlock(&clients_mutex);
+
+    // Listen for connections
+    if (listen(listen_socket, BACKLOG) < 0) {
+        perror("listen");
+        close(listen_socket);
+        return -1;
+    }
+
+    return listen_socket;
 }
 
 /**
- * Find available client slot
- * @return Index of available slot, -1 if none available
+ * Set up a reactor's listening socket and epoll instance
+ * @param reactor Reactor to initialize
+ * @param port Server port number
+ * @return 0 on success, -1 on error
  */
-static int find_available_slot(void) {
-    pthread_mutex_lock(&clients_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (!clients[i].active) {
-            pthread_mutex_unlock(&clients_mutex);
-            return i;
+static int init_reactor(reactor_t *reactor, int port) {
+    struct epoll_event event;
+
+    reactor->clients = NULL;
+    reactor->now_ms = timer_wheel_now_ms();
+    timer_wheel_init(&reactor->timers, reactor->now_ms, TIMER_TICK_MS);
+    reactor->buffer = NULL;
+    if (!splice_mode) {
+        reactor->buffer = malloc(buffer_size);
+        if (!reactor->buffer) {
+            perror("malloc");
+            return -1;
         }
     }
-    pthread_mutex_unlock(&clients_mutex);
-    return -1;
+
+    reactor->listen_socket = create_listen_socket(port);
+    if (reactor->listen_socket < 0) {
+        free(reactor->buffer);
+        return -1;
+    }
+
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epoll_fd < 0) {
+        perror("epoll_create1");
+        close(reactor->listen_socket);
+        free(reactor->buffer);
+        return -1;
+    }
+
+    reactor->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    // The listener stays level-triggered: accepts are capped per wakeup so
+    // a connection burst cannot starve established clients, and whatever is
+    // left in the backlog is reported again on the next epoll_wait
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->listen_socket, &event) < 0) {
+        perror("epoll_ctl");
+        close(reactor->reserve_fd);
+        close(reactor->epoll_fd);
+        close(reactor->listen_socket);
+        free(reactor->buffer);
+        return -1;
+    }
+
+    return 0;
 }
 
 /**
- * Function to log messages to a file
- * @param message Message to log
+ * Refuse one pending connection when out of file descriptors
+ *
+ * The level-triggered listener would otherwise report the same pending
+ * connection forever, so the reserve descriptor is freed just long enough
+ * to accept the connection and close it.
+ * @param reactor Reactor whose process hit EMFILE
  */
-static void log_message(const char *message) {
-    FILE *log_file = fopen(LOG_FILE, "a");
-    if (log_file) {
-        time_t now = time(NULL);
-        fprintf(log_file, "%s: %s\n", ctime(&now), message);
-        fclose(log_file);
+static void shed_client(reactor_t *reactor) {
+    int client_socket;
+
+    if (reactor->reserve_fd < 0) {
+        return;
     }
+
+    close(reactor->reserve_fd);
+    client_socket = accept(reactor->listen_socket, NULL, NULL);
+    if (client_socket >= 0) {
+        close(client_socket);
+    }
+    reactor->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    async_log(ASYNC_LOG_WARN, "No available slots for new client");
 }
 
 /**
- * Handle client connection
- * @param arg Client information structure
- * @return NULL
+ * Close a client connection and release its slot
+ * @param reactor Owning reactor
+ * @param client Client to close
  */
-static void *handle_client(void *arg) {
-    client_info_t *client = (client_info_t *)arg;
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_received;
-    time_t current_time;
+static void close_client(reactor_t *reactor, client_info_t *client) {
+    // Closing the socket also removes it from the epoll set
+    close(client->socket);
+    if (client->pipe_fds[0] >= 0) {
+        close(client->pipe_fds[0]);
+        close(client->pipe_fds[1]);
+    }
+    timer_wheel_cancel(&reactor->timers, &client->idle_timer);
+
+    if (client->prev) {
+        client->prev->next = client->next;
+    } else {
+        reactor->clients = client->next;
+    }
+    if (client->next) {
+        client->next->prev = client->prev;
+    }
 
-    printf("Client connected: %s:%d\n",
-           inet_ntoa(client->address.sin_addr),
-           ntohs(client->address.sin_port));
+    free(client->pending);
+    free(client);
+    atomic_fetch_sub(&active_clients, 1);
+}
 
-    while (running) {
-        // Check for timeout
-        current_time = time(NULL);
-        if (current_time - client->last_activity > TIMEOUT_SECONDS) {
-            printf("Client timeout: %s:%d\n",
-                   inet_ntoa(client->address.sin_addr),
-                   ntohs(client->address.sin_port));
-            break;
+/**
+ * Create the pipe a splice-mode client echoes through
+ *
+ * The pipe is sized to buffer_size where the system allows, so one splice
+ * can move a whole buffer; the default capacity is 64 KiB.
+ * @param client New client
+ * @return 0 on success, -1 on error
+ */
+static int open_client_pipe(client_info_t *client) {
+    if (pipe2(client->pipe_fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        client->pipe_fds[0] = -1;
+        client->pipe_fds[1] = -1;
+        perror("pipe2");
+        return -1;
+    }
+    if (buffer_size > BUFFER_SIZE) {
+        // Best effort: capped by /proc/sys/fs/pipe-max-size
+        fcntl(client->pipe_fds[1], F_SETPIPE_SZ, (int)buffer_size);
+    }
+    return 0;
+}
+
+/**
+ * Accept pending connections on a reactor's listening socket
+ * @param reactor Reactor whose listener is readable
+ */
+static void accept_clients(reactor_t *reactor) {
+    struct sockaddr_in client_addr;
+    socklen_t client_len;
+    struct epoll_event event;
+    client_info_t *client;
+    int client_socket;
+
+    for (int i = 0; i < ACCEPT_BATCH; i++) {
+        client_len = sizeof(client_addr);
+        client_socket = accept4(reactor->listen_socket, (struct sockaddr *)&client_addr,
+                                &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                shed_client(reactor);
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept4");
+            }
+            return;
+        }
+
+        // Reserve a slot
+        if (atomic_fetch_add(&active_clients, 1) >= MAX_CLIENTS) {
+            atomic_fetch_sub(&active_clients, 1);
+            async_log(ASYNC_LOG_WARN, "No available slots for new client");
+            close(client_socket);
+            continue;
+        }
+
+        client = malloc(sizeof(*client));
+        if (!client) {
+            perror("malloc");
+            atomic_fetch_sub(&active_clients, 1);
+            close(client_socket);
+            continue;
+        }
+
+        // Initialize client information
+        client->socket = client_socket;
+        client->address = client_addr;
+        client->last_activity = reactor->now_ms;
+        timer_node_init(&client->idle_timer);
+        client->pending = NULL;
+        client->pending_len = 0;
+        client->pending_off = 0;
+        client->pipe_fds[0] = -1;
+        client->pipe_fds[1] = -1;
+        client->piped = 0;
+        client->prev = NULL;
+        client->next = reactor->clients;
+        if (reactor->clients) {
+            reactor->clients->prev = client;
         }
+        reactor->clients = client;
+        timer_wheel_schedule(&reactor->timers, &client->idle_timer,
+                             client->last_activity + TIMEOUT_SECONDS * 1000ULL);
 
+        if (splice_mode && open_client_pipe(client) < 0) {
+            close_client(reactor, client);
+            continue;
+        }
+
+        // Edge-triggered: each readiness change is reported once, so the
+        // handler drains the socket until EAGAIN
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = client;
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, client_socket, &event) < 0) {
+            perror("epoll_ctl");
+            close_client(reactor, client);
+            continue;
+        }
+
+        async_log(ASYNC_LOG_INFO, "Client connected: " ASYNC_LOG_ADDR_FMT,
+                  ASYNC_LOG_ADDR_ARGS(&client->address));
+    }
+}
+
+/**
+ * Send as much of a client's pending echo data as the socket will take
+ * @param client Client with pending data
+ * @return 0 when drained or the socket is full, -1 on error
+ */
+static int flush_pending(client_info_t *client) {
+    while (client->pending_len > 0) {
+        ssize_t bytes_sent = send(client->socket,
+                                  client->pending + client->pending_off,
+                                  client->pending_len, MSG_NOSIGNAL);
+        if (bytes_sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            perror("send");
+            return -1;
+        }
+        stats_add(STATS_NET_TX_PACKETS, 1);
+        stats_add(STATS_NET_TX_BYTES, (uint64_t)bytes_sent);
+        client->pending_off += (size_t)bytes_sent;
+        client->pending_len -= (size_t)bytes_sent;
+    }
+
+    client->pending_off = 0;
+    return 0;
+}
+
+/**
+ * Handle readiness events on a client connection
+ *
+ * Echoes everything received. When the peer reads slower than it writes,
+ * the unsent part is kept in the client's pending buffer and reading stops
+ * until EPOLLOUT reports that the socket has room again.
+ * Activity only refreshes a timestamp; the idle timer is pushed back
+ * lazily when it fires.
+ * @param reactor Owning reactor
+ * @param client Client the events belong to
+ * @param events Events reported by epoll
+ * @return 0 to keep the connection, -1 to close it
+ */
+static int handle_client(reactor_t *reactor, client_info_t *client, uint32_t events) {
+    char *buffer = reactor->buffer;
+    ssize_t bytes_received;
+    ssize_t bytes_sent;
+
+    if (events & EPOLLERR) {
+        return -1;
+    }
+
+    // Finish the previous echo before reading more
+    if (flush_pending(client) < 0) {
+        return -1;
+    }
+    if (client->pending_len > 0) {
+        return 0;
+    }
+
+    while (running) {
         // Receive data
-        bytes_received = recv(client->socket, buffer, BUFFER_SIZE - 1, 0);
+        bytes_received = recv(client->socket, buffer, buffer_size, 0);
         if (bytes_received <= 0) {
             if (bytes_received == 0) {
-                printf("Client disconnected: %s:%d\n",
-                       inet_ntoa(client->address.sin_addr),
-                       ntohs(client->address.sin_port));
-            } else {
-                perror("recv");
+                async_log(ASYNC_LOG_INFO, "Client disconnected: " ASYNC_LOG_ADDR_FMT,
+                          ASYNC_LOG_ADDR_ARGS(&client->address));
+                return -1;
             }
-            break;
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            perror("recv");
+            return -1;
         }
 
         // Update last activity time
-        client->last_activity = current_time;
-
-        // Null-terminate received data
-        buffer[bytes_received] = '\0';
+        client->last_activity = reactor->now_ms;
+        stats_add(STATS_NET_RX_PACKETS, 1);
+        stats_add(STATS_NET_RX_BYTES, (uint64_t)bytes_received);
 
         // Echo back to client
-        if (send(client->socket, buffer, bytes_received, 0) < 0) {
-            perror("send");
-            break;
+        bytes_sent = send(client->socket, buffer, (size_t)bytes_received, MSG_NOSIGNAL);
+        if (bytes_sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("send");
+                return -1;
+            }
+            bytes_sent = 0;
+        } else {
+            stats_add(STATS_NET_TX_PACKETS, 1);
+            stats_add(STATS_NET_TX_BYTES, (uint64_t)bytes_sent);
         }
-    }
 
-    // Cleanup
-    close(client->socket);
-    client->active = 0;
+        if (bytes_sent < bytes_received) {
+            if (!client->pending) {
+                client->pending = malloc(buffer_size);
+                if (!client->pending) {
+                    perror("malloc");
+                    return -1;
+                }
+            }
+            client->pending_len = (size_t)(bytes_received - bytes_sent);
+            client->pending_off = 0;
+            memcpy(client->pending, buffer + bytes_sent, client->pending_len);
+            return 0;
+        }
+    }
 
-    return NULL;
+    return 0;
 }
 
 /**
- * Main function implementing TCP server
- * @return 0 on success, 1 on error
+ * Handle readiness events on a splice-mode client connection
+ *
+ * Echoes without copying through user space: data is spliced from the
+ * socket into the client's pipe and from the pipe back into the socket.
+ * Bytes the socket cannot take yet simply stay in the pipe, which plays
+ * the role of the pending buffer in copy mode.
+ * @param reactor Owning reactor
+ * @param client Client the events belong to
+ * @param events Events reported by epoll
+ * @return 0 to keep the connection, -1 to close it
  */
-int main(void) {
-    struct sockaddr_in server_addr;
-    int client_socket;
-    struct sockaddr_in client_addr;
-    socklen_t client_len;
-    int slot;
-    int opt = 1;
-
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+static int handle_client_splice(reactor_t *reactor, client_info_t *client, uint32_t events) {
+    ssize_t moved;
 
-    // Create server socket
-    server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket < 0) {
-        perror("socket");
-        return 1;
+    if (events & EPOLLERR) {
+        return -1;
     }
 
-    // Set socket options
-    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        perror("setsockopt");
-        close(server_socket);
-        return 1;
-    }
+    while (running) {
+        // Drain the pipe first; EAGAIN means the socket is full
+        if (client->piped > 0) {
+            moved = splice(client->pipe_fds[0], NULL, client->socket, NULL, client->piped,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (moved < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN) {
+                    return 0;
+                }
+                perror("splice");
+                return -1;
+            }
+            client->piped -= (size_t)moved;
+            stats_add(STATS_NET_TX_PACKETS, 1);
+            stats_add(STATS_NET_TX_BYTES, (uint64_t)moved);
+            continue;
+        }
 
-    // Initialize server address structure
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(PORT);
+        // The pipe is empty, so EAGAIN here means the socket is drained
+        moved = splice(client->socket, NULL, client->pipe_fds[1], NULL, buffer_size,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (moved <= 0) {
+            if (moved == 0) {
+                async_log(ASYNC_LOG_INFO, "Client disconnected: " ASYNC_LOG_ADDR_FMT,
+                          ASYNC_LOG_ADDR_ARGS(&client->address));
+                return -1;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                return 0;
+            }
+            perror("splice");
+            return -1;
+        }
 
-    // Bind socket
-    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        perror("bind");
-        close(server_socket);
-        return 1;
+        client->last_activity = reactor->now_ms;
+        client->piped = (size_t)moved;
+        stats_add(STATS_NET_RX_PACKETS, 1);
+        stats_add(STATS_NET_RX_BYTES, (uint64_t)moved);
     }
 
-    // Listen for connections
-    if (listen(server_socket, BACKLOG) < 0) {
-        perror("listen");
-        close(server_socket);
-        return 1;
+    return 0;
+}
+
+/**
+ * Timer wheel callback: drop a client that has been idle too long
+ * @param timer Expired idle timer
+ * @param arg Owning reactor
+ */
+static void expire_client(timer_node_t *timer, void *arg) {
+    reactor_t *reactor = (reactor_t *)arg;
+    client_info_t *client = timer_entry(timer, client_info_t, idle_timer);
+    uint64_t deadline = client->last_activity + TIMEOUT_SECONDS * 1000ULL;
+
+    // Traffic since the timer was armed: re-arm for the new deadline
+    if (deadline > reactor->now_ms) {
+        timer_wheel_schedule(&reactor->timers, timer, deadline);
+        return;
     }
 
-    printf("Server listening on port %d...\n", PORT);
-    log_message("TCP server started");
+    async_log(ASYNC_LOG_INFO, "Client timeout: " ASYNC_LOG_ADDR_FMT,
+              ASYNC_LOG_ADDR_ARGS(&client->address));
+    close_client(reactor, client);
+}
 
-    // Initialize clients array
-    init_clients();
+/**
+ * Reactor thread: runs one epoll event loop until shutdown
+ * @param arg Reactor to run
+ * @return NULL
+ */
+static void *reactor_thread(void *arg) {
+    reactor_t *reactor = (reactor_t *)arg;
+    struct epoll_event events[MAX_EVENTS];
+    int timeout;
+    int count;
 
-    // Main server loop
     while (running) {
-        client_len = sizeof(client_addr);
-        client_socket = accept(server_socket, (struct sockaddr *)&client_addr, &client_len);
-        
-        if (client_socket < 0) {
+        // Sleep until the next timer tick, or the shutdown check
+        timeout = timer_wheel_next_timeout(&reactor->timers, reactor->now_ms);
+        if (timeout < 0 || timeout > EPOLL_TIMEOUT_MS) {
+            timeout = EPOLL_TIMEOUT_MS;
+        }
+
+        count = epoll_wait(reactor->epoll_fd, events, MAX_EVENTS, timeout);
+        reactor->now_ms = timer_wheel_now_ms();
+        if (count < 0) {
             if (errno == EINTR) {
                 continue;
             }
-            perror("accept");
-            continue;
+            perror("epoll_wait");
+            break;
         }
 
-        // Find available slot
-        slot = find_available_slot();
-        if (slot == -1) {
-            printf("No available slots for new client\n");
-            close(client_socket);
-            continue;
-        }
+        for (int i = 0; i < count; i++) {
+            client_info_t *client = events[i].data.ptr;
 
-        // Initialize client information
-        pthread_mutex_lock(&clients_mutex);
-        clients[slot].socket = client_socket;
-        clients[slot].address = client_addr;
-        clients[slot].last_activity = time(NULL);
-        clients[slot].active = 1;
-        pthread_mutex_unlock(&clients_mutex);
-
-        // Create thread for client
-        if (pthread_create(&clients[slot].thread_id, NULL, handle_client, &clients[slot]) != 0) {
-            perror("pthread_create");
-            close(client_socket);
-            clients[slot].active = 0;
+            if (client == NULL) {
+                accept_clients(reactor);
+            } else if ((splice_mode ? handle_client_splice(reactor, client, events[i].events)
+                                    : handle_client(reactor, client, events[i].events)) < 0) {
+                close_client(reactor, client);
+            }
         }
+
+        // Expire idle clients after the events, so none is freed under us
+        timer_wheel_advance(&reactor->timers, reactor->now_ms, expire_client, reactor);
     }
 
-    // Cleanup
-    printf("Shutting down server...\n");
-    log_message("TCP server finished");
-    
     // Close all client connections
-    pthread_mutex_lock(&clients_mutex);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i].active) {
-            close(clients[i].socket);
-            pthread_join(clients[i].thread_id, NULL);
+    while (reactor->clients) {
+        close_client(reactor, reactor->clients);
+    }
+    if (reactor->reserve_fd >= 0) {
+        close(reactor->reserve_fd);
+    }
+    close(reactor->epoll_fd);
+    close(reactor->listen_socket);
+    free(reactor->buffer);
+
+    return NULL;
+}
+
+/**
+ * Main function implementing TCP server
+ * @param argc Argument count
+ * @param argv Arguments: options, then optional port and reactor count
+ * @return 0 on success, 1 on error
+ */
+int main(int argc, char *argv[]) {
+    int port = PORT;
+    int num_reactors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int positional = 0;
+    int started = 0;
+    int result = 0;
+    struct sigaction sa;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--splice") == 0) {
+            splice_mode = 1;
+        } else if (strcmp(argv[i], "--buffer") == 0 && i + 1 < argc) {
+            buffer_size = strtoul(argv[++i], NULL, 0);
+        } else if (positional == 0) {
+            port = atoi(argv[i]);
+            positional++;
+        } else if (positional == 1) {
+            num_reactors = atoi(argv[i]);
+            positional++;
+        }
+    }
+    if (buffer_size < MIN_BUFFER_SIZE) {
+        buffer_size = MIN_BUFFER_SIZE;
+    }
+    if (buffer_size > MAX_BUFFER_SIZE) {
+        buffer_size = MAX_BUFFER_SIZE;
+    }
+    if (num_reactors < 1) {
+        num_reactors = 1;
+    }
+    if (num_reactors > MAX_REACTORS) {
+        num_reactors = MAX_REACTORS;
+    }
+
+    // Set up signal handlers; no SA_RESTART so epoll_wait returns early
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    raise_fd_limit();
+
+    // Publish byte and packet counters for ui/menu; optional
+    stats_init("tcp_server");
+
+    if (async_log_init(LOG_FILE, ASYNC_LOG_INFO) < 0) {
+        return 1;
+    }
+
+    // Start one reactor per listening socket
+    for (int i = 0; i < num_reactors; i++) {
+        if (init_reactor(&reactors[i], port) < 0) {
+            result = 1;
+            break;
         }
+        if (pthread_create(&reactors[i].thread, NULL, reactor_thread, &reactors[i]) != 0) {
+            perror("pthread_create");
+            close(reactors[i].reserve_fd);
+            close(reactors[i].epoll_fd);
+            close(reactors[i].listen_socket);
+            free(reactors[i].buffer);
+            result = 1;
+            break;
+        }
+        started++;
+    }
+
+    if (result == 0) {
+        printf("Server listening on port %d with %d reactor thread(s), %s echo, %zu-byte buffer...\n",
+               port, started, splice_mode ? "splice" : "copy", buffer_size);
+        async_log(ASYNC_LOG_INFO, "TCP server started");
+    } else {
+        // Stop the reactors that did start
+        running = 0;
     }
-    pthread_mutex_unlock(&clients_mutex);
 
-    // Close server socket
-    close(server_socket);
+    // Wait for all reactors to finish
+    for (int i = 0; i < started; i++) {
+        pthread_join(reactors[i].thread, NULL);
+    }
+
+    if (result != 0) {
+        async_log_shutdown();
+        return result;
+    }
+
+    // Cleanup
+    printf("Shutting down server...\n");
+    async_log(ASYNC_LOG_INFO, "TCP server finished");
+    async_log_shutdown();
 
     return 0;
-}
\ No newline at end of file
+}
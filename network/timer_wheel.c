@@ -0,0 +1,185 @@
+/**
+ * Hierarchical Timing Wheel Implementation
+ *
+ * Level 0 holds timers due within TIMER_WHEEL_SLOTS ticks, one slot per
+ * tick. Each higher level covers TIMER_WHEEL_SLOTS times the range of the
+ * one below with the same number of slots. Whenever a level wraps, the
+ * next slot of the level above is cascaded: its timers are re-inserted and
+ * land in finer slots now that they are closer to expiry.
+ */
+
+#include <time.h>
+
+#include "timer_wheel.h"
+
+// Constants
+#define LEVEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define MAX_DELTA ((1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+uint64_t timer_wheel_now_ms(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now_ms, unsigned int tick_ms) {
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot] = NULL;
+        }
+    }
+    wheel->current = 0;
+    wheel->start_ms = now_ms;
+    wheel->tick_ms = tick_ms > 0 ? tick_ms : 1;
+    wheel->pending = 0;
+}
+
+void timer_node_init(timer_node_t *timer) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+}
+
+int timer_wheel_pending(const timer_node_t *timer) {
+    return timer->pprev != NULL;
+}
+
+/**
+ * Link a timer into the slot matching its distance from the current tick
+ * @param wheel Owning wheel
+ * @param timer Idle timer with expires no earlier than the current tick
+ */
+static void insert_timer(timer_wheel_t *wheel, timer_node_t *timer) {
+    uint64_t delta = timer->expires - wheel->current;
+    uint64_t slot_tick = timer->expires;
+    timer_node_t **head;
+    int level = 0;
+
+    // Beyond the wheel's range: park in the farthest top-level slot; the
+    // cascade that reaches it re-inserts the timer with its real expiry
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA;
+        slot_tick = wheel->current + MAX_DELTA;
+    }
+
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    head = &wheel->slots[level][(slot_tick >> (TIMER_WHEEL_BITS * level)) & LEVEL_MASK];
+    timer->next = *head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+/**
+ * Unlink a pending timer from its slot
+ * @param timer Armed timer
+ */
+static void unlink_timer(timer_node_t *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+void timer_wheel_schedule(timer_wheel_t *wheel, timer_node_t *timer, uint64_t expires_ms) {
+    uint64_t elapsed = expires_ms > wheel->start_ms ? expires_ms - wheel->start_ms : 0;
+
+    if (timer_wheel_pending(timer)) {
+        unlink_timer(timer);
+    } else {
+        wheel->pending++;
+    }
+
+    // Round up so a timer never fires early; the current tick has already
+    // been processed, so anything due by now fires on the next one
+    timer->expires = (elapsed + wheel->tick_ms - 1) / wheel->tick_ms;
+    if (timer->expires <= wheel->current) {
+        timer->expires = wheel->current + 1;
+    }
+    insert_timer(wheel, timer);
+}
+
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_node_t *timer) {
+    if (timer_wheel_pending(timer)) {
+        unlink_timer(timer);
+        wheel->pending--;
+    }
+}
+
+/**
+ * Re-insert every timer of a higher-level slot
+ * @param wheel Owning wheel
+ * @param level Level to cascade from (1 or above)
+ * @return 1 if that slot index is 0, so the next level also has to cascade
+ */
+static int cascade(timer_wheel_t *wheel, int level) {
+    int slot = (int)((wheel->current >> (TIMER_WHEEL_BITS * level)) & LEVEL_MASK);
+    timer_node_t *timer = wheel->slots[level][slot];
+
+    wheel->slots[level][slot] = NULL;
+    while (timer) {
+        timer_node_t *next = timer->next;
+        timer->next = NULL;
+        timer->pprev = NULL;
+        insert_timer(wheel, timer);
+        timer = next;
+    }
+
+    return slot == 0;
+}
+
+void timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms,
+                         timer_expire_fn expire, void *arg) {
+    uint64_t target = now_ms > wheel->start_ms ?
+                      (now_ms - wheel->start_ms) / wheel->tick_ms : 0;
+
+    while (wheel->current < target) {
+        timer_node_t **head;
+
+        // Nothing armed: skip the idle ticks in one step
+        if (wheel->pending == 0) {
+            wheel->current = target;
+            break;
+        }
+
+        wheel->current++;
+
+        // Pull the next slot of each wrapping level down
+        if ((wheel->current & LEVEL_MASK) == 0) {
+            for (int level = 1; level < TIMER_WHEEL_LEVELS && cascade(wheel, level); level++) {
+            }
+        }
+
+        // Expire everything due this tick; callbacks may re-arm timers
+        head = &wheel->slots[0][wheel->current & LEVEL_MASK];
+        while (*head) {
+            timer_node_t *timer = *head;
+            unlink_timer(timer);
+            wheel->pending--;
+            expire(timer, arg);
+        }
+    }
+}
+
+int timer_wheel_next_timeout(const timer_wheel_t *wheel, uint64_t now_ms) {
+    uint64_t next_ms;
+
+    if (wheel->pending == 0) {
+        return -1;
+    }
+
+    next_ms = wheel->start_ms + (wheel->current + 1) * wheel->tick_ms;
+    if (next_ms <= now_ms) {
+        return 0;
+    }
+    return (int)(next_ms - now_ms);
+}
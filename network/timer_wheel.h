@@ -0,0 +1,109 @@
+/**
+ * Hierarchical Timing Wheel Interface
+ *
+ * Timers for the network servers' idle-client timeouts. Scheduling,
+ * cancelling and expiring a timer are all O(1); advancing the wheel
+ * costs O(1) per elapsed tick plus the timers that expire or cascade.
+ * The wheel is not thread-safe: each event loop owns its own wheel and
+ * drives it from its poll/epoll timeout.
+ * Features include:
+ * - TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots each
+ * - Intrusive timer nodes, so arming a timer never allocates
+ * - A next-timeout hint for epoll_wait/poll
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Constants
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4    // Covers 64^4 ticks; later timers are re-filed on cascade
+
+// Timer embedded in the object it times out
+typedef struct timer_node {
+    struct timer_node *next;
+    struct timer_node **pprev;  // Link pointing at this node, NULL when idle
+    uint64_t expires;           // Expiry tick
+} timer_node_t;
+
+// Timer wheel state
+typedef struct {
+    timer_node_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t current;           // Last tick processed
+    uint64_t start_ms;          // Time of tick 0
+    unsigned int tick_ms;
+    size_t pending;             // Armed timers
+} timer_wheel_t;
+
+// Called for each expired timer; the timer is idle and may be re-armed
+typedef void (*timer_expire_fn)(timer_node_t *timer, void *arg);
+
+// Get the containing object of an embedded timer
+#define timer_entry(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
+/**
+ * Get the current monotonic time in milliseconds
+ * @return Milliseconds since an arbitrary fixed point
+ */
+uint64_t timer_wheel_now_ms(void);
+
+/**
+ * Initialize an empty wheel
+ * @param wheel Wheel to initialize
+ * @param now_ms Current time from timer_wheel_now_ms
+ * @param tick_ms Tick length in milliseconds (timer resolution)
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now_ms, unsigned int tick_ms);
+
+/**
+ * Initialize a timer node as idle
+ * @param timer Timer to initialize
+ */
+void timer_node_init(timer_node_t *timer);
+
+/**
+ * Arm a timer, re-arming it if already pending
+ * @param wheel Owning wheel
+ * @param timer Timer to arm
+ * @param expires_ms Absolute expiry time in milliseconds
+ */
+void timer_wheel_schedule(timer_wheel_t *wheel, timer_node_t *timer, uint64_t expires_ms);
+
+/**
+ * Disarm a timer; does nothing if it is idle
+ * @param wheel Owning wheel
+ * @param timer Timer to disarm
+ */
+void timer_wheel_cancel(timer_wheel_t *wheel, timer_node_t *timer);
+
+/**
+ * Check whether a timer is armed
+ * @param timer Timer to check
+ * @return 1 if armed, 0 otherwise
+ */
+int timer_wheel_pending(const timer_node_t *timer);
+
+/**
+ * Process every tick up to now_ms and expire the timers that are due
+ * @param wheel Wheel to advance
+ * @param now_ms Current time from timer_wheel_now_ms
+ * @param expire Callback for each expired timer
+ * @param arg Passed to the callback
+ */
+void timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms,
+                         timer_expire_fn expire, void *arg);
+
+/**
+ * Get how long an event loop may sleep before the wheel needs advancing
+ * @param wheel Wheel to query
+ * @param now_ms Current time from timer_wheel_now_ms
+ * @return Milliseconds until the next tick, -1 if no timer is armed
+ */
+int timer_wheel_next_timeout(const timer_wheel_t *wheel, uint64_t now_ms);
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,231 @@
+/**
+ * Batched Datagram I/O Implementation
+ *
+ * The ring owns one buffer, address and control area per message; the
+ * receive and send headers both point into them, so an echo reply is sent
+ * straight from the buffer it arrived in.
+ */
+
+#define _GNU_SOURCE             // recvmmsg, sendmmsg
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <netinet/udp.h>
+
+#include "udp_batch.h"
+#include "stats.h"
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+// Constants
+#define CONTROL_SIZE CMSG_SPACE(sizeof(uint16_t))   // Holds one segment-size cmsg
+
+int udp_enable_gro(int socket) {
+    int on = 1;
+
+    if (setsockopt(socket, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int udp_batch_init(udp_batch_t *batch, unsigned int size, size_t buffer_size, int gro) {
+    memset(batch, 0, sizeof(*batch));
+
+    if (size < 1) {
+        size = 1;
+    }
+    if (size > UDP_BATCH_MAX) {
+        size = UDP_BATCH_MAX;
+    }
+
+    batch->size = size;
+    batch->buffer_size = buffer_size;
+    batch->gro = gro;
+    batch->recv_msgs = calloc(size, sizeof(*batch->recv_msgs));
+    batch->send_msgs = calloc(size, sizeof(*batch->send_msgs));
+    batch->recv_iovs = calloc(size, sizeof(*batch->recv_iovs));
+    batch->send_iovs = calloc(size, sizeof(*batch->send_iovs));
+    batch->addrs = calloc(size, sizeof(*batch->addrs));
+    batch->recv_control = calloc(size, CONTROL_SIZE);
+    batch->send_control = calloc(size, CONTROL_SIZE);
+    // One spare byte per buffer for the NUL terminator
+    batch->buffers = malloc(size * (buffer_size + 1));
+
+    if (!batch->recv_msgs || !batch->send_msgs || !batch->recv_iovs ||
+        !batch->send_iovs || !batch->addrs || !batch->recv_control ||
+        !batch->send_control || !batch->buffers) {
+        perror("Failed to allocate message batch");
+        udp_batch_free(batch);
+        return -1;
+    }
+
+    for (unsigned int i = 0; i < size; i++) {
+        batch->recv_iovs[i].iov_base = batch->buffers + i * (buffer_size + 1);
+        batch->recv_iovs[i].iov_len = buffer_size;
+    }
+
+    return 0;
+}
+
+void udp_batch_free(udp_batch_t *batch) {
+    free(batch->recv_msgs);
+    free(batch->send_msgs);
+    free(batch->recv_iovs);
+    free(batch->send_iovs);
+    free(batch->addrs);
+    free(batch->recv_control);
+    free(batch->send_control);
+    free(batch->buffers);
+    memset(batch, 0, sizeof(*batch));
+}
+
+int udp_batch_recv(int socket, udp_batch_t *batch) {
+    uint64_t bytes = 0;
+    int count;
+
+    // recvmmsg overwrites the lengths, so reset every header
+    for (unsigned int i = 0; i < batch->size; i++) {
+        struct msghdr *hdr = &batch->recv_msgs[i].msg_hdr;
+
+        hdr->msg_name = &batch->addrs[i];
+        hdr->msg_namelen = sizeof(batch->addrs[i]);
+        hdr->msg_iov = &batch->recv_iovs[i];
+        hdr->msg_iovlen = 1;
+        hdr->msg_control = batch->gro ? batch->recv_control + i * CONTROL_SIZE : NULL;
+        hdr->msg_controllen = batch->gro ? CONTROL_SIZE : 0;
+        hdr->msg_flags = 0;
+    }
+
+    batch->received = 0;
+    batch->queued = 0;
+
+    do {
+        count = recvmmsg(socket, batch->recv_msgs, batch->size, MSG_DONTWAIT, NULL);
+    } while (count < 0 && errno == EINTR);
+
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        perror("recvmmsg");
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        udp_batch_data(batch, (unsigned int)i)[batch->recv_msgs[i].msg_len] = '\0';
+        bytes += batch->recv_msgs[i].msg_len;
+    }
+    stats_add(STATS_NET_RX_PACKETS, (uint64_t)count);
+    stats_add(STATS_NET_RX_BYTES, bytes);
+
+    batch->received = (unsigned int)count;
+    return count;
+}
+
+char *udp_batch_data(const udp_batch_t *batch, unsigned int index) {
+    return batch->recv_iovs[index].iov_base;
+}
+
+size_t udp_batch_length(const udp_batch_t *batch, unsigned int index) {
+    return batch->recv_msgs[index].msg_len;
+}
+
+size_t udp_batch_segment_size(const udp_batch_t *batch, unsigned int index) {
+    struct msghdr *hdr = &batch->recv_msgs[index].msg_hdr;
+    struct cmsghdr *cmsg;
+
+    if (batch->gro) {
+        for (cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+            if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int segment;
+                memcpy(&segment, CMSG_DATA(cmsg), sizeof(segment));
+                if (segment > 0) {
+                    return (size_t)segment;
+                }
+            }
+        }
+    }
+
+    return batch->recv_msgs[index].msg_len;
+}
+
+const struct sockaddr_in *udp_batch_peer(const udp_batch_t *batch, unsigned int index) {
+    return &batch->addrs[index];
+}
+
+void udp_batch_queue_echo(udp_batch_t *batch, unsigned int index) {
+    unsigned int slot = batch->queued++;
+    struct msghdr *hdr = &batch->send_msgs[slot].msg_hdr;
+    size_t length = udp_batch_length(batch, index);
+    size_t segment = udp_batch_segment_size(batch, index);
+
+    batch->send_iovs[slot].iov_base = udp_batch_data(batch, index);
+    batch->send_iovs[slot].iov_len = length;
+
+    hdr->msg_name = &batch->addrs[index];
+    hdr->msg_namelen = sizeof(batch->addrs[index]);
+    hdr->msg_iov = &batch->send_iovs[slot];
+    hdr->msg_iovlen = 1;
+    hdr->msg_control = NULL;
+    hdr->msg_controllen = 0;
+    hdr->msg_flags = 0;
+
+    // A coalesced buffer goes back out as one GSO send of the same segments
+    if (segment < length) {
+        char *control = batch->send_control + slot * CONTROL_SIZE;
+        struct cmsghdr *cmsg;
+        uint16_t gso_size = (uint16_t)segment;
+
+        memset(control, 0, CONTROL_SIZE);
+        hdr->msg_control = control;
+        hdr->msg_controllen = CONTROL_SIZE;
+        cmsg = CMSG_FIRSTHDR(hdr);
+        cmsg->cmsg_level = IPPROTO_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(gso_size));
+        memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+    }
+}
+
+int udp_batch_send(int socket, udp_batch_t *batch) {
+    unsigned int next = 0;
+    uint64_t bytes = 0;
+    int sent = 0;
+
+    while (next < batch->queued) {
+        int count = sendmmsg(socket, batch->send_msgs + next, batch->queued - next, 0);
+
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                break;
+            }
+            // sendmmsg stops at the first failing message: skip it
+            perror("sendmmsg");
+            next++;
+            continue;
+        }
+        // sendmmsg stores the bytes sent in each header it got through
+        for (int i = 0; i < count; i++) {
+            bytes += batch->send_msgs[next + i].msg_len;
+        }
+        next += (unsigned int)count;
+        sent += count;
+    }
+    stats_add(STATS_NET_TX_PACKETS, (uint64_t)sent);
+    stats_add(STATS_NET_TX_BYTES, bytes);
+
+    batch->queued = 0;
+    return sent;
+}
@@ -0,0 +1,125 @@
+/**
+ * Batched Datagram I/O Interface
+ *
+ * Receives and sends datagrams in batches with recvmmsg/sendmmsg, using a
+ * ring of message buffers allocated once up front. When the kernel
+ * supports UDP GRO, each buffer may hold several coalesced datagrams of
+ * the same size; replies to such a buffer go out as one UDP GSO send.
+ * Features include:
+ * - Configurable batch size
+ * - Per-message peer address and GRO segment size
+ * - Echo helper that replies to received messages in place
+ */
+
+#ifndef UDP_BATCH_H
+#define UDP_BATCH_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Constants
+#define UDP_BATCH_DEFAULT 32        // Messages per recvmmsg/sendmmsg call
+#define UDP_BATCH_MAX 1024
+#define UDP_GRO_BUFFER_SIZE 65535   // Largest coalesced GRO payload
+
+// Preallocated message ring
+typedef struct {
+    unsigned int size;              // Messages per syscall
+    size_t buffer_size;             // Payload bytes per message buffer
+    int gro;                        // Socket delivers GRO-coalesced buffers
+    struct mmsghdr *recv_msgs;
+    struct mmsghdr *send_msgs;
+    struct iovec *recv_iovs;
+    struct iovec *send_iovs;
+    struct sockaddr_in *addrs;
+    char *buffers;
+    char *recv_control;             // Space for each message's UDP_GRO cmsg
+    char *send_control;             // Space for each reply's UDP_SEGMENT cmsg
+    unsigned int received;          // Messages from the last udp_batch_recv
+    unsigned int queued;            // Replies waiting for udp_batch_send
+} udp_batch_t;
+
+/**
+ * Ask the kernel to coalesce incoming datagrams on a socket (UDP GRO)
+ * @param socket UDP socket
+ * @return 0 if enabled, -1 if the kernel does not support it
+ */
+int udp_enable_gro(int socket);
+
+/**
+ * Allocate a message ring
+ * @param batch Batch to initialize
+ * @param size Messages per syscall, 1 to UDP_BATCH_MAX
+ * @param buffer_size Payload bytes per message; UDP_GRO_BUFFER_SIZE with GRO
+ * @param gro Whether the socket has GRO enabled
+ * @return 0 on success, -1 on error
+ */
+int udp_batch_init(udp_batch_t *batch, unsigned int size, size_t buffer_size, int gro);
+
+/**
+ * Free a message ring
+ * @param batch Batch to free
+ */
+void udp_batch_free(udp_batch_t *batch);
+
+/**
+ * Receive up to batch->size datagrams without blocking
+ * Each payload is NUL-terminated for convenience.
+ * @param socket UDP socket
+ * @param batch Message ring
+ * @return Number of messages received (0 if none were queued), -1 on error
+ */
+int udp_batch_recv(int socket, udp_batch_t *batch);
+
+/**
+ * Get the payload of a received message
+ * @param batch Message ring
+ * @param index Message index below batch->received
+ * @return Payload
+ */
+char *udp_batch_data(const udp_batch_t *batch, unsigned int index);
+
+/**
+ * Get the payload length of a received message
+ * @param batch Message ring
+ * @param index Message index below batch->received
+ * @return Length in bytes, covering all coalesced segments
+ */
+size_t udp_batch_length(const udp_batch_t *batch, unsigned int index);
+
+/**
+ * Get the size of each datagram coalesced into a received message
+ * @param batch Message ring
+ * @param index Message index below batch->received
+ * @return Segment size, equal to the length if nothing was coalesced
+ */
+size_t udp_batch_segment_size(const udp_batch_t *batch, unsigned int index);
+
+/**
+ * Get the sender of a received message
+ * @param batch Message ring
+ * @param index Message index below batch->received
+ * @return Peer address
+ */
+const struct sockaddr_in *udp_batch_peer(const udp_batch_t *batch, unsigned int index);
+
+/**
+ * Queue a received message to be echoed back to its sender
+ * @param batch Message ring
+ * @param index Message index below batch->received
+ */
+void udp_batch_queue_echo(udp_batch_t *batch, unsigned int index);
+
+/**
+ * Send every queued reply with as few sendmmsg calls as possible
+ * Replies the socket cannot take right now, or that fail, are dropped,
+ * as UDP would.
+ * @param socket UDP socket
+ * @param batch Message ring
+ * @return Number of replies sent
+ */
+int udp_batch_send(int socket, udp_batch_t *batch);
+
+#endif // UDP_BATCH_H
@@ -7,6 +7,8 @@
  * - Resource management
  * - User input handling
  * - Graceful shutdown
+ * - Load generation: --load drives the server over many pipelined
+ *   connections and reports latency percentiles (see load_gen.h)
  */
 
 #include <stdio.h>
@@ -19,6 +21,8 @@
 #include <signal.h>
 #include <errno.h>
 
+#include "load_gen.h"
+
 // Constants
 #define BUFFER_SIZE 1024
 #define DEFAULT_PORT 8080
@@ -114,6 +118,11 @@ int main(int argc, char *argv[]) {
     int port = DEFAULT_PORT;
     ssize_t bytes_received;
 
+    // Load generator mode takes its own options
+    if (argc > 1 && strcmp(argv[1], "--load") == 0) {
+        return load_main(SOCK_DGRAM, argc - 1, argv + 1);
+    }
+
     // Parse command line arguments
     if (argc > 1) {
         host = argv[1];
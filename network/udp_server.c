@@ -5,8 +5,15 @@
  * - Connectionless communication
  * - Error handling and logging
  * - Resource management
- * - Client tracking
+ * - Client tracking in an open-addressing hash table
+ * - Idle client expiry on a timer wheel
+ * - Batched receive/echo with recvmmsg/sendmmsg, plus UDP GRO/GSO
+ * - Byte and packet counters published through stats.h
  * - Graceful shutdown
+ *
+ * Usage: udp_server [port] [batch]
+ *        batch is the number of datagrams per syscall (default 32)
+ *        udp_server --bench    (client table lookup microbenchmark)
  */
 
 #include <stdio.h>
@@ -19,24 +26,54 @@
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
+#include <poll.h>
+#include <stdint.h>
+
+#include "timer_wheel.h"
+#include "udp_batch.h"
+#include "async_log.h"
+#include "bench.h"
+#include "stats.h"
 
 // Constants
 #define BUFFER_SIZE 1024
 #define DEFAULT_PORT 8080
-#define MAX_CLIENTS 100
+#define CLIENT_TABLE_BITS 16
+#define CLIENT_TABLE_SIZE (1 << CLIENT_TABLE_BITS)     // Hash slots
+#define MAX_CLIENTS (CLIENT_TABLE_SIZE / 8 * 7)         // Caps the load factor at 87.5%
 #define TIMEOUT_SECONDS 30
+#define TIMER_TICK_MS 100           // Resolution of the idle timeout
+#define POLL_TIMEOUT_MS 1000        // How often an idle server checks for shutdown
+#define RECV_ROUNDS 4               // recvmmsg calls between timer checks
+#define BENCH_LOOKUPS 10000000
+#define BENCH_SCAN_LOOKUPS 20000    // The linear scan is too slow for BENCH_LOOKUPS
 
 // Structure to hold client information
 typedef struct {
     struct sockaddr_in address;
-    time_t last_activity;
-    int active;
+    uint64_t key;                   // Hash table key of address
+    uint64_t last_activity;         // Time of the last datagram, in ms
+    timer_node_t idle_timer;
 } client_info_t;
 
+// Hash table slot. Robin Hood ordering: along a probe sequence, entries
+// sit no farther from their home slot than the entry they displaced, so a
+// lookup can stop at the first slot closer to home than its own probe.
+typedef struct {
+    uint64_t key;
+    uint32_t client;                // Index into clients[]
+    uint32_t distance;              // Probe distance + 1, 0 when empty
+} client_slot_t;
+
 // Global variables
 static volatile sig_atomic_t running = 1;
 static int server_socket = -1;
 static client_info_t clients[MAX_CLIENTS];
+static client_slot_t client_table[CLIENT_TABLE_SIZE];
+static uint32_t free_clients[MAX_CLIENTS];   // Stack of unused clients[] indices
+static int free_count;
+static timer_wheel_t client_timers;
+static uint64_t now_ms;             // Time of the last poll return
 
 /**
  * Signal handler for graceful shutdown
@@ -56,8 +93,8 @@ static int init_server(int port) {
     struct sockaddr_in server_addr;
     int opt = 1;
 
-    // Create socket
-    server_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    // Create socket; non-blocking so the loop can drain it between polls
+    server_socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
     if (server_socket < 0) {
         perror("socket");
         return -1;
@@ -86,62 +123,272 @@ static int init_server(int port) {
     return 0;
 }
 
+/**
+ * Build the hash table key of a peer address
+ * @param addr Peer address
+ * @return Address and port packed into one integer
+ */
+static uint64_t client_key(const struct sockaddr_in *addr) {
+    return ((uint64_t)addr->sin_addr.s_addr << 16) | addr->sin_port;
+}
+
+/**
+ * Get the home slot of a key
+ * @param key Key from client_key
+ * @return Slot index
+ */
+static uint32_t client_hash(uint64_t key) {
+    // Fibonacci hashing: the top bits of the product mix every key bit
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - CLIENT_TABLE_BITS));
+}
+
+/**
+ * Reset the client table to empty
+ */
+static void init_client_table(void) {
+    memset(client_table, 0, sizeof(client_table));
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        free_clients[i] = (uint32_t)(MAX_CLIENTS - 1 - i);
+    }
+    free_count = MAX_CLIENTS;
+}
+
+/**
+ * Look up a key
+ * @param key Key from client_key
+ * @return Slot index, -1 if the key is not in the table
+ */
+static int table_find(uint64_t key) {
+    uint32_t slot = client_hash(key);
+
+    for (uint32_t distance = 1; ; distance++) {
+        const client_slot_t *entry = &client_table[slot];
+
+        // Empty, or a richer entry: the key would have displaced it
+        if (entry->distance < distance) {
+            return -1;
+        }
+        if (entry->key == key) {
+            return (int)slot;
+        }
+        slot = (slot + 1) & (CLIENT_TABLE_SIZE - 1);
+    }
+}
+
+/**
+ * Insert a key that is not yet in the table
+ * The table must have a free slot; MAX_CLIENTS guarantees it.
+ * @param key Key from client_key
+ * @param client Index into clients[]
+ */
+static void table_insert(uint64_t key, uint32_t client) {
+    client_slot_t entry = { key, client, 1 };
+    uint32_t slot = client_hash(key);
+
+    while (client_table[slot].distance != 0) {
+        // Take the slot from an entry closer to its home than we are
+        if (client_table[slot].distance < entry.distance) {
+            client_slot_t displaced = client_table[slot];
+            client_table[slot] = entry;
+            entry = displaced;
+        }
+        slot = (slot + 1) & (CLIENT_TABLE_SIZE - 1);
+        entry.distance++;
+    }
+
+    client_table[slot] = entry;
+}
+
+/**
+ * Remove the entry in a slot, shifting its probe run back by one
+ * @param slot Slot index from table_find
+ */
+static void table_remove(uint32_t slot) {
+    uint32_t next = (slot + 1) & (CLIENT_TABLE_SIZE - 1);
+
+    while (client_table[next].distance > 1) {
+        client_table[slot] = client_table[next];
+        client_table[slot].distance--;
+        slot = next;
+        next = (next + 1) & (CLIENT_TABLE_SIZE - 1);
+    }
+
+    client_table[slot].distance = 0;
+}
+
+/**
+ * Timer wheel callback: forget a client that has been idle too long
+ * @param timer Expired idle timer
+ * @param arg Unused
+ */
+static void expire_client(timer_node_t *timer, void *arg) {
+    client_info_t *client = timer_entry(timer, client_info_t, idle_timer);
+    uint64_t deadline = client->last_activity + TIMEOUT_SECONDS * 1000ULL;
+    int slot;
+
+    (void)arg;
+
+    // Traffic since the timer was armed: re-arm for the new deadline
+    if (deadline > now_ms) {
+        timer_wheel_schedule(&client_timers, timer, deadline);
+        return;
+    }
+
+    slot = table_find(client->key);
+    if (slot >= 0) {
+        table_remove((uint32_t)slot);
+    }
+    free_clients[free_count++] = (uint32_t)(client - clients);
+}
+
 /**
  * Find or create client entry
  * @param client_addr Client address
  * @return Index of client entry, -1 if no space available
  */
 static int find_client(const struct sockaddr_in *client_addr) {
-    time_t current_time = time(NULL);
-    int empty_slot = -1;
+    uint64_t key = client_key(client_addr);
+    int slot = table_find(key);
+    client_info_t *client;
+    uint32_t index;
 
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i].active) {
-            // Check for timeout
-            if (current_time - clients[i].last_activity > TIMEOUT_SECONDS) {
-                clients[i].active = 0;
-                empty_slot = i;
-                continue;
-            }
+    if (slot >= 0) {
+        index = client_table[slot].client;
+        clients[index].last_activity = now_ms;
+        return (int)index;
+    }
 
-            // Check if this is the client
-            if (memcmp(&clients[i].address, client_addr, sizeof(*client_addr)) == 0) {
-                clients[i].last_activity = current_time;
-                return i;
-            }
-        } else if (empty_slot == -1) {
-            empty_slot = i;
-        }
+    if (free_count == 0) {
+        return -1;
     }
 
-    // If we found an empty slot, use it
-    if (empty_slot != -1) {
-        clients[empty_slot].address = *client_addr;
-        clients[empty_slot].last_activity = current_time;
-        clients[empty_slot].active = 1;
-        return empty_slot;
+    // New client; the idle timer is pushed back lazily when it fires,
+    // so refreshing a client only stores a timestamp
+    index = free_clients[--free_count];
+    client = &clients[index];
+    client->address = *client_addr;
+    client->key = key;
+    client->last_activity = now_ms;
+    timer_wheel_schedule(&client_timers, &client->idle_timer,
+                         now_ms + TIMEOUT_SECONDS * 1000ULL);
+    table_insert(key, index);
+
+    return (int)index;
+}
+
+// Peers the lookup benchmarks probe, filled by run_table_bench
+static struct sockaddr_in bench_peers[MAX_CLIENTS];
+
+/**
+ * Benchmark body: look up every peer, in an order unrelated to insertion
+ * @param arg Lookup count
+ * @param latency Unused; the harness records the mean lookup time
+ * @return Lookups performed
+ */
+static long bench_table_hit(void *arg, bench_histogram_t *latency) {
+    long lookups = *(long *)arg;
+    volatile long found = 0;
+
+    (void)latency;
+    for (long i = 0; i < lookups; i++) {
+        int slot = table_find(client_key(&bench_peers[((uint32_t)i * 7919u) % MAX_CLIENTS]));
+        found += (slot >= 0);
     }
+    return found == lookups ? lookups : -1;
+}
+
+/**
+ * Benchmark body: look up absent peers, the known addresses on other ports
+ * @param arg Lookup count
+ * @param latency Unused
+ * @return Lookups performed
+ */
+static long bench_table_miss(void *arg, bench_histogram_t *latency) {
+    long lookups = *(long *)arg;
+    volatile long found = 0;
+    struct sockaddr_in missing;
 
-    return -1;
+    (void)latency;
+    for (long i = 0; i < lookups; i++) {
+        missing = bench_peers[((uint32_t)i * 7919u) % MAX_CLIENTS];
+        missing.sin_port ^= 0x5a5a;
+        found += (table_find(client_key(&missing)) >= 0);
+    }
+    return found == 0 ? lookups : -1;
 }
 
 /**
- * Send data to client
- * @param client_addr Client address
- * @param buffer Data to send
- * @param length Length of data
- * @return Number of bytes sent, -1 on error
- */
-static ssize_t send_to_client(const struct sockaddr_in *client_addr,
-                            const char *buffer,
-                            size_t length) {
-    ssize_t bytes_sent = sendto(server_socket, buffer, length, 0,
-                               (struct sockaddr *)client_addr,
-                               sizeof(*client_addr));
-    if (bytes_sent < 0) {
-        perror("sendto");
-    }
-    return bytes_sent;
+ * Benchmark body: the previous linear memcmp scan over the same peers
+ * @param arg Lookup count
+ * @param latency Unused
+ * @return Lookups performed
+ */
+static long bench_linear_scan(void *arg, bench_histogram_t *latency) {
+    long lookups = *(long *)arg;
+    volatile long found = 0;
+
+    (void)latency;
+    for (long i = 0; i < lookups; i++) {
+        const struct sockaddr_in *peer = &bench_peers[((uint32_t)i * 7919u) % MAX_CLIENTS];
+        for (int j = 0; j < MAX_CLIENTS; j++) {
+            if (memcmp(&clients[j].address, peer, sizeof(*peer)) == 0) {
+                found++;
+                break;
+            }
+        }
+    }
+    return found == lookups ? lookups : -1;
+}
+
+/**
+ * Microbenchmark: client lookups with the table at its maximum load
+ *
+ * Fills the table with MAX_CLIENTS random peers, then times hits and
+ * misses, with a linear memcmp scan over the same peers for comparison.
+ * @return 0 on success, 1 on error
+ */
+static int run_table_bench(void) {
+    bench_config_t config;
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    uint64_t probes = 0;
+    long lookups, scan_lookups;
+    int result = 0;
+
+    bench_config_init(&config, "udp_server");
+    lookups = bench_scaled(&config, BENCH_LOOKUPS);
+    scan_lookups = bench_scaled(&config, BENCH_SCAN_LOOKUPS);
+    init_client_table();
+
+    // Random distinct peers (xorshift), as many as the table accepts
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        do {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            memset(&bench_peers[i], 0, sizeof(bench_peers[i]));
+            bench_peers[i].sin_family = AF_INET;
+            bench_peers[i].sin_addr.s_addr = (uint32_t)state;
+            bench_peers[i].sin_port = (uint16_t)(state >> 32);
+        } while (table_find(client_key(&bench_peers[i])) >= 0);
+
+        clients[i].address = bench_peers[i];
+        clients[i].key = client_key(&bench_peers[i]);
+        table_insert(clients[i].key, (uint32_t)i);
+    }
+
+    // On stderr so CSV or JSON on stdout stays parseable
+    for (int i = 0; i < CLIENT_TABLE_SIZE; i++) {
+        probes += client_table[i].distance;
+    }
+    fprintf(stderr, "Client table: %d peers in %d slots (load %.1f%%), mean probe length %.2f\n",
+            MAX_CLIENTS, CLIENT_TABLE_SIZE, 100.0 * MAX_CLIENTS / CLIENT_TABLE_SIZE,
+            (double)probes / MAX_CLIENTS);
+
+    result |= bench_case(&config, "client-table/hit", bench_table_hit, &lookups);
+    result |= bench_case(&config, "client-table/miss", bench_table_miss, &lookups);
+    result |= bench_case(&config, "linear-scan/hit", bench_linear_scan, &scan_lookups);
+
+    return result ? 1 : 0;
 }
 
 /**
@@ -149,74 +396,130 @@ static ssize_t send_to_client(const struct sockaddr_in *client_addr,
  * @return 0 on success, 1 on error
  */
 int main(int argc, char *argv[]) {
-    char buffer[BUFFER_SIZE];
-    struct sockaddr_in client_addr;
-    socklen_t client_len;
-    ssize_t bytes_received;
+    struct pollfd server_poll;
+    udp_batch_t batch;
     int port = DEFAULT_PORT;
+    int batch_size = UDP_BATCH_DEFAULT;
+    int gro;
     int client_index;
+    int timeout;
+    int count;
 
     // Parse command line arguments
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return run_table_bench();
+    }
     if (argc > 1) {
         port = atoi(argv[1]);
     }
+    if (argc > 2) {
+        batch_size = atoi(argv[2]);
+    }
 
     // Set up signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
+    // Publish byte and packet counters for ui/menu; optional
+    stats_init("udp_server");
+
+    // Per-packet messages are DEBUG; run with LOG_LEVEL=debug to see them
+    if (async_log_init(NULL, ASYNC_LOG_INFO) < 0) {
+        return 1;
+    }
+
     // Initialize server
     if (init_server(port) < 0) {
+        async_log_shutdown();
+        return 1;
+    }
+
+    // Coalesced receives only pay off when batching
+    gro = (batch_size > 1 && udp_enable_gro(server_socket) == 0);
+    if (udp_batch_init(&batch, (unsigned int)(batch_size > 0 ? batch_size : 1),
+                       gro ? UDP_GRO_BUFFER_SIZE : BUFFER_SIZE - 1, gro) < 0) {
+        close(server_socket);
+        async_log_shutdown();
         return 1;
     }
 
-    printf("UDP Server listening on port %d...\n", port);
+    printf("UDP Server listening on port %d (batch %u, GRO %s)...\n",
+           port, batch.size, gro ? "on" : "off");
+    fflush(stdout);     // The logger writes to the same descriptor
 
-    // Initialize clients array
+    // Initialize client table and timers
     memset(clients, 0, sizeof(clients));
+    init_client_table();
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        timer_node_init(&clients[i].idle_timer);
+    }
+    now_ms = timer_wheel_now_ms();
+    timer_wheel_init(&client_timers, now_ms, TIMER_TICK_MS);
+
+    server_poll.fd = server_socket;
+    server_poll.events = POLLIN;
 
     // Main server loop
     while (running) {
-        client_len = sizeof(client_addr);
-        bytes_received = recvfrom(server_socket, buffer, BUFFER_SIZE - 1, 0,
-                                (struct sockaddr *)&client_addr, &client_len);
-        
-        if (bytes_received < 0) {
-            if (errno == EINTR) {
-                continue;
-            }
-            perror("recvfrom");
-            continue;
+        // Sleep until a datagram arrives or the next timer tick is due
+        timeout = timer_wheel_next_timeout(&client_timers, now_ms);
+        if (timeout < 0 || timeout > POLL_TIMEOUT_MS) {
+            timeout = POLL_TIMEOUT_MS;
         }
+        if (poll(&server_poll, 1, timeout) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+        now_ms = timer_wheel_now_ms();
 
-        // Null-terminate received data
-        buffer[bytes_received] = '\0';
+        // Handle queued datagrams, a bounded number so timers keep running
+        for (int round = 0; round < RECV_ROUNDS && running; round++) {
+            count = udp_batch_recv(server_socket, &batch);
+            if (count <= 0) {
+                break;
+            }
 
-        // Find or create client entry
-        client_index = find_client(&client_addr);
-        if (client_index == -1) {
-            printf("Maximum clients reached, dropping packet\n");
-            continue;
-        }
+            for (int i = 0; i < count; i++) {
+                const struct sockaddr_in *client_addr = udp_batch_peer(&batch, (unsigned int)i);
+                size_t length = udp_batch_length(&batch, (unsigned int)i);
+                size_t segment = udp_batch_segment_size(&batch, (unsigned int)i);
 
-        // Print received message
-        printf("Received from %s:%d: %s\n",
-               inet_ntoa(client_addr.sin_addr),
-               ntohs(client_addr.sin_port),
-               buffer);
+                // Find or create client entry
+                client_index = find_client(client_addr);
+                if (client_index == -1) {
+                    async_log(ASYNC_LOG_WARN, "Maximum clients reached, dropping packet");
+                    continue;
+                }
 
-        // Echo back to client
-        if (send_to_client(&client_addr, buffer, bytes_received) < 0) {
-            printf("Failed to send response to client\n");
+                // Log received message; coalesced datagrams are shown once
+                async_log(ASYNC_LOG_DEBUG, "Received from " ASYNC_LOG_ADDR_FMT ": %.*s (+%zu coalesced)",
+                          ASYNC_LOG_ADDR_ARGS(client_addr),
+                          (int)segment, udp_batch_data(&batch, (unsigned int)i),
+                          segment < length ? (length - 1) / segment : 0);
+
+                // Echo back to client
+                udp_batch_queue_echo(&batch, (unsigned int)i);
+            }
+
+            udp_batch_send(server_socket, &batch);
+
+            // A short batch means the socket is drained
+            if ((unsigned int)count < batch.size) {
+                break;
+            }
         }
+
+        // Expire idle clients
+        timer_wheel_advance(&client_timers, now_ms, expire_client, NULL);
     }
 
     // Cleanup
     printf("Shutting down server...\n");
+    async_log_shutdown();
+    udp_batch_free(&batch);
     if (server_socket != -1) {
         close(server_socket);
     }
 
     return 0;
-} 
-} 
\ No newline at end of file
+}
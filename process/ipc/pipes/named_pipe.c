@@ -3,13 +3,20 @@
  * 
  * This program demonstrates communication between parent and child processes
  * using a named pipe (FIFO). The parent writes to the pipe and the child reads from it.
+ * Messages are length-prefixed frames (pipe_frame.h), so message boundaries
+ * survive the byte stream and concurrent writers never tear each other's frames.
  * 
  * Features:
  * - Named pipe creation and management
+ * - Framed messages, batched into atomic writev calls
  * - Error handling
  * - Graceful shutdown
  * - Safe buffer management
  * - Resource cleanup
+ * - Small-message benchmark with concurrent writers, with sampled
+ *   writer-to-reader latency, through the shared harness in bench.h
+ *
+ * Usage: named_pipe [--bench [writers] [messages per writer]]
  */
 
 #include <fcntl.h>
@@ -22,15 +29,46 @@
 #include <sys/stat.h>
 #include <signal.h>
 #include <errno.h>
+#include <stdint.h>
 #include <time.h>
+#include <sys/mman.h>
+
+#include "pipe_frame.h"
+#include "bench.h"
 
 // Constants
-#define PIPE_NAME "named_pipe"
-#define BUFFER_SIZE 128
+#define PIPE_NAME "named_pipe.fifo"
 #define NUM_MESSAGES 3
 #define PIPE_PERMISSIONS 0666
 #define TIMEOUT_SECONDS 5
 #define LOG_FILE "named_pipe.log"
+#define BENCH_WRITERS 4
+#define BENCH_MAX_WRITERS 64
+#define BENCH_MESSAGES 250000
+#define BENCH_SAMPLE_EVERY 64       // Messages between timestamped ones
+
+// Benchmark control message
+typedef struct {
+    uint32_t writer;
+    uint32_t reserved;
+    uint64_t seq;
+    uint64_t sent_ns;       // Send time on sampled messages, 0 otherwise
+    char body[8];
+} bench_message_t;
+
+// Benchmarked write paths
+typedef enum {
+    BENCH_WRITE_EACH,   // One write per frame
+    BENCH_WRITEV_BATCH  // Frames coalesced into writev batches up to PIPE_BUF
+} bench_mode_t;
+
+// One benchmark configuration
+typedef struct {
+    bench_mode_t mode;
+    int writers;
+    long messages;                  // Per writer
+    bench_histogram_t *latency;     // Shared with the reader process
+} bench_case_t;
 
 // Global variables for cleanup
 static volatile sig_atomic_t running = 1;
@@ -78,10 +116,209 @@ static int wait_for_pipe(int fd, int timeout) {
     return select(fd + 1, &set, NULL, NULL, &tv);
 }
 
-int main(void) {
+/**
+ * Benchmark writer: send numbered control messages
+ * @param mode Write path
+ * @param fd Write end of the FIFO
+ * @param writer Writer index
+ * @param messages Number of messages
+ * @return Exit status
+ */
+static int bench_writer(bench_mode_t mode, int fd, uint32_t writer, long messages) {
+    static bench_message_t batch[PIPE_FRAME_BATCH];
+    pipe_framer_t framer;
+
+    pipe_framer_init(&framer, fd);
+    for (long i = 0; i < messages; i++) {
+        bench_message_t *message;
+
+        // Payloads must stay untouched until the batch they are in is flushed,
+        // so flush before reusing the batch array
+        if (!pipe_framer_fits(&framer, sizeof(*message)) && pipe_framer_flush(&framer) < 0) {
+            perror("writer: write error");
+            return EXIT_FAILURE;
+        }
+        message = &batch[framer.frames];
+
+        message->writer = writer;
+        message->reserved = 0;
+        message->seq = (uint64_t)i;
+        message->sent_ns = i % BENCH_SAMPLE_EVERY == 0 ? bench_now_ns() : 0;
+        memset(message->body, 'a' + writer % 26, sizeof(message->body));
+
+        if (pipe_framer_queue(&framer, message, sizeof(*message)) < 0 ||
+            (mode == BENCH_WRITE_EACH && pipe_framer_flush(&framer) < 0)) {
+            perror("writer: write error");
+            return EXIT_FAILURE;
+        }
+    }
+    if (pipe_framer_flush(&framer) < 0) {
+        perror("writer: write error");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Benchmark reader: check that every writer's messages arrive whole and in order
+ * @param fd Read end of the FIFO
+ * @param writers Number of writers
+ * @param messages Messages per writer
+ * @param latency Shared histogram for the sampled latencies
+ * @return Exit status
+ */
+static int bench_reader(int fd, int writers, long messages, bench_histogram_t *latency) {
+    static pipe_deframer_t deframer;
+    uint64_t expected[BENCH_MAX_WRITERS] = {0};
+    bench_message_t message;
+    const char *data;
+    size_t length;
+    long received = 0;
+    long errors = 0;
+    int result;
+
+    pipe_deframer_init(&deframer, fd);
+    while ((result = pipe_deframer_next(&deframer, &data, &length)) > 0) {
+        received++;
+        if (length != sizeof(message)) {
+            errors++;
+            continue;
+        }
+        memcpy(&message, data, sizeof(message));
+        if (message.writer >= (uint32_t)writers || message.seq != expected[message.writer] ||
+            message.body[0] != 'a' + (char)(message.writer % 26)) {
+            errors++;
+            continue;
+        }
+        expected[message.writer]++;
+        if (message.sent_ns != 0) {
+            bench_histogram_add(latency, bench_now_ns() - message.sent_ns);
+        }
+    }
+    if (result < 0) {
+        perror("reader: read error");
+        return EXIT_FAILURE;
+    }
+
+    if (received != writers * messages || errors > 0) {
+        fprintf(stderr, "reader: %ld of %ld messages, %ld errors\n",
+                received, writers * messages, errors);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * One repetition: concurrent writers send small messages through the FIFO
+ * @param arg Benchmark configuration
+ * @param latency Receives the reader's sampled latencies
+ * @return Messages delivered, -1 on error
+ */
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    int writers = bench->writers;
+    long messages = bench->messages;
+    pid_t reader;
+    int status;
+    int failed = 0;
+
+    bench_histogram_init(bench->latency);
+    reader = fork();
+    if (reader < 0) {
+        perror("fork failed");
+        return -1;
+    }
+    if (reader == 0) {
+        int fd = open(PIPE_NAME, O_RDONLY);
+        if (fd < 0) {
+            perror("reader: open failed");
+            _exit(EXIT_FAILURE);
+        }
+        _exit(bench_reader(fd, writers, messages, bench->latency));
+    }
+
+    // Hold the write end until every writer has inherited it, so the reader
+    // does not see end of stream before the last writer is done
+    pipe_fd = open(PIPE_NAME, O_WRONLY);
+    if (pipe_fd < 0) {
+        perror("open failed");
+        kill(reader, SIGTERM);
+        waitpid(reader, NULL, 0);
+        return -1;
+    }
+
+    for (int i = 0; i < writers; i++) {
+        pid_t writer = fork();
+        if (writer < 0) {
+            perror("fork failed");
+            failed = 1;
+            break;
+        }
+        if (writer == 0) {
+            _exit(bench_writer(bench->mode, pipe_fd, (uint32_t)i, messages));
+        }
+    }
+    close(pipe_fd);
+    pipe_fd = -1;
+
+    // Reap the writers and then the reader
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed = 1;
+        }
+    }
+
+    bench_histogram_merge(latency, bench->latency);
+    return failed ? -1 : (long)writers * messages;
+}
+
+/**
+ * Compare one write per message with writev batches
+ * @param writers Number of writer processes
+ * @param messages Messages per writer, 0 for the scaled default
+ * @return Exit status
+ */
+static int run_bench(int writers, long messages) {
+    static const char *names[] = { "write-each", "writev-batch" };
+    bench_config_t config;
+    bench_histogram_t *shared;
+    int result = EXIT_SUCCESS;
+    char name[64];
+
+    bench_config_init(&config, "named_pipe");
+    if (messages == 0) {
+        messages = bench_scaled(&config, BENCH_MESSAGES);
+    }
+
+    // The reader records latencies in memory the parent can read after it exits
+    shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap failed");
+        return EXIT_FAILURE;
+    }
+
+    for (int mode = BENCH_WRITE_EACH; mode <= BENCH_WRITEV_BATCH; mode++) {
+        bench_case_t bench = { (bench_mode_t)mode, writers, messages, shared };
+
+        snprintf(name, sizeof(name), "%s/writers=%d", names[mode], writers);
+        if (bench_case(&config, name, bench_repetition, &bench) != 0) {
+            fprintf(stderr, "%s FAILED\n", name);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    munmap(shared, sizeof(*shared));
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    static pipe_deframer_t deframer;
+    pipe_framer_t framer;
     pid_t reader;
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_read;
+    const char *message;
+    size_t length;
+    int result;
     int status;
 
     // Set up signal handlers
@@ -96,6 +333,22 @@ int main(void) {
         }
     }
 
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        int writers = argc > 2 ? atoi(argv[2]) : BENCH_WRITERS;
+        long messages = argc > 3 ? atol(argv[3]) : 0;
+
+        if (writers < 1 || writers > BENCH_MAX_WRITERS || (argc > 3 && messages < 1)) {
+            fprintf(stderr, "Usage: %s --bench [writers 1-%d] [messages per writer]\n",
+                    argv[0], BENCH_MAX_WRITERS);
+            cleanup();
+            exit(EXIT_FAILURE);
+        }
+
+        result = run_bench(writers, messages);
+        cleanup();
+        return result;
+    }
+
     // Fork process
     reader = fork();
     if (reader < 0) {
@@ -117,26 +370,36 @@ int main(void) {
             exit(EXIT_FAILURE);
         }
 
-        // Read messages from pipe
+        // Read messages from pipe; one read may deliver several frames
+        pipe_deframer_init(&deframer, pipe_fd);
         while (running) {
-            int ready = wait_for_pipe(pipe_fd, TIMEOUT_SECONDS);
-            if (ready == 0) {
-                printf("Child: Timeout waiting for data\n");
-                log_message("Child: Timeout waiting for data");
-                break;
-            } else if (ready < 0) {
-                perror("child: select error");
-                log_message("Child: select error");
-                break;
+            if (!pipe_deframer_ready(&deframer)) {
+                int ready = wait_for_pipe(pipe_fd, TIMEOUT_SECONDS);
+                if (ready == 0) {
+                    printf("Child: Timeout waiting for data\n");
+                    log_message("Child: Timeout waiting for data");
+                    break;
+                } else if (ready < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    perror("child: select error");
+                    log_message("Child: select error");
+                    break;
+                }
             }
 
-            bytes_read = read(pipe_fd, buffer, BUFFER_SIZE - 1);
-            if (bytes_read > 0) {
-                buffer[bytes_read] = '\0';
-                printf("Child received: %s", buffer);
-                log_message(buffer);
-                memset(buffer, 0, BUFFER_SIZE);
-            } else if (bytes_read < 0 && errno != EINTR) {
+            result = pipe_deframer_next(&deframer, &message, &length);
+            if (result > 0) {
+                char text[PIPE_FRAME_MAX + 1];
+
+                memcpy(text, message, length);
+                text[length] = '\0';
+                printf("Child received: %s", text);
+                log_message(text);
+            } else if (result == 0) {
+                break;  // Writer closed the pipe
+            } else {
                 perror("child: read error");
                 log_message("Child: read error");
                 break;
@@ -167,8 +430,10 @@ int main(void) {
             "Goodbye, World!\n"
         };
 
+        // Queue the messages as frames and send them with one writev
+        pipe_framer_init(&framer, pipe_fd);
         for (int i = 0; i < NUM_MESSAGES && running; i++) {
-            if (write(pipe_fd, messages[i], strlen(messages[i])) < 0) {
+            if (pipe_framer_queue(&framer, messages[i], strlen(messages[i])) < 0) {
                 perror("parent: write error");
                 log_message("Parent: write error");
                 cleanup();
@@ -176,6 +441,12 @@ int main(void) {
             }
             log_message(messages[i]);
         }
+        if (pipe_framer_flush(&framer) < 0) {
+            perror("parent: write error");
+            log_message("Parent: write error");
+            cleanup();
+            exit(EXIT_FAILURE);
+        }
 
         close(pipe_fd);
 
@@ -0,0 +1,137 @@
+/**
+ * Framed Pipe Message Implementation
+ *
+ * Frames are a native-endian 16-bit length and the payload; both ends run
+ * on the same machine, so no byte order conversion is needed.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "pipe_frame.h"
+
+void pipe_framer_init(pipe_framer_t *framer, int fd) {
+    framer->fd = fd;
+    framer->frames = 0;
+    framer->bytes = 0;
+}
+
+int pipe_framer_fits(const pipe_framer_t *framer, size_t length) {
+    return framer->frames < PIPE_FRAME_BATCH &&
+           framer->bytes + PIPE_FRAME_HEADER + length <= PIPE_BUF;
+}
+
+int pipe_framer_queue(pipe_framer_t *framer, const void *data, size_t length) {
+    int frame;
+
+    if (length > PIPE_FRAME_MAX) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    // Keep every batch within PIPE_BUF so the kernel writes it atomically
+    if (!pipe_framer_fits(framer, length)) {
+        if (pipe_framer_flush(framer) < 0) {
+            return -1;
+        }
+    }
+
+    frame = framer->frames++;
+    framer->lengths[frame] = (uint16_t)length;
+    framer->iov[2 * frame].iov_base = &framer->lengths[frame];
+    framer->iov[2 * frame].iov_len = PIPE_FRAME_HEADER;
+    framer->iov[2 * frame + 1].iov_base = (void *)data;
+    framer->iov[2 * frame + 1].iov_len = length;
+    framer->bytes += PIPE_FRAME_HEADER + length;
+    return 0;
+}
+
+int pipe_framer_flush(pipe_framer_t *framer) {
+    ssize_t written;
+
+    if (framer->frames == 0) {
+        return 0;
+    }
+
+    // Writes of at most PIPE_BUF bytes are never split: EINTR means nothing
+    // was written, so the whole batch can be retried
+    do {
+        written = writev(framer->fd, framer->iov, 2 * framer->frames);
+    } while (written < 0 && errno == EINTR);
+
+    if (written < 0) {
+        return -1;
+    }
+    if ((size_t)written != framer->bytes) {
+        errno = EIO;
+        return -1;
+    }
+
+    framer->frames = 0;
+    framer->bytes = 0;
+    return 0;
+}
+
+void pipe_deframer_init(pipe_deframer_t *deframer, int fd) {
+    deframer->fd = fd;
+    deframer->start = 0;
+    deframer->end = 0;
+}
+
+int pipe_deframer_ready(const pipe_deframer_t *deframer) {
+    size_t available = deframer->end - deframer->start;
+    uint16_t frame_length;
+
+    if (available < PIPE_FRAME_HEADER) {
+        return 0;
+    }
+    memcpy(&frame_length, deframer->buffer + deframer->start, PIPE_FRAME_HEADER);
+    return available >= PIPE_FRAME_HEADER + frame_length;
+}
+
+int pipe_deframer_next(pipe_deframer_t *deframer, const char **data, size_t *length) {
+    for (;;) {
+        size_t available = deframer->end - deframer->start;
+        uint16_t frame_length;
+        ssize_t bytes_read;
+
+        if (available >= PIPE_FRAME_HEADER) {
+            memcpy(&frame_length, deframer->buffer + deframer->start, PIPE_FRAME_HEADER);
+            if (frame_length > PIPE_FRAME_MAX) {
+                errno = EPROTO;
+                return -1;
+            }
+            if (available >= PIPE_FRAME_HEADER + frame_length) {
+                *data = deframer->buffer + deframer->start + PIPE_FRAME_HEADER;
+                *length = frame_length;
+                deframer->start += PIPE_FRAME_HEADER + frame_length;
+                return 1;
+            }
+        }
+
+        // Move a partial frame to the front before reading more
+        if (deframer->start > 0) {
+            memmove(deframer->buffer, deframer->buffer + deframer->start, available);
+            deframer->start = 0;
+            deframer->end = available;
+        }
+
+        bytes_read = read(deframer->fd, deframer->buffer + deframer->end,
+                          PIPE_FRAME_READ_SIZE - deframer->end);
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (bytes_read == 0) {
+            if (available > 0) {
+                errno = EPROTO;     // Stream ended inside a frame
+                return -1;
+            }
+            return 0;
+        }
+        deframer->end += (size_t)bytes_read;
+    }
+}
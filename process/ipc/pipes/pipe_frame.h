@@ -0,0 +1,105 @@
+/**
+ * Framed Pipe Message Interface
+ *
+ * Length-prefixed messages on top of a pipe or FIFO byte stream:
+ * - Each frame is a 16-bit length followed by the payload
+ * - The writer queues frames and sends them with one writev of at most
+ *   PIPE_BUF bytes, so a batch is written atomically and frames from
+ *   concurrent writers never interleave
+ * - The reader fills a large buffer with each read and hands out every
+ *   complete frame in it before reading again
+ */
+
+#ifndef PIPE_FRAME_H
+#define PIPE_FRAME_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+// Constants
+#define PIPE_FRAME_HEADER sizeof(uint16_t)
+#define PIPE_FRAME_MAX (PIPE_BUF - PIPE_FRAME_HEADER)  // Largest payload
+#define PIPE_FRAME_BATCH 64                            // Frames per writev
+#define PIPE_FRAME_READ_SIZE 65536                     // Reader buffer size
+
+// Writing side: frames queued for the next writev
+typedef struct {
+    int fd;
+    uint16_t lengths[PIPE_FRAME_BATCH];
+    struct iovec iov[2 * PIPE_FRAME_BATCH];
+    int frames;
+    size_t bytes;       // Queued bytes including headers, at most PIPE_BUF
+} pipe_framer_t;
+
+// Reading side: buffered bytes not yet handed out as frames
+typedef struct {
+    int fd;
+    size_t start;
+    size_t end;
+    char buffer[PIPE_FRAME_READ_SIZE];
+} pipe_deframer_t;
+
+/**
+ * Initialize a frame writer
+ * @param framer Writer to initialize
+ * @param fd Write end of the pipe
+ */
+void pipe_framer_init(pipe_framer_t *framer, int fd);
+
+/**
+ * Queue a message, flushing the batch first if it would exceed PIPE_BUF
+ *
+ * The payload is not copied: it must stay valid until the next flush.
+ * @param framer Frame writer
+ * @param data Message payload
+ * @param length Payload length, at most PIPE_FRAME_MAX
+ * @return 0 on success, -1 on error
+ */
+int pipe_framer_queue(pipe_framer_t *framer, const void *data, size_t length);
+
+/**
+ * Check whether a message fits in the current batch, i.e. whether
+ * pipe_framer_queue will add it without flushing first
+ * @param framer Frame writer
+ * @param length Payload length
+ * @return 1 if the message fits, 0 otherwise
+ */
+int pipe_framer_fits(const pipe_framer_t *framer, size_t length);
+
+/**
+ * Write all queued frames with a single atomic writev
+ * @param framer Frame writer
+ * @return 0 on success, -1 on error
+ */
+int pipe_framer_flush(pipe_framer_t *framer);
+
+/**
+ * Initialize a frame reader
+ * @param deframer Reader to initialize
+ * @param fd Read end of the pipe
+ */
+void pipe_deframer_init(pipe_deframer_t *deframer, int fd);
+
+/**
+ * Check whether a complete frame is buffered, i.e. whether
+ * pipe_deframer_next will return without reading
+ * @param deframer Frame reader
+ * @return 1 if a complete frame is buffered, 0 otherwise
+ */
+int pipe_deframer_ready(const pipe_deframer_t *deframer);
+
+/**
+ * Get the next message, reading from the pipe only when no complete
+ * frame is buffered
+ *
+ * The returned payload stays valid until the next call.
+ * @param deframer Frame reader
+ * @param data Set to the message payload
+ * @param length Set to the payload length
+ * @return 1 if a message was returned, 0 at end of stream, -1 on error
+ */
+int pipe_deframer_next(pipe_deframer_t *deframer, const char **data, size_t *length);
+
+#endif // PIPE_FRAME_H
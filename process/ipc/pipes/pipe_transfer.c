@@ -0,0 +1,119 @@
+/**
+ * Bulk Pipe Transfer Implementation
+ *
+ * Uses the Linux-specific F_SETPIPE_SZ, vmsplice and splice.
+ */
+
+#define _GNU_SOURCE             // F_SETPIPE_SZ, vmsplice, splice
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+#include "pipe_transfer.h"
+
+int pipe_set_capacity(int fd, size_t bytes) {
+    FILE *limit_file;
+    unsigned long limit;
+    int capacity;
+
+    // Unprivileged processes may not exceed pipe-max-size
+    limit_file = fopen("/proc/sys/fs/pipe-max-size", "r");
+    if (limit_file) {
+        if (fscanf(limit_file, "%lu", &limit) == 1 && bytes > limit) {
+            bytes = limit;
+        }
+        fclose(limit_file);
+    }
+
+    capacity = fcntl(fd, F_SETPIPE_SZ, (int)bytes);
+    if (capacity < 0) {
+        perror("fcntl(F_SETPIPE_SZ) failed");
+        return -1;
+    }
+    return capacity;
+}
+
+int pipe_write_all(int fd, const void *data, size_t length) {
+    const char *bytes = data;
+
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+int pipe_chunks_init(pipe_chunks_t *chunks, size_t chunk_size, size_t pipe_capacity) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    chunks->chunk_size = (chunk_size + page - 1) / page * page;
+    chunks->chunks = 2 * ((pipe_capacity + chunks->chunk_size - 1) / chunks->chunk_size) + 1;
+    chunks->next = 0;
+
+    if (posix_memalign((void **)&chunks->memory, page, chunks->chunk_size * chunks->chunks) != 0) {
+        chunks->memory = NULL;
+        perror("posix_memalign failed");
+        return -1;
+    }
+    memset(chunks->memory, 0, chunks->chunk_size * chunks->chunks);
+    return 0;
+}
+
+char *pipe_chunks_next(pipe_chunks_t *chunks) {
+    char *chunk = chunks->memory + chunks->next * chunks->chunk_size;
+
+    chunks->next = (chunks->next + 1) % chunks->chunks;
+    return chunk;
+}
+
+void pipe_chunks_free(pipe_chunks_t *chunks) {
+    free(chunks->memory);
+    chunks->memory = NULL;
+}
+
+int pipe_vmsplice_all(int fd, void *data, size_t length) {
+    struct iovec iov = { .iov_base = data, .iov_len = length };
+
+    while (iov.iov_len > 0) {
+        ssize_t moved = vmsplice(fd, &iov, 1, 0);
+        if (moved < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        iov.iov_base = (char *)iov.iov_base + moved;
+        iov.iov_len -= (size_t)moved;
+    }
+    return 0;
+}
+
+ssize_t pipe_splice_to(int fd, int out_fd, size_t chunk_size) {
+    ssize_t total = 0;
+
+    for (;;) {
+        ssize_t moved = splice(fd, NULL, out_fd, NULL, chunk_size, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (moved == 0) {
+            return total;
+        }
+        if (moved < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        total += moved;
+    }
+}
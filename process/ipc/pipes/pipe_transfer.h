@@ -0,0 +1,88 @@
+/**
+ * Bulk Pipe Transfer Interface
+ *
+ * Helpers for moving large amounts of data through a pipe:
+ * - Growing the pipe with F_SETPIPE_SZ so each system call moves more
+ * - vmsplice on the writing side, which maps the sender's pages into the
+ *   pipe instead of copying them
+ * - splice on the reading side, which passes pages on to another file
+ *   descriptor without copying them into user space
+ */
+
+#ifndef PIPE_TRANSFER_H
+#define PIPE_TRANSFER_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Rotating set of page-aligned buffers for vmsplice
+typedef struct {
+    char *memory;
+    size_t chunk_size;      // Bytes per chunk, a multiple of the page size
+    size_t chunks;          // Enough that a chunk has left the pipe before reuse
+    size_t next;
+} pipe_chunks_t;
+
+/**
+ * Set the capacity of a pipe, capped at /proc/sys/fs/pipe-max-size
+ * @param fd Either end of the pipe
+ * @param bytes Requested capacity
+ * @return Resulting capacity in bytes, -1 on error
+ */
+int pipe_set_capacity(int fd, size_t bytes);
+
+/**
+ * Write a whole buffer, retrying short writes
+ * @param fd Write end of the pipe
+ * @param data Data to write
+ * @param length Data length
+ * @return 0 on success, -1 on error
+ */
+int pipe_write_all(int fd, const void *data, size_t length);
+
+/**
+ * Allocate chunks for vmsplice on a pipe of the given capacity
+ *
+ * vmsplice leaves the sender's pages in the pipe, so a buffer must not be
+ * changed until the reader has consumed it. The chunks cover twice the
+ * pipe capacity: by the time a chunk comes round again, at least a full
+ * pipe of later data has been queued, so its pages have left the pipe.
+ * @param chunks Set to initialize
+ * @param chunk_size Bytes per chunk, rounded up to whole pages
+ * @param pipe_capacity Capacity of the pipe the chunks are sent into
+ * @return 0 on success, -1 on error
+ */
+int pipe_chunks_init(pipe_chunks_t *chunks, size_t chunk_size, size_t pipe_capacity);
+
+/**
+ * Get the next chunk to fill and send
+ * @param chunks Chunk set
+ * @return Chunk of chunks->chunk_size bytes
+ */
+char *pipe_chunks_next(pipe_chunks_t *chunks);
+
+/**
+ * Free a chunk set
+ * @param chunks Chunk set
+ */
+void pipe_chunks_free(pipe_chunks_t *chunks);
+
+/**
+ * Map a buffer into a pipe with vmsplice, retrying partial transfers
+ * @param fd Write end of the pipe
+ * @param data Page-aligned data, left unchanged until the reader consumed it
+ * @param length Data length
+ * @return 0 on success, -1 on error
+ */
+int pipe_vmsplice_all(int fd, void *data, size_t length);
+
+/**
+ * Move everything from a pipe to another descriptor with splice until EOF
+ * @param fd Read end of the pipe
+ * @param out_fd Destination (a file, socket or /dev/null)
+ * @param chunk_size Bytes per splice call
+ * @return Bytes moved, -1 on error
+ */
+ssize_t pipe_splice_to(int fd, int out_fd, size_t chunk_size);
+
+#endif // PIPE_TRANSFER_H
@@ -10,8 +10,14 @@
  * - Graceful shutdown
  * - Safe buffer management
  * - Resource cleanup
+ * - Bulk transfer benchmark: read/write, F_SETPIPE_SZ, vmsplice and splice,
+ *   through the shared harness in bench.h
+ *
+ * Usage: unidirectional [--bench [MiB]]
  */
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -20,10 +26,41 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <errno.h>
+#include <fcntl.h>
+
+#include "pipe_transfer.h"
+#include "bench.h"
 
 // Constants
 #define BUFFER_SIZE 128
 #define NUM_MESSAGES 3
+#define BENCH_DEFAULT_MIB 1024
+#define BENCH_PIPE_SIZE (1024 * 1024)   // Requested pipe capacity for the bulk modes
+#define BENCH_CHUNK_SIZE (256 * 1024)   // Bytes per system call in the bulk modes
+#define BENCH_SMALL_SHARE 16            // The 128-byte path moves 1/16 of the data
+
+// Benchmarked transfer paths
+typedef enum {
+    BENCH_SMALL_COPY,       // The example's path: 128-byte read/write, memset per read
+    BENCH_LARGE_COPY,       // Large pipe, 256 KiB read/write
+    BENCH_VMSPLICE_READ,    // Sender maps pages in with vmsplice, receiver reads
+    BENCH_VMSPLICE_SPLICE,  // vmsplice in, splice out to /dev/null: no copies at all
+    BENCH_KINDS
+} bench_kind_t;
+
+// Benchmark names; one op is one KiB moved, so ops/s is KiB per second
+static const char *bench_names[BENCH_KINDS] = {
+    "pipe-kib/read-write-128B",
+    "pipe-kib/read-write-256KiB",
+    "pipe-kib/vmsplice-read",
+    "pipe-kib/vmsplice-splice"
+};
+
+// One benchmark configuration
+typedef struct {
+    bench_kind_t kind;
+    size_t total;
+} bench_case_t;
 
 // Global variables for cleanup
 static int pipefd[2] = {-1, -1};
@@ -41,7 +78,143 @@ static void cleanup(void) {
     if (pipefd[1] != -1) close(pipefd[1]);
 }
 
-int main(void) {
+/**
+ * Benchmark receiver: drain the pipe the way a transfer path does
+ * @param kind Transfer path
+ * @param fd Read end of the pipe
+ * @return Exit status
+ */
+static int bench_receive(bench_kind_t kind, int fd) {
+    static char small[BUFFER_SIZE];
+    ssize_t bytes_read;
+    char *buffer;
+
+    if (kind == BENCH_VMSPLICE_SPLICE) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        ssize_t moved = null_fd < 0 ? -1 : pipe_splice_to(fd, null_fd, BENCH_CHUNK_SIZE);
+        if (moved < 0) {
+            perror("child: splice error");
+        }
+        if (null_fd >= 0) {
+            close(null_fd);
+        }
+        return moved < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    if (kind == BENCH_SMALL_COPY) {
+        while ((bytes_read = read(fd, small, BUFFER_SIZE - 1)) > 0 ||
+               (bytes_read < 0 && errno == EINTR)) {
+            memset(small, 0, BUFFER_SIZE);
+        }
+        return bytes_read < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    buffer = malloc(BENCH_CHUNK_SIZE);
+    if (!buffer) {
+        perror("child: malloc failed");
+        return EXIT_FAILURE;
+    }
+    while ((bytes_read = read(fd, buffer, BENCH_CHUNK_SIZE)) > 0 ||
+           (bytes_read < 0 && errno == EINTR)) {
+    }
+    free(buffer);
+    return bytes_read < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Benchmark sender: push a number of bytes through the pipe
+ * @param kind Transfer path
+ * @param fd Write end of the pipe
+ * @param total Bytes to send
+ * @param capacity Pipe capacity
+ * @return 0 on success, -1 on error
+ */
+static int bench_send(bench_kind_t kind, int fd, size_t total, size_t capacity) {
+    static char small[BUFFER_SIZE];
+    pipe_chunks_t chunks;
+    size_t chunk_size = kind == BENCH_SMALL_COPY ? BUFFER_SIZE : BENCH_CHUNK_SIZE;
+    int result = 0;
+
+    if (pipe_chunks_init(&chunks, chunk_size, capacity) < 0) {
+        return -1;
+    }
+
+    for (size_t sent = 0; sent < total && result == 0; sent += chunk_size) {
+        size_t length = total - sent < chunk_size ? total - sent : chunk_size;
+
+        switch (kind) {
+        case BENCH_SMALL_COPY:
+            result = pipe_write_all(fd, small, length);
+            break;
+        case BENCH_LARGE_COPY:
+            result = pipe_write_all(fd, chunks.memory, length);
+            break;
+        default:
+            // Rotate through the chunks: the pipe may still reference older ones
+            result = pipe_vmsplice_all(fd, pipe_chunks_next(&chunks), length);
+            break;
+        }
+    }
+
+    if (result < 0) {
+        perror("parent: write error");
+    }
+    pipe_chunks_free(&chunks);
+    return result;
+}
+
+/**
+ * One repetition: move the bytes from parent to child over a fresh pipe
+ * @param arg Benchmark configuration
+ * @param latency Unused; the harness records the mean time per KiB
+ * @return KiB transferred, -1 on error
+ */
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    size_t capacity;
+    pid_t child;
+    int status;
+    int result;
+
+    (void)latency;
+    if (pipe(pipefd) < 0) {
+        perror("pipe creation failed");
+        return -1;
+    }
+
+    // The example's path keeps the default 64 KiB pipe
+    if (bench->kind == BENCH_SMALL_COPY) {
+        capacity = (size_t)fcntl(pipefd[1], F_GETPIPE_SZ);
+    } else {
+        int resized = pipe_set_capacity(pipefd[1], BENCH_PIPE_SIZE);
+        capacity = resized > 0 ? (size_t)resized : (size_t)fcntl(pipefd[1], F_GETPIPE_SZ);
+    }
+
+    child = fork();
+    if (child < 0) {
+        perror("fork failed");
+        cleanup();
+        return -1;
+    }
+    if (child == 0) {
+        close(pipefd[1]);
+        _exit(bench_receive(bench->kind, pipefd[0]));
+    }
+
+    close(pipefd[0]);
+    pipefd[0] = -1;
+    result = bench_send(bench->kind, pipefd[1], bench->total, capacity);
+    close(pipefd[1]);
+    pipefd[1] = -1;
+    waitpid(child, &status, 0);
+
+    if (result < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return (long)(bench->total >> 10);
+}
+
+int main(int argc, char *argv[]) {
     pid_t child;
     char buffer[BUFFER_SIZE];
     ssize_t bytes_read;
@@ -51,6 +224,23 @@ int main(void) {
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench_config_t config;
+        bench_config_init(&config, "unidirectional");
+        size_t total = argc > 2 ? (size_t)atol(argv[2]) << 20
+                                : (size_t)bench_scaled(&config, BENCH_DEFAULT_MIB << 20);
+        int result = 0;
+
+        for (int kind = 0; kind < BENCH_KINDS; kind++) {
+            bench_case_t bench = {
+                (bench_kind_t)kind,
+                kind == BENCH_SMALL_COPY ? total / BENCH_SMALL_SHARE : total
+            };
+            result |= bench_case(&config, bench_names[kind], bench_repetition, &bench);
+        }
+        return result ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
     // Create pipe
     if (pipe(pipefd) < 0) {
         perror("pipe creation failed");
@@ -75,7 +265,6 @@ int main(void) {
         while (running && (bytes_read = read(pipefd[0], buffer, BUFFER_SIZE - 1)) > 0) {
             buffer[bytes_read] = '\0';
             printf("Child received: %s", buffer);
-            memset(buffer, 0, BUFFER_SIZE);
         }
 
         if (bytes_read < 0 && errno != EINTR) {
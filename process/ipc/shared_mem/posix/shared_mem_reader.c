@@ -2,13 +2,15 @@
  * POSIX Shared Memory Reader
  * 
  * This program demonstrates reading from shared memory using POSIX shared memory API.
- * It opens an existing shared memory object, reads data from it, and properly cleans up resources.
+ * It opens an existing shared memory object, consumes the writer's record stream
+ * from the ring buffer in it, and properly cleans up resources.
  * 
  * Features:
  * - Shared memory access and management
+ * - Lock-free single-producer/single-consumer ring (shm_ring.c)
+ * - Futex wakeups when the ring is empty, no polling
  * - Error handling
  * - Resource cleanup
- * - Safe memory operations
  */
 
 #include <stdio.h>
@@ -20,15 +22,17 @@
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <stdint.h>
+#include <time.h>
 
-// Constants
-#define SHM_NAME "/shared_mem"
-#define SHM_SIZE 1024
-#define NUM_ELEMENTS (SHM_SIZE / sizeof(int))
+#include "shm_ring.h"
+#include "shm_record.h"
 
 // Global variables for cleanup
 static int shm_fd = -1;
 static void *shm_ptr = MAP_FAILED;
+static size_t shm_size = 0;
+static shm_ring_t *ring = NULL;
 static volatile sig_atomic_t running = 1;
 
 // Signal handler for graceful shutdown
@@ -39,8 +43,9 @@ static void signal_handler(int sig) {
 
 // Cleanup function
 static void cleanup(void) {
+    shm_ring_detach(ring);
     if (shm_ptr != MAP_FAILED) {
-        munmap(shm_ptr, SHM_SIZE);
+        munmap(shm_ptr, shm_size);
     }
     if (shm_fd != -1) {
         close(shm_fd);
@@ -48,9 +53,19 @@ static void cleanup(void) {
 }
 
 int main(void) {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    struct sigaction sa;
+    shm_record_t record;
+    struct timespec start, end;
+    uint64_t received = 0;
+    ssize_t length;
+    int error = 0;
+
+    // Set up signal handlers; no SA_RESTART so a blocked pop returns
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
     // Open shared memory object
     shm_fd = shm_open(SHM_NAME, O_RDWR, 0666);
@@ -60,34 +75,59 @@ int main(void) {
         exit(EXIT_FAILURE);
     }
 
+    // The writer chooses the segment size
+    struct stat shm_stat;
+    if (fstat(shm_fd, &shm_stat) == -1) {
+        perror("fstat failed");
+        cleanup();
+        exit(EXIT_FAILURE);
+    }
+    shm_size = (size_t)shm_stat.st_size;
+
     // Map shared memory object
-    shm_ptr = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    shm_ptr = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
     if (shm_ptr == MAP_FAILED) {
         perror("mmap failed");
         cleanup();
         exit(EXIT_FAILURE);
     }
 
-    printf("Reading from shared memory...\n");
+    // Map the writer's huge pages as huge pages here too; without them
+    // this has no effect
+    madvise(shm_ptr, shm_size, MADV_HUGEPAGE);
 
-    // Read data from shared memory
-    int *data = (int *)shm_ptr;
-    printf("Data read from shared memory:\n");
-    for (int i = 0; i < 10 && i < NUM_ELEMENTS; i++) {
-        printf("data[%d] = %d\n", i, data[i]);
+    ring = shm_ring_attach(shm_ptr);
+    if (!ring) {
+        perror("shm_ring_attach failed");
+        cleanup();
+        exit(EXIT_FAILURE);
     }
-    printf("...\n");
 
-    // Verify data
-    int error = 0;
-    for (int i = 0; i < NUM_ELEMENTS && running; i++) {
-        if (data[i] != i) {
-            printf("Data verification failed at index %d: expected %d, got %d\n",
-                   i, i, data[i]);
+    printf("Reading from shared memory...\n");
+
+    // Read and verify records until the writer closes the stream
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (running) {
+        length = shm_ring_pop(ring, &record, sizeof(record));
+        if (length <= 0) {
+            if (length < 0 && errno != EINTR) {
+                perror("shm_ring_pop failed");
+                error = 1;
+            }
+            break;
+        }
+        if (!shm_record_check(&record, (size_t)length, received)) {
+            printf("Data verification failed at message %lu\n", (unsigned long)received);
             error = 1;
             break;
         }
+        received++;
     }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Read %lu messages in %.3f s (%.2f M msgs/s)\n",
+           (unsigned long)received, seconds, received / seconds / 1e6);
 
     if (!error) {
         printf("Data verification successful\n");
@@ -96,4 +136,4 @@ int main(void) {
     cleanup();
     printf("Reader process finished\n");
     return error ? EXIT_FAILURE : EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -2,13 +2,18 @@
  * POSIX Shared Memory Writer
  * 
  * This program demonstrates writing to shared memory using POSIX shared memory API.
- * It creates a shared memory object, writes data to it, and properly cleans up resources.
+ * It creates a shared memory object, streams records through a ring buffer in it,
+ * and properly cleans up resources.
  * 
  * Features:
  * - Shared memory creation and management
+ * - Lock-free single-producer/single-consumer ring (shm_ring.c)
+ * - Variable-length records with futex wakeups when the ring is full
+ * - Optional huge pages, NUMA binding and pre-faulting (shm_placement.c)
  * - Error handling
  * - Resource cleanup
- * - Safe memory operations
+ *
+ * Usage: writer [--huge] [--node N] [--populate] [messages] [ring bytes]
  */
 
 #include <stdio.h>
@@ -20,15 +25,18 @@
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <stdint.h>
+#include <time.h>
 
-// Constants
-#define SHM_NAME "/shared_mem"
-#define SHM_SIZE 1024
-#define NUM_ELEMENTS (SHM_SIZE / sizeof(int))
+#include "shm_ring.h"
+#include "shm_record.h"
+#include "shm_placement.h"
 
 // Global variables for cleanup
 static int shm_fd = -1;
 static void *shm_ptr = MAP_FAILED;
+static size_t shm_size = 0;
+static shm_ring_t *ring = NULL;
 static volatile sig_atomic_t running = 1;
 
 // Signal handler for graceful shutdown
@@ -39,8 +47,9 @@ static void signal_handler(int sig) {
 
 // Cleanup function
 static void cleanup(void) {
+    shm_ring_detach(ring);
     if (shm_ptr != MAP_FAILED) {
-        munmap(shm_ptr, SHM_SIZE);
+        munmap(shm_ptr, shm_size);
     }
     if (shm_fd != -1) {
         close(shm_fd);
@@ -48,10 +57,44 @@ static void cleanup(void) {
     }
 }
 
-int main(void) {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+int main(int argc, char *argv[]) {
+    shm_placement_t placement;
+    size_t capacity = RING_CAPACITY;
+    long messages = DEFAULT_MESSAGES;
+    int map_flags = MAP_SHARED;
+    struct sigaction sa;
+    shm_record_t record;
+    struct timespec start, end;
+    long sent = 0;
+
+    if (shm_placement_parse(&placement, &argc, argv) < 0) {
+        fprintf(stderr, "Usage: %s [--huge] [--node N] [--populate] [messages] [ring bytes]\n",
+                argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (argc > 1) {
+        messages = atol(argv[1]);
+    }
+    if (argc > 2) {
+        // The ring needs a power of two
+        size_t requested = strtoull(argv[2], NULL, 0);
+        while (capacity < requested) {
+            capacity <<= 1;
+        }
+    }
+
+    // Huge pages only back the segment in whole huge pages
+    shm_size = shm_ring_region_size(capacity);
+    if (placement.huge_pages) {
+        shm_size = shm_round_huge(shm_size);
+    }
+
+    // Set up signal handlers; no SA_RESTART so a blocked push returns
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
     // Create shared memory object
     shm_fd = shm_open(SHM_NAME, O_CREAT | O_RDWR, 0666);
@@ -62,41 +105,66 @@ int main(void) {
     }
 
     // Set size of shared memory object
-    if (ftruncate(shm_fd, SHM_SIZE) == -1) {
+    if (ftruncate(shm_fd, (off_t)shm_size) == -1) {
         perror("ftruncate failed");
         cleanup();
         exit(EXIT_FAILURE);
     }
 
-    // Map shared memory object
-    shm_ptr = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    // Map shared memory object; without a NUMA binding, MAP_POPULATE can
+    // pre-fault it right away, otherwise the pages must wait for mbind
+    if (placement.populate && placement.numa_node < 0 && !placement.huge_pages) {
+        map_flags |= MAP_POPULATE;
+        placement.populate = 0;
+    }
+    shm_ptr = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, map_flags, shm_fd, 0);
     if (shm_ptr == MAP_FAILED) {
         perror("mmap failed");
         cleanup();
         exit(EXIT_FAILURE);
     }
+    if (map_flags & MAP_POPULATE) {
+        printf("Segment pre-faulted (%zu bytes)\n", shm_size);
+    }
 
-    printf("Writing to shared memory...\n");
+    // shm_open memory lives on tmpfs, which cannot use MAP_HUGETLB; it gets
+    // transparent huge pages when shmem_enabled allows "advise"
+    shm_apply_placement(&placement, shm_ptr, shm_size, 1);
 
-    // Write data to shared memory
-    int *data = (int *)shm_ptr;
-    for (int i = 0; i < NUM_ELEMENTS && running; i++) {
-        data[i] = i;
+    ring = shm_ring_create(shm_ptr, capacity);
+    if (!ring) {
+        perror("shm_ring_create failed");
+        cleanup();
+        exit(EXIT_FAILURE);
     }
 
-    printf("Data written to shared memory:\n");
-    for (int i = 0; i < 10 && i < NUM_ELEMENTS; i++) {
-        printf("data[%d] = %d\n", i, data[i]);
+    printf("Streaming %ld messages through a %zu-byte ring...\n", messages, capacity);
+
+    // Write records; the push waits while the reader is behind
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < messages && running; i++) {
+        size_t length = shm_record_fill(&record, (uint64_t)i);
+        if (shm_ring_push(ring, &record, length) != 0) {
+            if (errno != EINTR) {
+                perror("shm_ring_push failed");
+            }
+            break;
+        }
+        sent++;
     }
-    printf("...\n");
+    shm_ring_close(ring);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Wrote %ld messages in %.3f s (%.2f M msgs/s)\n",
+           sent, seconds, sent / seconds / 1e6);
 
     // Wait for reader to finish
     printf("Waiting for reader to finish...\n");
-    while (running) {
-        sleep(1);
+    while (running && shm_ring_wait_empty(ring) != 0) {
     }
 
     cleanup();
     printf("Writer process finished\n");
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
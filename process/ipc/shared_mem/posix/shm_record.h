@@ -0,0 +1,55 @@
+/**
+ * Record format shared by shared_mem_writer.c and shared_mem_reader.c
+ *
+ * Each record carries a sequence number and a payload whose length
+ * varies with it, so the reader can check order and contents.
+ */
+
+#ifndef SHM_RECORD_H
+#define SHM_RECORD_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "shm_ring.h"
+
+// Constants
+#define SHM_NAME "/shared_mem"
+#define RING_CAPACITY (1 << 20)                 // Default ring data area in bytes
+#define DEFAULT_MESSAGES 10000000
+#define MAX_PAYLOAD 56
+
+typedef struct {
+    uint64_t seq;
+    unsigned char payload[MAX_PAYLOAD];
+} shm_record_t;
+
+/**
+ * Build the record for a sequence number
+ * @param record Record to fill
+ * @param seq Sequence number
+ * @return Record length in bytes
+ */
+static inline size_t shm_record_fill(shm_record_t *record, uint64_t seq) {
+    size_t payload = seq % (MAX_PAYLOAD + 1);
+
+    record->seq = seq;
+    memset(record->payload, (int)(seq & 0xff), payload);
+    return sizeof(record->seq) + payload;
+}
+
+/**
+ * Check a received record against the one the writer built
+ * @param record Received record
+ * @param length Received length
+ * @param seq Expected sequence number
+ * @return 1 if it matches, 0 otherwise
+ */
+static inline int shm_record_check(const shm_record_t *record, size_t length, uint64_t seq) {
+    shm_record_t expected;
+
+    return length == shm_record_fill(&expected, seq) &&
+           memcmp(record, &expected, length) == 0;
+}
+
+#endif // SHM_RECORD_H
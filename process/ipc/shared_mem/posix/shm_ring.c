@@ -0,0 +1,331 @@
+/**
+ * Shared Memory Ring Buffer Implementation
+ *
+ * Records are a 32-bit length followed by the payload, padded to 8 bytes.
+ * A record never wraps: when it does not fit before the end of the data
+ * area, the producer writes a wrap marker and starts again at offset 0.
+ * Head and tail are free-running byte counts, so full and empty are
+ * never ambiguous.
+ *
+ * Sleeping follows the eventcount pattern: a waiter reads the futex word,
+ * announces itself, re-checks the index and only then sleeps. The other
+ * side bumps the word and wakes it after publishing an index, but only
+ * when a waiter has announced itself. A sleeping producer is woken once
+ * the ring is at most half full, so the two sides do not take turns one
+ * record at a time.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "shm_ring.h"
+
+// Constants
+#define RING_MAGIC 0x52494e47u      // "RING"
+#define CACHE_LINE_SIZE 64
+#define RECORD_ALIGN 8
+#define RECORD_HEADER sizeof(uint32_t)
+#define WRAP_MARKER UINT32_MAX      // Length value meaning "continue at offset 0"
+#define SPIN_LIMIT 256              // Index re-checks before yielding
+#define YIELD_LIMIT 16              // sched_yield calls before sleeping
+
+// Layout of the shared region
+typedef struct {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t capacity;
+    atomic_uint closed;             // Producer has finished
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_least64_t tail;   // Written by the producer
+    atomic_uint data_seq;           // Futex word the consumer sleeps on
+    atomic_uint consumer_waiting;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_least64_t head;   // Written by the consumer
+    atomic_uint space_seq;          // Futex word the producer sleeps on
+    atomic_uint producer_waiting;
+    _Alignas(CACHE_LINE_SIZE) unsigned char data[];
+} shm_ring_shared_t;
+
+// Per-process handle; caches the other side's index to avoid sharing its line
+struct shm_ring {
+    shm_ring_shared_t *shared;
+    uint64_t mask;
+    uint64_t cached_head;           // Producer's last view of head
+    uint64_t cached_tail;           // Consumer's last view of tail
+};
+
+/**
+ * Sleep on a shared futex word while it still holds a value
+ * @param word Futex word
+ * @param value Value observed before announcing the wait
+ * @return 0 on wakeup, -1 on signal
+ */
+static int futex_wait(atomic_uint *word, unsigned int value) {
+    if (syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0) < 0 && errno == EINTR) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Wake the waiter on a shared futex word
+ * @param word Futex word
+ */
+static void futex_wake(atomic_uint *word) {
+    atomic_fetch_add_explicit(word, 1, memory_order_release);
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// Space a record of the given length occupies, header and padding included
+static uint64_t record_size(size_t length) {
+    return (RECORD_HEADER + length + RECORD_ALIGN - 1) & ~(uint64_t)(RECORD_ALIGN - 1);
+}
+
+static void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/**
+ * Wait until an index moves away from a value
+ * @param index Index owned by the other side
+ * @param value Value to wait out
+ * @param seq Futex word the other side bumps
+ * @param waiting Flag announcing the sleep
+ * @param closed End-of-stream flag that also ends the wait, or NULL
+ * @return 0 when the index moved (or the stream closed), -1 on signal
+ */
+static int wait_index(atomic_uint_least64_t *index, uint64_t value,
+                      atomic_uint *seq, atomic_uint *waiting, atomic_uint *closed) {
+    for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+        if (atomic_load_explicit(index, memory_order_acquire) != value) {
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    // Give the other side the CPU; on a busy or single-core machine this
+    // lets it fill (or drain) a batch instead of waking us per record
+    for (int yield = 0; yield < YIELD_LIMIT; yield++) {
+        sched_yield();
+        if (atomic_load_explicit(index, memory_order_acquire) != value) {
+            return 0;
+        }
+    }
+
+    unsigned int observed = atomic_load_explicit(seq, memory_order_acquire);
+    atomic_store(waiting, 1);
+    if (atomic_load(index) != value || (closed && atomic_load(closed))) {
+        atomic_store_explicit(waiting, 0, memory_order_relaxed);
+        return 0;
+    }
+    int result = futex_wait(seq, observed);
+    atomic_store_explicit(waiting, 0, memory_order_relaxed);
+    return result;
+}
+
+/**
+ * Wake the other side if it announced that it is sleeping
+ * @param seq Futex word it sleeps on
+ * @param waiting Its announcement flag
+ */
+static void notify(atomic_uint *seq, atomic_uint *waiting) {
+    // Order the index store before reading the flag (pairs with wait_index)
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiting, memory_order_relaxed)) {
+        futex_wake(seq);
+    }
+}
+
+size_t shm_ring_region_size(size_t capacity) {
+    return sizeof(shm_ring_shared_t) + capacity;
+}
+
+/**
+ * Build a local handle for a formatted region
+ * @param shared Shared ring header
+ * @return Handle, NULL on error
+ */
+static shm_ring_t *make_handle(shm_ring_shared_t *shared) {
+    shm_ring_t *ring = malloc(sizeof(*ring));
+    if (!ring) {
+        return NULL;
+    }
+    ring->shared = shared;
+    ring->mask = shared->capacity - 1;
+    ring->cached_head = atomic_load(&shared->head);
+    ring->cached_tail = atomic_load(&shared->tail);
+    return ring;
+}
+
+shm_ring_t *shm_ring_create(void *region, size_t capacity) {
+    shm_ring_shared_t *shared = (shm_ring_shared_t *)region;
+
+    if (!region || capacity < CACHE_LINE_SIZE || (capacity & (capacity - 1)) != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    memset(shared, 0, sizeof(*shared));
+    shared->capacity = capacity;
+    atomic_init(&shared->closed, 0);
+    atomic_init(&shared->tail, 0);
+    atomic_init(&shared->head, 0);
+    atomic_init(&shared->data_seq, 0);
+    atomic_init(&shared->space_seq, 0);
+    atomic_init(&shared->consumer_waiting, 0);
+    atomic_init(&shared->producer_waiting, 0);
+
+    // Publish the magic last so an early consumer never sees a half-made ring
+    atomic_thread_fence(memory_order_release);
+    shared->magic = RING_MAGIC;
+    return make_handle(shared);
+}
+
+shm_ring_t *shm_ring_attach(void *region) {
+    shm_ring_shared_t *shared = (shm_ring_shared_t *)region;
+
+    if (!region || shared->magic != RING_MAGIC) {
+        errno = EINVAL;
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return make_handle(shared);
+}
+
+void shm_ring_detach(shm_ring_t *ring) {
+    free(ring);
+}
+
+size_t shm_ring_max_record(const shm_ring_t *ring) {
+    // A record plus the wrap padding before it must fit in the ring
+    return ring->shared->capacity / 2 - RECORD_HEADER;
+}
+
+int shm_ring_push(shm_ring_t *ring, const void *data, size_t length) {
+    shm_ring_shared_t *shared = ring->shared;
+    uint64_t capacity = shared->capacity;
+    uint64_t tail = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+    uint64_t offset = tail & ring->mask;
+    uint64_t contiguous = capacity - offset;
+    uint64_t need = record_size(length);
+    uint64_t total;
+
+    if (length > shm_ring_max_record(ring)) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    // Skip the end of the data area if the record would straddle it
+    total = need + (contiguous < need ? contiguous : 0);
+
+    // Wait for room, refreshing the cached head only when needed
+    while (tail + total - ring->cached_head > capacity) {
+        ring->cached_head = atomic_load_explicit(&shared->head, memory_order_acquire);
+        if (tail + total - ring->cached_head <= capacity) {
+            break;
+        }
+        if (wait_index(&shared->head, ring->cached_head, &shared->space_seq,
+                       &shared->producer_waiting, NULL) < 0) {
+            errno = EINTR;
+            return -1;
+        }
+    }
+
+    if (contiguous < need) {
+        memcpy(shared->data + offset, &(uint32_t){ WRAP_MARKER }, RECORD_HEADER);
+        tail += contiguous;
+        offset = 0;
+    }
+
+    uint32_t header = (uint32_t)length;
+    memcpy(shared->data + offset, &header, RECORD_HEADER);
+    memcpy(shared->data + offset + RECORD_HEADER, data, length);
+
+    // Publish the record
+    atomic_store_explicit(&shared->tail, tail + need, memory_order_release);
+    notify(&shared->data_seq, &shared->consumer_waiting);
+    return 0;
+}
+
+ssize_t shm_ring_pop(shm_ring_t *ring, void *buffer, size_t size) {
+    shm_ring_shared_t *shared = ring->shared;
+    uint64_t head = atomic_load_explicit(&shared->head, memory_order_relaxed);
+    uint32_t length;
+
+    for (;;) {
+        // Wait for data, refreshing the cached tail only when needed
+        while (head == ring->cached_tail) {
+            ring->cached_tail = atomic_load_explicit(&shared->tail, memory_order_acquire);
+            if (head != ring->cached_tail) {
+                break;
+            }
+            if (atomic_load_explicit(&shared->closed, memory_order_acquire)) {
+                // Records pushed before the close are visible by now
+                ring->cached_tail = atomic_load_explicit(&shared->tail, memory_order_acquire);
+                if (head == ring->cached_tail) {
+                    return 0;
+                }
+                break;
+            }
+            if (wait_index(&shared->tail, head, &shared->data_seq,
+                           &shared->consumer_waiting, &shared->closed) < 0) {
+                errno = EINTR;
+                return -1;
+            }
+        }
+
+        memcpy(&length, shared->data + (head & ring->mask), RECORD_HEADER);
+        if (length != WRAP_MARKER) {
+            break;
+        }
+        head += shared->capacity - (head & ring->mask);
+    }
+
+    if (length > size) {
+        // Keep the record; only release the wrap padding before it
+        atomic_store_explicit(&shared->head, head, memory_order_release);
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    memcpy(buffer, shared->data + (head & ring->mask) + RECORD_HEADER, length);
+
+    // Hand the space back to the producer
+    head += record_size(length);
+    atomic_store_explicit(&shared->head, head, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&shared->producer_waiting, memory_order_relaxed) &&
+        atomic_load_explicit(&shared->tail, memory_order_acquire) - head <= shared->capacity / 2) {
+        futex_wake(&shared->space_seq);
+    }
+    return (ssize_t)length;
+}
+
+void shm_ring_close(shm_ring_t *ring) {
+    atomic_store(&ring->shared->closed, 1);
+    notify(&ring->shared->data_seq, &ring->shared->consumer_waiting);
+}
+
+int shm_ring_wait_empty(shm_ring_t *ring) {
+    shm_ring_shared_t *shared = ring->shared;
+    uint64_t tail = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&shared->head, memory_order_acquire);
+        if (head == tail) {
+            return 0;
+        }
+        if (wait_index(&shared->head, head, &shared->space_seq,
+                       &shared->producer_waiting, NULL) < 0) {
+            errno = EINTR;
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ * Shared Memory Ring Buffer Interface
+ *
+ * Single-producer/single-consumer stream of variable-length records in a
+ * memory region shared by two processes (e.g. a shm_open/mmap segment).
+ * Features include:
+ * - Head and tail indices on separate cache lines
+ * - No system calls while the ring is neither empty nor full
+ * - Futex wakeups, only when the other side is actually sleeping
+ * - End-of-stream signalling so the consumer knows when to stop
+ *
+ * A blocked push or pop returns -1 with errno EINTR when a signal
+ * arrives, provided the handler was installed without SA_RESTART.
+ */
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Local handle on a ring in shared memory
+typedef struct shm_ring shm_ring_t;
+
+/**
+ * Get the size of the shared region needed for a ring
+ * @param capacity Data capacity in bytes, a power of two
+ * @return Region size in bytes
+ */
+size_t shm_ring_region_size(size_t capacity);
+
+/**
+ * Format a shared region as an empty ring (producer side)
+ * @param region Shared memory of at least shm_ring_region_size(capacity) bytes
+ * @param capacity Data capacity in bytes, a power of two of at least 64
+ * @return Handle, NULL on error
+ */
+shm_ring_t *shm_ring_create(void *region, size_t capacity);
+
+/**
+ * Attach to a ring formatted by shm_ring_create (consumer side)
+ * @param region Shared memory holding the ring
+ * @return Handle, NULL on error
+ */
+shm_ring_t *shm_ring_attach(void *region);
+
+/**
+ * Release a local handle; the shared region is left untouched
+ * @param ring Handle to release
+ */
+void shm_ring_detach(shm_ring_t *ring);
+
+/**
+ * Get the longest record the ring accepts
+ * @param ring Ring handle
+ * @return Maximum record length in bytes
+ */
+size_t shm_ring_max_record(const shm_ring_t *ring);
+
+/**
+ * Append a record, waiting while the ring is full
+ * @param ring Ring handle
+ * @param data Record bytes
+ * @param length Record length, at most shm_ring_max_record()
+ * @return 0 on success, -1 on error
+ */
+int shm_ring_push(shm_ring_t *ring, const void *data, size_t length);
+
+/**
+ * Remove the oldest record, waiting while the ring is empty
+ * @param ring Ring handle
+ * @param buffer Output buffer
+ * @param size Size of the output buffer
+ * @return Record length, 0 at end of stream, -1 on error
+ *         (EMSGSIZE: buffer too small, the record stays queued)
+ */
+ssize_t shm_ring_pop(shm_ring_t *ring, void *buffer, size_t size);
+
+/**
+ * Mark the end of the stream; the consumer's pop returns 0 once drained
+ * @param ring Ring handle
+ */
+void shm_ring_close(shm_ring_t *ring);
+
+/**
+ * Wait until the consumer has taken every record
+ * @param ring Ring handle
+ * @return 0 on success, -1 on error
+ */
+int shm_ring_wait_empty(shm_ring_t *ring);
+
+#endif // SHM_RING_H
@@ -0,0 +1,125 @@
+/**
+ * Shared Memory Placement Implementation
+ *
+ * mbind is called through syscall(2), so no libnuma is needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "shm_placement.h"
+
+// Constants
+#define DEFAULT_HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+#define MAX_NUMA_NODES 1024
+
+int shm_placement_parse(shm_placement_t *placement, int *argc, char *argv[]) {
+    int kept = 1;
+
+    placement->huge_pages = 0;
+    placement->numa_node = -1;
+    placement->populate = 0;
+
+    for (int i = 1; i < *argc; i++) {
+        if (strcmp(argv[i], "--huge") == 0) {
+            placement->huge_pages = 1;
+        } else if (strcmp(argv[i], "--populate") == 0) {
+            placement->populate = 1;
+        } else if (strcmp(argv[i], "--node") == 0) {
+            if (i + 1 >= *argc) {
+                return -1;
+            }
+            placement->numa_node = atoi(argv[++i]);
+            if (placement->numa_node < 0 || placement->numa_node >= MAX_NUMA_NODES) {
+                return -1;
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+
+    *argc = kept;
+    argv[kept] = NULL;
+    return 0;
+}
+
+size_t shm_huge_page_size(void) {
+    FILE *meminfo = fopen("/proc/meminfo", "r");
+    size_t size = DEFAULT_HUGE_PAGE_SIZE;
+    char line[128];
+    unsigned long kb;
+
+    if (meminfo) {
+        while (fgets(line, sizeof(line), meminfo)) {
+            if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+                size = kb * 1024;
+                break;
+            }
+        }
+        fclose(meminfo);
+    }
+    return size;
+}
+
+size_t shm_round_huge(size_t size) {
+    size_t huge = shm_huge_page_size();
+    return (size + huge - 1) / huge * huge;
+}
+
+int shm_bind_node(void *addr, size_t length, int node) {
+    unsigned long nodemask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = { 0 };
+
+    nodemask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_mbind, addr, length, MPOL_BIND, nodemask,
+                (unsigned long)MAX_NUMA_NODES, MPOL_MF_MOVE) < 0) {
+        perror("mbind");
+        return -1;
+    }
+    return 0;
+}
+
+int shm_advise_huge(void *addr, size_t length) {
+    if (madvise(addr, length, MADV_HUGEPAGE) < 0) {
+        perror("madvise(MADV_HUGEPAGE)");
+        return -1;
+    }
+    return 0;
+}
+
+int shm_prefault(void *addr, size_t length) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(addr, length, MADV_POPULATE_WRITE) == 0) {
+        return 0;
+    }
+    if (errno != EINVAL) {
+        perror("madvise(MADV_POPULATE_WRITE)");
+        return -1;
+    }
+#endif
+    // Kernels before 5.14: write each page's first byte back to itself
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    volatile char *bytes = (volatile char *)addr;
+    for (size_t offset = 0; offset < length; offset += page) {
+        bytes[offset] = bytes[offset];
+    }
+    return 0;
+}
+
+void shm_apply_placement(const shm_placement_t *placement, void *addr, size_t length,
+                         int advise_huge) {
+    if (placement->numa_node >= 0 && shm_bind_node(addr, length, placement->numa_node) == 0) {
+        printf("Segment bound to NUMA node %d\n", placement->numa_node);
+    }
+    if (placement->huge_pages && advise_huge && shm_advise_huge(addr, length) == 0) {
+        printf("Transparent huge pages requested for the segment\n");
+    }
+    if (placement->populate && shm_prefault(addr, length) == 0) {
+        printf("Segment pre-faulted (%zu bytes)\n", length);
+    }
+}
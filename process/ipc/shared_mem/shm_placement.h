@@ -0,0 +1,91 @@
+/**
+ * Shared Memory Placement Interface
+ *
+ * Helpers used by the POSIX and System V writers to control where the
+ * pages of a large segment live:
+ * - Huge pages, to cut TLB misses on multi-GB segments
+ * - Binding to one NUMA node, to avoid cross-socket traffic
+ * - Pre-faulting, so first-touch page faults happen at startup and not
+ *   in the hot loop
+ *
+ * Apply them in the order bind, advise, prefault: a policy only affects
+ * pages faulted in after it is set.
+ */
+
+#ifndef SHM_PLACEMENT_H
+#define SHM_PLACEMENT_H
+
+#include <stddef.h>
+
+// Placement requested on the command line
+typedef struct {
+    int huge_pages;     // Back the segment with huge pages
+    int numa_node;      // Node to bind to, -1 for the default policy
+    int populate;       // Fault every page in before use
+} shm_placement_t;
+
+/**
+ * Parse placement options (--huge, --node N, --populate) from argv
+ *
+ * Recognised options are removed from argv so the caller can parse the
+ * remaining positional arguments as before.
+ * @param placement Set from the options
+ * @param argc Argument count, updated
+ * @param argv Arguments, compacted
+ * @return 0 on success, -1 on a malformed option
+ */
+int shm_placement_parse(shm_placement_t *placement, int *argc, char *argv[]);
+
+/**
+ * Get the system's default huge page size
+ * @return Size in bytes
+ */
+size_t shm_huge_page_size(void);
+
+/**
+ * Round a segment size up to a whole number of huge pages
+ * @param size Size in bytes
+ * @return Rounded size
+ */
+size_t shm_round_huge(size_t size);
+
+/**
+ * Bind a mapping's memory to one NUMA node, moving pages already faulted in
+ * @param addr Start of the mapping, page aligned
+ * @param length Mapping length
+ * @param node NUMA node
+ * @return 0 on success, -1 on error
+ */
+int shm_bind_node(void *addr, size_t length, int node);
+
+/**
+ * Ask for transparent huge pages on a mapping (MADV_HUGEPAGE)
+ * @param addr Start of the mapping, page aligned
+ * @param length Mapping length
+ * @return 0 on success, -1 on error
+ */
+int shm_advise_huge(void *addr, size_t length);
+
+/**
+ * Fault in every page of a mapping for writing, without changing its contents
+ * @param addr Start of the mapping, page aligned
+ * @param length Mapping length
+ * @return 0 on success, -1 on error
+ */
+int shm_prefault(void *addr, size_t length);
+
+/**
+ * Apply the bind, huge page advice and prefault steps a placement asks for
+ *
+ * Failures are reported and skipped: placement is an optimisation, so the
+ * segment is still usable without it.
+ * @param placement Requested placement
+ * @param addr Start of the mapping, page aligned
+ * @param length Mapping length
+ * @param advise_huge Non-zero to use MADV_HUGEPAGE for huge_pages (for
+ *                    mappings not already backed by hugetlb pages)
+ */
+void shm_apply_placement(const shm_placement_t *placement, void *addr, size_t length,
+                         int advise_huge);
+
+#endif // SHM_PLACEMENT_H
@@ -0,0 +1,243 @@
+/**
+ * Shared Memory Queue Benchmark
+ *
+ * Measures message throughput between processes for:
+ * - the POSIX single-producer/single-consumer ring (../posix/shm_ring.c)
+ * - the System V multi-producer/multi-consumer queue (shm_queue.c)
+ * with 16-byte messages. Each configuration forks its producers and
+ * consumers onto one freshly created segment. Every 64th message carries
+ * its send time, so consumers also record producer-to-consumer latency.
+ * Results go through the shared harness in bench.h.
+ *
+ * Usage: queue_bench [messages]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/wait.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "shm_queue.h"
+#include "shm_ring.h"
+#include "bench.h"
+
+// Constants
+#define DEFAULT_MESSAGES 10000000   // Total per configuration
+#define QUEUE_CAPACITY 4096         // MPMC slots
+#define RING_CAPACITY (1 << 20)     // SPSC bytes
+#define MESSAGE_SIZE 16
+#define MAX_WORKERS 16
+#define SAMPLE_EVERY 64             // Messages between timestamped ones
+
+// Benchmarked queue kinds
+typedef enum {
+    BENCH_SPSC_RING,
+    BENCH_MPMC_QUEUE
+} bench_kind_t;
+
+// One benchmark configuration
+typedef struct {
+    bench_kind_t kind;
+    int producers;
+    int consumers;
+    uint64_t messages;
+    bench_histogram_t *latency;     // Shared with the workers, one per worker
+} bench_case_t;
+
+/**
+ * Create and attach a private System V segment
+ * @param size Segment size in bytes
+ * @param shm_id Set to the segment ID
+ * @return Attached address, NULL on error
+ */
+static void *create_segment(size_t size, int *shm_id) {
+    void *ptr;
+
+    *shm_id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (*shm_id == -1) {
+        perror("shmget failed");
+        return NULL;
+    }
+    ptr = shmat(*shm_id, NULL, 0);
+    // Removal takes effect once every process has detached
+    shmctl(*shm_id, IPC_RMID, NULL);
+    if (ptr == (void *)-1) {
+        perror("shmat failed");
+        return NULL;
+    }
+    return ptr;
+}
+
+/**
+ * Worker process body
+ * @param kind Queue kind
+ * @param region Shared region holding the queue
+ * @param producer Non-zero to produce, zero to consume
+ * @param messages Messages to produce (ignored when consuming)
+ * @param latency Shared histogram for the latencies this consumer sees
+ * @return Exit status
+ */
+static int run_worker(bench_kind_t kind, void *region, int producer, uint64_t messages,
+                      bench_histogram_t *latency) {
+    unsigned char message[SHM_QUEUE_MAX_RECORD] = { 0 };
+    shm_queue_t *queue = NULL;
+    shm_ring_t *ring = NULL;
+    ssize_t length;
+
+    if (kind == BENCH_SPSC_RING) {
+        ring = shm_ring_attach(region);
+    } else {
+        queue = shm_queue_attach(region);
+    }
+    if (!ring && !queue) {
+        perror("attach failed");
+        return EXIT_FAILURE;
+    }
+
+    if (producer) {
+        for (uint64_t i = 0; i < messages; i++) {
+            uint64_t sent = i % SAMPLE_EVERY == 0 ? bench_now_ns() : 0;
+            memcpy(message, &i, sizeof(i));
+            memcpy(message + sizeof(i), &sent, sizeof(sent));
+            if ((ring ? shm_ring_push(ring, message, MESSAGE_SIZE)
+                      : shm_queue_push(queue, message, MESSAGE_SIZE)) != 0) {
+                perror("push failed");
+                return EXIT_FAILURE;
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+
+    for (;;) {
+        uint64_t sent;
+
+        length = ring ? shm_ring_pop(ring, message, sizeof(message))
+                      : shm_queue_pop(queue, message);
+        if (length <= 0) {
+            break;
+        }
+        memcpy(&sent, message + sizeof(uint64_t), sizeof(sent));
+        if (sent != 0) {
+            bench_histogram_add(latency, bench_now_ns() - sent);
+        }
+    }
+    return length < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * One repetition: stream the messages through a fresh segment
+ * @param arg Benchmark configuration
+ * @param latency Receives the consumers' sampled latencies
+ * @return Messages delivered, -1 on error
+ */
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    bench_kind_t kind = bench->kind;
+    int producers = bench->producers;
+    int consumers = bench->consumers;
+    uint64_t messages = bench->messages;
+    size_t size = kind == BENCH_SPSC_RING ? shm_ring_region_size(RING_CAPACITY)
+                                          : shm_queue_region_size(QUEUE_CAPACITY);
+    shm_queue_t *queue = NULL;
+    shm_ring_t *ring = NULL;
+    pid_t workers[MAX_WORKERS];
+    int failed = 0;
+    int status;
+    int shm_id;
+    void *region = create_segment(size, &shm_id);
+
+    if (!region || producers + consumers > MAX_WORKERS) {
+        return -1;
+    }
+    if (kind == BENCH_SPSC_RING) {
+        ring = shm_ring_create(region, RING_CAPACITY);
+    } else {
+        queue = shm_queue_create(region, QUEUE_CAPACITY);
+    }
+
+    for (int i = 0; i < producers + consumers; i++) {
+        bench_histogram_init(&bench->latency[i]);
+    }
+    for (int i = 0; i < producers + consumers; i++) {
+        int producer = i < producers;
+        // Spread the messages so the producers' shares add up exactly
+        uint64_t share = messages / producers + ((uint64_t)i < messages % producers);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork failed");
+            return -1;
+        }
+        if (pid == 0) {
+            _exit(run_worker(kind, region, producer, share, &bench->latency[i]));
+        }
+        workers[i] = pid;
+    }
+
+    // Close the stream once all producers are done, then reap the consumers
+    for (int i = 0; i < producers + consumers; i++) {
+        while (waitpid(workers[i], &status, 0) < 0 && errno == EINTR) {
+        }
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        if (i == producers - 1) {
+            if (ring) {
+                shm_ring_close(ring);
+            } else {
+                shm_queue_close(queue);
+            }
+        }
+    }
+    for (int i = producers; i < producers + consumers; i++) {
+        bench_histogram_merge(latency, &bench->latency[i]);
+    }
+
+    shm_ring_detach(ring);
+    shm_queue_detach(queue);
+    shmdt(region);
+    return failed ? -1 : (long)messages;
+}
+
+// Run one configuration through the harness
+static int run_bench(const bench_config_t *config, bench_histogram_t *shared,
+                     bench_kind_t kind, int producers, int consumers, uint64_t messages) {
+    bench_case_t bench = { kind, producers, consumers, messages, shared };
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s/%dP%dC",
+             kind == BENCH_SPSC_RING ? "spsc-ring" : "mpmc-queue", producers, consumers);
+    return bench_case(config, name, bench_repetition, &bench);
+}
+
+int main(int argc, char *argv[]) {
+    bench_config_t config;
+    bench_histogram_t *shared;
+    uint64_t messages;
+    int result = 0;
+
+    bench_config_init(&config, "queue_bench");
+    messages = argc > 1 ? strtoull(argv[1], NULL, 10)
+                        : (uint64_t)bench_scaled(&config, DEFAULT_MESSAGES);
+
+    // Consumers record latencies in memory the parent can read after they exit
+    shared = mmap(NULL, MAX_WORKERS * sizeof(*shared), PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap failed");
+        return EXIT_FAILURE;
+    }
+
+    result |= run_bench(&config, shared, BENCH_SPSC_RING, 1, 1, messages);
+    result |= run_bench(&config, shared, BENCH_MPMC_QUEUE, 1, 1, messages);
+    result |= run_bench(&config, shared, BENCH_MPMC_QUEUE, 2, 2, messages);
+    result |= run_bench(&config, shared, BENCH_MPMC_QUEUE, 4, 4, messages);
+
+    munmap(shared, MAX_WORKERS * sizeof(*shared));
+    return result ? EXIT_FAILURE : EXIT_SUCCESS;
+}
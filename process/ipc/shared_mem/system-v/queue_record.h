@@ -0,0 +1,45 @@
+/**
+ * Segment layout shared by shared_mem_writer.c and shared_mem_reader.c
+ *
+ * The segment starts with a small header describing the stream, followed
+ * by the MPMC queue (shm_queue.c). Each record names its producer and
+ * carries that producer's sequence number, so consumers can check order.
+ */
+
+#ifndef QUEUE_RECORD_H
+#define QUEUE_RECORD_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "shm_queue.h"
+
+// Constants
+#define SHM_KEY_FILE "."            // Any existing path; writer and reader must agree
+#define SHM_KEY_ID 65
+#define QUEUE_CAPACITY 4096         // Slots in the queue
+#define SHM_SIZE (sizeof(stream_header_t) + shm_queue_region_size(QUEUE_CAPACITY))
+#define DEFAULT_WORKERS 4
+#define DEFAULT_MESSAGES 1000000    // Per producer
+#define MAX_PRODUCERS 64
+
+// Stream description and consumer totals, ahead of the queue
+typedef struct {
+    _Alignas(64) uint32_t producers;
+    uint64_t messages;              // Records per producer
+    atomic_uint_least64_t consumed; // Records taken by all consumers
+    atomic_uint_least64_t checksum; // Sum of the sequence numbers taken
+    atomic_uint errors;             // Out-of-order or malformed records seen
+} stream_header_t;
+
+// One queued record
+typedef struct {
+    uint32_t producer;
+    uint32_t reserved;
+    uint64_t seq;
+} queue_record_t;
+
+// Queue region inside an attached segment
+#define SHM_QUEUE_REGION(shm_ptr) ((char *)(shm_ptr) + sizeof(stream_header_t))
+
+#endif // QUEUE_RECORD_H
@@ -2,13 +2,18 @@
  * System V Shared Memory Reader
  * 
  * This program demonstrates reading from shared memory using System V IPC.
- * It attaches to an existing shared memory segment, reads data from it, and properly cleans up resources.
+ * It attaches to an existing shared memory segment, forks consumer processes
+ * that drain the writer's multi-producer/multi-consumer queue, and properly
+ * cleans up resources.
  * 
  * Features:
  * - Shared memory access and management
+ * - Lock-free MPMC queue shared by several processes (shm_queue.c)
+ * - Per-producer order and total count verification
  * - Error handling
  * - Resource cleanup
- * - Safe memory operations
+ *
+ * Usage: reader [consumers]
  */
 
 #include <stdio.h>
@@ -16,18 +21,20 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/wait.h>
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <unistd.h>
+#include <time.h>
 
-// Constants
-#define SHM_SIZE 1024
-#define SHM_KEY_FILE "shared_mem"
-#define SHM_KEY_ID 65
+#include "shm_queue.h"
+#include "queue_record.h"
 
 // Global variables for cleanup
 static int shm_id = -1;
 static void *shm_ptr = (void *)-1;
+static shm_queue_t *queue = NULL;
 static volatile sig_atomic_t running = 1;
 
 // Signal handler for graceful shutdown
@@ -38,15 +45,73 @@ static void signal_handler(int sig) {
 
 // Cleanup function
 static void cleanup(void) {
+    shm_queue_detach(queue);
     if (shm_ptr != (void *)-1) {
         shmdt(shm_ptr);
     }
 }
 
-int main(void) {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+/**
+ * Consumer process body: drain the queue, checking each producer's order
+ * @param header Stream header to add this consumer's totals to
+ * @return Exit status
+ */
+static int run_consumer(stream_header_t *header) {
+    unsigned char buffer[SHM_QUEUE_MAX_RECORD];
+    uint64_t next_seq[MAX_PRODUCERS] = { 0 };
+    uint64_t consumed = 0;
+    uint64_t checksum = 0;
+    unsigned int errors = 0;
+    ssize_t length;
+
+    while (running) {
+        length = shm_queue_pop(queue, buffer);
+        if (length <= 0) {
+            if (length < 0 && errno != EINTR) {
+                perror("shm_queue_pop failed");
+                errors++;
+            }
+            break;
+        }
+
+        queue_record_t record;
+        memcpy(&record, buffer, sizeof(record));
+
+        // One producer's records reach any single consumer in order
+        if ((size_t)length != sizeof(record) || record.producer >= header->producers ||
+            record.seq < next_seq[record.producer]) {
+            errors++;
+            continue;
+        }
+        next_seq[record.producer] = record.seq + 1;
+        checksum += record.seq;
+        consumed++;
+    }
+
+    atomic_fetch_add(&header->consumed, consumed);
+    atomic_fetch_add(&header->checksum, checksum);
+    atomic_fetch_add(&header->errors, errors);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+    int consumers = argc > 1 ? atoi(argv[1]) : DEFAULT_WORKERS;
+    struct sigaction sa;
+    struct timespec start, end;
+    int started = 0;
+    int status;
+
+    if (consumers < 1) {
+        fprintf(stderr, "Usage: %s [consumers]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // Set up signal handlers; no SA_RESTART so a blocked pop returns
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
     // Generate IPC key
     key_t key = ftok(SHM_KEY_FILE, SHM_KEY_ID);
@@ -70,32 +135,54 @@ int main(void) {
         exit(EXIT_FAILURE);
     }
 
-    printf("Reading from shared memory...\n");
-
-    // Read data from shared memory
-    int *data = (int *)shm_ptr;
-    printf("Data read from shared memory:\n");
-    for (int i = 0; i < 10 && i < SHM_SIZE / sizeof(int); i++) {
-        printf("data[%d] = %d\n", i, data[i]);
+    stream_header_t *header = (stream_header_t *)shm_ptr;
+    queue = shm_queue_attach(SHM_QUEUE_REGION(shm_ptr));
+    if (!queue) {
+        perror("shm_queue_attach failed");
+        cleanup();
+        exit(EXIT_FAILURE);
     }
-    printf("...\n");
-
-    // Verify data
-    int error = 0;
-    for (int i = 0; i < SHM_SIZE / sizeof(int) && running; i++) {
-        if (data[i] != i) {
-            printf("Data verification failed at index %d: expected %d, got %d\n",
-                   i, i, data[i]);
-            error = 1;
+
+    printf("Reading from shared memory with %d consumers...\n", consumers);
+
+    // Fork the consumers; they share the attached segment
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < consumers; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork failed");
             break;
         }
+        if (pid == 0) {
+            _exit(run_consumer(header));
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        while (wait(&status) < 0 && errno == EINTR) {
+        }
     }
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-    if (!error) {
+    // Verify data: every record once, each producer's records in order
+    uint64_t consumed = atomic_load(&header->consumed);
+    uint64_t expected = (uint64_t)header->producers * header->messages;
+    uint64_t expected_sum = (uint64_t)header->producers *
+                            (header->messages * (header->messages - 1) / 2);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    int error = atomic_load(&header->errors) != 0 || consumed != expected ||
+                atomic_load(&header->checksum) != expected_sum;
+
+    printf("Read %lu of %lu messages in %.3f s (%.2f M msgs/s)\n",
+           (unsigned long)consumed, (unsigned long)expected, seconds, consumed / seconds / 1e6);
+
+    if (error) {
+        printf("Data verification failed (%u bad records)\n", atomic_load(&header->errors));
+    } else {
         printf("Data verification successful\n");
     }
 
     cleanup();
     printf("Reader process finished\n");
     return error ? EXIT_FAILURE : EXIT_SUCCESS;
-}
\ No newline at end of file
+}
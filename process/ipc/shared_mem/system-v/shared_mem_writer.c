@@ -2,13 +2,18 @@
  * System V Shared Memory Writer
  * 
  * This program demonstrates writing to shared memory using System V IPC.
- * It creates a shared memory segment, writes data to it, and properly cleans up resources.
+ * It creates a shared memory segment holding a multi-producer/multi-consumer
+ * queue, forks producer processes that fill it, and properly cleans up resources.
  * 
  * Features:
  * - Shared memory creation and management
+ * - Lock-free MPMC queue shared by several processes (shm_queue.c)
+ * - Producer processes that sleep on a futex while the queue is full
+ * - Optional huge pages, NUMA binding and pre-faulting (shm_placement.c)
  * - Error handling
  * - Resource cleanup
- * - Safe memory operations
+ *
+ * Usage: writer [--huge] [--node N] [--populate] [producers] [messages per producer]
  */
 
 #include <stdio.h>
@@ -16,18 +21,21 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/wait.h>
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <unistd.h>
+#include <time.h>
 
-// Constants
-#define SHM_SIZE 1024
-#define SHM_KEY_FILE "shared_mem"
-#define SHM_KEY_ID 65
+#include "shm_queue.h"
+#include "queue_record.h"
+#include "shm_placement.h"
 
 // Global variables for cleanup
 static int shm_id = -1;
 static void *shm_ptr = (void *)-1;
+static shm_queue_t *queue = NULL;
 static volatile sig_atomic_t running = 1;
 
 // Signal handler for graceful shutdown
@@ -38,6 +46,7 @@ static void signal_handler(int sig) {
 
 // Cleanup function
 static void cleanup(void) {
+    shm_queue_detach(queue);
     if (shm_ptr != (void *)-1) {
         shmdt(shm_ptr);
     }
@@ -46,10 +55,52 @@ static void cleanup(void) {
     }
 }
 
-int main(void) {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+/**
+ * Producer process body: push this producer's records in order
+ * @param producer Producer number
+ * @param messages Number of records to push
+ * @return Exit status
+ */
+static int run_producer(uint32_t producer, uint64_t messages) {
+    queue_record_t record = { .producer = producer };
+
+    for (uint64_t seq = 0; seq < messages && running; seq++) {
+        record.seq = seq;
+        if (shm_queue_push(queue, &record, sizeof(record)) != 0) {
+            if (errno != EINTR) {
+                perror("shm_queue_push failed");
+                return EXIT_FAILURE;
+            }
+            break;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+    shm_placement_t placement;
+    int parsed = shm_placement_parse(&placement, &argc, argv);
+    int producers = argc > 1 ? atoi(argv[1]) : DEFAULT_WORKERS;
+    long messages = argc > 2 ? atol(argv[2]) : DEFAULT_MESSAGES;
+    size_t shm_size = SHM_SIZE;
+    int hugetlb = 0;
+    struct sigaction sa;
+    struct timespec start, end;
+    int started = 0;
+    int status;
+
+    if (parsed < 0 || producers < 1 || producers > MAX_PRODUCERS || messages < 0) {
+        fprintf(stderr, "Usage: %s [--huge] [--node N] [--populate] "
+                "[producers (1-%d)] [messages per producer]\n", argv[0], MAX_PRODUCERS);
+        exit(EXIT_FAILURE);
+    }
+
+    // Set up signal handlers; no SA_RESTART so a blocked push returns
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
     // Generate IPC key
     key_t key = ftok(SHM_KEY_FILE, SHM_KEY_ID);
@@ -58,8 +109,23 @@ int main(void) {
         exit(EXIT_FAILURE);
     }
 
-    // Create shared memory segment
-    shm_id = shmget(key, SHM_SIZE, IPC_CREAT | 0666);
+    // Create shared memory segment, from the hugetlb pool if asked; the
+    // pool must be reserved first (vm.nr_hugepages), so fall back to
+    // normal pages with transparent huge page advice when it is empty
+    if (placement.huge_pages) {
+        shm_size = shm_round_huge(SHM_SIZE);
+        shm_id = shmget(key, shm_size, IPC_CREAT | SHM_HUGETLB | 0666);
+        if (shm_id != -1) {
+            hugetlb = 1;
+            printf("Segment backed by %zu-byte huge pages\n", shm_huge_page_size());
+        } else {
+            perror("shmget(SHM_HUGETLB) failed, using normal pages");
+            shm_size = SHM_SIZE;
+        }
+    }
+    if (!hugetlb) {
+        shm_id = shmget(key, shm_size, IPC_CREAT | 0666);
+    }
     if (shm_id == -1) {
         perror("shmget failed");
         exit(EXIT_FAILURE);
@@ -75,27 +141,53 @@ int main(void) {
         exit(EXIT_FAILURE);
     }
 
-    printf("Writing to shared memory...\n");
+    // shmat has no MAP_POPULATE, so pre-faulting is always done afterwards
+    shm_apply_placement(&placement, shm_ptr, shm_size, !hugetlb);
 
-    // Write data to shared memory
-    int *data = (int *)shm_ptr;
-    for (int i = 0; i < SHM_SIZE / sizeof(int) && running; i++) {
-        data[i] = i;
+    // Describe the stream, then format the queue behind the header
+    stream_header_t *header = (stream_header_t *)shm_ptr;
+    memset(header, 0, sizeof(*header));
+    header->producers = (uint32_t)producers;
+    header->messages = (uint64_t)messages;
+    queue = shm_queue_create(SHM_QUEUE_REGION(shm_ptr), QUEUE_CAPACITY);
+    if (!queue) {
+        perror("shm_queue_create failed");
+        cleanup();
+        exit(EXIT_FAILURE);
     }
 
-    printf("Data written to shared memory:\n");
-    for (int i = 0; i < 10 && i < SHM_SIZE / sizeof(int); i++) {
-        printf("data[%d] = %d\n", i, data[i]);
+    printf("Writing %ld messages from each of %d producers...\n", messages, producers);
+
+    // Fork the producers; they share the attached segment
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < producers; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork failed");
+            break;
+        }
+        if (pid == 0) {
+            _exit(run_producer((uint32_t)i, (uint64_t)messages));
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        while (wait(&status) < 0 && errno == EINTR) {
+        }
     }
-    printf("...\n");
+    shm_queue_close(queue);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Producers finished in %.3f s (%.2f M msgs/s)\n",
+           seconds, (double)started * messages / seconds / 1e6);
 
     // Wait for reader to finish
     printf("Waiting for reader to finish...\n");
-    while (running) {
-        sleep(1);
+    while (running && shm_queue_wait_empty(queue) != 0) {
     }
 
     cleanup();
     printf("Writer process finished\n");
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
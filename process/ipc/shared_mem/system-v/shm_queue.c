@@ -0,0 +1,291 @@
+/**
+ * Shared Memory MPMC Queue Implementation
+ *
+ * Slot i starts with sequence i. A producer that finds sequence == pos at
+ * its enqueue position claims the slot by advancing enqueue_pos, fills it
+ * and publishes it with sequence pos + 1. A consumer that finds
+ * sequence == pos + 1 at its dequeue position claims it the same way and
+ * frees it with sequence pos + capacity, ready for the next lap.
+ *
+ * Sleeping uses an eventcount per direction: a waiter reads the event
+ * word, registers in the waiter count, re-checks its slot and only then
+ * sleeps. The other side bumps the word and wakes one waiter after each
+ * operation, but only if the count is non-zero.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "shm_queue.h"
+
+// Constants
+#define QUEUE_MAGIC 0x4d504d43u     // "MPMC"
+#define CACHE_LINE_SIZE 64
+#define SPIN_LIMIT 256              // Slot re-checks before yielding
+#define YIELD_LIMIT 16              // sched_yield calls before sleeping
+
+// One record slot, a cache line each so neighbours do not false-share
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_least64_t sequence;
+    uint32_t length;
+    unsigned char data[SHM_QUEUE_MAX_RECORD];
+} queue_slot_t;
+
+// One direction's eventcount
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_uint seq;  // Futex word
+    atomic_uint waiters;
+} queue_event_t;
+
+// Layout of the shared region
+typedef struct {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t capacity;
+    atomic_uint closed;             // Producers have finished
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_least64_t enqueue_pos;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_least64_t dequeue_pos;
+    queue_event_t not_empty;        // Consumers sleep here
+    queue_event_t not_full;         // Producers sleep here
+    queue_slot_t slots[];
+} shm_queue_shared_t;
+
+// Per-process handle
+struct shm_queue {
+    shm_queue_shared_t *shared;
+    uint64_t mask;
+};
+
+_Static_assert(sizeof(queue_slot_t) == CACHE_LINE_SIZE, "slot must fill one cache line");
+
+static void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/**
+ * Wait until a shared counter moves away from a value
+ * @param word Counter to watch (a slot sequence or a queue position)
+ * @param value Value to wait out
+ * @param event Eventcount the other side signals
+ * @param closed End-of-stream flag that also ends the wait, or NULL
+ * @return 0 when the counter moved (or the stream closed), -1 on signal
+ */
+static int wait_change(atomic_uint_least64_t *word, uint64_t value,
+                       queue_event_t *event, atomic_uint *closed) {
+    unsigned int observed;
+    int result = 0;
+
+    for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+        if (atomic_load_explicit(word, memory_order_acquire) != value) {
+            return 0;
+        }
+        cpu_relax();
+    }
+    for (int yield = 0; yield < YIELD_LIMIT; yield++) {
+        sched_yield();
+        if (atomic_load_explicit(word, memory_order_acquire) != value) {
+            return 0;
+        }
+    }
+
+    observed = atomic_load_explicit(&event->seq, memory_order_acquire);
+    atomic_fetch_add(&event->waiters, 1);
+    if (atomic_load(word) == value && !(closed && atomic_load(closed))) {
+        if (syscall(SYS_futex, &event->seq, FUTEX_WAIT, observed, NULL, NULL, 0) < 0 &&
+            errno == EINTR) {
+            result = -1;
+        }
+    }
+    atomic_fetch_sub(&event->waiters, 1);
+    return result;
+}
+
+/**
+ * Wake waiters on an eventcount, if there are any
+ * @param event Eventcount to signal
+ * @param count Number of waiters to wake
+ */
+static void signal_event(queue_event_t *event, int count) {
+    // Order the slot update before reading the count (pairs with wait_change)
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&event->waiters, memory_order_relaxed) > 0) {
+        atomic_fetch_add_explicit(&event->seq, 1, memory_order_release);
+        syscall(SYS_futex, &event->seq, FUTEX_WAKE, count, NULL, NULL, 0);
+    }
+}
+
+size_t shm_queue_region_size(size_t capacity) {
+    return sizeof(shm_queue_shared_t) + capacity * sizeof(queue_slot_t);
+}
+
+/**
+ * Build a local handle for a formatted region
+ * @param shared Shared queue header
+ * @return Handle, NULL on error
+ */
+static shm_queue_t *make_handle(shm_queue_shared_t *shared) {
+    shm_queue_t *queue = malloc(sizeof(*queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->shared = shared;
+    queue->mask = shared->capacity - 1;
+    return queue;
+}
+
+shm_queue_t *shm_queue_create(void *region, size_t capacity) {
+    shm_queue_shared_t *shared = (shm_queue_shared_t *)region;
+
+    if (!region || ((uintptr_t)region & (CACHE_LINE_SIZE - 1)) != 0 ||
+        capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    memset(shared, 0, sizeof(*shared));
+    shared->capacity = capacity;
+    atomic_init(&shared->closed, 0);
+    atomic_init(&shared->enqueue_pos, 0);
+    atomic_init(&shared->dequeue_pos, 0);
+    atomic_init(&shared->not_empty.seq, 0);
+    atomic_init(&shared->not_empty.waiters, 0);
+    atomic_init(&shared->not_full.seq, 0);
+    atomic_init(&shared->not_full.waiters, 0);
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&shared->slots[i].sequence, i);
+    }
+
+    // Publish the magic last so an early attach never sees a half-made queue
+    atomic_thread_fence(memory_order_release);
+    shared->magic = QUEUE_MAGIC;
+    return make_handle(shared);
+}
+
+shm_queue_t *shm_queue_attach(void *region) {
+    shm_queue_shared_t *shared = (shm_queue_shared_t *)region;
+
+    if (!region || shared->magic != QUEUE_MAGIC) {
+        errno = EINVAL;
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return make_handle(shared);
+}
+
+void shm_queue_detach(shm_queue_t *queue) {
+    free(queue);
+}
+
+int shm_queue_push(shm_queue_t *queue, const void *data, size_t length) {
+    shm_queue_shared_t *shared = queue->shared;
+    uint64_t pos = atomic_load_explicit(&shared->enqueue_pos, memory_order_relaxed);
+    queue_slot_t *slot;
+
+    if (length > SHM_QUEUE_MAX_RECORD) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    for (;;) {
+        slot = &shared->slots[pos & queue->mask];
+        uint64_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+
+        if (diff == 0) {
+            // Slot is free for this lap: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&shared->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: the slot still holds last lap's record
+            if (wait_change(&slot->sequence, seq, &shared->not_full, NULL) < 0) {
+                errno = EINTR;
+                return -1;
+            }
+            pos = atomic_load_explicit(&shared->enqueue_pos, memory_order_relaxed);
+        } else {
+            // Another producer claimed it first
+            pos = atomic_load_explicit(&shared->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->length = (uint32_t)length;
+    memcpy(slot->data, data, length);
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    signal_event(&shared->not_empty, 1);
+    return 0;
+}
+
+ssize_t shm_queue_pop(shm_queue_t *queue, void *buffer) {
+    shm_queue_shared_t *shared = queue->shared;
+    uint64_t pos = atomic_load_explicit(&shared->dequeue_pos, memory_order_relaxed);
+    queue_slot_t *slot;
+    uint32_t length;
+
+    for (;;) {
+        slot = &shared->slots[pos & queue->mask];
+        uint64_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - (pos + 1));
+
+        if (diff == 0) {
+            // Slot holds this lap's record: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&shared->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Empty, or a producer is still filling the slot
+            if (atomic_load_explicit(&shared->closed, memory_order_acquire) &&
+                atomic_load(&shared->enqueue_pos) == pos) {
+                return 0;
+            }
+            if (wait_change(&slot->sequence, seq, &shared->not_empty, &shared->closed) < 0) {
+                errno = EINTR;
+                return -1;
+            }
+            pos = atomic_load_explicit(&shared->dequeue_pos, memory_order_relaxed);
+        } else {
+            // Another consumer claimed it first
+            pos = atomic_load_explicit(&shared->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    length = slot->length;
+    memcpy(buffer, slot->data, length);
+    atomic_store_explicit(&slot->sequence, pos + queue->mask + 1, memory_order_release);
+    signal_event(&shared->not_full, 1);
+    return (ssize_t)length;
+}
+
+void shm_queue_close(shm_queue_t *queue) {
+    atomic_store(&queue->shared->closed, 1);
+    signal_event(&queue->shared->not_empty, INT_MAX);
+}
+
+int shm_queue_wait_empty(shm_queue_t *queue) {
+    shm_queue_shared_t *shared = queue->shared;
+
+    for (;;) {
+        uint64_t pos = atomic_load_explicit(&shared->dequeue_pos, memory_order_acquire);
+        if (pos == atomic_load(&shared->enqueue_pos)) {
+            return 0;
+        }
+        if (wait_change(&shared->dequeue_pos, pos, &shared->not_full, NULL) < 0) {
+            errno = EINTR;
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * Shared Memory MPMC Queue Interface
+ *
+ * Bounded multi-producer/multi-consumer queue of small records in a memory
+ * region shared by several processes (e.g. a System V shmget segment).
+ * It follows Dmitry Vyukov's bounded queue: every slot carries a sequence
+ * number, so producers and consumers claim slots with a single
+ * compare-and-swap and never lock.
+ * Features include:
+ * - Any number of producer and consumer processes on one segment
+ * - FIFO order of each producer's records
+ * - Futex sleeping while the queue is empty or full, woken only on demand
+ * - End-of-stream signalling that wakes every consumer
+ *
+ * A blocked push or pop returns -1 with errno EINTR when a signal
+ * arrives, provided the handler was installed without SA_RESTART.
+ */
+
+#ifndef SHM_QUEUE_H
+#define SHM_QUEUE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Constants
+#define SHM_QUEUE_MAX_RECORD 48     // Largest record; a slot is one 64-byte cache line
+
+// Local handle on a queue in shared memory
+typedef struct shm_queue shm_queue_t;
+
+/**
+ * Get the size of the shared region needed for a queue
+ * @param capacity Number of slots, a power of two
+ * @return Region size in bytes
+ */
+size_t shm_queue_region_size(size_t capacity);
+
+/**
+ * Format a shared region as an empty queue
+ * @param region Shared memory of at least shm_queue_region_size(capacity) bytes,
+ *               aligned to 64 bytes
+ * @param capacity Number of slots, a power of two of at least 2
+ * @return Handle, NULL on error
+ */
+shm_queue_t *shm_queue_create(void *region, size_t capacity);
+
+/**
+ * Attach to a queue formatted by shm_queue_create
+ * @param region Shared memory holding the queue
+ * @return Handle, NULL on error
+ */
+shm_queue_t *shm_queue_attach(void *region);
+
+/**
+ * Release a local handle; the shared region is left untouched
+ * @param queue Handle to release
+ */
+void shm_queue_detach(shm_queue_t *queue);
+
+/**
+ * Append a record, waiting while the queue is full
+ * @param queue Queue handle
+ * @param data Record bytes
+ * @param length Record length, at most SHM_QUEUE_MAX_RECORD
+ * @return 0 on success, -1 on error
+ */
+int shm_queue_push(shm_queue_t *queue, const void *data, size_t length);
+
+/**
+ * Remove the oldest record, waiting while the queue is empty
+ * @param queue Queue handle
+ * @param buffer Output buffer of at least SHM_QUEUE_MAX_RECORD bytes
+ * @return Record length, 0 at end of stream, -1 on error
+ */
+ssize_t shm_queue_pop(shm_queue_t *queue, void *buffer);
+
+/**
+ * Mark the end of the stream; consumers' pops return 0 once it is drained
+ * @param queue Queue handle
+ */
+void shm_queue_close(shm_queue_t *queue);
+
+/**
+ * Wait until consumers have claimed every record
+ * @param queue Queue handle
+ * @return 0 on success, -1 on error
+ */
+int shm_queue_wait_empty(shm_queue_t *queue);
+
+#endif // SHM_QUEUE_H
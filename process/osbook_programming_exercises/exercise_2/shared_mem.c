@@ -1,12 +1,18 @@
 /**
  * Shared Memory Timer
- * 
+ *
  * This program measures the execution time of a command using shared memory
- * for inter-process communication between parent and child processes.
- * 
+ * for inter-process communication between parent and child processes. Run
+ * the command many times and it becomes a spawn-latency profiler: each run
+ * records three timestamps in a shared-memory ring (parent before fork,
+ * child just before exec, parent after reaping), and the results are
+ * summarized as min/p50/p99/max and a histogram.
+ *
  * Features:
  * - Command execution timing
  * - Shared memory IPC
+ * - CLOCK_MONOTONIC_RAW or TSC timestamps
+ * - Fork-to-exec and total latency percentiles and a histogram
  * - Error handling
  * - Resource cleanup
  */
@@ -15,21 +21,44 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <time.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <errno.h>
 #include <signal.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bench.h"
 
 // Constants
-#define MEM_SIZE sizeof(struct timespec)
+#define RING_SLOTS 4096             // Samples kept in shared memory at once
+#define HIST_ROW_BUCKETS (BENCH_HIST_SUB / 4) // Printed rows split each power of two in four
+#define HIST_BAR_WIDTH 50
+#define TSC_CALIBRATION_NS 50000000 // Calibrate the TSC over 50 ms
+
+// Timestamps of one run, in clock ticks
+typedef struct {
+    uint64_t fork;      // Parent, just before fork
+    uint64_t exec;      // Child, just before exec
+    uint64_t end;       // Parent, after reaping the child
+} sample_t;
+
+// Shared-memory ring; run i uses slot i % RING_SLOTS
+typedef struct {
+    sample_t slots[RING_SLOTS];
+} ring_t;
 
 // Global variables for cleanup
-static void *start_time = MAP_FAILED;
-static void *end_time = MAP_FAILED;
+static ring_t *ring = MAP_FAILED;
 static volatile sig_atomic_t running = 1;
+static int use_tsc = 0;
+static double ns_per_tick = 1.0;
 
 // Signal handler for graceful shutdown
 static void signal_handler(int sig) {
@@ -39,96 +68,281 @@ static void signal_handler(int sig) {
 
 // Cleanup function
 static void cleanup(void) {
-    if (start_time != MAP_FAILED) {
-        munmap(start_time, MEM_SIZE);
+    if (ring != MAP_FAILED) {
+        munmap(ring, sizeof(*ring));
     }
-    if (end_time != MAP_FAILED) {
-        munmap(end_time, MEM_SIZE);
+}
+
+static uint64_t monotonic_raw_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Current timestamp in ticks: TSC cycles or CLOCK_MONOTONIC_RAW nanoseconds
+static inline uint64_t timestamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (use_tsc) {
+        return __rdtsc();
     }
+#endif
+    return monotonic_raw_ns();
 }
 
-int main(int argc, char *argv[]) {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+/**
+ * Switch timestamps to the TSC and calibrate it against CLOCK_MONOTONIC_RAW
+ * @return 0 on success, -1 if there is no usable TSC
+ */
+static int enable_tsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    char line[4096];
+    int invariant = 0;
+    uint64_t ns_start, ns_end, tsc_start, tsc_end;
 
-    // Check command line arguments
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <command> [args...]\n", argv[0]);
-        return EXIT_FAILURE;
+    // Only an invariant TSC ticks at a constant rate in every process
+    if (f) {
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, "flags", 5) == 0) {
+                invariant = strstr(line, " constant_tsc") && strstr(line, " nonstop_tsc");
+                break;
+            }
+        }
+        fclose(f);
+    }
+    if (!invariant) {
+        fprintf(stderr, "Warning: TSC is not invariant, timings may drift\n");
     }
 
-    // Map shared memory for timing
-    start_time = mmap(NULL, MEM_SIZE, PROT_READ | PROT_WRITE, 
-                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-    end_time = mmap(NULL, MEM_SIZE, PROT_READ | PROT_WRITE, 
-                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ns_start = monotonic_raw_ns();
+    tsc_start = __rdtsc();
+    do {
+        ns_end = monotonic_raw_ns();
+    } while (ns_end - ns_start < TSC_CALIBRATION_NS);
+    tsc_end = __rdtsc();
 
-    if (start_time == MAP_FAILED || end_time == MAP_FAILED) {
-        perror("Memory mapping failed");
-        cleanup();
-        return EXIT_FAILURE;
+    ns_per_tick = (double)(ns_end - ns_start) / (double)(tsc_end - tsc_start);
+    use_tsc = 1;
+    return 0;
+#else
+    fprintf(stderr, "No TSC on this architecture\n");
+    return -1;
+#endif
+}
+
+static void print_summary(const char *name, const bench_histogram_t *h) {
+    printf("%-12s %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+           h->min / 1000.0, bench_histogram_quantile(h, 0.50) / 1000.0,
+           bench_histogram_quantile(h, 0.99) / 1000.0, h->max / 1000.0,
+           h->sum / h->count / 1000.0);
+}
+
+// Histogram rows of HIST_ROW_BUCKETS buckets, four per power of two
+static void print_histogram(const bench_histogram_t *h) {
+    int rows = BENCH_HIST_BUCKETS / HIST_ROW_BUCKETS, first = rows, last = -1;
+    uint64_t peak = 0;
+
+    for (int r = 0; r < rows; r++) {
+        uint64_t count = 0;
+        for (int b = r * HIST_ROW_BUCKETS; b < (r + 1) * HIST_ROW_BUCKETS; b++) {
+            count += h->counts[b];
+        }
+        if (count > 0) {
+            if (r < first) first = r;
+            last = r;
+            if (count > peak) peak = count;
+        }
+    }
+
+    printf("\n%12s %12s %10s\n", "from us", "to us", "runs");
+    for (int r = first; r <= last; r++) {
+        uint64_t count = 0;
+        for (int b = r * HIST_ROW_BUCKETS; b < (r + 1) * HIST_ROW_BUCKETS; b++) {
+            count += h->counts[b];
+        }
+        int width = (int)((count * HIST_BAR_WIDTH + peak - 1) / peak);
+        uint64_t low = bench_histogram_bucket_low(r * HIST_ROW_BUCKETS);
+        uint64_t high = r + 1 < rows ? bench_histogram_bucket_low((r + 1) * HIST_ROW_BUCKETS)
+                                     : UINT64_MAX;
+        printf("%12.1f %12.1f %10llu ", low / 1000.0, high / 1000.0, (unsigned long long)count);
+        for (int i = 0; i < width; i++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+// Convert a tick interval to nanoseconds
+static uint64_t ticks_to_ns(uint64_t ticks) {
+    return use_tsc ? (uint64_t)(ticks * ns_per_tick) : ticks;
+}
+
+// Join arguments into one shell command line
+static char *join_command(char *const argv[], int argc) {
+    size_t total_length = 0;
+    char *command;
+
+    for (int i = 0; i < argc; i++) {
+        total_length += strlen(argv[i]) + 1;
+    }
+    command = malloc(total_length);
+    if (!command) {
+        perror("Memory allocation failed");
+        return NULL;
     }
+    strcpy(command, argv[0]);
+    for (int i = 1; i < argc; i++) {
+        strcat(command, " ");
+        strcat(command, argv[i]);
+    }
+    return command;
+}
 
-    // Create child process
+/**
+ * Run the command once, filling its ring slot
+ * @param slot Shared sample for this run
+ * @param argv Command to execute directly, NULL-terminated
+ * @param quiet Send the command's output to /dev/null
+ * @param status Set to the wait status
+ * @return 0 on success, -1 on error
+ */
+static int run_once(sample_t *slot, char *const argv[], int quiet, int *status) {
+    slot->exec = 0;
+    slot->fork = timestamp();
     pid_t pid = fork();
     if (pid < 0) {
         perror("Fork failed");
-        cleanup();
-        return EXIT_FAILURE;
+        return -1;
     }
 
     if (pid == 0) {
         // Child process: execute command
-        clock_gettime(CLOCK_REALTIME, (struct timespec *)start_time);
+        if (quiet) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            if (null_fd >= 0) {
+                dup2(null_fd, STDOUT_FILENO);
+                dup2(null_fd, STDERR_FILENO);
+                close(null_fd);
+            }
+        }
+        slot->exec = timestamp();
+        execvp(argv[0], argv);
+        perror("exec failed");
+        _exit(127);
+    }
 
-        // Calculate total command length
-        int total_length = 0;
-        for (int i = 1; i < argc; i++) {
-            total_length += strlen(argv[i]) + 1;
+    // Parent process: wait and measure time
+    while (waitpid(pid, status, 0) < 0) {
+        if (errno != EINTR) {
+            perror("waitpid failed");
+            return -1;
         }
+    }
+    slot->end = timestamp();
+    return 0;
+}
 
-        // Allocate and build command string
-        char *command = malloc(total_length);
-        if (!command) {
-            perror("Memory allocation failed");
-            cleanup();
-            return EXIT_FAILURE;
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [-n runs] [--tsc] [--shell] [--quiet] <command> [args...]\n"
+            "  -n runs   run the command this many times and print latency statistics\n"
+            "  --tsc     timestamp with the TSC instead of CLOCK_MONOTONIC_RAW\n"
+            "  --shell   run the command line through /bin/sh -c\n"
+            "  --quiet   discard the command's output\n",
+            program);
+}
+
+int main(int argc, char *argv[]) {
+    long runs = 1;
+    int shell = 0, quiet = 0, first_arg;
+    char *shell_argv[4] = { "sh", "-c", NULL, NULL };
+    char *const *command;
+    bench_histogram_t spawn_hist, total_hist;
+    int status = 0, failures = 0;
+    long completed = 0;
+
+    // Set up signal handlers
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    // Check command line arguments
+    for (first_arg = 1; first_arg < argc && argv[first_arg][0] == '-'; first_arg++) {
+        if (strcmp(argv[first_arg], "-n") == 0 && first_arg + 1 < argc) {
+            runs = atol(argv[++first_arg]);
+        } else if (strcmp(argv[first_arg], "--tsc") == 0) {
+            if (enable_tsc() != 0) {
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[first_arg], "--shell") == 0) {
+            shell = 1;
+        } else if (strcmp(argv[first_arg], "--quiet") == 0) {
+            quiet = 1;
+        } else {
+            break;
         }
+    }
+    if (first_arg >= argc || runs <= 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
 
-        strcpy(command, argv[1]);
-        for (int i = 2; i < argc; i++) {
-            strcat(command, " ");
-            strcat(command, argv[i]);
+    if (shell) {
+        shell_argv[2] = join_command(&argv[first_arg], argc - first_arg);
+        if (!shell_argv[2]) {
+            return EXIT_FAILURE;
         }
+        command = shell_argv;
+    } else {
+        command = &argv[first_arg];
+    }
 
-        // Execute command
-        execl("/bin/sh", "sh", "-c", command, NULL);
-        perror("execl failed");
-        free(command);
-        cleanup();
+    // Map shared memory for timing
+    ring = mmap(NULL, sizeof(*ring), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        perror("Memory mapping failed");
+        free(shell_argv[2]);
         return EXIT_FAILURE;
-    } else {
-        // Parent process: wait and measure time
-        int status;
-        waitpid(pid, &status, 0);
-        
+    }
+
+    bench_histogram_init(&spawn_hist);
+    bench_histogram_init(&total_hist);
+    fflush(stdout);
+    for (long i = 0; i < runs && running; i++) {
+        sample_t *slot = &ring->slots[i % RING_SLOTS];
+
+        if (run_once(slot, command, quiet, &status) != 0) {
+            break;
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+        if (slot->exec != 0) {
+            bench_histogram_add(&spawn_hist, ticks_to_ns(slot->exec - slot->fork));
+        }
+        bench_histogram_add(&total_hist, ticks_to_ns(slot->end - slot->fork));
+        completed++;
+    }
+
+    if (completed == 1) {
+        printf("Command execution time: %.6f seconds\n", total_hist.max / 1e9);
         if (WIFEXITED(status)) {
-            clock_gettime(CLOCK_REALTIME, (struct timespec *)end_time);
-            
-            struct timespec *start = (struct timespec *)start_time;
-            struct timespec *end = (struct timespec *)end_time;
-            
-            double time_taken = (end->tv_sec - start->tv_sec) +
-                              (end->tv_nsec - start->tv_nsec) / 1e9;
-            
-            printf("Command execution time: %.6f seconds\n", time_taken);
             printf("Exit status: %d\n", WEXITSTATUS(status));
         } else if (WIFSIGNALED(status)) {
             printf("Command terminated by signal %d\n", WTERMSIG(status));
         }
+    } else if (completed > 1) {
+        printf("\n%ld runs, %d failed, clock %s\n\n", completed, failures,
+               use_tsc ? "TSC" : "CLOCK_MONOTONIC_RAW");
+        printf("%-12s %10s %10s %10s %10s %10s\n", "us", "min", "p50", "p99", "max", "mean");
+        if (spawn_hist.count > 0) {
+            print_summary("fork->exec", &spawn_hist);
+        }
+        print_summary("total", &total_hist);
+        print_histogram(&total_hist);
     }
 
     cleanup();
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    free(shell_argv[2]);
+    return completed > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
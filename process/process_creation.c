@@ -3,11 +3,16 @@
  * 
  * This program demonstrates the creation of child and grandchild processes
  * using the fork() system call. It shows how process IDs are inherited
- * and how the process hierarchy works in Unix-like systems.
+ * and how the process hierarchy works in Unix-like systems. It also launches
+ * programs through the faster creation methods of process_launcher and
+ * benchmarks them against the parent's resident memory.
  * 
  * Features:
  * - Process hierarchy creation
  * - PID inheritance demonstration
+ * - Launching with fork, vfork, posix_spawn or clone(CLONE_VM)
+ * - A pre-forked process pool for repeated jobs
+ * - Launch latency against parent RSS
  * - Error handling
  * - Resource cleanup
  */
@@ -19,10 +24,21 @@
 #include <sys/wait.h>
 #include <errno.h>
 #include <signal.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "process_launcher.h"
 
 // Constants
 #define CHILD_SLEEP_TIME 2
 #define GRANDCHILD_SLEEP_TIME 1
+#define DEFAULT_BENCH_MB 1024       // Largest parent RSS to benchmark
+#define DEFAULT_BENCH_ITERATIONS 200
+#define FIRST_BENCH_MB 64           // RSS steps double from here
+#define DEFAULT_POOL_WORKERS 4
+#define DEFAULT_POOL_JOBS 100000
+#define BENCH_PROGRAM "true"
 
 // Global variables for cleanup
 static volatile sig_atomic_t running = 1;
@@ -33,20 +49,259 @@ static void signal_handler(int sig) {
     running = 0;
 }
 
+// Get current time in seconds
+static double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Resident set size of this process in MiB
+static double resident_mb(void) {
+    long pages_total, pages_resident;
+    FILE *f = fopen("/proc/self/statm", "r");
+
+    if (!f) {
+        return 0;
+    }
+    if (fscanf(f, "%ld %ld", &pages_total, &pages_resident) != 2) {
+        pages_resident = 0;
+    }
+    fclose(f);
+    return (double)pages_resident * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+static int parse_method(const char *name, launch_method_t *method) {
+    static const char *names[LAUNCH_METHOD_COUNT] = { "fork", "vfork", "spawn", "clone" };
+
+    for (int i = 0; i < LAUNCH_METHOD_COUNT; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *method = i;
+            return 0;
+        }
+    }
+    fprintf(stderr, "Unknown launch method '%s' (fork, vfork, spawn, clone)\n", name);
+    return -1;
+}
+
+// Print how a reaped child ended
+static void print_exit(pid_t pid, int status) {
+    if (WIFEXITED(status)) {
+        printf("Child %d exited with status %d\n", pid, WEXITSTATUS(status));
+    } else if (WIFSIGNALED(status)) {
+        printf("Child %d killed by signal %d\n", pid, WTERMSIG(status));
+    }
+}
+
+/**
+ * Launch a command and wait for it through its pidfd
+ * @param method Creation method
+ * @param argv Command, NULL-terminated
+ * @return Exit status
+ */
+static int spawn_command(launch_method_t method, char *const argv[]) {
+    child_watch_t watch;
+    child_t child, *reaped;
+    int status;
+
+    if (child_watch_init(&watch) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (process_launch(method, argv, &child) != 0) {
+        fprintf(stderr, "Failed to launch %s with %s: %s\n",
+                argv[0], launch_method_name(method), strerror(errno));
+        child_watch_destroy(&watch);
+        return EXIT_FAILURE;
+    }
+    printf("Launched %s with %s as PID %d\n", argv[0], launch_method_name(method), child.pid);
+    if (child_watch_add(&watch, &child) != 0 ||
+        (reaped = child_watch_wait(&watch, -1, &status)) == NULL) {
+        child_watch_destroy(&watch);
+        return EXIT_FAILURE;
+    }
+    print_exit(reaped->pid, status);
+    child_watch_destroy(&watch);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Pool job: length of the Collatz sequence starting at input
+static int64_t collatz_steps(int64_t input) {
+    uint64_t x = (uint64_t)input;
+    int64_t steps = 0;
+
+    while (x > 1) {
+        x = (x & 1) ? 3 * x + 1 : x / 2;
+        steps++;
+    }
+    return steps;
+}
+
+/**
+ * Run Collatz jobs on a pre-forked pool and check them in the parent
+ * @param workers Worker processes
+ * @param jobs Number of jobs
+ * @return Exit status
+ */
+static int run_pool_demo(int workers, size_t jobs) {
+    process_pool_t pool;
+    int64_t *inputs = malloc(jobs * sizeof(*inputs));
+    int64_t *outputs = malloc(jobs * sizeof(*outputs));
+    int64_t longest = 0;
+    size_t longest_at = 0;
+    double start;
+    int status = EXIT_FAILURE;
+
+    if (!inputs || !outputs) {
+        perror("Failed to allocate jobs");
+        goto out;
+    }
+    for (size_t i = 0; i < jobs; i++) {
+        inputs[i] = (int64_t)i + 1;
+    }
+    if (process_pool_create(&pool, workers, collatz_steps) != 0) {
+        goto out;
+    }
+
+    start = get_time();
+    if (process_pool_run(&pool, inputs, outputs, jobs) != 0) {
+        process_pool_destroy(&pool);
+        goto out;
+    }
+    double seconds = get_time() - start;
+
+    for (size_t i = 0; i < jobs; i++) {
+        if (outputs[i] != collatz_steps(inputs[i])) {
+            fprintf(stderr, "Job %zu returned %lld, expected %lld\n",
+                    i, (long long)outputs[i], (long long)collatz_steps(inputs[i]));
+            process_pool_destroy(&pool);
+            goto out;
+        }
+        if (outputs[i] > longest) {
+            longest = outputs[i];
+            longest_at = i;
+        }
+    }
+    printf("%zu jobs on %d workers in %.3f s (%.2f us per job, %llu respawns)\n",
+           jobs, workers, seconds, seconds * 1e6 / jobs, (unsigned long long)pool.respawns);
+    printf("Longest Collatz sequence below %zu starts at %lld (%lld steps)\n",
+           jobs + 1, (long long)inputs[longest_at], (long long)longest);
+    process_pool_destroy(&pool);
+    status = EXIT_SUCCESS;
+
+out:
+    free(inputs);
+    free(outputs);
+    return status;
+}
+
+// Mean microseconds to launch and reap one short-lived program
+static double time_launches(launch_method_t method, int iterations) {
+    char *argv[] = { BENCH_PROGRAM, NULL };
+    double start = get_time();
+
+    for (int i = 0; i < iterations; i++) {
+        child_t child;
+        int status;
+
+        if (process_launch(method, argv, &child) != 0 || process_wait(&child, &status) != 0) {
+            return -1;
+        }
+    }
+    return (get_time() - start) * 1e6 / iterations;
+}
+
+// Mean microseconds for one job round trip through a single pool worker
+static double time_pool_jobs(int iterations) {
+    process_pool_t pool;
+    int64_t input = 1, output;
+    double start, elapsed;
+
+    if (process_pool_create(&pool, 1, collatz_steps) != 0) {
+        return -1;
+    }
+    start = get_time();
+    for (int i = 0; i < iterations; i++) {
+        if (process_pool_run(&pool, &input, &output, 1) != 0) {
+            process_pool_destroy(&pool);
+            return -1;
+        }
+    }
+    elapsed = get_time() - start;
+    process_pool_destroy(&pool);
+    return elapsed * 1e6 / iterations;
+}
+
+/**
+ * Benchmark launch latency while the parent's resident memory grows
+ * @param max_mb Largest ballast to touch, in MiB
+ * @param iterations Launches per method and size
+ * @return Exit status
+ */
+static int run_benchmark(size_t max_mb, int iterations) {
+    char *ballast = NULL;
+    size_t touched = 0;
+
+    printf("Launch + reap latency of '%s', %d iterations (microseconds)\n\n",
+           BENCH_PROGRAM, iterations);
+    printf("%9s", "RSS MiB");
+    for (int m = 0; m < LAUNCH_METHOD_COUNT; m++) {
+        printf(" %16s", launch_method_name(m));
+    }
+    printf(" %16s\n", "pool job");
+
+    for (size_t mb = 0; mb <= max_mb; mb = mb ? 2 * mb : FIRST_BENCH_MB) {
+        // Grow and touch the ballast so its pages are really resident
+        if (mb > 0) {
+            char *grown = realloc(ballast, mb << 20);
+            if (!grown) {
+                perror("Failed to allocate ballast");
+                free(ballast);
+                return EXIT_FAILURE;
+            }
+            ballast = grown;
+            memset(ballast + touched, 1, (mb << 20) - touched);
+            touched = mb << 20;
+        }
+
+        printf("%9.0f", resident_mb());
+        fflush(stdout);
+        for (int m = 0; m < LAUNCH_METHOD_COUNT; m++) {
+            double us = time_launches(m, iterations);
+            if (us < 0) {
+                fprintf(stderr, "\n%s failed: %s\n", launch_method_name(m), strerror(errno));
+                free(ballast);
+                return EXIT_FAILURE;
+            }
+            printf(" %16.1f", us);
+            fflush(stdout);
+        }
+        printf(" %16.1f\n", time_pool_jobs(iterations));
+    }
+
+    free(ballast);
+    return EXIT_SUCCESS;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s                              process hierarchy demo\n"
+            "       %s --spawn METHOD CMD [ARGS...]  launch a command (fork, vfork, spawn, clone)\n"
+            "       %s --pool [workers] [jobs]       run jobs on a pre-forked pool\n"
+            "       %s --bench [max MiB] [iterations]\n"
+            "                                        launch latency against parent RSS\n",
+            program, program, program, program);
+}
+
 /**
- * @brief Main function demonstrating process creation
+ * @brief Process hierarchy demonstration
  * 
  * Creates a child process and a grandchild process using fork().
  * Demonstrates the process hierarchy and PID inheritance.
  * 
  * @return int Exit status (0 on success)
  */
-int main(void)
+static int run_hierarchy_demo(void)
 {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-
     printf("Main process (PID: %d, PPID: %d) starting...\n", 
            getpid(), getppid());
     
@@ -120,4 +375,42 @@ int main(void)
 
     printf("Main process terminating\n");
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+int main(int argc, char *argv[])
+{
+    // Set up signal handlers
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    if (argc == 1) {
+        return run_hierarchy_demo();
+    }
+    if (strcmp(argv[1], "--spawn") == 0 && argc >= 4) {
+        launch_method_t method;
+        if (parse_method(argv[2], &method) != 0) {
+            return EXIT_FAILURE;
+        }
+        return spawn_command(method, &argv[3]);
+    }
+    if (strcmp(argv[1], "--pool") == 0) {
+        int workers = argc > 2 ? atoi(argv[2]) : DEFAULT_POOL_WORKERS;
+        long long jobs = argc > 3 ? atoll(argv[3]) : DEFAULT_POOL_JOBS;
+        if (workers <= 0 || jobs <= 0) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        return run_pool_demo(workers, (size_t)jobs);
+    }
+    if (strcmp(argv[1], "--bench") == 0) {
+        long long max_mb = argc > 2 ? atoll(argv[2]) : DEFAULT_BENCH_MB;
+        int iterations = argc > 3 ? atoi(argv[3]) : DEFAULT_BENCH_ITERATIONS;
+        if (max_mb < 0 || iterations <= 0) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        return run_benchmark((size_t)max_mb, iterations);
+    }
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+}
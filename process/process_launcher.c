@@ -0,0 +1,537 @@
+/**
+ * Process Launcher Implementation
+ *
+ * fork duplicates the parent's page tables, so its cost grows with the
+ * parent's resident memory. vfork and clone(CLONE_VM | CLONE_VFORK) run the
+ * child on the parent's memory until it calls exec, and posix_spawn does the
+ * same inside glibc, so their cost stays flat. Exec failures are reported
+ * back through a close-on-exec pipe (fork) or through shared memory (the
+ * memory-sharing methods).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <spawn.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "process_launcher.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// Constants
+#define EXEC_FAILED_STATUS 127
+#define POOL_EVENT_BATCH 64
+
+extern char **environ;
+
+// Arguments of a clone(CLONE_VM) child, shared with the parent
+typedef struct {
+    char *const *argv;
+    volatile int exec_errno;
+} clone_args_t;
+
+static int pidfd_open(pid_t pid) {
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+}
+
+// Reap a child that failed to exec, keeping the caller's errno
+static void reap_failed(pid_t pid) {
+    int saved = errno;
+    while (waitpid(pid, NULL, 0) == -1 && errno == EINTR) {
+    }
+    errno = saved;
+}
+
+static int launch_fork(char *const argv[], pid_t *pid) {
+    int report[2];
+    int child_errno;
+    ssize_t n;
+
+    if (pipe2(report, O_CLOEXEC) != 0) {
+        perror("Failed to create exec report pipe");
+        return -1;
+    }
+    *pid = fork();
+    if (*pid < 0) {
+        perror("fork failed");
+        close(report[0]);
+        close(report[1]);
+        return -1;
+    }
+    if (*pid == 0) {
+        close(report[0]);
+        execvp(argv[0], argv);
+        child_errno = errno;
+        if (write(report[1], &child_errno, sizeof(child_errno)) < 0) {
+            // Nothing left to report to
+        }
+        _exit(EXEC_FAILED_STATUS);
+    }
+
+    // The pipe closes without data when exec succeeds
+    close(report[1]);
+    do {
+        n = read(report[0], &child_errno, sizeof(child_errno));
+    } while (n < 0 && errno == EINTR);
+    close(report[0]);
+    if (n == sizeof(child_errno)) {
+        errno = child_errno;
+        reap_failed(*pid);
+        return -1;
+    }
+    return 0;
+}
+
+static int launch_vfork(char *const argv[], pid_t *pid) {
+    volatile int exec_errno = 0;
+
+    // The child borrows this stack frame until exec, so it only writes the
+    // shared error and leaves with _exit
+    *pid = vfork();
+    if (*pid < 0) {
+        perror("vfork failed");
+        return -1;
+    }
+    if (*pid == 0) {
+        execvp(argv[0], argv);
+        exec_errno = errno;
+        _exit(EXEC_FAILED_STATUS);
+    }
+    if (exec_errno != 0) {
+        errno = exec_errno;
+        reap_failed(*pid);
+        return -1;
+    }
+    return 0;
+}
+
+static int launch_spawn(char *const argv[], pid_t *pid) {
+    int result = posix_spawnp(pid, argv[0], NULL, NULL, argv, environ);
+
+    if (result != 0) {
+        errno = result;
+        return -1;
+    }
+    return 0;
+}
+
+static int clone_child(void *arg) {
+    clone_args_t *args = arg;
+
+    execvp(args->argv[0], args->argv);
+    args->exec_errno = errno;
+    return EXEC_FAILED_STATUS;
+}
+
+static int launch_clone(char *const argv[], pid_t *pid, int *pidfd) {
+    clone_args_t args = { argv, 0 };
+    char *stack = malloc(LAUNCHER_STACK_SIZE);
+
+    if (!stack) {
+        perror("Failed to allocate child stack");
+        return -1;
+    }
+
+    // CLONE_VFORK suspends us until the child execs or exits, after which
+    // the stack is free again; CLONE_PIDFD hands back the pidfd atomically
+    *pid = clone(clone_child, stack + LAUNCHER_STACK_SIZE,
+                 CLONE_VM | CLONE_VFORK | CLONE_PIDFD | SIGCHLD, &args, pidfd);
+    free(stack);
+    if (*pid < 0) {
+        perror("clone failed");
+        return -1;
+    }
+    if (args.exec_errno != 0) {
+        errno = args.exec_errno;
+        close(*pidfd);
+        reap_failed(*pid);
+        return -1;
+    }
+    return 0;
+}
+
+int process_launch(launch_method_t method, char *const argv[], child_t *child) {
+    int result;
+
+    child->pid = -1;
+    child->pidfd = -1;
+    switch (method) {
+        case LAUNCH_FORK:
+            result = launch_fork(argv, &child->pid);
+            break;
+        case LAUNCH_VFORK:
+            result = launch_vfork(argv, &child->pid);
+            break;
+        case LAUNCH_POSIX_SPAWN:
+            result = launch_spawn(argv, &child->pid);
+            break;
+        case LAUNCH_CLONE_VM:
+            result = launch_clone(argv, &child->pid, &child->pidfd);
+            break;
+        default:
+            fprintf(stderr, "Invalid launch method %d\n", method);
+            errno = EINVAL;
+            return -1;
+    }
+    if (result != 0) {
+        return -1;
+    }
+
+    // An unreaped child keeps its pid, so opening the pidfd now cannot race
+    if (child->pidfd < 0) {
+        child->pidfd = pidfd_open(child->pid);
+        if (child->pidfd < 0) {
+            perror("pidfd_open failed");
+            reap_failed(child->pid);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+pid_t process_fork(child_t *child) {
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        perror("fork failed");
+        return -1;
+    }
+    if (pid > 0) {
+        child->pid = pid;
+        child->pidfd = pidfd_open(pid);
+        if (child->pidfd < 0) {
+            perror("pidfd_open failed");
+            kill(pid, SIGKILL);
+            reap_failed(pid);
+            child->pid = -1;
+            return -1;
+        }
+    }
+    return pid;
+}
+
+// Convert waitid's siginfo into a waitpid-style status
+static int status_from_siginfo(const siginfo_t *info) {
+    switch (info->si_code) {
+        case CLD_EXITED:
+            return (info->si_status & 0xff) << 8;
+        case CLD_DUMPED:
+            return info->si_status | 0x80;
+        default:
+            return info->si_status;
+    }
+}
+
+int process_wait(child_t *child, int *status) {
+    siginfo_t info;
+    int result;
+
+    memset(&info, 0, sizeof(info));
+    do {
+        result = waitid(P_PIDFD, child->pidfd, &info, WEXITED);
+    } while (result != 0 && errno == EINTR);
+    if (result != 0) {
+        perror("waitid failed");
+        return -1;
+    }
+    close(child->pidfd);
+    child->pidfd = -1;
+    *status = status_from_siginfo(&info);
+    return 0;
+}
+
+const char *launch_method_name(launch_method_t method) {
+    switch (method) {
+        case LAUNCH_FORK: return "fork";
+        case LAUNCH_VFORK: return "vfork";
+        case LAUNCH_POSIX_SPAWN: return "posix_spawn";
+        case LAUNCH_CLONE_VM: return "clone(CLONE_VM)";
+        default: return "unknown";
+    }
+}
+
+int child_watch_init(child_watch_t *watch) {
+    watch->count = 0;
+    watch->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (watch->epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        return -1;
+    }
+    return 0;
+}
+
+int child_watch_add(child_watch_t *watch, child_t *child) {
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = child;
+    if (epoll_ctl(watch->epoll_fd, EPOLL_CTL_ADD, child->pidfd, &event) != 0) {
+        perror("Failed to watch child");
+        return -1;
+    }
+    watch->count++;
+    return 0;
+}
+
+child_t *child_watch_wait(child_watch_t *watch, int timeout_ms, int *status) {
+    struct epoll_event event;
+    child_t *child;
+    int ready;
+
+    if (watch->count == 0) {
+        return NULL;
+    }
+    do {
+        ready = epoll_wait(watch->epoll_fd, &event, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    if (ready < 0) {
+        perror("epoll_wait failed");
+        return NULL;
+    }
+    if (ready == 0) {
+        return NULL;
+    }
+
+    child = event.data.ptr;
+    epoll_ctl(watch->epoll_fd, EPOLL_CTL_DEL, child->pidfd, NULL);
+    watch->count--;
+    if (process_wait(child, status) != 0) {
+        return NULL;
+    }
+    return child;
+}
+
+void child_watch_destroy(child_watch_t *watch) {
+    close(watch->epoll_fd);
+    watch->epoll_fd = -1;
+    watch->count = 0;
+}
+
+// Worker loop: run jobs until the parent closes the channel
+static void worker_main(int channel, pool_job_fn job) {
+    int64_t input, output;
+    ssize_t n;
+
+    for (;;) {
+        n = recv(channel, &input, sizeof(input), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n != sizeof(input)) {
+            _exit(n == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        output = job(input);
+        if (send(channel, &output, sizeof(output), MSG_NOSIGNAL) != sizeof(output)) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// Watch both ends of a worker: its results and its exit
+static int watch_worker(process_pool_t *pool, int index) {
+    pool_worker_t *worker = &pool->workers[index];
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = (uint64_t)index << 1;
+    if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, worker->channel, &event) != 0) {
+        perror("Failed to watch worker channel");
+        return -1;
+    }
+    event.data.u64 = ((uint64_t)index << 1) | 1;
+    if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, worker->child.pidfd, &event) != 0) {
+        perror("Failed to watch worker");
+        return -1;
+    }
+    return 0;
+}
+
+// Fork the index-th worker
+static int spawn_worker(process_pool_t *pool, int index) {
+    pool_worker_t *worker = &pool->workers[index];
+    int channel[2];
+    pid_t pid;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel) != 0) {
+        perror("Failed to create worker channel");
+        return -1;
+    }
+    pid = process_fork(&worker->child);
+    if (pid < 0) {
+        close(channel[0]);
+        close(channel[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        // Drop the parent's descriptors so other workers see EOF correctly
+        close(channel[0]);
+        close(pool->epoll_fd);
+        for (int i = 0; i < pool->worker_count; i++) {
+            if (i != index && pool->workers[i].child.pid > 0) {
+                close(pool->workers[i].channel);
+                close(pool->workers[i].child.pidfd);
+            }
+        }
+        worker_main(channel[1], pool->job);
+    }
+
+    close(channel[1]);
+    worker->channel = channel[0];
+    worker->job = SIZE_MAX;
+    worker->attempts = 0;
+    return watch_worker(pool, index);
+}
+
+// Stop watching a worker and release its descriptors
+static void retire_worker(process_pool_t *pool, pool_worker_t *worker) {
+    int status;
+
+    epoll_ctl(pool->epoll_fd, EPOLL_CTL_DEL, worker->channel, NULL);
+    epoll_ctl(pool->epoll_fd, EPOLL_CTL_DEL, worker->child.pidfd, NULL);
+    close(worker->channel);
+    process_wait(&worker->child, &status);
+    worker->child.pid = -1;
+}
+
+int process_pool_create(process_pool_t *pool, int workers, pool_job_fn job) {
+    memset(pool, 0, sizeof(*pool));
+    if (workers <= 0) {
+        fprintf(stderr, "Invalid worker count %d\n", workers);
+        return -1;
+    }
+    pool->workers = calloc(workers, sizeof(*pool->workers));
+    if (!pool->workers) {
+        perror("Failed to allocate workers");
+        return -1;
+    }
+    pool->worker_count = workers;
+    pool->job = job;
+    for (int i = 0; i < workers; i++) {
+        pool->workers[i].child.pid = -1;
+    }
+    pool->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pool->epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        free(pool->workers);
+        return -1;
+    }
+
+    // Flush so buffered output is not written once per worker
+    fflush(NULL);
+    for (int i = 0; i < workers; i++) {
+        if (spawn_worker(pool, i) != 0) {
+            process_pool_destroy(pool);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Hand a job to a worker; a send failure means the worker is dying, and its
+// pidfd will report that
+static void dispatch(pool_worker_t *worker, size_t job, const int64_t *inputs) {
+    worker->job = job;
+    send(worker->channel, &inputs[job], sizeof(inputs[job]), MSG_NOSIGNAL);
+}
+
+int process_pool_run(process_pool_t *pool, const int64_t *inputs, int64_t *outputs, size_t count) {
+    struct epoll_event events[POOL_EVENT_BATCH];
+    size_t next = 0, done = 0;
+
+    for (int i = 0; i < pool->worker_count && next < count; i++) {
+        pool->workers[i].attempts = 1;
+        dispatch(&pool->workers[i], next++, inputs);
+    }
+
+    while (done < count) {
+        int ready = epoll_wait(pool->epoll_fd, events, POOL_EVENT_BATCH, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait failed");
+            return -1;
+        }
+
+        for (int e = 0; e < ready; e++) {
+            int index = (int)(events[e].data.u64 >> 1);
+            int is_exit = (int)(events[e].data.u64 & 1);
+            pool_worker_t *worker = &pool->workers[index];
+            int64_t result;
+
+            // Collect a result, including one sent just before the worker died
+            if (worker->job != SIZE_MAX &&
+                recv(worker->channel, &result, sizeof(result), MSG_DONTWAIT) == sizeof(result)) {
+                outputs[worker->job] = result;
+                worker->job = SIZE_MAX;
+                done++;
+                if (!is_exit && next < count) {
+                    worker->attempts = 1;
+                    dispatch(worker, next++, inputs);
+                }
+            }
+            if (!is_exit) {
+                continue;
+            }
+
+            // The worker died: replace it and retry its job
+            size_t job = worker->job;
+            int attempts = worker->attempts;
+
+            retire_worker(pool, worker);
+            if (job != SIZE_MAX && attempts >= POOL_MAX_ATTEMPTS) {
+                fprintf(stderr, "Job %zu killed %d workers, giving up\n", job, attempts);
+                return -1;
+            }
+            if (spawn_worker(pool, index) != 0) {
+                return -1;
+            }
+            pool->respawns++;
+            if (job == SIZE_MAX && next < count) {
+                job = next++;
+                attempts = 0;
+            }
+            if (job != SIZE_MAX) {
+                worker->attempts = attempts + 1;
+                dispatch(worker, job, inputs);
+            }
+        }
+    }
+    return 0;
+}
+
+void process_pool_destroy(process_pool_t *pool) {
+    int status;
+
+    // Closing a channel is the signal for its worker to exit
+    for (int i = 0; i < pool->worker_count; i++) {
+        if (pool->workers[i].child.pid > 0) {
+            close(pool->workers[i].channel);
+        }
+    }
+    for (int i = 0; i < pool->worker_count; i++) {
+        if (pool->workers[i].child.pid > 0) {
+            process_wait(&pool->workers[i].child, &status);
+        }
+    }
+    if (pool->epoll_fd >= 0) {
+        close(pool->epoll_fd);
+    }
+    free(pool->workers);
+    memset(pool, 0, sizeof(*pool));
+    pool->epoll_fd = -1;
+}
@@ -0,0 +1,154 @@
+/**
+ * Process Launcher Interface
+ *
+ * Fast child process creation and signal-free child tracking. Features
+ * include:
+ * - Launching programs with fork, vfork, posix_spawn or clone(CLONE_VM);
+ *   all but fork avoid copying the parent's page tables
+ * - Forking without exec, with the child tracked like a launched one
+ * - A pidfd for every child, so exits are observed through epoll instead of
+ *   a SIGCHLD handler and children are reaped with waitid(P_PIDFD)
+ * - A pool of pre-forked worker processes that run repeated jobs without
+ *   paying for process creation each time, replacing workers that die
+ */
+
+#ifndef PROCESS_LAUNCHER_H
+#define PROCESS_LAUNCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Constants
+#define LAUNCHER_STACK_SIZE (64 * 1024)   // Child stack for clone(CLONE_VM)
+#define POOL_MAX_ATTEMPTS 2                 // Workers a job may kill before the run fails
+
+typedef enum {
+    LAUNCH_FORK,
+    LAUNCH_VFORK,
+    LAUNCH_POSIX_SPAWN,
+    LAUNCH_CLONE_VM,
+    LAUNCH_METHOD_COUNT
+} launch_method_t;
+
+// A launched child
+typedef struct {
+    pid_t pid;
+    int pidfd;      // Readable once the child has exited
+} child_t;
+
+// Set of children watched through epoll
+typedef struct {
+    int epoll_fd;
+    int count;      // Children added and not yet reaped
+} child_watch_t;
+
+// Job run inside a pool worker
+typedef int64_t (*pool_job_fn)(int64_t input);
+
+// Pool worker process
+typedef struct {
+    child_t child;
+    int channel;        // Parent's end of a SOCK_SEQPACKET pair: inputs out, results in
+    size_t job;         // Index of the job in flight, SIZE_MAX when idle
+    int attempts;       // Workers the job in flight has been sent to
+} pool_worker_t;
+
+// Pre-forked process pool
+typedef struct {
+    pool_worker_t *workers;
+    int worker_count;
+    pool_job_fn job;
+    int epoll_fd;       // Worker channels and pidfds
+    uint64_t respawns;  // Workers replaced after dying
+} process_pool_t;
+
+/**
+ * Launch a program
+ * @param method Creation method
+ * @param argv Program and arguments, NULL-terminated; argv[0] is searched in PATH
+ * @param child Filled with the child's pid and pidfd
+ * @return 0 on success, -1 on error (including a program that cannot be executed)
+ */
+int process_launch(launch_method_t method, char *const argv[], child_t *child);
+
+/**
+ * Fork the calling process and open a pidfd for the child
+ * @param child Filled with the child's pid and pidfd in the parent
+ * @return As fork: 0 in the child, the child's pid in the parent, -1 on error
+ */
+pid_t process_fork(child_t *child);
+
+/**
+ * Wait for a child and reap it
+ * @param child Child to wait for; its pidfd is closed
+ * @param status Set to the wait status as from waitpid
+ * @return 0 on success, -1 on error
+ */
+int process_wait(child_t *child, int *status);
+
+/**
+ * Name of a creation method
+ * @param method Creation method
+ * @return Constant name such as "posix_spawn"
+ */
+const char *launch_method_name(launch_method_t method);
+
+/**
+ * Create an empty child watch
+ * @param watch Watch to initialize
+ * @return 0 on success, -1 on error
+ */
+int child_watch_init(child_watch_t *watch);
+
+/**
+ * Watch a child for exit
+ * @param watch Watch to add to
+ * @param child Child to watch; must stay valid until it is reaped
+ * @return 0 on success, -1 on error
+ */
+int child_watch_add(child_watch_t *watch, child_t *child);
+
+/**
+ * Wait until a watched child exits and reap it
+ * @param watch Watch to wait on
+ * @param timeout_ms Milliseconds to wait, -1 for no limit
+ * @param status Set to the wait status as from waitpid
+ * @return The reaped child (its pidfd closed), NULL on timeout, error or when
+ *         no children are left
+ */
+child_t *child_watch_wait(child_watch_t *watch, int timeout_ms, int *status);
+
+/**
+ * Destroy a child watch; children still running are not affected
+ * @param watch Watch to destroy
+ */
+void child_watch_destroy(child_watch_t *watch);
+
+/**
+ * Fork a pool of worker processes
+ * @param pool Pool to initialize
+ * @param workers Number of workers
+ * @param job Function every job runs in a worker
+ * @return 0 on success, -1 on error
+ */
+int process_pool_create(process_pool_t *pool, int workers, pool_job_fn job);
+
+/**
+ * Run a batch of jobs, keeping every worker busy until all are done; a job
+ * whose worker dies is retried on a replacement worker
+ * @param pool Process pool
+ * @param inputs Job inputs
+ * @param outputs Job results, in input order
+ * @param count Number of jobs
+ * @return 0 on success, -1 on error, after which the pool should be destroyed
+ */
+int process_pool_run(process_pool_t *pool, const int64_t *inputs, int64_t *outputs, size_t count);
+
+/**
+ * Stop the workers and reap them
+ * @param pool Pool to destroy
+ */
+void process_pool_destroy(process_pool_t *pool);
+
+#endif // PROCESS_LAUNCHER_H
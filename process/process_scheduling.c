@@ -1,179 +1,758 @@
 /**
- * Process Scheduling Demonstration
- * 
- * This program demonstrates different process scheduling concepts
- * including priority scheduling and round-robin scheduling.
- * It uses fork() to create child processes and set their priorities.
- * 
+ * Process Scheduling Simulator
+ *
+ * This program is a discrete-event simulator of a single CPU. It compares
+ * classic scheduling policies on the same workload without running or
+ * sleeping on real processes: simulated time jumps straight from one event
+ * (an arrival, a completion or the end of a time slice) to the next, so
+ * millions of processes simulate in about a second.
+ *
  * Features:
- * - Priority-based scheduling
- * - Round-robin scheduling
- * - Process priority management
- * - Error handling
- * - Resource cleanup
+ * - FCFS, RR, SJF, SRTF, non-preemptive priority and MLFQ policies
+ * - Binary-heap ready queue keyed per policy, O(log n) per operation
+ * - Turnaround, waiting and response times (mean, p99 and max), context
+ *   switches and CPU utilization
+ * - Workloads from a trace file or generated synthetically
+ *
+ * Trace files hold one process per line, "arrival burst [priority]", in
+ * integer time units; '#' starts a comment. Lower priority values run first,
+ * like nice values.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/types.h>
-#include <unistd.h>
-#include <sys/time.h>
-#include <sys/resource.h>
-#include <sched.h>
-#include <time.h>
-#include <errno.h>
-#include <signal.h>
+#include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
 
 // Constants
 #define NUM_PROCESSES 3
-#define TIME_SLICE 100000  // 100ms in microseconds
+#define DEFAULT_QUANTUM 4
+#define MLFQ_LEVELS 4               // Quantum doubles with each level
+#define MLFQ_BOOST_QUANTA 64        // Boost everyone to the top every this many quanta
+#define DEFAULT_SYNTHETIC 1000000
+#define SHORT_BURST_MEAN 10         // 80% of synthetic processes are interactive
+#define LONG_BURST_MEAN 100         // the rest are CPU-bound
+#define TARGET_LOAD 0.9             // Offered load of synthetic workloads
 #define MAX_PRIORITY 19
 #define MIN_PRIORITY -20
 
-// Process information structure
+typedef enum {
+    POLICY_FCFS,
+    POLICY_RR,
+    POLICY_SJF,
+    POLICY_SRTF,
+    POLICY_PRIORITY,
+    POLICY_MLFQ,
+    POLICY_COUNT
+} policy_t;
+
+static const char *policy_names[POLICY_COUNT] = {
+    "fcfs", "rr", "sjf", "srtf", "priority", "mlfq"
+};
+
+// Process information structure; the workload part is read-only during a run
 typedef struct {
-    pid_t pid;
+    int64_t arrival;
+    int64_t burst;
     int priority;
-    int burst_time;
-    int remaining_time;
-    char name[32];
+    // Simulation state
+    int64_t remaining;
+    int64_t first_run;      // -1 until first dispatched
+    int64_t finish;
+    int64_t slice_left;     // MLFQ: time left in the current level's quantum
+    int level;              // MLFQ queue level
 } process_t;
 
-// Global variables
-static process_t processes[NUM_PROCESSES];
-static volatile sig_atomic_t running = 1;
+// Ready queue entry; seq breaks ties in arrival order and makes RR a FIFO
+typedef struct {
+    int64_t key;
+    uint64_t seq;
+    size_t proc;
+} ready_entry_t;
+
+typedef struct {
+    ready_entry_t *entries;
+    size_t size;
+    size_t capacity;
+} ready_queue_t;
+
+// Aggregate results of one run
+typedef struct {
+    double mean_turnaround;
+    double mean_waiting;
+    double mean_response;
+    int64_t p99_turnaround;
+    int64_t p99_waiting;
+    int64_t p99_response;
+    int64_t max_turnaround;
+    int64_t max_waiting;
+    int64_t max_response;
+    int64_t makespan;
+    uint64_t switches;
+    double utilization;
+    double wall_seconds;
+} sim_result_t;
+
+// Simulation parameters
+typedef struct {
+    policy_t policy;
+    int64_t quantum;
+    uint64_t seq;           // Next ready queue sequence number
+    int64_t next_boost;     // MLFQ: time of the next priority boost
+} sim_t;
+
+// Get current time in seconds
+static double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
-// Signal handler for graceful shutdown
-static void signal_handler(int sig) {
-    (void)sig;
-    running = 0;
+static inline int entry_less(const ready_entry_t *a, const ready_entry_t *b) {
+    return a->key < b->key || (a->key == b->key && a->seq < b->seq);
 }
 
-// Set process priority using nice value
-static int set_process_priority(pid_t pid, int priority) {
-    if (priority < MIN_PRIORITY || priority > MAX_PRIORITY) {
-        fprintf(stderr, "Invalid priority value: %d\n", priority);
-        return -1;
+static int ready_push(ready_queue_t *q, int64_t key, uint64_t seq, size_t proc) {
+    size_t i;
+
+    if (q->size == q->capacity) {
+        size_t capacity = q->capacity ? 2 * q->capacity : 1024;
+        ready_entry_t *entries = realloc(q->entries, capacity * sizeof(*entries));
+        if (!entries) {
+            perror("Failed to grow ready queue");
+            return -1;
+        }
+        q->entries = entries;
+        q->capacity = capacity;
+    }
+
+    // Sift up
+    ready_entry_t entry = { key, seq, proc };
+    for (i = q->size++; i > 0; ) {
+        size_t parent = (i - 1) / 2;
+        if (!entry_less(&entry, &q->entries[parent])) {
+            break;
+        }
+        q->entries[i] = q->entries[parent];
+        i = parent;
+    }
+    q->entries[i] = entry;
+    return 0;
+}
+
+// Restore the heap order below position i
+static void ready_sift_down(ready_queue_t *q, size_t i) {
+    ready_entry_t entry = q->entries[i];
+
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= q->size) {
+            break;
+        }
+        if (child + 1 < q->size && entry_less(&q->entries[child + 1], &q->entries[child])) {
+            child++;
+        }
+        if (!entry_less(&q->entries[child], &entry)) {
+            break;
+        }
+        q->entries[i] = q->entries[child];
+        i = child;
+    }
+    q->entries[i] = entry;
+}
+
+static size_t ready_pop(ready_queue_t *q) {
+    size_t proc = q->entries[0].proc;
+
+    q->entries[0] = q->entries[--q->size];
+    if (q->size > 0) {
+        ready_sift_down(q, 0);
+    }
+    return proc;
+}
+
+static void ready_heapify(ready_queue_t *q) {
+    for (size_t i = q->size / 2; i-- > 0; ) {
+        ready_sift_down(q, i);
+    }
+}
+
+// Time slice a policy grants a process at dispatch, 0 for run to completion
+static int64_t slice_length(const sim_t *sim, const process_t *p) {
+    switch (sim->policy) {
+        case POLICY_RR:
+            return sim->quantum;
+        case POLICY_MLFQ:
+            return p->slice_left;
+        default:
+            return 0;
+    }
+}
+
+// Queue a ready process under the key its policy orders by
+static int make_ready(sim_t *sim, ready_queue_t *q, process_t *procs, size_t i) {
+    process_t *p = &procs[i];
+    int64_t key;
+
+    switch (sim->policy) {
+        case POLICY_SJF:
+            key = p->burst;
+            break;
+        case POLICY_SRTF:
+            key = p->remaining;
+            break;
+        case POLICY_PRIORITY:
+            key = p->priority;
+            break;
+        case POLICY_MLFQ:
+            key = p->level;
+            break;
+        default:
+            key = 0;    // FCFS and RR: sequence order alone
+            break;
     }
+    return ready_push(q, key, sim->seq++, i);
+}
+
+// Would a newly arrived process preempt the running one?
+static int preempts(const sim_t *sim, const process_t *arrived, const process_t *running) {
+    switch (sim->policy) {
+        case POLICY_SRTF:
+            return arrived->remaining < running->remaining;
+        case POLICY_MLFQ:
+            return arrived->level < running->level;
+        default:
+            return 0;
+    }
+}
+
+// MLFQ boost: move every process back to the top level
+static void mlfq_boost(sim_t *sim, ready_queue_t *q, process_t *procs) {
+    for (size_t i = 0; i < q->size; i++) {
+        process_t *p = &procs[q->entries[i].proc];
+        p->level = 0;
+        p->slice_left = sim->quantum;
+        q->entries[i].key = 0;
+    }
+    ready_heapify(q);
+}
+
+// 99th percentile by quickselect, nearest rank: the smallest value with at
+// least 99% of the values at or below it; reorders values
+static int64_t percentile_99(int64_t *values, size_t n) {
+    size_t k = (n * 99 + 99) / 100 - 1, lo = 0, hi = n - 1;
+
+    while (lo < hi) {
+        int64_t pivot = values[lo + (hi - lo) / 2];
+        size_t i = lo, j = hi;
+
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                int64_t tmp = values[i];
+                values[i] = values[j];
+                values[j] = tmp;
+                i++;
+                if (j-- == 0) break;
+            }
+        }
+        if (k <= j && j != (size_t)-1) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return values[k];
+}
+
+// Fill in per-process metrics once every process has finished
+static int collect_metrics(const process_t *procs, size_t n, sim_result_t *result) {
+    int64_t *values = malloc(n * sizeof(*values));
+    double sum_turnaround = 0, sum_waiting = 0, sum_response = 0, busy = 0;
 
-    if (setpriority(PRIO_PROCESS, pid, priority) == -1) {
-        perror("setpriority failed");
+    if (!values) {
+        perror("Failed to allocate metrics");
         return -1;
     }
+
+    result->max_turnaround = result->max_waiting = result->max_response = 0;
+    for (size_t i = 0; i < n; i++) {
+        int64_t turnaround = procs[i].finish - procs[i].arrival;
+        int64_t waiting = turnaround - procs[i].burst;
+        int64_t response = procs[i].first_run - procs[i].arrival;
+
+        sum_turnaround += turnaround;
+        sum_waiting += waiting;
+        sum_response += response;
+        busy += procs[i].burst;
+        if (turnaround > result->max_turnaround) result->max_turnaround = turnaround;
+        if (waiting > result->max_waiting) result->max_waiting = waiting;
+        if (response > result->max_response) result->max_response = response;
+    }
+    result->mean_turnaround = sum_turnaround / n;
+    result->mean_waiting = sum_waiting / n;
+    result->mean_response = sum_response / n;
+    result->utilization = result->makespan > procs[0].arrival ?
+                          busy / (result->makespan - procs[0].arrival) : 1.0;
+
+    for (size_t i = 0; i < n; i++) {
+        values[i] = procs[i].finish - procs[i].arrival;
+    }
+    result->p99_turnaround = percentile_99(values, n);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = procs[i].finish - procs[i].arrival - procs[i].burst;
+    }
+    result->p99_waiting = percentile_99(values, n);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = procs[i].first_run - procs[i].arrival;
+    }
+    result->p99_response = percentile_99(values, n);
+
+    free(values);
     return 0;
 }
 
-// Simulate CPU burst for a process
-static void run_process(process_t* process) {
-    printf("Process %s (PID: %d) running with priority %d\n", 
-           process->name, process->pid, process->priority);
-    
-    // Simulate CPU burst
-    struct timespec ts;
-    ts.tv_sec = 0;
-    ts.tv_nsec = TIME_SLICE * 1000;  // Convert to nanoseconds
-    
-    nanosleep(&ts, NULL);
-    
-    process->remaining_time -= TIME_SLICE;
-    if (process->remaining_time <= 0) {
-        printf("Process %s completed\n", process->name);
-    }
-}
-
-// Round-robin scheduler implementation
-static void round_robin_scheduler(void) {
-    printf("\nRound-Robin Scheduling:\n");
-    
-    while (running) {
-        int all_completed = 1;
-        
-        for (int i = 0; i < NUM_PROCESSES && running; i++) {
-            if (processes[i].remaining_time > 0) {
-                all_completed = 0;
-                run_process(&processes[i]);
+/**
+ * Simulate one policy on a workload
+ * @param procs Processes sorted by arrival; simulation state is overwritten
+ * @param n Number of processes, at least 1
+ * @param policy Scheduling policy
+ * @param quantum Time slice for RR and the top MLFQ level
+ * @param result Filled with the run's metrics
+ * @return 0 on success, -1 on error
+ */
+static int simulate(process_t *procs, size_t n, policy_t policy, int64_t quantum,
+                    sim_result_t *result) {
+    ready_queue_t queue = { NULL, 0, 0 };
+    sim_t sim = { policy, quantum, 0, 0 };
+    size_t next_arrival = 0, completed = 0;
+    size_t running = SIZE_MAX, last_run = SIZE_MAX;
+    int64_t now = procs[0].arrival, run_end = 0;
+    double start = get_time();
+    int status = -1;
+
+    memset(result, 0, sizeof(*result));
+    for (size_t i = 0; i < n; i++) {
+        procs[i].remaining = procs[i].burst;
+        procs[i].first_run = -1;
+        procs[i].finish = 0;
+        procs[i].level = 0;
+        procs[i].slice_left = quantum;
+    }
+    sim.next_boost = now + quantum * MLFQ_BOOST_QUANTA;
+
+    while (completed < n) {
+        // Dispatch: idle forward to the next arrival if nothing is ready
+        if (running == SIZE_MAX) {
+            if (queue.size == 0 && procs[next_arrival].arrival > now) {
+                now = procs[next_arrival].arrival;
+            }
+            while (next_arrival < n && procs[next_arrival].arrival <= now) {
+                if (make_ready(&sim, &queue, procs, next_arrival++) != 0) {
+                    goto out;
+                }
+            }
+            running = ready_pop(&queue);
+            if (procs[running].first_run < 0) {
+                procs[running].first_run = now;
+            }
+            if (running != last_run) {
+                result->switches++;
+                last_run = running;
             }
+            int64_t slice = slice_length(&sim, &procs[running]);
+            run_end = now + (slice > 0 && slice < procs[running].remaining ?
+                             slice : procs[running].remaining);
         }
-        
-        if (all_completed) break;
+
+        process_t *p = &procs[running];
+
+        // Arrivals before the running process stops may preempt it
+        if (next_arrival < n && procs[next_arrival].arrival < run_end &&
+            (policy == POLICY_SRTF || policy == POLICY_MLFQ)) {
+            int64_t elapsed = procs[next_arrival].arrival - now;
+            process_t *arrived = &procs[next_arrival];
+
+            now = arrived->arrival;
+            p->remaining -= elapsed;
+            p->slice_left -= elapsed;
+            if (make_ready(&sim, &queue, procs, next_arrival++) != 0) {
+                goto out;
+            }
+            if (preempts(&sim, arrived, p)) {
+                if (make_ready(&sim, &queue, procs, running) != 0) {
+                    goto out;
+                }
+                running = SIZE_MAX;
+            }
+            continue;
+        }
+
+        // Run to the end of the slice or burst; arrivals in between queue
+        // ahead of a process whose slice expires
+        int64_t elapsed = run_end - now;
+        now = run_end;
+        p->remaining -= elapsed;
+        p->slice_left -= elapsed;
+        while (next_arrival < n && procs[next_arrival].arrival <= now) {
+            if (make_ready(&sim, &queue, procs, next_arrival++) != 0) {
+                goto out;
+            }
+        }
+
+        if (p->remaining == 0) {
+            p->finish = now;
+            completed++;
+        } else {
+            if (policy == POLICY_MLFQ && p->slice_left == 0) {
+                if (p->level < MLFQ_LEVELS - 1) {
+                    p->level++;
+                }
+                p->slice_left = quantum << p->level;
+            }
+            if (make_ready(&sim, &queue, procs, running) != 0) {
+                goto out;
+            }
+        }
+        running = SIZE_MAX;
+
+        if (policy == POLICY_MLFQ && now >= sim.next_boost) {
+            mlfq_boost(&sim, &queue, procs);
+            sim.next_boost = now + quantum * MLFQ_BOOST_QUANTA;
+        }
+    }
+
+    result->makespan = now;
+    result->wall_seconds = get_time() - start;
+    status = collect_metrics(procs, n, result);
+
+out:
+    free(queue.entries);
+    return status;
+}
+
+// Order processes by arrival, stable by input position
+static int compare_arrival(const void *a, const void *b) {
+    const process_t *x = a;
+    const process_t *y = b;
+    if (x->arrival != y->arrival) {
+        return x->arrival < y->arrival ? -1 : 1;
+    }
+    return (x->remaining > y->remaining) - (x->remaining < y->remaining);
+}
+
+// Sort a freshly loaded workload by arrival; remaining holds the input
+// position until the first simulation resets it
+static void sort_by_arrival(process_t *procs, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        procs[i].remaining = (int64_t)i;
     }
+    qsort(procs, n, sizeof(*procs), compare_arrival);
 }
 
-// Priority scheduler implementation
-static void priority_scheduler(void) {
-    printf("\nPriority Scheduling:\n");
-    
-    // Sort processes by priority (higher priority first)
-    for (int i = 0; i < NUM_PROCESSES - 1; i++) {
-        for (int j = 0; j < NUM_PROCESSES - i - 1; j++) {
-            if (processes[j].priority < processes[j + 1].priority) {
-                process_t temp = processes[j];
-                processes[j] = processes[j + 1];
-                processes[j + 1] = temp;
+// Skip blanks and parse a signed integer, advancing *cursor
+static int parse_int64(char **cursor, int64_t *value) {
+    char *end;
+
+    errno = 0;
+    long long parsed = strtoll(*cursor, &end, 10);
+    if (end == *cursor || errno != 0) {
+        return -1;
+    }
+    *value = parsed;
+    *cursor = end;
+    return 0;
+}
+
+/**
+ * Load a workload from a trace file
+ * @param path Trace file, "-" for standard input
+ * @param count Set to the number of processes
+ * @return Newly allocated processes sorted by arrival, NULL on error
+ */
+static process_t *load_trace(const char *path, size_t *count) {
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    process_t *procs = NULL;
+    size_t n = 0, capacity = 0, line_number = 0;
+    char *line = NULL;
+    size_t line_size = 0;
+
+    if (!f) {
+        perror("Failed to open trace file");
+        return NULL;
+    }
+
+    while (getline(&line, &line_size, f) != -1) {
+        char *cursor = line;
+        int64_t arrival, burst, priority = 0;
+
+        line_number++;
+        cursor[strcspn(cursor, "#\n")] = '\0';
+        cursor += strspn(cursor, " \t\r");
+        if (*cursor == '\0') {
+            continue;
+        }
+        if (parse_int64(&cursor, &arrival) != 0 || parse_int64(&cursor, &burst) != 0) {
+            fprintf(stderr, "%s:%zu: expected \"arrival burst [priority]\"\n", path, line_number);
+            goto fail;
+        }
+        cursor += strspn(cursor, " \t\r");
+        if (*cursor != '\0' && parse_int64(&cursor, &priority) != 0) {
+            fprintf(stderr, "%s:%zu: invalid priority\n", path, line_number);
+            goto fail;
+        }
+        if (arrival < 0 || burst <= 0 || priority < MIN_PRIORITY || priority > MAX_PRIORITY) {
+            fprintf(stderr, "%s:%zu: need arrival >= 0, burst > 0 and priority %d..%d\n",
+                    path, line_number, MIN_PRIORITY, MAX_PRIORITY);
+            goto fail;
+        }
+
+        if (n == capacity) {
+            capacity = capacity ? 2 * capacity : 4096;
+            process_t *grown = realloc(procs, capacity * sizeof(*procs));
+            if (!grown) {
+                perror("Failed to allocate processes");
+                goto fail;
             }
+            procs = grown;
         }
+        memset(&procs[n], 0, sizeof(procs[n]));
+        procs[n].arrival = arrival;
+        procs[n].burst = burst;
+        procs[n].priority = (int)priority;
+        n++;
+    }
+    if (ferror(f)) {
+        perror("Failed to read trace file");
+        goto fail;
+    }
+    if (n == 0) {
+        fprintf(stderr, "%s: no processes\n", path);
+        goto fail;
+    }
+
+    free(line);
+    if (f != stdin) {
+        fclose(f);
     }
-    
-    // Run processes in priority order
-    for (int i = 0; i < NUM_PROCESSES && running; i++) {
-        while (processes[i].remaining_time > 0 && running) {
-            run_process(&processes[i]);
+    sort_by_arrival(procs, n);
+    *count = n;
+    return procs;
+
+fail:
+    free(line);
+    free(procs);
+    if (f != stdin) {
+        fclose(f);
+    }
+    return NULL;
+}
+
+// xorshift64*: fast, deterministic pseudo-random numbers
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+// Exponentially distributed integer with the given mean, at least 1
+static int64_t random_exponential(uint64_t *state, double mean) {
+    double u = ((next_random(state) >> 11) + 1) * (1.0 / 9007199254740993.0);
+    return (int64_t)(-mean * log(u)) + 1;
+}
+
+/**
+ * Generate a synthetic workload: Poisson arrivals at TARGET_LOAD and a mix
+ * of short interactive and long CPU-bound bursts
+ * @param n Number of processes
+ * @param seed Random seed
+ * @return Newly allocated processes sorted by arrival, NULL on error
+ */
+static process_t *generate_workload(size_t n, uint64_t seed) {
+    process_t *procs = calloc(n, sizeof(*procs));
+    double mean_burst = 0.8 * SHORT_BURST_MEAN + 0.2 * LONG_BURST_MEAN + 1;
+    double mean_gap = mean_burst / TARGET_LOAD;
+    uint64_t state = seed ? seed : 1;
+    int64_t now = 0;
+
+    if (!procs) {
+        perror("Failed to allocate processes");
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        int interactive = next_random(&state) % 10 < 8;
+        procs[i].arrival = now;
+        procs[i].burst = random_exponential(&state, interactive ? SHORT_BURST_MEAN : LONG_BURST_MEAN);
+        procs[i].priority = interactive ? 0 : 10;
+        now += random_exponential(&state, mean_gap) - 1;
+    }
+    return procs;
+}
+
+// Write a workload in trace format
+static void write_trace(FILE *out, const process_t *procs, size_t n) {
+    fprintf(out, "# arrival burst priority\n");
+    for (size_t i = 0; i < n; i++) {
+        fprintf(out, "%lld %lld %d\n", (long long)procs[i].arrival,
+                (long long)procs[i].burst, procs[i].priority);
+    }
+}
+
+static void print_header(void) {
+    printf("%-9s %10s %8s %8s %10s %8s %8s %10s %8s %8s %9s %6s %8s\n",
+           "policy", "turnaround", "p99", "max", "waiting", "p99", "max",
+           "response", "p99", "max", "switches", "util", "sim ms");
+}
+
+static void print_result(policy_t policy, const sim_result_t *r) {
+    printf("%-9s %10.1f %8lld %8lld %10.1f %8lld %8lld %10.1f %8lld %8lld %9llu %5.1f%% %8.1f\n",
+           policy_names[policy],
+           r->mean_turnaround, (long long)r->p99_turnaround, (long long)r->max_turnaround,
+           r->mean_waiting, (long long)r->p99_waiting, (long long)r->max_waiting,
+           r->mean_response, (long long)r->p99_response, (long long)r->max_response,
+           (unsigned long long)r->switches, 100.0 * r->utilization,
+           r->wall_seconds * 1000);
+}
+
+/**
+ * Simulate the selected policies and print one row for each
+ * @param procs Processes sorted by arrival
+ * @param n Number of processes
+ * @param only Policy to run, POLICY_COUNT for all
+ * @param quantum Time slice for RR and MLFQ
+ * @return 0 on success, -1 on error
+ */
+static int compare_policies(process_t *procs, size_t n, policy_t only, int64_t quantum) {
+    printf("%zu processes, quantum %lld (times in trace units)\n\n", n, (long long)quantum);
+    print_header();
+    for (int policy = 0; policy < POLICY_COUNT; policy++) {
+        sim_result_t result;
+
+        if (only != POLICY_COUNT && policy != (int)only) {
+            continue;
         }
+        if (simulate(procs, n, policy, quantum, &result) != 0) {
+            return -1;
+        }
+        print_result(policy, &result);
     }
+    return 0;
 }
 
-int main(void) {
-    // Set up signal handlers
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+// Small built-in workload: three processes like the textbook examples
+static process_t *demo_workload(size_t *count) {
+    static const int64_t arrival[NUM_PROCESSES] = { 0, 1, 2 };
+    static const int64_t burst[NUM_PROCESSES] = { 24, 3, 3 };
+    static const int priority[NUM_PROCESSES] = { 3, 1, 2 };
+    process_t *procs = calloc(NUM_PROCESSES, sizeof(*procs));
 
-    // Initialize processes
+    if (!procs) {
+        perror("Failed to allocate processes");
+        return NULL;
+    }
     for (int i = 0; i < NUM_PROCESSES; i++) {
-        pid_t pid = fork();
-        
-        if (pid < 0) {
-            perror("fork failed");
-            return EXIT_FAILURE;
+        procs[i].arrival = arrival[i];
+        procs[i].burst = burst[i];
+        procs[i].priority = priority[i];
+    }
+    *count = NUM_PROCESSES;
+    return procs;
+}
+
+static int parse_policy(const char *name, policy_t *policy) {
+    if (strcmp(name, "all") == 0) {
+        *policy = POLICY_COUNT;
+        return 0;
+    }
+    for (int i = 0; i < POLICY_COUNT; i++) {
+        if (strcmp(name, policy_names[i]) == 0) {
+            *policy = i;
+            return 0;
         }
-        else if (pid == 0) {
-            // Child process
-            processes[i].pid = getpid();
-            processes[i].priority = MAX_PRIORITY - i;  // Higher number = lower priority
-            processes[i].burst_time = (i + 1) * TIME_SLICE * 2;
-            processes[i].remaining_time = processes[i].burst_time;
-            snprintf(processes[i].name, sizeof(processes[i].name), "Process%d", i);
-            
-            // Set process priority
-            if (set_process_priority(getpid(), processes[i].priority) == -1) {
+    }
+    fprintf(stderr, "Unknown policy '%s'\n", name);
+    return -1;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--policy P] [--quantum Q]                simulate a 3-process demo\n"
+            "       %s --trace FILE [--policy P] [--quantum Q]   simulate a trace (- for stdin)\n"
+            "       %s --random [N] [seed] [--policy P] [--quantum Q]\n"
+            "                                                  simulate a synthetic workload\n"
+            "       %s --generate N [seed]                     write a synthetic trace\n"
+            "Policies: fcfs, rr, sjf, srtf, priority, mlfq, all (default)\n",
+            program, program, program, program);
+}
+
+int main(int argc, char *argv[]) {
+    const char *trace = NULL;
+    policy_t policy = POLICY_COUNT;
+    int64_t quantum = DEFAULT_QUANTUM;
+    size_t random_count = 0, generate_count = 0;
+    uint64_t seed = 1;
+    process_t *procs;
+    size_t n;
+    int status;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            if (parse_policy(argv[++i], &policy) != 0) {
                 return EXIT_FAILURE;
             }
-            
-            // Child processes exit after initialization
-            return EXIT_SUCCESS;
-        }
-        else {
-            // Parent process
-            processes[i].pid = pid;
-            processes[i].priority = MAX_PRIORITY - i;
-            processes[i].burst_time = (i + 1) * TIME_SLICE * 2;
-            processes[i].remaining_time = processes[i].burst_time;
-            snprintf(processes[i].name, sizeof(processes[i].name), "Process%d", i);
-        }
-    }
-    
-    // Wait for all child processes to initialize
-    sleep(1);
-    
-    // Run different scheduling algorithms
-    round_robin_scheduler();
-    priority_scheduler();
-    
-    // Wait for all child processes to complete
-    for (int i = 0; i < NUM_PROCESSES; i++) {
-        int status;
-        waitpid(processes[i].pid, &status, 0);
+        } else if (strcmp(argv[i], "--quantum") == 0 && i + 1 < argc) {
+            quantum = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        } else if (strcmp(argv[i], "--random") == 0 || strcmp(argv[i], "--generate") == 0) {
+            size_t *count = strcmp(argv[i], "--random") == 0 ? &random_count : &generate_count;
+            *count = DEFAULT_SYNTHETIC;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                *count = strtoull(argv[++i], NULL, 10);
+            }
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                seed = strtoull(argv[++i], NULL, 10);
+            }
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
     }
-    
-    return EXIT_SUCCESS;
-} 
\ No newline at end of file
+    if (quantum <= 0 || quantum > (INT64_MAX >> MLFQ_LEVELS) / MLFQ_BOOST_QUANTA) {
+        fprintf(stderr, "Invalid quantum\n");
+        return EXIT_FAILURE;
+    }
+
+    if (generate_count > 0) {
+        procs = generate_workload(generate_count, seed);
+        if (!procs) {
+            return EXIT_FAILURE;
+        }
+        write_trace(stdout, procs, generate_count);
+        free(procs);
+        return EXIT_SUCCESS;
+    }
+
+    if (trace) {
+        procs = load_trace(trace, &n);
+    } else if (random_count > 0) {
+        n = random_count;
+        procs = generate_workload(n, seed);
+    } else {
+        procs = demo_workload(&n);
+    }
+    if (!procs) {
+        return EXIT_FAILURE;
+    }
+
+    status = compare_policies(procs, n, policy, quantum);
+    free(procs);
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -3,11 +3,14 @@
  * 
  * This program demonstrates how zombie processes are created and
  * how to prevent them using proper process management techniques.
+ * Children are tracked through pidfds and epoll rather than a SIGCHLD
+ * handler, so reaping happens in ordinary code with no async-signal-safety
+ * concerns and no risk of reaping another component's children.
  * 
  * Features:
  * - Zombie process creation
  * - Process state monitoring
- * - Signal handling
+ * - Reaping each child as soon as its pidfd becomes readable
  * - Error handling
  * - Resource cleanup
  */
@@ -22,6 +25,8 @@
 #include <errno.h>
 #include <string.h>
 
+#include "process_launcher.h"
+
 // Constants
 #define NUM_CHILDREN 3
 #define CHILD_LIFETIME 2
@@ -29,7 +34,7 @@
 
 // Global variables
 static volatile sig_atomic_t running = 1;
-static pid_t children[NUM_CHILDREN];
+static child_t children[NUM_CHILDREN];
 
 // Signal handler for graceful shutdown
 static void signal_handler(int sig) {
@@ -37,24 +42,6 @@ static void signal_handler(int sig) {
     running = 0;
 }
 
-// SIGCHLD handler to prevent zombies
-static void sigchld_handler(int sig) {
-    (void)sig;
-    int status;
-    pid_t pid;
-    
-    // Wait for any child process
-    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
-        if (WIFEXITED(status)) {
-            printf("Child %d exited with status %d\n", 
-                   pid, WEXITSTATUS(status));
-        } else if (WIFSIGNALED(status)) {
-            printf("Child %d killed by signal %d\n", 
-                   pid, WTERMSIG(status));
-        }
-    }
-}
-
 // Child process function
 static int child_process(int id) {
     printf("Child %d (PID: %d) started\n", id, getpid());
@@ -66,7 +53,76 @@ static int child_process(int id) {
     return id;
 }
 
+// Process state letter from /proc/<pid>/stat ('Z' for a zombie), '?' if unknown
+static char process_state(pid_t pid) {
+    char path[64];
+    char state = '?';
+    FILE *f;
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    f = fopen(path, "r");
+    if (!f) {
+        return state;
+    }
+    // The command name may contain spaces, so skip to its closing parenthesis
+    if (fscanf(f, "%*d (%*[^)]) %c", &state) != 1) {
+        state = '?';
+    }
+    fclose(f);
+    return state;
+}
+
+// Print how a reaped child ended
+static void print_exit(pid_t pid, int status) {
+    if (WIFEXITED(status)) {
+        printf("Child %d exited normally with status %d\n",
+               pid, WEXITSTATUS(status));
+    } else if (WIFSIGNALED(status)) {
+        printf("Child %d was killed by signal %d\n",
+               pid, WTERMSIG(status));
+    }
+}
+
+// Fork the children and watch their pidfds
+static int create_children(child_watch_t *watch) {
+    for (int i = 0; i < NUM_CHILDREN; i++) {
+        // Flush first, or the child would print the parent's buffered output again
+        fflush(stdout);
+        pid_t pid = process_fork(&children[i]);
+        
+        if (pid < 0) {
+            return -1;
+        } else if (pid == 0) {
+            // Child process
+            exit(child_process(i));
+        }
+
+        // Parent process
+        printf("Created child process %d with PID: %d\n", i, pid);
+        if (child_watch_add(watch, &children[i]) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Reap children in the order they exit until none are left
+static int reap_children(child_watch_t *watch) {
+    while (watch->count > 0 && running) {
+        int status;
+        child_t *child = child_watch_wait(watch, -1, &status);
+
+        if (!child) {
+            return -1;
+        }
+        print_exit(child->pid, status);
+    }
+    return 0;
+}
+
 int main(void) {
+    child_watch_t watch;
+
     // Set up signal handlers
     struct sigaction sa;
     sa.sa_handler = signal_handler;
@@ -82,58 +138,37 @@ int main(void) {
         perror("sigaction failed");
         return EXIT_FAILURE;
     }
-    
-    // Set up SIGCHLD handler
-    sa.sa_handler = sigchld_handler;
-    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
-    
-    if (sigaction(SIGCHLD, &sa, NULL) == -1) {
-        perror("sigaction failed");
+
+    if (child_watch_init(&watch) != 0) {
         return EXIT_FAILURE;
     }
     
     printf("Parent process (PID: %d) starting...\n", getpid());
     
-    // Create child processes
-    for (int i = 0; i < NUM_CHILDREN; i++) {
-        pid_t pid = fork();
-        
-        if (pid < 0) {
-            perror("fork failed");
-            return EXIT_FAILURE;
-        } else if (pid == 0) {
-            // Child process
-            return child_process(i);
-        } else {
-            // Parent process
-            children[i] = pid;
-            printf("Created child process %d with PID: %d\n", i, pid);
-        }
+    // First round: leave exited children unreaped so they become zombies
+    if (create_children(&watch) != 0) {
+        child_watch_destroy(&watch);
+        return EXIT_FAILURE;
     }
-    
-    // Parent process continues
-    printf("Parent process waiting for children...\n");
-    
-    // Sleep to allow children to become zombies
     printf("Children will become zombies for %d seconds\n", ZOMBIE_LIFETIME);
     sleep(ZOMBIE_LIFETIME);
-    
-    // Wait for all children to complete
     for (int i = 0; i < NUM_CHILDREN; i++) {
-        int status;
-        pid_t pid = waitpid(children[i], &status, 0);
-        
-        if (pid == -1) {
-            perror("waitpid failed");
-        } else if (WIFEXITED(status)) {
-            printf("Child %d exited normally with status %d\n", 
-                   pid, WEXITSTATUS(status));
-        } else if (WIFSIGNALED(status)) {
-            printf("Child %d was killed by signal %d\n", 
-                   pid, WTERMSIG(status));
-        }
+        printf("Child %d (PID: %d) state: %c\n", i, children[i].pid,
+               process_state(children[i].pid));
+    }
+    if (reap_children(&watch) != 0) {
+        child_watch_destroy(&watch);
+        return EXIT_FAILURE;
+    }
+
+    // Second round: reap each child the moment its pidfd reports the exit
+    printf("\nReaping children as they exit...\n");
+    if (create_children(&watch) != 0 || reap_children(&watch) != 0) {
+        child_watch_destroy(&watch);
+        return EXIT_FAILURE;
     }
     
+    child_watch_destroy(&watch);
     printf("All children completed\n");
     return EXIT_SUCCESS;
-} 
\ No newline at end of file
+}
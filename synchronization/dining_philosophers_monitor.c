@@ -1,16 +1,27 @@
 /**
  * Dining Philosophers Problem with Monitor Implementation
- * 
+ *
  * This program demonstrates a deadlock-free solution to the dining
  * philosophers problem using monitors and condition variables. It
  * implements a resource hierarchy solution to prevent deadlocks.
- * 
+ *
+ * The monitor puts every philosopher behind one mutex, although each
+ * philosopher only competes with its two neighbours. The --forks mode
+ * instead gives every fork its own mutex and has each philosopher take
+ * the lower-numbered fork first (resource ordering), so philosophers that
+ * share no fork eat in parallel.
+ *
  * Features:
  * - Deadlock prevention
  * - Resource hierarchy solution
+ * - Monitor or per-fork locking
  * - Error handling
  * - Graceful shutdown
- * - Performance monitoring
+ * - Performance monitoring: throughput and fairness
+ * - Benchmark of both modes for 5 to 1024 philosophers, with per-meal
+ *   wait latency, through the shared harness in bench.h
+ *
+ * Usage: dining_philosophers_monitor [--forks] [--bench philosophers [seconds]]
  */
 
 #include <stdio.h>
@@ -21,12 +32,20 @@
 #include <errno.h>
 #include <string.h>
 #include <signal.h>
+#include <limits.h>
+
+#include "bench.h"
 
 // Constants
 #define NUM_PHILOSOPHERS 5
 #define EATING_TIME 2
 #define THINKING_TIME 3
 #define MAX_MEALS 3
+#define MAX_PHILOSOPHERS 1024
+#define BENCH_SECONDS 0.2           // Per repetition, scaled by BENCH_SCALE
+#define BENCH_EATING_WORK 2000      // Busy-loop iterations per meal in the benchmark
+#define BENCH_THINKING_WORK 2000    // Busy-loop iterations of thinking in the benchmark
+#define DETAIL_MAX_PHILOSOPHERS 16  // Print per-philosopher statistics up to this many
 
 // Philosopher states
 typedef enum {
@@ -35,6 +54,12 @@ typedef enum {
     EATING
 } philosopher_state_t;
 
+// Synchronization schemes
+typedef enum {
+    MODE_MONITOR,   // One mutex, can_eat checked under it
+    MODE_FORKS      // One mutex per fork, lower-numbered fork first
+} dining_mode_t;
+
 // Philosopher data structure
 typedef struct {
     int id;
@@ -43,20 +68,30 @@ typedef struct {
     struct timespec start_time;
     struct timespec end_time;
     double total_wait_time;
+    bench_histogram_t *latency;     // Wait per meal, benchmark only
 } philosopher_data_t;
 
 // Monitor structure
 typedef struct {
     pthread_mutex_t mutex;
-    pthread_cond_t cond_vars[NUM_PHILOSOPHERS];
-    philosopher_state_t states[NUM_PHILOSOPHERS];
-    philosopher_data_t philosophers[NUM_PHILOSOPHERS];
+    pthread_cond_t *cond_vars;
+    philosopher_state_t *states;
+    pthread_mutex_t *forks;         // Fork i lies between philosophers i and i + 1
+    philosopher_data_t *philosophers;
     int num_philosophers;
 } dining_monitor_t;
 
 // Global monitor instance
 static dining_monitor_t monitor;
 static volatile sig_atomic_t running = 1;
+static pthread_barrier_t start_barrier;    // Start all philosophers together
+
+// Run settings
+static dining_mode_t mode = MODE_MONITOR;
+static int max_meals = MAX_MEALS;
+static int verbose = 1;             // Print every state change
+static long eating_work = 0;        // 0: sleep EATING_TIME and THINKING_TIME instead
+static long thinking_work = 0;
 
 // Signal handler for graceful shutdown
 static void signal_handler(int sig) {
@@ -64,177 +99,462 @@ static void signal_handler(int sig) {
     running = 0;
 }
 
+// Clean up monitor resources
+static void monitor_cleanup(void) {
+    for (int i = 0; i < monitor.num_philosophers; i++) {
+        pthread_cond_destroy(&monitor.cond_vars[i]);
+        pthread_mutex_destroy(&monitor.forks[i]);
+    }
+    pthread_mutex_destroy(&monitor.mutex);
+    free(monitor.cond_vars);
+    free(monitor.states);
+    free(monitor.forks);
+    free(monitor.philosophers);
+    monitor.num_philosophers = 0;
+}
+
 // Initialize monitor
-static int monitor_init(void) {
+static int monitor_init(int num_philosophers) {
     if (pthread_mutex_init(&monitor.mutex, NULL) != 0) {
         perror("pthread_mutex_init failed");
         return -1;
     }
-    
-    for (int i = 0; i < NUM_PHILOSOPHERS; i++) {
+
+    monitor.num_philosophers = 0;
+    monitor.cond_vars = calloc((size_t)num_philosophers, sizeof(*monitor.cond_vars));
+    monitor.states = calloc((size_t)num_philosophers, sizeof(*monitor.states));
+    monitor.forks = calloc((size_t)num_philosophers, sizeof(*monitor.forks));
+    monitor.philosophers = calloc((size_t)num_philosophers, sizeof(*monitor.philosophers));
+    if (!monitor.cond_vars || !monitor.states || !monitor.forks || !monitor.philosophers) {
+        perror("calloc failed");
+        monitor_cleanup();
+        return -1;
+    }
+
+    for (int i = 0; i < num_philosophers; i++) {
         if (pthread_cond_init(&monitor.cond_vars[i], NULL) != 0) {
             perror("pthread_cond_init failed");
-            // Clean up previously initialized condition variables
-            for (int j = 0; j < i; j++) {
-                pthread_cond_destroy(&monitor.cond_vars[j]);
-            }
-            pthread_mutex_destroy(&monitor.mutex);
+            monitor_cleanup();
+            return -1;
+        }
+        if (pthread_mutex_init(&monitor.forks[i], NULL) != 0) {
+            perror("pthread_mutex_init failed");
+            pthread_cond_destroy(&monitor.cond_vars[i]);
+            monitor_cleanup();
             return -1;
         }
-        
+        // Count only fully initialized entries, for monitor_cleanup
+        monitor.num_philosophers++;
+
         monitor.states[i] = THINKING;
         monitor.philosophers[i].id = i;
         monitor.philosophers[i].state = THINKING;
         monitor.philosophers[i].meals_eaten = 0;
         monitor.philosophers[i].total_wait_time = 0.0;
     }
-    
-    monitor.num_philosophers = NUM_PHILOSOPHERS;
+
     return 0;
 }
 
-// Clean up monitor resources
-static void monitor_cleanup(void) {
-    for (int i = 0; i < monitor.num_philosophers; i++) {
-        pthread_cond_destroy(&monitor.cond_vars[i]);
-    }
-    pthread_mutex_destroy(&monitor.mutex);
+// Neighbours of a philosopher
+static int left_of(int philosopher) {
+    return (philosopher + monitor.num_philosophers - 1) % monitor.num_philosophers;
+}
+
+static int right_of(int philosopher) {
+    return (philosopher + 1) % monitor.num_philosophers;
 }
 
 // Check if philosopher can eat
 static int can_eat(int philosopher) {
-    int left = (philosopher + NUM_PHILOSOPHERS - 1) % NUM_PHILOSOPHERS;
-    int right = (philosopher + 1) % NUM_PHILOSOPHERS;
-    
     return (monitor.states[philosopher] == HUNGRY &&
-            monitor.states[left] != EATING &&
-            monitor.states[right] != EATING);
+            monitor.states[left_of(philosopher)] != EATING &&
+            monitor.states[right_of(philosopher)] != EATING);
+}
+
+// Think or eat: sleep in the demo, spin for a fixed amount of work in the benchmark
+static void spend_time(long work, unsigned int seconds) {
+    if (work == 0) {
+        sleep(seconds);
+        return;
+    }
+    for (volatile long i = 0; i < work; i++) {
+    }
+}
+
+// Seconds between two timestamps
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Take both forks through the monitor; returns -1 if stopped while waiting
+static int monitor_pick_up(philosopher_data_t *philosopher) {
+    pthread_mutex_lock(&monitor.mutex);
+    monitor.states[philosopher->id] = HUNGRY;
+    philosopher->state = HUNGRY;
+    if (verbose) {
+        printf("Philosopher %d is hungry\n", philosopher->id);
+    }
+
+    // Try to eat
+    while (!can_eat(philosopher->id) && running) {
+        pthread_cond_wait(&monitor.cond_vars[philosopher->id], &monitor.mutex);
+    }
+
+    if (!running) {
+        monitor.states[philosopher->id] = THINKING;
+        pthread_mutex_unlock(&monitor.mutex);
+        return -1;
+    }
+
+    // Eat
+    monitor.states[philosopher->id] = EATING;
+    philosopher->state = EATING;
+    pthread_mutex_unlock(&monitor.mutex);
+    return 0;
+}
+
+// Put both forks down through the monitor and wake neighbours that can eat now
+static void monitor_put_down(philosopher_data_t *philosopher) {
+    pthread_mutex_lock(&monitor.mutex);
+    monitor.states[philosopher->id] = THINKING;
+    philosopher->state = THINKING;
+    if (verbose) {
+        printf("Philosopher %d finished eating\n", philosopher->id);
+    }
+
+    // Notify neighbors
+    int left = left_of(philosopher->id);
+    int right = right_of(philosopher->id);
+
+    if (monitor.states[left] == HUNGRY && can_eat(left)) {
+        pthread_cond_signal(&monitor.cond_vars[left]);
+    }
+    if (monitor.states[right] == HUNGRY && can_eat(right)) {
+        pthread_cond_signal(&monitor.cond_vars[right]);
+    }
+
+    pthread_mutex_unlock(&monitor.mutex);
+}
+
+// Take both forks, lower-numbered first: the ordering rules out a cycle of
+// philosophers each holding one fork and waiting for the next
+static void forks_pick_up(philosopher_data_t *philosopher) {
+    int left_fork = philosopher->id;
+    int right_fork = right_of(philosopher->id);
+    int first = left_fork < right_fork ? left_fork : right_fork;
+    int second = left_fork < right_fork ? right_fork : left_fork;
+
+    philosopher->state = HUNGRY;
+    if (verbose) {
+        printf("Philosopher %d is hungry\n", philosopher->id);
+    }
+    pthread_mutex_lock(&monitor.forks[first]);
+    if (second != first) {
+        pthread_mutex_lock(&monitor.forks[second]);
+    }
+    philosopher->state = EATING;
+}
+
+// Put both forks down
+static void forks_put_down(philosopher_data_t *philosopher) {
+    int left_fork = philosopher->id;
+    int right_fork = right_of(philosopher->id);
+
+    philosopher->state = THINKING;
+    if (verbose) {
+        printf("Philosopher %d finished eating\n", philosopher->id);
+    }
+    if (right_fork != left_fork) {
+        pthread_mutex_unlock(&monitor.forks[right_fork]);
+    }
+    pthread_mutex_unlock(&monitor.forks[left_fork]);
 }
 
 // Philosopher thread function
 static void *philosopher_thread(void *arg) {
     philosopher_data_t *philosopher = (philosopher_data_t *)arg;
     struct timespec wait_start, wait_end;
-    
+
+    pthread_barrier_wait(&start_barrier);
+
     // Record start time
     clock_gettime(CLOCK_MONOTONIC, &philosopher->start_time);
-    
-    while (running && philosopher->meals_eaten < MAX_MEALS) {
+
+    while (running && philosopher->meals_eaten < max_meals) {
         // Think
-        printf("Philosopher %d is thinking\n", philosopher->id);
-        sleep(THINKING_TIME);
-        
-        // Get hungry
-        pthread_mutex_lock(&monitor.mutex);
-        monitor.states[philosopher->id] = HUNGRY;
-        philosopher->state = HUNGRY;
-        printf("Philosopher %d is hungry\n", philosopher->id);
-        
-        // Try to eat
-        clock_gettime(CLOCK_MONOTONIC, &wait_start);
-        while (!can_eat(philosopher->id) && running) {
-            pthread_cond_wait(&monitor.cond_vars[philosopher->id], &monitor.mutex);
+        if (verbose) {
+            printf("Philosopher %d is thinking\n", philosopher->id);
         }
-        
-        if (!running) {
-            pthread_mutex_unlock(&monitor.mutex);
+        spend_time(thinking_work, THINKING_TIME);
+
+        // Get hungry and try to eat
+        clock_gettime(CLOCK_MONOTONIC, &wait_start);
+        if (mode == MODE_FORKS) {
+            forks_pick_up(philosopher);
+        } else if (monitor_pick_up(philosopher) != 0) {
             break;
         }
-        
-        // Eat
-        monitor.states[philosopher->id] = EATING;
-        philosopher->state = EATING;
+
         philosopher->meals_eaten++;
-        
         clock_gettime(CLOCK_MONOTONIC, &wait_end);
-        double wait_time = (wait_end.tv_sec - wait_start.tv_sec) +
-                          (wait_end.tv_nsec - wait_start.tv_nsec) / 1e9;
-        philosopher->total_wait_time += wait_time;
-        
-        printf("Philosopher %d is eating (meal %d/%d)\n",
-               philosopher->id, philosopher->meals_eaten, MAX_MEALS);
-        
-        pthread_mutex_unlock(&monitor.mutex);
-        sleep(EATING_TIME);
-        
+        philosopher->total_wait_time += elapsed_seconds(&wait_start, &wait_end);
+        if (philosopher->latency) {
+            bench_histogram_add(philosopher->latency,
+                                (uint64_t)(elapsed_seconds(&wait_start, &wait_end) * 1e9));
+        }
+
+        if (verbose) {
+            printf("Philosopher %d is eating (meal %d/%d)\n",
+                   philosopher->id, philosopher->meals_eaten, max_meals);
+        }
+        spend_time(eating_work, EATING_TIME);
+
         // Finish eating
-        pthread_mutex_lock(&monitor.mutex);
-        monitor.states[philosopher->id] = THINKING;
-        philosopher->state = THINKING;
-        printf("Philosopher %d finished eating\n", philosopher->id);
-        
-        // Notify neighbors
-        int left = (philosopher->id + NUM_PHILOSOPHERS - 1) % NUM_PHILOSOPHERS;
-        int right = (philosopher->id + 1) % NUM_PHILOSOPHERS;
-        
-        if (monitor.states[left] == HUNGRY && can_eat(left)) {
-            pthread_cond_signal(&monitor.cond_vars[left]);
-        }
-        if (monitor.states[right] == HUNGRY && can_eat(right)) {
-            pthread_cond_signal(&monitor.cond_vars[right]);
-        }
-        
-        pthread_mutex_unlock(&monitor.mutex);
+        if (mode == MODE_FORKS) {
+            forks_put_down(philosopher);
+        } else {
+            monitor_put_down(philosopher);
+        }
     }
-    
+
     // Record end time
     clock_gettime(CLOCK_MONOTONIC, &philosopher->end_time);
-    
-    printf("Philosopher %d completed all meals\n", philosopher->id);
+
+    if (verbose) {
+        printf("Philosopher %d completed all meals\n", philosopher->id);
+    }
     return NULL;
 }
 
-// Print performance statistics
-static void print_stats(void) {
-    printf("\nDining Philosophers Statistics:\n");
-    
+// Fairness as Jain's index over meals eaten: 1.0 means every philosopher
+// ate equally often, 1/n means one philosopher ate everything
+static double fairness(long *total_meals) {
+    double sum_squares = 0.0;
+    long total = 0;
+
+    for (int i = 0; i < monitor.num_philosophers; i++) {
+        long meals = monitor.philosophers[i].meals_eaten;
+        total += meals;
+        sum_squares += (double)meals * meals;
+    }
+    *total_meals = total;
+    return sum_squares > 0 ? (double)total * total / (monitor.num_philosophers * sum_squares)
+                           : 1.0;
+}
+
+// Print performance statistics: per philosopher for small tables, then
+// throughput and fairness
+static void print_stats(double elapsed) {
+    long total_meals = 0;
+    double jain = fairness(&total_meals);
+    double total_wait = 0.0;
+    int min_meals = monitor.philosophers[0].meals_eaten;
+    int max_meals_eaten = min_meals;
+
+    printf("\nDining Philosophers Statistics (%s, %d philosophers):\n",
+           mode == MODE_FORKS ? "per-fork locks" : "monitor", monitor.num_philosophers);
+
     for (int i = 0; i < monitor.num_philosophers; i++) {
         philosopher_data_t *philosopher = &monitor.philosophers[i];
-        double runtime = (philosopher->end_time.tv_sec - philosopher->start_time.tv_sec) +
-                        (philosopher->end_time.tv_nsec - philosopher->start_time.tv_nsec) / 1e9;
-        
+
+        total_wait += philosopher->total_wait_time;
+        if (philosopher->meals_eaten < min_meals) {
+            min_meals = philosopher->meals_eaten;
+        }
+        if (philosopher->meals_eaten > max_meals_eaten) {
+            max_meals_eaten = philosopher->meals_eaten;
+        }
+
+        if (monitor.num_philosophers > DETAIL_MAX_PHILOSOPHERS) {
+            continue;
+        }
         printf("\nPhilosopher %d:\n", philosopher->id);
         printf("  Meals eaten: %d\n", philosopher->meals_eaten);
         printf("  Total wait time: %.6f seconds\n", philosopher->total_wait_time);
         printf("  Average wait time: %.6f seconds\n",
-               philosopher->total_wait_time / philosopher->meals_eaten);
-        printf("  Runtime: %.6f seconds\n", runtime);
+               philosopher->meals_eaten ? philosopher->total_wait_time / philosopher->meals_eaten : 0.0);
+        printf("  Runtime: %.6f seconds\n",
+               elapsed_seconds(&philosopher->start_time, &philosopher->end_time));
     }
+
+    printf("\n  Total meals: %ld in %.3f seconds\n", total_meals, elapsed);
+    printf("  Throughput: %.0f meals/sec\n", total_meals / elapsed);
+    printf("  Fairness (Jain's index): %.3f, meals per philosopher %d..%d\n",
+           jain, min_meals, max_meals_eaten);
+    printf("  Average wait per meal: %.3f us\n",
+           total_meals ? total_wait / total_meals * 1e6 : 0.0);
 }
 
-int main(void) {
-    // Set up signal handler
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-    
-    // Initialize monitor
-    if (monitor_init() != 0) {
-        return EXIT_FAILURE;
+// Run the table once. With a latency histogram (benchmark mode) stop after
+// the given number of seconds and return the meals eaten, adding each
+// meal's wait to latency and the table's fairness to *jain; otherwise
+// print the statistics and return 0. Returns -1 on error.
+static long run_table(int num_philosophers, double seconds, bench_histogram_t *latency,
+                      double *jain) {
+    struct timespec start, end;
+    bench_histogram_t *waits = NULL;
+    long total_meals = 0;
+    int created = 0;
+
+    if (monitor_init(num_philosophers) != 0) {
+        return -1;
+    }
+    running = 1;
+
+    pthread_t *threads = calloc((size_t)num_philosophers, sizeof(*threads));
+    if (latency) {
+        waits = malloc((size_t)num_philosophers * sizeof(*waits));
+    }
+    if (!threads || (latency && !waits)) {
+        perror("calloc failed");
+        free(threads);
+        monitor_cleanup();
+        return -1;
     }
-    
+    for (int i = 0; latency && i < num_philosophers; i++) {
+        bench_histogram_init(&waits[i]);
+        monitor.philosophers[i].latency = &waits[i];
+    }
+
     // Create philosopher threads
-    pthread_t threads[NUM_PHILOSOPHERS];
-    for (int i = 0; i < NUM_PHILOSOPHERS; i++) {
-        if (pthread_create(&threads[i], NULL, philosopher_thread,
-                          &monitor.philosophers[i]) != 0) {
+    pthread_barrier_init(&start_barrier, NULL, (unsigned int)num_philosophers + 1);
+    for (; created < num_philosophers; created++) {
+        if (pthread_create(&threads[created], NULL, philosopher_thread,
+                          &monitor.philosophers[created]) != 0) {
             perror("pthread_create failed");
-            monitor_cleanup();
-            return EXIT_FAILURE;
+            // The started philosophers wait at the barrier forever
+            exit(EXIT_FAILURE);
         }
     }
-    
+
+    // Time from the moment all philosophers are at the table
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_barrier_wait(&start_barrier);
+
+    if (seconds > 0 && running) {
+        struct timespec run = { (time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9) };
+        nanosleep(&run, NULL);
+        running = 0;
+    }
+
+    // Wake philosophers still waiting in the monitor so they see running == 0
+    if (!running) {
+        pthread_mutex_lock(&monitor.mutex);
+        for (int i = 0; i < num_philosophers; i++) {
+            pthread_cond_signal(&monitor.cond_vars[i]);
+        }
+        pthread_mutex_unlock(&monitor.mutex);
+    }
+
     // Wait for all threads to complete
-    for (int i = 0; i < NUM_PHILOSOPHERS; i++) {
+    for (int i = 0; i < created; i++) {
         if (pthread_join(threads[i], NULL) != 0) {
             perror("pthread_join failed");
         }
     }
-    
-    // Print statistics
-    print_stats();
-    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (latency) {
+        for (int i = 0; i < num_philosophers; i++) {
+            bench_histogram_merge(latency, &waits[i]);
+        }
+        *jain = fairness(&total_meals);
+    } else {
+        print_stats(elapsed_seconds(&start, &end));
+    }
+
     // Clean up
+    pthread_barrier_destroy(&start_barrier);
+    free(threads);
+    free(waits);
     monitor_cleanup();
-    
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+
+    return total_meals;
+}
+
+// One benchmark configuration, with fairness summed over repetitions
+typedef struct {
+    dining_mode_t mode;
+    int philosophers;
+    double seconds;
+    double fairness;
+    int runs;
+} bench_case_t;
+
+// One repetition: run the table; returns the meals eaten, -1 on error
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    double jain = 0.0;
+    long meals;
+
+    mode = bench->mode;
+    meals = run_table(bench->philosophers, bench->seconds, latency, &jain);
+    if (meals >= 0) {
+        bench->fairness += jain;
+        bench->runs++;
+    }
+    return meals;
+}
+
+int main(int argc, char *argv[]) {
+    int bench_philosophers = 0;
+    double bench_seconds = BENCH_SECONDS;
+
+    // Set up signal handler
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--forks") == 0) {
+            mode = MODE_FORKS;
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench_philosophers = atoi(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                bench_seconds = atof(argv[++i]);
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--forks] [--bench philosophers [seconds]]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (bench_philosophers == 0) {
+        return run_table(NUM_PHILOSOPHERS, 0, NULL, NULL) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (bench_philosophers < 2 || bench_philosophers > MAX_PHILOSOPHERS || bench_seconds <= 0) {
+        fprintf(stderr, "benchmark needs 2-%d philosophers and a positive number of seconds\n",
+                MAX_PHILOSOPHERS);
+        return EXIT_FAILURE;
+    }
+
+    // Benchmark: eat as often as possible with short busy meals, in both
+    // modes unless one was chosen with --forks
+    max_meals = INT_MAX;
+    verbose = 0;
+    eating_work = BENCH_EATING_WORK;
+    thinking_work = BENCH_THINKING_WORK;
+
+    bench_config_t config;
+    int result = EXIT_SUCCESS;
+    char name[64];
+
+    bench_config_init(&config, "dining_philosophers");
+    for (int m = mode; m <= MODE_FORKS; m++) {
+        bench_case_t bench = { (dining_mode_t)m, bench_philosophers,
+                               bench_seconds * config.scale, 0.0, 0 };
+
+        snprintf(name, sizeof(name), "%s/philosophers=%d",
+                 m == MODE_FORKS ? "forks" : "monitor", bench_philosophers);
+        if (bench_case(&config, name, bench_repetition, &bench) != 0) {
+            fprintf(stderr, "%s FAILED\n", name);
+            result = EXIT_FAILURE;
+            continue;
+        }
+        // On stderr so CSV or JSON on stdout stays parseable
+        fprintf(stderr, "%s: fairness (Jain's index) %.3f\n", name,
+                bench.runs ? bench.fairness / bench.runs : 1.0);
+    }
+    return result;
+}
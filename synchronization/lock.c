@@ -0,0 +1,320 @@
+/**
+ * Lock Implementation
+ *
+ * The adaptive lock is the three-state futex mutex: a release only makes
+ * a system call when the lock word says a thread may be parked. The
+ * distributed reader-writer lock uses the same rule: readers and writers
+ * only enter the kernel to sleep, and wake-ups are only issued while the
+ * other side is known to be waiting.
+ * Adaptive lock acquisitions are counted in stats.h under one lock class;
+ * only an acquisition that finds the lock taken reads the clock.
+ */
+
+#define _GNU_SOURCE             // sched_getcpu
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "lock.h"
+#include "stats.h"
+
+// Block while the futex word still holds the expected value
+static void futex_wait(_Atomic int *addr, int expected) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+// Wake up to count threads blocked on the futex word
+static void futex_wake(_Atomic int *addr, int count) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// Spinning only helps when the holder can run on another CPU
+static int adaptive_spin_limit(void) {
+    static _Atomic int limit = -1;
+    int value = atomic_load_explicit(&limit, memory_order_relaxed);
+
+    if (value < 0) {
+        value = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? ADAPTIVE_LOCK_SPINS : 0;
+        atomic_store_explicit(&limit, value, memory_order_relaxed);
+    }
+    return value;
+}
+
+// Statistics class shared by every adaptive lock
+static int adaptive_lock_class(void) {
+    static _Atomic int lock_class = -2;
+    int value = atomic_load_explicit(&lock_class, memory_order_relaxed);
+
+    // Registering twice returns the same class, so racing here is harmless
+    if (value == -2) {
+        value = stats_lock_class("adaptive_lock");
+        atomic_store_explicit(&lock_class, value, memory_order_relaxed);
+    }
+    return value;
+}
+
+int filter_lock_init(filter_lock_t *lock, int threads) {
+    if (threads < 2) {
+        fprintf(stderr, "filter lock needs at least 2 threads\n");
+        return -1;
+    }
+
+    lock->level = calloc((size_t)threads, sizeof(*lock->level));
+    lock->victim = calloc((size_t)threads, sizeof(*lock->victim));
+    if (!lock->level || !lock->victim) {
+        perror("Failed to allocate filter lock");
+        free(lock->level);
+        free(lock->victim);
+        return -1;
+    }
+    lock->threads = threads;
+    return 0;
+}
+
+void filter_lock_destroy(filter_lock_t *lock) {
+    free(lock->level);
+    free(lock->victim);
+    lock->level = NULL;
+    lock->victim = NULL;
+}
+
+// Check whether any other thread is at the given level or above
+static int filter_lock_conflict(filter_lock_t *lock, int id, int level) {
+    for (int k = 0; k < lock->threads; k++) {
+        if (k != id && atomic_load(&lock->level[k]) >= level) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void filter_lock_acquire(filter_lock_t *lock, int id) {
+    // Pass through levels 1..n-1; at most n-level threads get past each one.
+    // The level store must be visible before the victim and level loads,
+    // which is why these are sequentially consistent and not plain ints.
+    for (int level = 1; level < lock->threads; level++) {
+        atomic_store(&lock->level[id], level);
+        atomic_store(&lock->victim[level], id);
+
+        for (int spins = 0;
+             atomic_load(&lock->victim[level]) == id && filter_lock_conflict(lock, id, level);
+             spins++) {
+            cpu_relax();
+            // Let the thread we are waiting for run on an oversubscribed CPU
+            if (spins % LOCK_YIELD_SPINS == LOCK_YIELD_SPINS - 1) {
+                sched_yield();
+            }
+        }
+    }
+}
+
+void filter_lock_release(filter_lock_t *lock, int id) {
+    atomic_store_explicit(&lock->level[id], 0, memory_order_release);
+}
+
+void adaptive_lock_init(adaptive_lock_t *lock) {
+    atomic_init(&lock->state, 0);
+}
+
+int adaptive_lock_trylock(adaptive_lock_t *lock) {
+    int expected = 0;
+    return atomic_compare_exchange_strong_explicit(&lock->state, &expected, 1,
+                                                   memory_order_acquire,
+                                                   memory_order_relaxed);
+}
+
+// Contended path of adaptive_lock_acquire: spin, back off, then park
+static void adaptive_lock_wait(adaptive_lock_t *lock) {
+    int spin_limit = adaptive_spin_limit();
+    int delay = 1;
+
+    // Spin: the holder is usually about to release
+    for (int spins = 0; spins < spin_limit; spins++) {
+        if (atomic_load_explicit(&lock->state, memory_order_relaxed) == 0 &&
+            adaptive_lock_trylock(lock)) {
+            return;
+        }
+        cpu_relax();
+    }
+
+    // Back off exponentially, giving up the CPU between attempts
+    for (int round = 0; round < ADAPTIVE_LOCK_BACKOFF; round++) {
+        for (int i = 0; i < delay * spin_limit / ADAPTIVE_LOCK_SPINS; i++) {
+            cpu_relax();
+        }
+        if (adaptive_lock_trylock(lock)) {
+            return;
+        }
+        sched_yield();
+        delay *= 2;
+    }
+
+    // Park: mark the lock contended so the holder wakes us on release
+    while (atomic_exchange_explicit(&lock->state, 2, memory_order_acquire) != 0) {
+        futex_wait(&lock->state, 2);
+    }
+}
+
+void adaptive_lock_acquire(adaptive_lock_t *lock) {
+    uint64_t start;
+
+    if (adaptive_lock_trylock(lock)) {
+        stats_lock_acquired(adaptive_lock_class(), 0);
+        return;
+    }
+    if (stats_page == NULL) {
+        adaptive_lock_wait(lock);
+        return;
+    }
+
+    start = stats_now_ns();
+    adaptive_lock_wait(lock);
+    stats_lock_acquired(adaptive_lock_class(), stats_now_ns() - start + 1);
+}
+
+void adaptive_lock_release(adaptive_lock_t *lock) {
+    if (atomic_exchange_explicit(&lock->state, 0, memory_order_release) == 2) {
+        futex_wake(&lock->state, 1);
+    }
+}
+
+int dist_rwlock_init(dist_rwlock_t *lock) {
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    unsigned slots = 1;
+
+    while (slots < (unsigned)cpus && slots < RWLOCK_MAX_SLOTS) {
+        slots *= 2;
+    }
+
+    lock->slots = aligned_alloc(LOCK_CACHE_LINE, slots * sizeof(rwlock_slot_t));
+    if (!lock->slots) {
+        perror("Failed to allocate reader slots");
+        return -1;
+    }
+    for (unsigned i = 0; i < slots; i++) {
+        atomic_init(&lock->slots[i].readers, 0);
+    }
+    lock->slot_mask = slots - 1;
+    atomic_init(&lock->writers, 0);
+    atomic_init(&lock->drained, 0);
+    adaptive_lock_init(&lock->write_lock);
+    return 0;
+}
+
+void dist_rwlock_destroy(dist_rwlock_t *lock) {
+    free(lock->slots);
+    lock->slots = NULL;
+}
+
+int dist_rwlock_read_lock(dist_rwlock_t *lock) {
+    int cpu = sched_getcpu();
+    int slot = (int)((unsigned)(cpu < 0 ? 0 : cpu) & lock->slot_mask);
+
+    for (;;) {
+        int writers = atomic_load(&lock->writers);
+
+        // Writer preference: stay out while any writer is active or waiting
+        if (writers > 0) {
+            futex_wait(&lock->writers, writers);
+            continue;
+        }
+
+        // Announce ourselves, then check again: a writer that arrived in
+        // between either sees our slot or we see its count
+        atomic_fetch_add(&lock->slots[slot].readers, 1);
+        if (atomic_load(&lock->writers) == 0) {
+            return slot;
+        }
+        dist_rwlock_read_unlock(lock, slot);
+    }
+}
+
+void dist_rwlock_read_unlock(dist_rwlock_t *lock, int slot) {
+    atomic_fetch_sub(&lock->slots[slot].readers, 1);
+
+    // A writer may be waiting for the readers to drain
+    if (atomic_load(&lock->writers) > 0) {
+        atomic_fetch_add(&lock->drained, 1);
+        futex_wake(&lock->drained, INT_MAX);
+    }
+}
+
+// Check whether any reader slot is occupied
+static int dist_rwlock_has_readers(dist_rwlock_t *lock) {
+    for (unsigned i = 0; i <= lock->slot_mask; i++) {
+        if (atomic_load(&lock->slots[i].readers) > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void dist_rwlock_write_lock(dist_rwlock_t *lock) {
+    // Registering first keeps new readers out while we queue behind writers
+    atomic_fetch_add(&lock->writers, 1);
+    adaptive_lock_acquire(&lock->write_lock);
+
+    for (;;) {
+        int drained = atomic_load(&lock->drained);
+        if (!dist_rwlock_has_readers(lock)) {
+            break;
+        }
+        futex_wait(&lock->drained, drained);
+    }
+}
+
+void dist_rwlock_write_unlock(dist_rwlock_t *lock) {
+    adaptive_lock_release(&lock->write_lock);
+
+    // The last writer lets the readers back in
+    if (atomic_fetch_sub(&lock->writers, 1) == 1) {
+        futex_wake(&lock->writers, INT_MAX);
+    }
+}
+
+void seqlock_init(seqlock_t *lock) {
+    atomic_init(&lock->sequence, 0);
+    adaptive_lock_init(&lock->write_lock);
+}
+
+unsigned seqlock_read_begin(seqlock_t *lock) {
+    unsigned sequence;
+
+    for (int spins = 0;
+         (sequence = atomic_load_explicit(&lock->sequence, memory_order_acquire)) & 1;
+         spins++) {
+        cpu_relax();
+        // The writer may have been preempted on an oversubscribed CPU
+        if (spins % LOCK_YIELD_SPINS == LOCK_YIELD_SPINS - 1) {
+            sched_yield();
+        }
+    }
+    return sequence;
+}
+
+int seqlock_read_retry(seqlock_t *lock, unsigned sequence) {
+    // Order the data loads before the second sequence load
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&lock->sequence, memory_order_relaxed) != sequence;
+}
+
+void seqlock_write_lock(seqlock_t *lock) {
+    adaptive_lock_acquire(&lock->write_lock);
+    atomic_store_explicit(&lock->sequence,
+                          atomic_load_explicit(&lock->sequence, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    // Order the odd sequence before the data stores
+    atomic_thread_fence(memory_order_release);
+}
+
+void seqlock_write_unlock(seqlock_t *lock) {
+    atomic_store_explicit(&lock->sequence,
+                          atomic_load_explicit(&lock->sequence, memory_order_relaxed) + 1,
+                          memory_order_release);
+    adaptive_lock_release(&lock->write_lock);
+}
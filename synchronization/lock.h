@@ -0,0 +1,204 @@
+/**
+ * Lock Interface
+ *
+ * Locks for threads of one process:
+ * - Filter lock: Peterson's algorithm generalized to n threads, built only
+ *   from loads and stores (with C11 sequentially consistent ordering, which
+ *   the algorithm needs to be correct on modern CPUs)
+ * - Adaptive lock: spins briefly with a CPU pause hint, backs off, and then
+ *   parks the thread on a futex so waiting threads do not burn CPU time
+ * - Distributed reader-writer lock: readers announce themselves in per-CPU
+ *   slots on separate cache lines, so readers on different CPUs do not
+ *   contend; writers take precedence over newly arriving readers
+ * - Seqlock: readers take no lock at all and retry if a writer ran
+ *   concurrently; suited to small data read far more often than written
+ */
+
+#ifndef LOCK_H
+#define LOCK_H
+
+#include <stdatomic.h>
+
+// Constants
+#define ADAPTIVE_LOCK_SPINS 100     // Pause-spins before backing off (0 on one CPU)
+#define ADAPTIVE_LOCK_BACKOFF 8     // Backoff rounds (doubling) before parking
+#define LOCK_YIELD_SPINS 64         // Spins between yields while waiting
+#define RWLOCK_MAX_SLOTS 64         // Reader slots, one per CPU up to this
+#define LOCK_CACHE_LINE 64
+
+// Hint to the CPU that this is a spin-wait loop
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define cpu_relax() atomic_signal_fence(memory_order_seq_cst)
+#endif
+
+// Filter lock for a fixed number of threads, identified as 0..threads-1
+typedef struct {
+    int threads;
+    _Atomic int *level;     // Level each thread is trying to pass
+    _Atomic int *victim;    // Last thread to enter each level
+} filter_lock_t;
+
+// Adaptive lock: 0 unlocked, 1 locked, 2 locked with possible sleepers
+typedef struct {
+    _Atomic int state;
+} adaptive_lock_t;
+
+#define ADAPTIVE_LOCK_INITIALIZER { 0 }
+
+// Reader count on its own cache line
+typedef struct {
+    _Atomic int readers;
+    char padding[LOCK_CACHE_LINE - sizeof(_Atomic int)];
+} rwlock_slot_t;
+
+// Distributed reader-writer lock with writer preference
+typedef struct {
+    rwlock_slot_t *slots;
+    unsigned slot_mask;         // Slot count minus one (a power of two)
+    _Atomic int writers;        // Waiting plus active writers; blocks new readers
+    _Atomic int drained;        // Bumped by departing readers while writers wait
+    adaptive_lock_t write_lock; // Serializes writers
+} dist_rwlock_t;
+
+// Seqlock: odd sequence while a write is in progress
+typedef struct {
+    _Atomic unsigned sequence;
+    adaptive_lock_t write_lock;
+} seqlock_t;
+
+#define SEQLOCK_INITIALIZER { 0, ADAPTIVE_LOCK_INITIALIZER }
+
+/**
+ * Initialize a filter lock
+ * @param lock Lock to initialize
+ * @param threads Number of threads that will use the lock (at least 2)
+ * @return 0 on success, -1 on error
+ */
+int filter_lock_init(filter_lock_t *lock, int threads);
+
+/**
+ * Free a filter lock
+ * @param lock Lock to free; no thread may hold or wait for it
+ */
+void filter_lock_destroy(filter_lock_t *lock);
+
+/**
+ * Acquire a filter lock
+ * @param lock Lock to acquire
+ * @param id Calling thread's index, unique among its users
+ */
+void filter_lock_acquire(filter_lock_t *lock, int id);
+
+/**
+ * Release a filter lock
+ * @param lock Lock to release
+ * @param id Calling thread's index
+ */
+void filter_lock_release(filter_lock_t *lock, int id);
+
+/**
+ * Initialize an adaptive lock
+ * @param lock Lock to initialize
+ */
+void adaptive_lock_init(adaptive_lock_t *lock);
+
+/**
+ * Try to acquire an adaptive lock without waiting
+ * @param lock Lock to acquire
+ * @return 1 if acquired, 0 otherwise
+ */
+int adaptive_lock_trylock(adaptive_lock_t *lock);
+
+/**
+ * Acquire an adaptive lock: spin, back off, then park on a futex
+ * @param lock Lock to acquire
+ */
+void adaptive_lock_acquire(adaptive_lock_t *lock);
+
+/**
+ * Release an adaptive lock, waking one parked thread if there is one
+ * @param lock Lock to release
+ */
+void adaptive_lock_release(adaptive_lock_t *lock);
+
+/**
+ * Initialize a distributed reader-writer lock with one slot per CPU
+ * @param lock Lock to initialize
+ * @return 0 on success, -1 on error
+ */
+int dist_rwlock_init(dist_rwlock_t *lock);
+
+/**
+ * Free a distributed reader-writer lock
+ * @param lock Lock to free; no thread may hold or wait for it
+ */
+void dist_rwlock_destroy(dist_rwlock_t *lock);
+
+/**
+ * Acquire a distributed reader-writer lock for reading; waits while any
+ * writer is active or waiting
+ * @param lock Lock to acquire
+ * @return Slot token to pass to dist_rwlock_read_unlock
+ */
+int dist_rwlock_read_lock(dist_rwlock_t *lock);
+
+/**
+ * Release a read hold on a distributed reader-writer lock
+ * @param lock Lock to release
+ * @param slot Token returned by dist_rwlock_read_lock
+ */
+void dist_rwlock_read_unlock(dist_rwlock_t *lock, int slot);
+
+/**
+ * Acquire a distributed reader-writer lock for writing
+ * @param lock Lock to acquire
+ */
+void dist_rwlock_write_lock(dist_rwlock_t *lock);
+
+/**
+ * Release a write hold on a distributed reader-writer lock
+ * @param lock Lock to release
+ */
+void dist_rwlock_write_unlock(dist_rwlock_t *lock);
+
+/**
+ * Initialize a seqlock
+ * @param lock Lock to initialize
+ */
+void seqlock_init(seqlock_t *lock);
+
+/**
+ * Start a read section; waits out a write in progress
+ *
+ * Data read inside the section may be torn and must only be used once
+ * seqlock_read_retry returns 0; read it with (relaxed) atomic loads.
+ * @param lock Seqlock
+ * @return Sequence to pass to seqlock_read_retry
+ */
+unsigned seqlock_read_begin(seqlock_t *lock);
+
+/**
+ * Finish a read section
+ * @param lock Seqlock
+ * @param sequence Value returned by seqlock_read_begin
+ * @return 1 if a writer interfered and the section must be retried, 0 otherwise
+ */
+int seqlock_read_retry(seqlock_t *lock, unsigned sequence);
+
+/**
+ * Start a write section, excluding other writers
+ * @param lock Seqlock
+ */
+void seqlock_write_lock(seqlock_t *lock);
+
+/**
+ * Finish a write section
+ * @param lock Seqlock
+ */
+void seqlock_write_unlock(seqlock_t *lock);
+
+#endif // LOCK_H
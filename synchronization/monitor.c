@@ -5,12 +5,22 @@
  * condition variables. It includes priority inheritance to prevent
  * priority inversion and ensure proper synchronization.
  * 
+ * Waiting threads are kept in a priority-ordered wait queue (wait_queue.c),
+ * each with its own condition variable. On exit the monitor is handed
+ * directly to the highest-priority waiter and only that thread is woken,
+ * instead of broadcasting to every waiter.
+ * 
  * Features:
  * - Priority inheritance
  * - Condition variables
+ * - Targeted O(log n) wakeup
  * - Error handling
  * - Graceful shutdown
  * - Performance monitoring
+ * - Benchmark against the broadcast monitor, with per-entry wait
+ *   latency, through the shared harness in bench.h
+ *
+ * Usage: monitor [--bench [threads] [operations per thread]]
  */
 
 #include <stdio.h>
@@ -21,6 +31,11 @@
 #include <errno.h>
 #include <string.h>
 #include <signal.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+#include "wait_queue.h"
+#include "bench.h"
 
 // Constants
 #define MAX_THREADS 5
@@ -28,6 +43,9 @@
 #define MIN_PRIORITY 1
 #define OPERATION_TIME 2
 #define MAX_OPERATIONS 3
+#define BENCH_THREADS 128
+#define BENCH_MAX_THREADS 1024
+#define BENCH_OPERATIONS 100
 
 // Thread states
 typedef enum {
@@ -49,16 +67,36 @@ typedef struct {
 // Monitor structure
 typedef struct {
     pthread_mutex_t mutex;
-    pthread_cond_t cond;
+    pthread_cond_t cond;        // Broadcast baseline, used by the benchmark only
+    wait_queue_t waiters;       // Threads waiting to enter, by priority
     int current_priority;
     thread_data_t *current_thread;
     thread_data_t threads[MAX_THREADS];
     int num_threads;
 } monitor_t;
 
+// Benchmark thread argument
+typedef struct {
+    thread_data_t data;
+    int broadcast;          // Use the broadcast monitor instead of targeted wakeup
+    int operations;
+    bench_histogram_t latency;  // Time to enter the monitor
+} bench_thread_t;
+
+// One benchmark configuration, with context switches summed over repetitions
+typedef struct {
+    int broadcast;
+    int threads;
+    int operations;
+    long switches;
+    long entries;
+} bench_case_t;
+
 // Global monitor instance
 static monitor_t monitor;
 static volatile sig_atomic_t running = 1;
+static long bench_counter;
+static pthread_barrier_t bench_barrier;    // Start all benchmark threads together
 
 // Signal handler for graceful shutdown
 static void signal_handler(int sig) {
@@ -79,6 +117,12 @@ static int monitor_init(void) {
         return -1;
     }
     
+    if (wait_queue_init(&monitor.waiters) != 0) {
+        pthread_cond_destroy(&monitor.cond);
+        pthread_mutex_destroy(&monitor.mutex);
+        return -1;
+    }
+    
     monitor.current_priority = MIN_PRIORITY;
     monitor.current_thread = NULL;
     monitor.num_threads = 0;
@@ -88,12 +132,72 @@ static int monitor_init(void) {
 
 // Clean up monitor resources
 static void monitor_cleanup(void) {
+    wait_queue_destroy(&monitor.waiters);
     pthread_cond_destroy(&monitor.cond);
     pthread_mutex_destroy(&monitor.mutex);
 }
 
 // Enter monitor
-static void monitor_enter(thread_data_t *thread) {
+static int monitor_enter(thread_data_t *thread) {
+    pthread_mutex_lock(&monitor.mutex);
+    
+    // Wait if another thread is inside or threads are queued ahead of us
+    if (monitor.current_thread != NULL || wait_queue_peek(&monitor.waiters) != NULL) {
+        wait_node_t node;
+        
+        // Priority inheritance: the thread inside runs at the highest
+        // priority of the threads waiting for it
+        if (thread->priority > monitor.current_priority) {
+            monitor.current_priority = thread->priority;
+        }
+        
+        if (wait_node_init(&node, thread->priority, thread) != 0 ||
+            wait_queue_push(&monitor.waiters, &node) != 0) {
+            pthread_mutex_unlock(&monitor.mutex);
+            return -1;
+        }
+        
+        // Sleep until monitor_exit hands the monitor to us
+        thread->state = WAITING;
+        while (!node.granted) {
+            pthread_cond_wait(&node.cond, &monitor.mutex);
+        }
+        wait_node_destroy(&node);
+    }
+    
+    // Enter monitor
+    monitor.current_thread = thread;
+    monitor.current_priority = thread->priority;
+    thread->state = RUNNING;
+    
+    pthread_mutex_unlock(&monitor.mutex);
+    return 0;
+}
+
+// Exit monitor
+static void monitor_exit(thread_data_t *thread) {
+    pthread_mutex_lock(&monitor.mutex);
+    
+    // Exit monitor
+    thread->state = COMPLETED;
+    
+    // Hand the monitor to the highest-priority waiter and wake only it
+    wait_node_t *next = wait_queue_pop(&monitor.waiters);
+    if (next != NULL) {
+        monitor.current_thread = next->owner;
+        monitor.current_priority = next->priority;
+        next->granted = 1;
+        pthread_cond_signal(&next->cond);
+    } else {
+        monitor.current_thread = NULL;
+        monitor.current_priority = MIN_PRIORITY;
+    }
+    
+    pthread_mutex_unlock(&monitor.mutex);
+}
+
+// Enter the broadcast monitor (the previous implementation, benchmark only)
+static void broadcast_monitor_enter(thread_data_t *thread) {
     pthread_mutex_lock(&monitor.mutex);
     
     // Priority inheritance
@@ -109,7 +213,6 @@ static void monitor_enter(thread_data_t *thread) {
         pthread_cond_wait(&monitor.cond, &monitor.mutex);
     }
     
-    // Enter monitor
     monitor.current_thread = thread;
     monitor.current_priority = thread->priority;
     thread->state = RUNNING;
@@ -117,16 +220,14 @@ static void monitor_enter(thread_data_t *thread) {
     pthread_mutex_unlock(&monitor.mutex);
 }
 
-// Exit monitor
-static void monitor_exit(thread_data_t *thread) {
+// Exit the broadcast monitor: every waiter wakes up to re-check
+static void broadcast_monitor_exit(thread_data_t *thread) {
     pthread_mutex_lock(&monitor.mutex);
     
-    // Exit monitor
     monitor.current_thread = NULL;
     monitor.current_priority = MIN_PRIORITY;
     thread->state = COMPLETED;
     
-    // Signal waiting threads
     pthread_cond_broadcast(&monitor.cond);
     
     pthread_mutex_unlock(&monitor.mutex);
@@ -149,8 +250,11 @@ static void *thread_function(void *arg) {
     
     while (running && thread->operations < MAX_OPERATIONS) {
         // Enter monitor
-        monitor_enter(thread);
-        if (!running) break;
+        if (monitor_enter(thread) != 0) break;
+        if (!running) {
+            monitor_exit(thread);
+            break;
+        }
         
         // Perform operation
         printf("Thread %d (priority %d) performing operation %d/%d\n",
@@ -173,7 +277,117 @@ static void *thread_function(void *arg) {
     return NULL;
 }
 
-int main(void) {
+// Benchmark thread: enter, bump a counter, exit; yielding inside the
+// monitor lets the other threads queue up as they would behind real work
+static void *bench_thread_function(void *arg) {
+    bench_thread_t *bench = arg;
+    
+    pthread_barrier_wait(&bench_barrier);
+    for (int i = 0; i < bench->operations; i++) {
+        uint64_t start = bench_now_ns();
+
+        if (bench->broadcast) {
+            broadcast_monitor_enter(&bench->data);
+            bench_histogram_add(&bench->latency, bench_now_ns() - start);
+            bench_counter++;
+            sched_yield();
+            broadcast_monitor_exit(&bench->data);
+        } else {
+            if (monitor_enter(&bench->data) != 0) {
+                return NULL;
+            }
+            bench_histogram_add(&bench->latency, bench_now_ns() - start);
+            bench_counter++;
+            sched_yield();
+            monitor_exit(&bench->data);
+        }
+    }
+    return NULL;
+}
+
+// One repetition of one variant; returns the monitor entries, -1 on error
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    int threads = bench->threads;
+    bench_thread_t *benches = calloc((size_t)threads, sizeof(*benches));
+    pthread_t *tids = calloc((size_t)threads, sizeof(*tids));
+    struct rusage usage_start, usage_end;
+    int created = 0;
+    
+    if (!benches || !tids) {
+        perror("calloc failed");
+        free(benches);
+        free(tids);
+        return -1;
+    }
+    
+    bench_counter = 0;
+    pthread_barrier_init(&bench_barrier, NULL, (unsigned)threads + 1);
+    
+    for (; created < threads; created++) {
+        benches[created].data.id = created;
+        benches[created].data.priority = MIN_PRIORITY + created % (MAX_PRIORITY - MIN_PRIORITY + 1);
+        benches[created].broadcast = bench->broadcast;
+        benches[created].operations = bench->operations;
+        bench_histogram_init(&benches[created].latency);
+        if (pthread_create(&tids[created], NULL, bench_thread_function, &benches[created]) != 0) {
+            perror("pthread_create failed");
+            break;
+        }
+    }
+    if (created < threads) {
+        // The barrier can never fill; the program cannot continue
+        fprintf(stderr, "could not start all benchmark threads\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    getrusage(RUSAGE_SELF, &usage_start);
+    pthread_barrier_wait(&bench_barrier);
+    for (int i = 0; i < created; i++) {
+        pthread_join(tids[i], NULL);
+        bench_histogram_merge(latency, &benches[i].latency);
+    }
+    getrusage(RUSAGE_SELF, &usage_end);
+    
+    bench->switches += (usage_end.ru_nvcsw - usage_start.ru_nvcsw) +
+                       (usage_end.ru_nivcsw - usage_start.ru_nivcsw);
+    bench->entries += bench_counter;
+    long expected = (long)created * bench->operations;
+    if (bench_counter != expected) {
+        fprintf(stderr, "%ld monitor entries, expected %ld\n", bench_counter, expected);
+    }
+    
+    pthread_barrier_destroy(&bench_barrier);
+    free(benches);
+    free(tids);
+    return bench_counter == expected ? bench_counter : -1;
+}
+
+// Compare the broadcast monitor with targeted wakeup
+static int run_bench(int threads, int operations) {
+    bench_config_t config;
+    int result = EXIT_SUCCESS;
+    char name[64];
+    
+    bench_config_init(&config, "monitor");
+    for (int broadcast = 1; broadcast >= 0; broadcast--) {
+        bench_case_t bench = { broadcast, threads, operations, 0, 0 };
+        
+        snprintf(name, sizeof(name), "%s/threads=%d",
+                 broadcast ? "broadcast" : "targeted", threads);
+        if (bench_case(&config, name, bench_repetition, &bench) != 0) {
+            fprintf(stderr, "%s FAILED\n", name);
+            result = EXIT_FAILURE;
+            continue;
+        }
+        // On stderr so CSV or JSON on stdout stays parseable
+        fprintf(stderr, "%s: %.1f context switches per entry\n", name,
+                (double)bench.switches / (bench.entries ? bench.entries : 1));
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
     // Set up signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -183,6 +397,21 @@ int main(void) {
         return EXIT_FAILURE;
     }
     
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        int threads = argc > 2 ? atoi(argv[2]) : BENCH_THREADS;
+        int operations = argc > 3 ? atoi(argv[3]) : BENCH_OPERATIONS;
+        
+        if (threads < 1 || threads > BENCH_MAX_THREADS || operations < 1) {
+            fprintf(stderr, "Usage: %s --bench [threads 1-%d] [operations per thread]\n",
+                    argv[0], BENCH_MAX_THREADS);
+            monitor_cleanup();
+            return EXIT_FAILURE;
+        }
+        int result = run_bench(threads, operations);
+        monitor_cleanup();
+        return result;
+    }
+    
     // Create threads
     pthread_t threads[MAX_THREADS];
     for (int i = 0; i < MAX_THREADS; i++) {
@@ -4,6 +4,8 @@
  * This program demonstrates Peterson's algorithm for mutual exclusion
  * between two processes. It provides a software-based solution to the
  * critical section problem without requiring special hardware support.
+ * The lock itself is the filter lock from lock.c, which is Peterson's
+ * algorithm for two threads and its generalization for more.
  * 
  * Features:
  * - Mutual exclusion
@@ -11,6 +13,10 @@
  * - Bounded waiting
  * - Error handling
  * - Graceful shutdown
+ * - Contention benchmark: filter lock, adaptive lock, pthread_mutex_t,
+ *   with sampled acquire latency, through the shared harness in bench.h
+ *
+ * Usage: peterson [--bench [max threads] [operations]]
  */
 
 #include <stdio.h>
@@ -22,17 +28,54 @@
 #include <string.h>
 #include <signal.h>
 
+#include "lock.h"
+#include "stats.h"
+#include "bench.h"
+
 // Constants
 #define NUM_PROCESSES 2
 #define CRITICAL_SECTION_TIME 2
 #define NON_CRITICAL_SECTION_TIME 3
 #define MAX_ITERATIONS 5
+#define BENCH_MAX_THREADS 64
+#define BENCH_OPERATIONS 2000000    // Lock acquisitions per run, split across threads
+#define BENCH_FILTER_MAX_THREADS 8  // The filter lock is O(n) per level; skip beyond this
+#define BENCH_FILTER_SHARE 16       // ...and runs 1/16 of the operations
+#define BENCH_SAMPLE_EVERY 64       // Time one acquisition in this many
+
+// Locks compared by the benchmark
+typedef enum {
+    BENCH_PTHREAD_MUTEX,
+    BENCH_ADAPTIVE,
+    BENCH_FILTER,
+    BENCH_LOCKS
+} bench_lock_t;
+
+// Benchmark thread argument
+typedef struct {
+    bench_lock_t kind;
+    int id;
+    long operations;
+    bench_histogram_t latency;  // Sampled acquire latencies
+} bench_arg_t;
+
+// One benchmark configuration
+typedef struct {
+    bench_lock_t kind;
+    int threads;
+    long operations;
+} bench_case_t;
 
-// Peterson's algorithm variables
-static int flag[NUM_PROCESSES] = {0, 0};
-static int turn = 0;
+// Peterson's algorithm lock
+static filter_lock_t peterson_lock;
 static volatile sig_atomic_t running = 1;
 
+// Benchmark locks and protected counter
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static adaptive_lock_t bench_adaptive = ADAPTIVE_LOCK_INITIALIZER;
+static filter_lock_t bench_filter;
+static long bench_counter;
+
 // Signal handler for graceful shutdown
 static void signal_handler(int sig) {
     (void)sig;
@@ -41,23 +84,14 @@ static void signal_handler(int sig) {
 
 // Enter critical section using Peterson's algorithm
 static void enter_critical_section(int process_id) {
-    int other = 1 - process_id;
-    
-    // Set flag to indicate interest
-    flag[process_id] = 1;
-    
-    // Give turn to other process
-    turn = other;
-    
-    // Wait while other process is in critical section
-    while (flag[other] && turn == other && running) {
-        // Busy wait
-    }
+    // Set our flag, give the turn away and wait while the other thread is
+    // interested and holds the turn (the filter lock with two threads)
+    filter_lock_acquire(&peterson_lock, process_id);
 }
 
 // Exit critical section
 static void exit_critical_section(int process_id) {
-    flag[process_id] = 0;
+    filter_lock_release(&peterson_lock, process_id);
 }
 
 // Process thread function
@@ -91,10 +125,158 @@ static void *process_thread(void *arg) {
     return NULL;
 }
 
-int main(void) {
+// Take a lock of the benchmarked kind
+static inline void bench_acquire(const bench_arg_t *bench) {
+    switch (bench->kind) {
+    case BENCH_PTHREAD_MUTEX:
+        pthread_mutex_lock(&bench_mutex);
+        break;
+    case BENCH_ADAPTIVE:
+        adaptive_lock_acquire(&bench_adaptive);
+        break;
+    default:
+        filter_lock_acquire(&bench_filter, bench->id);
+        break;
+    }
+}
+
+static inline void bench_release(const bench_arg_t *bench) {
+    switch (bench->kind) {
+    case BENCH_PTHREAD_MUTEX:
+        pthread_mutex_unlock(&bench_mutex);
+        break;
+    case BENCH_ADAPTIVE:
+        adaptive_lock_release(&bench_adaptive);
+        break;
+    default:
+        filter_lock_release(&bench_filter, bench->id);
+        break;
+    }
+}
+
+// Benchmark thread: take the lock, bump the shared counter, release; every
+// BENCH_SAMPLE_EVERY-th acquisition is timed
+static void *bench_thread(void *arg) {
+    bench_arg_t *bench = arg;
+
+    for (long i = 0; i < bench->operations; i++) {
+        if (i % BENCH_SAMPLE_EVERY == 0) {
+            uint64_t start = bench_now_ns();
+            bench_acquire(bench);
+            bench_histogram_add(&bench->latency, bench_now_ns() - start);
+        } else {
+            bench_acquire(bench);
+        }
+        bench_counter++;
+        bench_release(bench);
+    }
+    return NULL;
+}
+
+/**
+ * One repetition: one lock at one thread count
+ * @param arg Benchmark configuration
+ * @param latency Receives the sampled acquire latencies
+ * @return Lock acquisitions, -1 on error
+ */
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    pthread_t tids[BENCH_MAX_THREADS];
+    bench_arg_t *args = malloc(bench->threads * sizeof(*args));
+    long per_thread = bench->operations / bench->threads;
+    int created = 0;
+
+    if (!args) {
+        perror("malloc failed");
+        return -1;
+    }
+    if (bench->kind == BENCH_FILTER && filter_lock_init(&bench_filter, bench->threads) < 0) {
+        free(args);
+        return -1;
+    }
+
+    bench_counter = 0;
+    for (; created < bench->threads; created++) {
+        args[created].kind = bench->kind;
+        args[created].id = created;
+        args[created].operations = per_thread;
+        bench_histogram_init(&args[created].latency);
+        if (pthread_create(&tids[created], NULL, bench_thread, &args[created]) != 0) {
+            perror("pthread_create failed");
+            break;
+        }
+    }
+    for (int i = 0; i < created; i++) {
+        pthread_join(tids[i], NULL);
+        bench_histogram_merge(latency, &args[i].latency);
+    }
+    free(args);
+
+    if (bench->kind == BENCH_FILTER) {
+        filter_lock_destroy(&bench_filter);
+    }
+    if (created < bench->threads) {
+        return -1;
+    }
+    if (bench_counter != per_thread * bench->threads) {
+        fprintf(stderr, "counter is %ld, expected %ld: mutual exclusion failed\n",
+                bench_counter, per_thread * bench->threads);
+        return -1;
+    }
+    return bench_counter;
+}
+
+// Compare the locks at 2, 4, ... up to max_threads threads
+static int run_bench(int max_threads, long operations) {
+    static const char *names[BENCH_LOCKS] = { "pthread_mutex", "adaptive", "filter" };
+    bench_config_t config;
+    int result = EXIT_SUCCESS;
+    char name[64];
+
+    bench_config_init(&config, "peterson");
+    for (int threads = 2; threads <= max_threads; threads *= 2) {
+        for (int kind = 0; kind < BENCH_LOCKS; kind++) {
+            if (kind == BENCH_FILTER && threads > BENCH_FILTER_MAX_THREADS) {
+                continue;
+            }
+            long count = kind == BENCH_FILTER ? operations / BENCH_FILTER_SHARE : operations;
+            bench_case_t bench = { (bench_lock_t)kind, threads, count };
+
+            snprintf(name, sizeof(name), "%s/threads=%d", names[kind], threads);
+            if (count < threads || bench_case(&config, name, bench_repetition, &bench) != 0) {
+                fprintf(stderr, "%s FAILED\n", name);
+                result = EXIT_FAILURE;
+            }
+        }
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
     // Set up signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+
+    // Publish lock counters for ui/menu; optional
+    stats_init("peterson");
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench_config_t config;
+        bench_config_init(&config, "peterson");
+        int max_threads = argc > 2 ? atoi(argv[2]) : BENCH_MAX_THREADS;
+        long operations = argc > 3 ? atol(argv[3]) : bench_scaled(&config, BENCH_OPERATIONS);
+
+        if (max_threads < 2 || max_threads > BENCH_MAX_THREADS || operations < max_threads) {
+            fprintf(stderr, "Usage: %s --bench [max threads 2-%d] [operations]\n",
+                    argv[0], BENCH_MAX_THREADS);
+            return EXIT_FAILURE;
+        }
+        return run_bench(max_threads, operations);
+    }
+
+    if (filter_lock_init(&peterson_lock, NUM_PROCESSES) < 0) {
+        return EXIT_FAILURE;
+    }
     
     // Create process threads
     pthread_t threads[NUM_PROCESSES];
@@ -120,6 +302,7 @@ int main(void) {
         }
     }
     
+    filter_lock_destroy(&peterson_lock);
     printf("All processes have completed their iterations\n");
     return EXIT_SUCCESS;
 }
\ No newline at end of file
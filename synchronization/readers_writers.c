@@ -2,15 +2,22 @@
  * Readers-Writers Problem Solution
  * 
  * This program demonstrates a solution to the readers-writers problem
- * using mutexes and condition variables. It implements a readers-preference
- * solution with proper resource management and synchronization.
+ * using the distributed reader-writer lock from lock.c. Readers only touch
+ * the reader slot of their own CPU, so pure readers do not serialize on a
+ * shared mutex; waiting writers keep new readers out (writer preference).
+ * The original mutex and condition variable solution is kept as a
+ * baseline for the benchmark.
  * 
  * Features:
- * - Readers preference
+ * - Writer preference
  * - Fair resource access
  * - Error handling
  * - Graceful shutdown
  * - Performance monitoring
+ * - Read scaling benchmark up to 64 reader threads, with sampled read
+ *   latency, through the shared harness in bench.h
+ *
+ * Usage: readers_writers [--bench [max readers] [milliseconds per run]]
  */
 
 #include <stdio.h>
@@ -21,6 +28,11 @@
 #include <errno.h>
 #include <string.h>
 #include <signal.h>
+#include <stdatomic.h>
+
+#include "lock.h"
+#include "bench.h"
+#include "stats.h"
 
 // Constants
 #define NUM_READERS 3
@@ -28,6 +40,40 @@
 #define READING_TIME 2
 #define WRITING_TIME 3
 #define MAX_OPERATIONS 3
+#define BENCH_MAX_READERS 64
+#define BENCH_RUN_MS 200
+#define BENCH_WRITE_INTERVAL_US 100     // Writer pause between updates
+#define BENCH_SAMPLE_EVERY 64           // Reads between timed ones
+
+// Locks compared by the benchmark
+typedef enum {
+    BENCH_CONDVAR,          // Mutex and condition variables (the original solution)
+    BENCH_PTHREAD_RWLOCK,   // pthread_rwlock_t, writer preference
+    BENCH_DIST_RWLOCK,      // Distributed reader-writer lock
+    BENCH_SEQLOCK,          // Seqlock
+    BENCH_LOCKS
+} bench_lock_t;
+
+// Data updated by the writer; a == b whenever no write is in progress
+typedef struct {
+    _Atomic long a;
+    _Atomic long b;
+} bench_data_t;
+
+// Per-reader results, padded so counters do not share cache lines
+typedef struct {
+    long reads;
+    long torn;
+    char padding[LOCK_CACHE_LINE - 2 * sizeof(long)];
+    bench_histogram_t latency;  // Sampled read latencies
+} bench_reader_t;
+
+// One benchmark configuration
+typedef struct {
+    bench_lock_t kind;
+    int readers;
+    long run_ms;
+} bench_case_t;
 
 // Global variables
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -36,15 +82,69 @@ static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
 static int readers_count = 0;
 static int writers_count = 0;
 static int waiting_writers = 0;
+static dist_rwlock_t rwlock;
 static int shared_data = 0;
 static volatile sig_atomic_t running = 1;
 
+// Benchmark state
+static bench_lock_t bench_kind;
+static pthread_rwlock_t bench_pthread_rwlock;
+static seqlock_t bench_seqlock = SEQLOCK_INITIALIZER;
+static bench_data_t bench_data;
+static bench_reader_t bench_readers[BENCH_MAX_READERS];
+static atomic_int bench_stop;
+
 // Signal handler for graceful shutdown
 static void signal_handler(int sig) {
     (void)sig;
     running = 0;
 }
 
+// Mutex and condition variable read lock: wait while a writer is active
+// or waiting
+static void condvar_read_lock(void) {
+    pthread_mutex_lock(&mutex);
+    while (writers_count > 0 || waiting_writers > 0) {
+        pthread_cond_wait(&reader_cond, &mutex);
+    }
+    readers_count++;
+    pthread_mutex_unlock(&mutex);
+}
+
+// Mutex and condition variable read unlock: the last reader wakes a writer
+static void condvar_read_unlock(void) {
+    pthread_mutex_lock(&mutex);
+    readers_count--;
+    if (readers_count == 0 && waiting_writers > 0) {
+        pthread_cond_signal(&writer_cond);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+// Mutex and condition variable write lock
+static void condvar_write_lock(void) {
+    pthread_mutex_lock(&mutex);
+    waiting_writers++;
+    while (readers_count > 0 || writers_count > 0) {
+        pthread_cond_wait(&writer_cond, &mutex);
+    }
+    waiting_writers--;
+    writers_count++;
+    pthread_mutex_unlock(&mutex);
+}
+
+// Mutex and condition variable write unlock: waiting writers go first
+static void condvar_write_unlock(void) {
+    pthread_mutex_lock(&mutex);
+    writers_count--;
+    if (waiting_writers > 0) {
+        pthread_cond_signal(&writer_cond);
+    } else {
+        pthread_cond_broadcast(&reader_cond);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
 // Reader thread function
 static void *reader_thread(void *arg) {
     int reader_id = *(int *)arg;
@@ -54,33 +154,17 @@ static void *reader_thread(void *arg) {
     printf("Reader %d starting\n", reader_id);
     
     while (running && operations < MAX_OPERATIONS) {
-        // Try to read
-        pthread_mutex_lock(&mutex);
-        
-        // Wait if there are writers
-        while (writers_count > 0) {
-            pthread_cond_wait(&reader_cond, &mutex);
-        }
-        
-        readers_count++;
-        pthread_mutex_unlock(&mutex);
+        // Try to read; waits while writers are active or waiting
+        int slot = dist_rwlock_read_lock(&rwlock);
         
         // Read data
         printf("Reader %d reading data: %d\n", reader_id, shared_data);
         sleep(READING_TIME);
         
-        // Finish reading
-        pthread_mutex_lock(&mutex);
-        readers_count--;
+        // Finish reading; the last reader out lets a waiting writer in
+        dist_rwlock_read_unlock(&rwlock, slot);
         operations++;
         
-        // If no more readers, signal waiting writers
-        if (readers_count == 0 && waiting_writers > 0) {
-            pthread_cond_signal(&writer_cond);
-        }
-        
-        pthread_mutex_unlock(&mutex);
-        
         // Think between operations
         sleep(1);
     }
@@ -98,38 +182,18 @@ static void *writer_thread(void *arg) {
     printf("Writer %d starting\n", writer_id);
     
     while (running && operations < MAX_OPERATIONS) {
-        // Try to write
-        pthread_mutex_lock(&mutex);
-        waiting_writers++;
-        
-        // Wait if there are readers or writers
-        while (readers_count > 0 || writers_count > 0) {
-            pthread_cond_wait(&writer_cond, &mutex);
-        }
-        
-        waiting_writers--;
-        writers_count++;
-        pthread_mutex_unlock(&mutex);
+        // Try to write; new readers stay out while we wait
+        dist_rwlock_write_lock(&rwlock);
         
         // Write data
         shared_data++;
         printf("Writer %d writing data: %d\n", writer_id, shared_data);
         sleep(WRITING_TIME);
         
-        // Finish writing
-        pthread_mutex_lock(&mutex);
-        writers_count--;
+        // Finish writing; waiting writers go before readers
+        dist_rwlock_write_unlock(&rwlock);
         operations++;
         
-        // Signal waiting threads
-        if (waiting_writers > 0) {
-            pthread_cond_signal(&writer_cond);
-        } else {
-            pthread_cond_broadcast(&reader_cond);
-        }
-        
-        pthread_mutex_unlock(&mutex);
-        
         // Think between operations
         sleep(1);
     }
@@ -138,10 +202,221 @@ static void *writer_thread(void *arg) {
     return NULL;
 }
 
-int main(void) {
+// Benchmark reader: read both fields under the lock until stopped
+static void *bench_reader_thread(void *arg) {
+    bench_reader_t *result = arg;
+    long reads = 0;
+    long torn = 0;
+    long a, b;
+
+    while (!atomic_load_explicit(&bench_stop, memory_order_relaxed)) {
+        uint64_t start = reads % BENCH_SAMPLE_EVERY == 0 ? bench_now_ns() : 0;
+
+        switch (bench_kind) {
+        case BENCH_CONDVAR:
+            condvar_read_lock();
+            a = atomic_load_explicit(&bench_data.a, memory_order_relaxed);
+            b = atomic_load_explicit(&bench_data.b, memory_order_relaxed);
+            condvar_read_unlock();
+            break;
+        case BENCH_PTHREAD_RWLOCK:
+            pthread_rwlock_rdlock(&bench_pthread_rwlock);
+            a = atomic_load_explicit(&bench_data.a, memory_order_relaxed);
+            b = atomic_load_explicit(&bench_data.b, memory_order_relaxed);
+            pthread_rwlock_unlock(&bench_pthread_rwlock);
+            break;
+        case BENCH_DIST_RWLOCK: {
+            int slot = dist_rwlock_read_lock(&rwlock);
+            a = atomic_load_explicit(&bench_data.a, memory_order_relaxed);
+            b = atomic_load_explicit(&bench_data.b, memory_order_relaxed);
+            dist_rwlock_read_unlock(&rwlock, slot);
+            break;
+        }
+        default: {
+            unsigned sequence;
+            do {
+                sequence = seqlock_read_begin(&bench_seqlock);
+                a = atomic_load_explicit(&bench_data.a, memory_order_relaxed);
+                b = atomic_load_explicit(&bench_data.b, memory_order_relaxed);
+            } while (seqlock_read_retry(&bench_seqlock, sequence));
+            break;
+        }
+        }
+
+        if (start != 0) {
+            bench_histogram_add(&result->latency, bench_now_ns() - start);
+        }
+        if (a != b) {
+            torn++;
+        }
+        reads++;
+    }
+
+    result->reads = reads;
+    result->torn = torn;
+    return NULL;
+}
+
+// Benchmark writer: update both fields under the lock, pausing between updates
+static void *bench_writer_thread(void *arg) {
+    long *writes = arg;
+    struct timespec pause = { 0, BENCH_WRITE_INTERVAL_US * 1000L };
+
+    while (!atomic_load_explicit(&bench_stop, memory_order_relaxed)) {
+        switch (bench_kind) {
+        case BENCH_CONDVAR:
+            condvar_write_lock();
+            break;
+        case BENCH_PTHREAD_RWLOCK:
+            pthread_rwlock_wrlock(&bench_pthread_rwlock);
+            break;
+        case BENCH_DIST_RWLOCK:
+            dist_rwlock_write_lock(&rwlock);
+            break;
+        default:
+            seqlock_write_lock(&bench_seqlock);
+            break;
+        }
+
+        // Two separate stores: a reader between them would see a != b
+        atomic_store_explicit(&bench_data.a, bench_data.a + 1, memory_order_relaxed);
+        atomic_store_explicit(&bench_data.b, bench_data.b + 1, memory_order_relaxed);
+
+        switch (bench_kind) {
+        case BENCH_CONDVAR:
+            condvar_write_unlock();
+            break;
+        case BENCH_PTHREAD_RWLOCK:
+            pthread_rwlock_unlock(&bench_pthread_rwlock);
+            break;
+        case BENCH_DIST_RWLOCK:
+            dist_rwlock_write_unlock(&rwlock);
+            break;
+        default:
+            seqlock_write_unlock(&bench_seqlock);
+            break;
+        }
+
+        (*writes)++;
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+// One repetition: run one lock with its readers plus one writer for run_ms;
+// returns the reads done, -1 on error
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    pthread_t reader_tids[BENCH_MAX_READERS];
+    pthread_t writer_tid;
+    struct timespec run = { bench->run_ms / 1000, (bench->run_ms % 1000) * 1000000L };
+    long reads = 0;
+    long torn = 0;
+    long writes = 0;
+    int created = 0;
+
+    bench_kind = bench->kind;
+    atomic_store(&bench_stop, 0);
+
+    for (; created < bench->readers; created++) {
+        bench_histogram_init(&bench_readers[created].latency);
+        if (pthread_create(&reader_tids[created], NULL, bench_reader_thread,
+                           &bench_readers[created]) != 0) {
+            perror("pthread_create failed");
+            break;
+        }
+    }
+    int writer_created = created == bench->readers &&
+                         pthread_create(&writer_tid, NULL, bench_writer_thread, &writes) == 0;
+
+    if (writer_created) {
+        nanosleep(&run, NULL);
+    }
+    atomic_store(&bench_stop, 1);
+
+    if (writer_created) {
+        pthread_join(writer_tid, NULL);
+    }
+    for (int i = 0; i < created; i++) {
+        pthread_join(reader_tids[i], NULL);
+        reads += bench_readers[i].reads;
+        torn += bench_readers[i].torn;
+        bench_histogram_merge(latency, &bench_readers[i].latency);
+    }
+
+    if (!writer_created) {
+        return -1;
+    }
+    if (torn > 0) {
+        fprintf(stderr, "%ld torn reads\n", torn);
+        return -1;
+    }
+    return reads;
+}
+
+// Compare the locks with 1, 2, 4, ... up to max_readers readers and one writer
+static int run_bench(const bench_config_t *config, int max_readers, long run_ms) {
+    static const char *names[BENCH_LOCKS] = {
+        "mutex+cond", "pthread_rwlock", "dist_rwlock", "seqlock"
+    };
+    pthread_rwlockattr_t attr;
+    int result = EXIT_SUCCESS;
+    char name[64];
+
+    // glibc rwlocks prefer readers by default; match the writer preference
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&bench_pthread_rwlock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    // On stderr so CSV or JSON on stdout stays parseable
+    fprintf(stderr, "One writer every %d us, %ld ms per repetition\n",
+            BENCH_WRITE_INTERVAL_US, run_ms);
+
+    for (int readers = 1; readers <= max_readers; readers *= 2) {
+        for (int kind = 0; kind < BENCH_LOCKS; kind++) {
+            bench_case_t bench = { (bench_lock_t)kind, readers, run_ms };
+
+            snprintf(name, sizeof(name), "%s/readers=%d", names[kind], readers);
+            if (bench_case(config, name, bench_repetition, &bench) != 0) {
+                fprintf(stderr, "%s FAILED\n", name);
+                result = EXIT_FAILURE;
+            }
+        }
+    }
+
+    pthread_rwlock_destroy(&bench_pthread_rwlock);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
     // Set up signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+
+    // Publish lock counters for ui/menu; optional
+    stats_init("readers_writers");
+
+    if (dist_rwlock_init(&rwlock) < 0) {
+        return EXIT_FAILURE;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench_config_t config;
+        bench_config_init(&config, "readers_writers");
+        int max_readers = argc > 2 ? atoi(argv[2]) : BENCH_MAX_READERS;
+        long run_ms = argc > 3 ? atol(argv[3]) : bench_scaled(&config, BENCH_RUN_MS);
+
+        if (max_readers < 1 || max_readers > BENCH_MAX_READERS || run_ms < 1) {
+            fprintf(stderr, "Usage: %s --bench [max readers 1-%d] [milliseconds per run]\n",
+                    argv[0], BENCH_MAX_READERS);
+            dist_rwlock_destroy(&rwlock);
+            return EXIT_FAILURE;
+        }
+        int result = run_bench(&config, max_readers, run_ms);
+        dist_rwlock_destroy(&rwlock);
+        return result;
+    }
     
     // Create reader threads
     pthread_t reader_threads[NUM_READERS];
@@ -191,6 +466,7 @@ int main(void) {
     }
     
     // Clean up
+    dist_rwlock_destroy(&rwlock);
     pthread_mutex_destroy(&mutex);
     pthread_cond_destroy(&reader_cond);
     pthread_cond_destroy(&writer_cond);
@@ -2,16 +2,22 @@
  * Custom Semaphore Implementation
  * 
  * This program demonstrates a custom implementation of counting semaphores
- * using POSIX signals for process synchronization. The implementation
- * includes proper process management, signal handling, and memory management.
+ * built on Linux futexes. The semaphore lives in shared memory, so the forked
+ * processes all operate on the same counter. An uncontended wait or signal is
+ * a single atomic operation; only a process that has to block enters the
+ * kernel, and a signal makes a wake-up call only when someone is sleeping.
  * 
  * Features:
  * - Counting semaphore implementation
  * - Process synchronization
- * - Signal-based wakeup mechanism
+ * - Futex-based wakeup mechanism
  * - Error handling
  * - Resource cleanup
  * - Performance monitoring
+ * - Benchmark against a process-shared sem_t, with sampled wait latency,
+ *   through the shared harness in bench.h
+ *
+ * Usage: semaphore_implementation [--bench [processes] [iterations]]
  */
 
 #include <stdio.h>
@@ -24,31 +30,68 @@
 #include <errno.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <time.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "bench.h"
 
 // Constants
-#define MAX_WAITING_PROCESSES 100
 #define INITIAL_SEM_VALUE 2
 #define MAX_PROCESSES 3
 #define WORK_TIME 2
 #define MAX_ITERATIONS 5
+#define BENCH_PROCESSES 4
+#define BENCH_MAX_PROCESSES 64
+#define BENCH_ITERATIONS 200000
+#define BENCH_SAMPLE_EVERY 64   // Wait/signal pairs between timed waits
 
 /**
  * @brief Custom semaphore structure
  * 
- * Implements a counting semaphore with a waiting list of processes.
- * Uses volatile qualifiers for variables that may be modified by signal handlers.
+ * Implements a counting semaphore on a futex word. The structure is mapped
+ * shared, so it is the same object in every forked process; all fields that
+ * change after initialization are atomic.
  */
 typedef struct {
-    volatile int val;           /**< Current value of the semaphore */
-    volatile int waiting_count; /**< Number of processes currently waiting */
-    pid_t* list;               /**< Array of waiting process IDs */
-    size_t list_capacity;      /**< Maximum capacity of the waiting list */
+    _Atomic int val;            /**< Current value of the semaphore, never negative */
+    _Atomic int waiting_count;  /**< Number of processes blocked in the kernel */
     struct timespec start_time; /**< Start time for performance monitoring */
-    unsigned long total_operations; /**< Total number of operations */
-    unsigned long total_wait_time; /**< Total wait time in nanoseconds */
+    _Atomic unsigned long total_operations; /**< Total number of operations */
+    _Atomic unsigned long total_wait_time;  /**< Total wait time in nanoseconds */
 } my_sem_t;
 
+/**
+ * @brief Semaphores compared by the benchmark
+ */
+typedef enum {
+    BENCH_FUTEX_SEM,            /**< The custom semaphore */
+    BENCH_POSIX_SEM             /**< Process-shared sem_t */
+} bench_kind_t;
+
+/**
+ * @brief Benchmark state shared with the forked processes
+ */
+typedef struct {
+    sem_t sem;                  /**< Process-shared POSIX semaphore */
+    long inside;                /**< Processes in the critical section */
+    long violations;            /**< Times more than one process was inside */
+    bench_histogram_t latency[BENCH_MAX_PROCESSES]; /**< Sampled waits, one per process */
+} bench_shared_t;
+
+/**
+ * @brief One benchmark configuration
+ */
+typedef struct {
+    bench_kind_t kind;
+    int processes;
+    long iterations;            /**< Wait/signal pairs per process */
+    bench_shared_t* shared;
+} bench_case_t;
+
 /** Global semaphore instance for the example */
 static my_sem_t* global_sem = NULL;
 static volatile sig_atomic_t running = 1;
@@ -66,48 +109,82 @@ static void signal_handler(int sig) {
 }
 
 /**
- * @brief Signal handler for waking up waiting processes
+ * @brief Block while a futex word still holds the expected value
+ * 
+ * Uses the shared (non-private) futex operations because the word is
+ * mapped into several processes.
+ * 
+ * @param addr Futex word
+ * @param expected Value the word must still have for the caller to sleep
+ * @return int 0 when woken, -1 with errno set otherwise (EAGAIN, EINTR)
+ */
+static int futex_wait(_Atomic int* addr, int expected) {
+    return (int)syscall(SYS_futex, addr, FUTEX_WAIT, expected, NULL, NULL, 0);
+}
+
+/**
+ * @brief Wake processes blocked on a futex word
  * 
- * Handles SIGUSR1 signals used to wake up processes that were
- * waiting on the semaphore.
+ * @param addr Futex word
+ * @param count Maximum number of processes to wake
+ */
+static void futex_wake(_Atomic int* addr, int count) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+/**
+ * @brief Allocate zeroed memory shared with forked children
  * 
- * @param signo The signal number received
+ * @param size Number of bytes
+ * @return void* The mapping, or NULL on error
  */
-static void wake_handler(int signo) {
-    if (signo == SIGUSR1) {
-        // Just wake up from pause()
-        return;
+static void* shared_alloc(size_t size) {
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        perror("Failed to map shared memory");
+        return NULL;
     }
+    return memory;
+}
+
+/**
+ * @brief Elapsed nanoseconds between two timestamps
+ * 
+ * @param start Earlier timestamp
+ * @param end Later timestamp
+ * @return unsigned long Nanoseconds
+ */
+static unsigned long elapsed_ns(const struct timespec* start, const struct timespec* end) {
+    return (unsigned long)((end->tv_sec - start->tv_sec) * 1000000000L +
+                           (end->tv_nsec - start->tv_nsec));
 }
 
 /**
  * @brief Initialize a new semaphore
  * 
- * Allocates and initializes a new semaphore structure with the given
- * initial value. Also allocates the waiting list.
+ * Maps and initializes a new semaphore structure with the given initial
+ * value. The mapping is shared, so children forked afterwards use the
+ * same semaphore.
  * 
  * @param initial_value The starting value for the semaphore
  * @return my_sem_t* Pointer to the new semaphore, or NULL on error
  */
 my_sem_t* custom_sem_init(int initial_value) {
-    my_sem_t* sem = malloc(sizeof(my_sem_t));
-    if (!sem) {
-        perror("Failed to allocate semaphore");
+    if (initial_value < 0) {
+        fprintf(stderr, "Invalid initial semaphore value\n");
         return NULL;
     }
 
-    sem->list = malloc(MAX_WAITING_PROCESSES * sizeof(pid_t));
-    if (!sem->list) {
-        perror("Failed to allocate waiting list");
-        free(sem);
+    my_sem_t* sem = shared_alloc(sizeof(my_sem_t));
+    if (!sem) {
         return NULL;
     }
 
-    sem->val = initial_value;
-    sem->waiting_count = 0;
-    sem->list_capacity = MAX_WAITING_PROCESSES;
-    sem->total_operations = 0;
-    sem->total_wait_time = 0;
+    atomic_init(&sem->val, initial_value);
+    atomic_init(&sem->waiting_count, 0);
+    atomic_init(&sem->total_operations, 0);
+    atomic_init(&sem->total_wait_time, 0);
     clock_gettime(CLOCK_MONOTONIC, &sem->start_time);
 
     return sem;
@@ -116,22 +193,42 @@ my_sem_t* custom_sem_init(int initial_value) {
 /**
  * @brief Clean up a semaphore
  * 
- * Frees all memory associated with the semaphore.
+ * Unmaps the semaphore. No process may still be using it.
  * 
  * @param sem Pointer to the semaphore to destroy
  */
 void custom_sem_destroy(my_sem_t* sem) {
     if (sem) {
-        free(sem->list);
-        free(sem);
+        munmap(sem, sizeof(my_sem_t));
+    }
+}
+
+/**
+ * @brief Try to take one unit without blocking
+ * 
+ * @param sem Pointer to the semaphore
+ * @return bool true if the value was decremented
+ */
+static bool custom_try_wait(my_sem_t* sem) {
+    int val = atomic_load_explicit(&sem->val, memory_order_relaxed);
+
+    while (val > 0) {
+        if (atomic_compare_exchange_weak_explicit(&sem->val, &val, val - 1,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed)) {
+            return true;
+        }
     }
+    return false;
 }
 
 /**
  * @brief Perform the wait (P) operation on a semaphore
  * 
- * Decrements the semaphore value and blocks if it becomes negative.
- * The calling process is added to the waiting list if it needs to block.
+ * Takes one unit with a compare-and-swap if the value is positive; the
+ * value never goes below 0. Otherwise the caller counts itself in
+ * waiting_count and sleeps in FUTEX_WAIT on the value word for as long
+ * as it is 0, retrying the compare-and-swap after every wake-up.
  * 
  * @param sem Pointer to the semaphore
  * @return bool true on success, false on error
@@ -142,37 +239,22 @@ bool custom_wait(my_sem_t* sem) {
         return false;
     }
 
-    struct timespec wait_start, wait_end;
-    clock_gettime(CLOCK_MONOTONIC, &wait_start);
-
-    sem->val--;
-
-    if (sem->val < 0) {
-        if (sem->waiting_count >= sem->list_capacity) {
-            fprintf(stderr, "Too many waiting processes\n");
-            sem->val++;
-            return false;
+    // Fast path: a unit is available, no system call
+    if (!custom_try_wait(sem)) {
+        // Register as a waiter before the final check, so a concurrent
+        // custom_signal either sees the waiter or leaves a unit behind
+        atomic_fetch_add(&sem->waiting_count, 1);
+        while (!custom_try_wait(sem)) {
+            // Sleeps only while the value is still 0
+            if (futex_wait(&sem->val, 0) == -1 && errno != EAGAIN && errno != EINTR) {
+                perror("futex wait failed");
+                atomic_fetch_sub(&sem->waiting_count, 1);
+                return false;
+            }
         }
-
-        pid_t calling_proc = getpid();
-        sem->list[sem->waiting_count++] = calling_proc;
-
-        // Wait for signal
-        sigset_t mask;
-        sigemptyset(&mask);
-        sigaddset(&mask, SIGUSR1);
-        
-        // Atomically unblock SIGUSR1 and wait for it
-        sigprocmask(SIG_UNBLOCK, &mask, NULL);
-        pause();
-        sigprocmask(SIG_BLOCK, &mask, NULL);
+        atomic_fetch_sub(&sem->waiting_count, 1);
     }
 
-    clock_gettime(CLOCK_MONOTONIC, &wait_end);
-    sem->total_wait_time += (wait_end.tv_sec - wait_start.tv_sec) * 1000000000 +
-                           (wait_end.tv_nsec - wait_start.tv_nsec);
-    sem->total_operations++;
-
     return true;
 }
 
@@ -190,19 +272,18 @@ bool custom_signal(my_sem_t* sem) {
         return false;
     }
 
-    sem->val++;
+    if (atomic_load_explicit(&sem->val, memory_order_relaxed) == INT_MAX) {
+        fprintf(stderr, "Semaphore value overflow\n");
+        return false;
+    }
 
-    if (sem->val <= 0 && sem->waiting_count > 0) {
-        sem->waiting_count--;
-        pid_t waken_proc = sem->list[sem->waiting_count];
+    atomic_fetch_add(&sem->val, 1);
 
-        if (kill(waken_proc, SIGUSR1) == -1) {
-            perror("Failed to wake process");
-            return false;
-        }
+    // Only enter the kernel when a process is actually sleeping
+    if (atomic_load(&sem->waiting_count) > 0) {
+        futex_wake(&sem->val, 1);
     }
 
-    sem->total_operations++;
     return true;
 }
 
@@ -222,12 +303,12 @@ void print_semaphore_stats(my_sem_t* sem) {
     
     printf("\nSemaphore Statistics:\n");
     printf("Total runtime: %.6f seconds\n", total_time);
-    printf("Total operations: %lu\n", sem->total_operations);
-    printf("Total wait time: %.6f seconds\n", sem->total_wait_time / 1e9);
+    printf("Total operations: %lu\n", atomic_load(&sem->total_operations));
+    printf("Total wait time: %.6f seconds\n", atomic_load(&sem->total_wait_time) / 1e9);
     printf("Average wait time: %.6f seconds\n",
-           (sem->total_wait_time / 1e9) / sem->total_operations);
+           (atomic_load(&sem->total_wait_time) / 1e9) / atomic_load(&sem->total_operations));
     printf("Operations per second: %.2f\n",
-           sem->total_operations / total_time);
+           atomic_load(&sem->total_operations) / total_time);
 }
 
 /**
@@ -238,22 +319,28 @@ void print_semaphore_stats(my_sem_t* sem) {
  * @param process_id The ID of the process
  */
 void process_function(int process_id) {
+    struct timespec wait_start, wait_end;
     int iterations = 0;
     
     while (running && iterations < MAX_ITERATIONS) {
         printf("Process %d (PID: %d) trying to acquire semaphore\n",
                process_id, getpid());
         
+        clock_gettime(CLOCK_MONOTONIC, &wait_start);
         if (custom_wait(global_sem)) {
+            clock_gettime(CLOCK_MONOTONIC, &wait_end);
+            atomic_fetch_add(&global_sem->total_wait_time, elapsed_ns(&wait_start, &wait_end));
+            atomic_fetch_add(&global_sem->total_operations, 1);
             printf("Process %d (PID: %d) acquired semaphore (value: %d)\n",
-                   process_id, getpid(), global_sem->val);
+                   process_id, getpid(), atomic_load(&global_sem->val));
             
             // Simulate some work
             sleep(WORK_TIME);
             
             if (custom_signal(global_sem)) {
+                atomic_fetch_add(&global_sem->total_operations, 1);
                 printf("Process %d (PID: %d) released semaphore (value: %d)\n",
-                       process_id, getpid(), global_sem->val);
+                       process_id, getpid(), atomic_load(&global_sem->val));
             }
         }
         
@@ -262,39 +349,187 @@ void process_function(int process_id) {
     }
 }
 
+/**
+ * @brief Benchmark process: use the semaphore as a lock
+ * 
+ * The semaphore starts at 1, so only one process may be in the critical
+ * section at a time; every BENCH_SAMPLE_EVERY-th wait is timed.
+ * 
+ * @param bench Benchmark configuration
+ * @param latency This process's histogram in the shared state
+ * @return int Exit status
+ */
+static int bench_process(const bench_case_t* bench, bench_histogram_t* latency) {
+    bench_shared_t* shared = bench->shared;
+
+    for (long i = 0; i < bench->iterations; i++) {
+        uint64_t start = i % BENCH_SAMPLE_EVERY == 0 ? bench_now_ns() : 0;
+
+        if (bench->kind == BENCH_FUTEX_SEM) {
+            if (!custom_wait(global_sem)) {
+                return EXIT_FAILURE;
+            }
+        } else {
+            while (sem_wait(&shared->sem) == -1) {
+                if (errno != EINTR) {
+                    perror("sem_wait failed");
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        if (start != 0) {
+            bench_histogram_add(latency, bench_now_ns() - start);
+        }
+
+        if (++shared->inside != 1) {
+            ++shared->violations;
+        }
+        --shared->inside;
+
+        if (bench->kind == BENCH_FUTEX_SEM) {
+            if (!custom_signal(global_sem)) {
+                return EXIT_FAILURE;
+            }
+        } else {
+            sem_post(&shared->sem);
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief One repetition: fork the processes and wait for them
+ * 
+ * @param arg Benchmark configuration
+ * @param latency Receives the sampled wait latencies
+ * @return long Wait/signal pairs, or -1 on error
+ */
+static long bench_repetition(void* arg, bench_histogram_t* latency) {
+    bench_case_t* bench = arg;
+    bench_shared_t* shared = bench->shared;
+    int started = 0;
+    bool failed = false;
+    int status;
+
+    shared->inside = 0;
+    shared->violations = 0;
+    for (int i = 0; i < bench->processes; i++) {
+        bench_histogram_init(&shared->latency[i]);
+    }
+
+    fflush(stdout);     // Children must not inherit buffered output
+    for (; started < bench->processes; started++) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("Fork failed");
+            failed = true;
+            break;
+        }
+        if (pid == 0) {
+            _exit(bench_process(bench, &shared->latency[started]));
+        }
+    }
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            failed = true;
+        }
+    }
+
+    for (int i = 0; i < started; i++) {
+        bench_histogram_merge(latency, &shared->latency[i]);
+    }
+    if (shared->violations) {
+        fprintf(stderr, "%ld critical section violations\n", shared->violations);
+        failed = true;
+    }
+    return failed ? -1 : (long)bench->processes * bench->iterations;
+}
+
+/**
+ * @brief Compare the futex semaphore with a process-shared sem_t
+ * 
+ * Both are used as a lock shared by several processes.
+ * 
+ * @param config Harness configuration
+ * @param processes Number of competing processes
+ * @param iterations Wait/signal pairs per process
+ * @return int Exit status
+ */
+static int run_bench(const bench_config_t* config, int processes, long iterations) {
+    bench_shared_t* shared = shared_alloc(sizeof(bench_shared_t));
+    int result = EXIT_FAILURE;
+    char name[64];
+
+    global_sem = custom_sem_init(1);
+    if (!shared || !global_sem) {
+        goto out;
+    }
+    if (sem_init(&shared->sem, 1, 1) == -1) {
+        perror("sem_init failed");
+        goto out;
+    }
+
+    result = EXIT_SUCCESS;
+    for (int kind = BENCH_FUTEX_SEM; kind <= BENCH_POSIX_SEM; kind++) {
+        bench_case_t bench = { (bench_kind_t)kind, processes, iterations, shared };
+
+        snprintf(name, sizeof(name), "%s/processes=%d",
+                 kind == BENCH_FUTEX_SEM ? "futex_sem" : "sem_t", processes);
+        if (bench_case(config, name, bench_repetition, &bench) != 0) {
+            result = EXIT_FAILURE;
+        }
+    }
+    sem_destroy(&shared->sem);
+
+out:
+    custom_sem_destroy(global_sem);
+    if (shared) {
+        munmap(shared, sizeof(bench_shared_t));
+    }
+    return result;
+}
+
 /**
  * @brief Main function demonstrating semaphore usage
  * 
  * Creates multiple child processes that compete for the semaphore.
  * Each process attempts to acquire the semaphore, performs some work,
- * and then releases it.
+ * and then releases it. With --bench, compares the semaphore against
+ * a process-shared sem_t instead.
  * 
+ * @param argc Argument count
+ * @param argv Argument vector
  * @return int Exit status (0 on success, 1 on error)
  */
-int main(void) {
+int main(int argc, char* argv[]) {
     // Set up signal handlers
-    struct sigaction sa;
-    sa.sa_handler = wake_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
-    
-    if (sigaction(SIGUSR1, &sa, NULL) == -1) {
-        perror("Failed to set up signal handler");
-        return EXIT_FAILURE;
-    }
-    
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench_config_t config;
+        bench_config_init(&config, "semaphore");
+        int processes = argc > 2 ? atoi(argv[2]) : BENCH_PROCESSES;
+        long iterations = argc > 3 ? atol(argv[3]) : bench_scaled(&config, BENCH_ITERATIONS);
+
+        if (processes < 1 || processes > BENCH_MAX_PROCESSES || iterations < 1) {
+            fprintf(stderr, "Usage: %s --bench [processes 1-%d] [iterations]\n",
+                    argv[0], BENCH_MAX_PROCESSES);
+            return EXIT_FAILURE;
+        }
+        return run_bench(&config, processes, iterations);
+    }
+
     // Initialize semaphore
     global_sem = custom_sem_init(INITIAL_SEM_VALUE);
     if (!global_sem) {
         return EXIT_FAILURE;
     }
 
-    printf("Initial semaphore value is %d\n", global_sem->val);
+    printf("Initial semaphore value is %d\n", atomic_load(&global_sem->val));
 
     // Create child processes
+    fflush(stdout);
     pid_t pids[MAX_PROCESSES];
     for (int i = 0; i < MAX_PROCESSES; i++) {
         pids[i] = fork();
@@ -4,6 +4,8 @@
  * This program tests the monitor implementation with various thread
  * priorities and operations. It verifies the correctness of the
  * priority inheritance mechanism and thread synchronization.
+ * Like monitor.c, waiters queue by priority (wait_queue.c) and exiting
+ * hands the monitor to exactly one of them.
  * 
  * Features:
  * - Priority inheritance testing
@@ -22,6 +24,8 @@
 #include <string.h>
 #include <signal.h>
 
+#include "wait_queue.h"
+
 // Constants
 #define NUM_TEST_THREADS 3
 #define TEST_OPERATION_TIME 1
@@ -41,7 +45,7 @@ typedef struct {
 // Test monitor structure
 typedef struct {
     pthread_mutex_t mutex;
-    pthread_cond_t cond;
+    wait_queue_t waiters;
     int current_priority;
     test_thread_data_t *current_thread;
     test_thread_data_t threads[NUM_TEST_THREADS];
@@ -67,8 +71,7 @@ static int test_monitor_init(void) {
         return -1;
     }
     
-    if (pthread_cond_init(&test_monitor.cond, NULL) != 0) {
-        perror("pthread_cond_init failed");
+    if (wait_queue_init(&test_monitor.waiters) != 0) {
         pthread_mutex_destroy(&test_monitor.mutex);
         return -1;
     }
@@ -84,24 +87,34 @@ static int test_monitor_init(void) {
 
 // Clean up test monitor resources
 static void test_monitor_cleanup(void) {
-    pthread_cond_destroy(&test_monitor.cond);
+    wait_queue_destroy(&test_monitor.waiters);
     pthread_mutex_destroy(&test_monitor.mutex);
 }
 
 // Enter test monitor
-static void test_monitor_enter(test_thread_data_t *thread) {
+static int test_monitor_enter(test_thread_data_t *thread) {
     pthread_mutex_lock(&test_monitor.mutex);
     
-    // Priority inheritance
-    if (test_monitor.current_thread != NULL && 
-        thread->priority > test_monitor.current_priority) {
-        test_monitor.current_priority = thread->priority;
-    }
-    
-    // Wait if higher priority thread is running
-    while (test_monitor.current_thread != NULL && 
-           thread->priority <= test_monitor.current_priority) {
-        pthread_cond_wait(&test_monitor.cond, &test_monitor.mutex);
+    // Wait if another thread is inside or threads are queued ahead of us
+    if (test_monitor.current_thread != NULL || wait_queue_peek(&test_monitor.waiters) != NULL) {
+        wait_node_t node;
+        
+        // Priority inheritance
+        if (thread->priority > test_monitor.current_priority) {
+            test_monitor.current_priority = thread->priority;
+        }
+        
+        if (wait_node_init(&node, thread->priority, thread) != 0 ||
+            wait_queue_push(&test_monitor.waiters, &node) != 0) {
+            pthread_mutex_unlock(&test_monitor.mutex);
+            return -1;
+        }
+        
+        // Sleep until test_monitor_exit hands the monitor to us
+        while (!node.granted) {
+            pthread_cond_wait(&node.cond, &test_monitor.mutex);
+        }
+        wait_node_destroy(&node);
     }
     
     // Enter monitor
@@ -109,18 +122,25 @@ static void test_monitor_enter(test_thread_data_t *thread) {
     test_monitor.current_priority = thread->priority;
     
     pthread_mutex_unlock(&test_monitor.mutex);
+    return 0;
 }
 
 // Exit test monitor
 static void test_monitor_exit(test_thread_data_t *thread) {
+    (void)thread;
     pthread_mutex_lock(&test_monitor.mutex);
     
-    // Exit monitor
-    test_monitor.current_thread = NULL;
-    test_monitor.current_priority = 0;
-    
-    // Signal waiting threads
-    pthread_cond_broadcast(&test_monitor.cond);
+    // Hand the monitor to the highest-priority waiter and wake only it
+    wait_node_t *next = wait_queue_pop(&test_monitor.waiters);
+    if (next != NULL) {
+        test_monitor.current_thread = next->owner;
+        test_monitor.current_priority = next->priority;
+        next->granted = 1;
+        pthread_cond_signal(&next->cond);
+    } else {
+        test_monitor.current_thread = NULL;
+        test_monitor.current_priority = 0;
+    }
     
     pthread_mutex_unlock(&test_monitor.mutex);
 }
@@ -143,8 +163,14 @@ static void *test_thread_function(void *arg) {
     
     while (running && thread->operations < TEST_MAX_OPERATIONS) {
         // Enter monitor
-        test_monitor_enter(thread);
-        if (!running) break;
+        if (test_monitor_enter(thread) != 0) {
+            thread->errors++;
+            break;
+        }
+        if (!running) {
+            test_monitor_exit(thread);
+            break;
+        }
         
         // Perform test operation
         printf("Test thread %d (priority %d) performing operation %d/%d\n",
@@ -0,0 +1,119 @@
+/**
+ * Priority Wait Queue Implementation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "wait_queue.h"
+
+// Check whether waiter a should be served before waiter b
+static int wait_node_before(const wait_node_t *a, const wait_node_t *b) {
+    if (a->priority != b->priority) {
+        return a->priority > b->priority;
+    }
+    return a->sequence < b->sequence;
+}
+
+int wait_queue_init(wait_queue_t *queue) {
+    queue->heap = malloc(WAIT_QUEUE_INITIAL_CAPACITY * sizeof(*queue->heap));
+    if (!queue->heap) {
+        perror("Failed to allocate wait queue");
+        return -1;
+    }
+    queue->count = 0;
+    queue->capacity = WAIT_QUEUE_INITIAL_CAPACITY;
+    queue->next_sequence = 0;
+    return 0;
+}
+
+void wait_queue_destroy(wait_queue_t *queue) {
+    free(queue->heap);
+    queue->heap = NULL;
+    queue->count = 0;
+    queue->capacity = 0;
+}
+
+int wait_node_init(wait_node_t *node, int priority, void *owner) {
+    if (pthread_cond_init(&node->cond, NULL) != 0) {
+        perror("pthread_cond_init failed");
+        return -1;
+    }
+    node->priority = priority;
+    node->sequence = 0;
+    node->granted = 0;
+    node->owner = owner;
+    return 0;
+}
+
+void wait_node_destroy(wait_node_t *node) {
+    pthread_cond_destroy(&node->cond);
+}
+
+int wait_queue_push(wait_queue_t *queue, wait_node_t *node) {
+    size_t i;
+
+    if (queue->count == queue->capacity) {
+        wait_node_t **heap = realloc(queue->heap, 2 * queue->capacity * sizeof(*heap));
+        if (!heap) {
+            perror("Failed to grow wait queue");
+            return -1;
+        }
+        queue->heap = heap;
+        queue->capacity *= 2;
+    }
+
+    node->sequence = queue->next_sequence++;
+    node->granted = 0;
+
+    // Sift up
+    i = queue->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!wait_node_before(node, queue->heap[parent])) {
+            break;
+        }
+        queue->heap[i] = queue->heap[parent];
+        i = parent;
+    }
+    queue->heap[i] = node;
+    return 0;
+}
+
+wait_node_t *wait_queue_pop(wait_queue_t *queue) {
+    wait_node_t *top;
+    wait_node_t *last;
+    size_t i = 0;
+
+    if (queue->count == 0) {
+        return NULL;
+    }
+
+    top = queue->heap[0];
+    last = queue->heap[--queue->count];
+
+    // Sift the last waiter down from the root
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= queue->count) {
+            break;
+        }
+        if (child + 1 < queue->count &&
+            wait_node_before(queue->heap[child + 1], queue->heap[child])) {
+            child++;
+        }
+        if (!wait_node_before(queue->heap[child], last)) {
+            break;
+        }
+        queue->heap[i] = queue->heap[child];
+        i = child;
+    }
+    if (queue->count > 0) {
+        queue->heap[i] = last;
+    }
+    return top;
+}
+
+wait_node_t *wait_queue_peek(const wait_queue_t *queue) {
+    return queue->count > 0 ? queue->heap[0] : NULL;
+}
@@ -0,0 +1,88 @@
+/**
+ * Priority Wait Queue Interface
+ *
+ * Waiters ordered by priority in a binary heap, for monitors that hand the
+ * monitor directly to the next eligible thread instead of broadcasting:
+ * - Each waiter has its own condition variable, so a wakeup reaches exactly
+ *   one thread
+ * - Push and pop are O(log n); equal priorities are served in arrival order
+ * - The queue is protected by the caller's monitor mutex
+ */
+
+#ifndef WAIT_QUEUE_H
+#define WAIT_QUEUE_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Constants
+#define WAIT_QUEUE_INITIAL_CAPACITY 16
+
+// A waiting thread; lives on the waiter's stack while it waits
+typedef struct {
+    pthread_cond_t cond;
+    int priority;           // Higher is served first
+    unsigned long sequence; // Arrival order among equal priorities
+    int granted;            // Set by the thread that hands over the monitor
+    void *owner;            // Caller data, e.g. the waiting thread's record
+} wait_node_t;
+
+// Heap of waiters, highest priority at index 0
+typedef struct {
+    wait_node_t **heap;
+    size_t count;
+    size_t capacity;
+    unsigned long next_sequence;
+} wait_queue_t;
+
+/**
+ * Initialize a wait queue
+ * @param queue Queue to initialize
+ * @return 0 on success, -1 on error
+ */
+int wait_queue_init(wait_queue_t *queue);
+
+/**
+ * Free a wait queue; it must be empty
+ * @param queue Queue to free
+ */
+void wait_queue_destroy(wait_queue_t *queue);
+
+/**
+ * Initialize a waiter
+ * @param node Waiter to initialize
+ * @param priority Waiter priority
+ * @param owner Caller data stored in the node
+ * @return 0 on success, -1 on error
+ */
+int wait_node_init(wait_node_t *node, int priority, void *owner);
+
+/**
+ * Free a waiter's resources
+ * @param node Waiter to free
+ */
+void wait_node_destroy(wait_node_t *node);
+
+/**
+ * Add a waiter, growing the heap if needed
+ * @param queue Wait queue
+ * @param node Waiter to add
+ * @return 0 on success, -1 on error
+ */
+int wait_queue_push(wait_queue_t *queue, wait_node_t *node);
+
+/**
+ * Remove the highest-priority waiter
+ * @param queue Wait queue
+ * @return Removed waiter, NULL if the queue is empty
+ */
+wait_node_t *wait_queue_pop(wait_queue_t *queue);
+
+/**
+ * Get the highest-priority waiter without removing it
+ * @param queue Wait queue
+ * @return Highest-priority waiter, NULL if the queue is empty
+ */
+wait_node_t *wait_queue_peek(const wait_queue_t *queue);
+
+#endif // WAIT_QUEUE_H
@@ -0,0 +1,398 @@
+/**
+ * Arbitrary-Precision Integer Implementation
+ *
+ * Limb-array routines work on raw uint64_t arrays with explicit lengths;
+ * the bigint_t functions manage allocation and normalization around them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bigint.h"
+
+// Constants
+#define DECIMAL_CHUNK 10000000000000000000ULL  // 10^19, the largest power of ten in a limb
+#define DECIMAL_CHUNK_DIGITS 19
+
+typedef unsigned __int128 uint128_t;
+
+// Sub-product run on a helper thread
+typedef struct {
+    uint64_t *r;
+    const uint64_t *a;
+    size_t an;
+    const uint64_t *b;
+    size_t bn;
+    int threads;
+    int status;
+} mul_job_t;
+
+static int mul_limbs(uint64_t *r, const uint64_t *a, size_t an,
+                     const uint64_t *b, size_t bn, int threads);
+
+// r[0..an+bn) = a * b, schoolbook
+static void mul_basecase(uint64_t *r, const uint64_t *a, size_t an,
+                         const uint64_t *b, size_t bn) {
+    memset(r, 0, (an + bn) * sizeof(*r));
+    for (size_t i = 0; i < bn; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < an; j++) {
+            uint128_t t = (uint128_t)a[j] * b[i] + r[i + j] + carry;
+            r[i + j] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+        }
+        r[i + an] = carry;
+    }
+}
+
+// r[0..an) = a + b with an >= bn; returns the carry out
+static uint64_t add_limbs(uint64_t *r, const uint64_t *a, size_t an,
+                          const uint64_t *b, size_t bn) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < an; i++) {
+        uint128_t t = (uint128_t)a[i] + (i < bn ? b[i] : 0) + carry;
+        r[i] = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    return carry;
+}
+
+// r[0..rn) += x[0..xn), xn <= rn; the sum must fit in rn limbs
+static void add_into(uint64_t *r, size_t rn, const uint64_t *x, size_t xn) {
+    uint64_t carry = 0;
+    size_t i;
+    for (i = 0; i < xn; i++) {
+        uint128_t t = (uint128_t)r[i] + x[i] + carry;
+        r[i] = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    for (; carry && i < rn; i++) {
+        carry = ++r[i] == 0;
+    }
+}
+
+// r[0..rn) -= x[0..xn), xn <= rn; the difference must not be negative
+static void sub_from(uint64_t *r, size_t rn, const uint64_t *x, size_t xn) {
+    uint64_t borrow = 0;
+    size_t i;
+    for (i = 0; i < xn; i++) {
+        uint64_t d = r[i] - x[i];
+        uint64_t next = (r[i] < x[i]) || (d < borrow);
+        r[i] = d - borrow;
+        borrow = next;
+    }
+    for (; borrow && i < rn; i++) {
+        borrow = r[i]-- == 0;
+    }
+}
+
+// Helper thread body for one sub-product
+static void *mul_job_thread(void *arg) {
+    mul_job_t *job = arg;
+    job->status = mul_limbs(job->r, job->a, job->an, job->b, job->bn, job->threads);
+    return NULL;
+}
+
+// Start a sub-product on a new thread, or run it here if that fails
+static int mul_job_start(mul_job_t *job, pthread_t *tid) {
+    if (pthread_create(tid, NULL, mul_job_thread, job) != 0) {
+        mul_job_thread(job);
+        return 0;
+    }
+    return 1;
+}
+
+// Multiply the long operand piece by piece when it is much longer than b
+static int mul_unbalanced(uint64_t *r, const uint64_t *a, size_t an,
+                          const uint64_t *b, size_t bn, int threads) {
+    uint64_t *piece = malloc(2 * bn * sizeof(*piece));
+    if (!piece) {
+        perror("Failed to allocate product");
+        return -1;
+    }
+
+    memset(r, 0, (an + bn) * sizeof(*r));
+    for (size_t offset = 0; offset < an; offset += bn) {
+        size_t len = an - offset < bn ? an - offset : bn;
+        if (mul_limbs(piece, a + offset, len, b, bn, threads) != 0) {
+            free(piece);
+            return -1;
+        }
+        add_into(r + offset, an + bn - offset, piece, len + bn);
+    }
+    free(piece);
+    return 0;
+}
+
+/**
+ * r[0..an+bn) = a * b; r must not overlap a or b
+ *
+ * Karatsuba with a = a1 B^m + a0 and b = b1 B^m + b0:
+ * a b = z2 B^2m + (z1 - z2 - z0) B^m + z0, where z0 = a0 b0, z2 = a1 b1
+ * and z1 = (a0 + a1)(b0 + b1). z0 and z2 are computed straight into the
+ * low and high halves of r; with spare threads they run concurrently.
+ */
+static int mul_limbs(uint64_t *r, const uint64_t *a, size_t an,
+                     const uint64_t *b, size_t bn, int threads) {
+    if (an < bn) {
+        const uint64_t *t = a;
+        a = b;
+        b = t;
+        size_t tn = an;
+        an = bn;
+        bn = tn;
+    }
+    if (bn == 0) {
+        memset(r, 0, an * sizeof(*r));
+        return 0;
+    }
+    if (bn < BIGINT_KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, an, b, bn);
+        return 0;
+    }
+
+    size_t m = (an + 1) / 2;
+    if (bn <= m) {
+        return mul_unbalanced(r, a, an, b, bn, threads);
+    }
+
+    uint64_t *scratch = malloc((4 * m + 4) * sizeof(*scratch));
+    if (!scratch) {
+        perror("Failed to allocate product");
+        return -1;
+    }
+    uint64_t *sa = scratch;             // a0 + a1, m + 1 limbs
+    uint64_t *sb = scratch + m + 1;     // b0 + b1, m + 1 limbs
+    uint64_t *z1 = scratch + 2 * m + 2; // 2m + 2 limbs
+    size_t high = an + bn - 2 * m;      // Limbs of z2
+
+    sa[m] = add_limbs(sa, a, m, a + m, an - m);
+    sb[m] = add_limbs(sb, b, m, b + m, bn - m);
+
+    // Split the threads between the three sub-products
+    int share = threads >= 3 ? threads / 3 : 1;
+    int middle_threads = threads >= 3 ? threads - 2 * share : 1;
+    mul_job_t low_job = { r, a, m, b, m, share, 0 };
+    mul_job_t high_job = { r + 2 * m, a + m, an - m, b + m, bn - m, share, 0 };
+    pthread_t low_tid, high_tid;
+    int low_started = 0, high_started = 0;
+    int status;
+
+    if (threads >= 2) {
+        low_started = mul_job_start(&low_job, &low_tid);
+    } else {
+        mul_job_thread(&low_job);
+    }
+    if (threads >= 3) {
+        high_started = mul_job_start(&high_job, &high_tid);
+    } else {
+        mul_job_thread(&high_job);
+    }
+    status = mul_limbs(z1, sa, m + 1, sb, m + 1, middle_threads);
+    if (low_started) {
+        pthread_join(low_tid, NULL);
+    }
+    if (high_started) {
+        pthread_join(high_tid, NULL);
+    }
+    if (status != 0 || low_job.status != 0 || high_job.status != 0) {
+        free(scratch);
+        return -1;
+    }
+
+    // z1 - z0 - z2 is the middle term; it fits in the limbs above B^m
+    sub_from(z1, 2 * m + 2, r, 2 * m);
+    sub_from(z1, 2 * m + 2, r + 2 * m, high);
+    size_t middle = an + bn - m;
+    add_into(r + m, middle, z1, 2 * m + 2 < middle ? 2 * m + 2 : middle);
+
+    free(scratch);
+    return 0;
+}
+
+// Make room for at least n limbs
+static int bigint_reserve(bigint_t *x, size_t n) {
+    if (n <= x->capacity) {
+        return 0;
+    }
+    size_t capacity = x->capacity ? x->capacity : 1;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    uint64_t *limbs = realloc(x->limbs, capacity * sizeof(*limbs));
+    if (!limbs) {
+        perror("Failed to allocate integer");
+        return -1;
+    }
+    x->limbs = limbs;
+    x->capacity = capacity;
+    return 0;
+}
+
+// Drop leading zero limbs
+static void bigint_normalize(bigint_t *x) {
+    while (x->size > 0 && x->limbs[x->size - 1] == 0) {
+        x->size--;
+    }
+}
+
+int bigint_init(bigint_t *x, uint64_t value) {
+    x->limbs = NULL;
+    x->size = 0;
+    x->capacity = 0;
+    if (bigint_reserve(x, 1) != 0) {
+        return -1;
+    }
+    x->limbs[0] = value;
+    x->size = value != 0;
+    return 0;
+}
+
+void bigint_free(bigint_t *x) {
+    free(x->limbs);
+    x->limbs = NULL;
+    x->size = 0;
+    x->capacity = 0;
+}
+
+int bigint_add(bigint_t *r, const bigint_t *a, const bigint_t *b) {
+    if (a->size < b->size) {
+        const bigint_t *t = a;
+        a = b;
+        b = t;
+    }
+    size_t an = a->size;
+    size_t bn = b->size;
+    if (bigint_reserve(r, an + 1) != 0) {
+        return -1;
+    }
+
+    // Limb i of the result depends only on limb i of the inputs, so the
+    // result may share storage with either one
+    uint64_t carry = add_limbs(r->limbs, a->limbs, an, b->limbs, bn);
+    r->limbs[an] = carry;
+    r->size = an + 1;
+    bigint_normalize(r);
+    return 0;
+}
+
+int bigint_sub(bigint_t *r, const bigint_t *a, const bigint_t *b) {
+    size_t an = a->size;
+    size_t bn = b->size;
+    uint64_t borrow = 0;
+
+    if (bigint_reserve(r, an) != 0) {
+        return -1;
+    }
+    // Limb by limb, so the result may share storage with either input
+    for (size_t i = 0; i < an; i++) {
+        uint64_t x = a->limbs[i];
+        uint64_t y = i < bn ? b->limbs[i] : 0;
+        uint64_t d = x - y;
+        uint64_t next = (x < y) || (d < borrow);
+        r->limbs[i] = d - borrow;
+        borrow = next;
+    }
+    r->size = an;
+    bigint_normalize(r);
+    return 0;
+}
+
+int bigint_mul_small(bigint_t *x, uint64_t m) {
+    uint64_t carry = 0;
+
+    for (size_t i = 0; i < x->size; i++) {
+        uint128_t t = (uint128_t)x->limbs[i] * m + carry;
+        x->limbs[i] = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    if (carry) {
+        if (bigint_reserve(x, x->size + 1) != 0) {
+            return -1;
+        }
+        x->limbs[x->size++] = carry;
+    }
+    bigint_normalize(x);
+    return 0;
+}
+
+int bigint_mul(bigint_t *r, const bigint_t *a, const bigint_t *b, int threads) {
+    if (a->size == 0 || b->size == 0) {
+        r->size = 0;
+        return 0;
+    }
+    if (bigint_reserve(r, a->size + b->size) != 0) {
+        return -1;
+    }
+    if (mul_limbs(r->limbs, a->limbs, a->size, b->limbs, b->size,
+                  threads > 0 ? threads : 1) != 0) {
+        return -1;
+    }
+    r->size = a->size + b->size;
+    bigint_normalize(r);
+    return 0;
+}
+
+uint64_t bigint_mod_small(const bigint_t *x, uint64_t m) {
+    uint128_t rem = 0;
+    for (size_t i = x->size; i-- > 0;) {
+        rem = ((rem << 64) | x->limbs[i]) % m;
+    }
+    return (uint64_t)rem;
+}
+
+size_t bigint_bits(const bigint_t *x) {
+    if (x->size == 0) {
+        return 0;
+    }
+    return x->size * 64 - (size_t)__builtin_clzll(x->limbs[x->size - 1]);
+}
+
+char *bigint_to_string(const bigint_t *x) {
+    size_t size = x->size;
+    size_t chunks = 0;
+    uint64_t *work = malloc((size ? size : 1) * sizeof(*work));
+    uint64_t *digits = malloc((size * 64 / 63 + 1) * sizeof(*digits));
+    char *out = NULL;
+
+    if (!work || !digits) {
+        perror("Failed to allocate conversion buffer");
+        goto out;
+    }
+    memcpy(work, x->limbs, size * sizeof(*work));
+
+    // Peel off 19 decimal digits at a time, least significant first
+    while (size > 0) {
+        uint128_t rem = 0;
+        for (size_t i = size; i-- > 0;) {
+            uint128_t cur = (rem << 64) | work[i];
+            work[i] = (uint64_t)(cur / DECIMAL_CHUNK);
+            rem = cur % DECIMAL_CHUNK;
+        }
+        digits[chunks++] = (uint64_t)rem;
+        while (size > 0 && work[size - 1] == 0) {
+            size--;
+        }
+    }
+
+    out = malloc(chunks * DECIMAL_CHUNK_DIGITS + 2);
+    if (!out) {
+        perror("Failed to allocate string");
+        goto out;
+    }
+    if (chunks == 0) {
+        strcpy(out, "0");
+        goto out;
+    }
+    char *p = out + sprintf(out, "%llu", (unsigned long long)digits[chunks - 1]);
+    for (size_t i = chunks - 1; i-- > 0;) {
+        p += sprintf(p, "%0*llu", DECIMAL_CHUNK_DIGITS, (unsigned long long)digits[i]);
+    }
+
+out:
+    free(digits);
+    free(work);
+    return out;
+}
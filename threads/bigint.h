@@ -0,0 +1,104 @@
+/**
+ * Arbitrary-Precision Integer Interface
+ *
+ * Non-negative integers of any size, stored as 64-bit limbs with the least
+ * significant limb first. Features include:
+ * - Schoolbook multiplication for small operands and Karatsuba above
+ *   BIGINT_KARATSUBA_THRESHOLD limbs
+ * - Parallel multiplication: the top levels of the Karatsuba recursion run
+ *   their three sub-products on separate threads
+ * - Addition, subtraction, multiplication by a single word and remainder
+ *   by a single word
+ * - Decimal conversion
+ */
+
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Constants
+#define BIGINT_KARATSUBA_THRESHOLD 32   // Limbs below which schoolbook is faster
+
+// Non-negative integer; size 0 is zero
+typedef struct {
+    uint64_t *limbs;
+    size_t size;        // Limbs in use, no leading zero limbs
+    size_t capacity;    // Limbs allocated
+} bigint_t;
+
+/**
+ * Initialize an integer to a small value
+ * @param x Integer to initialize
+ * @param value Initial value
+ * @return 0 on success, -1 on error
+ */
+int bigint_init(bigint_t *x, uint64_t value);
+
+/**
+ * Free an integer's limbs
+ * @param x Integer to free
+ */
+void bigint_free(bigint_t *x);
+
+/**
+ * Add two integers
+ * @param r Sum; may be a or b
+ * @param a First term
+ * @param b Second term
+ * @return 0 on success, -1 on error
+ */
+int bigint_add(bigint_t *r, const bigint_t *a, const bigint_t *b);
+
+/**
+ * Subtract two integers
+ * @param r Difference; may be a or b
+ * @param a Minuend
+ * @param b Subtrahend, at most a
+ * @return 0 on success, -1 on error
+ */
+int bigint_sub(bigint_t *r, const bigint_t *a, const bigint_t *b);
+
+/**
+ * Multiply an integer by a word in place
+ * @param x Integer to multiply
+ * @param m Multiplier
+ * @return 0 on success, -1 on error
+ */
+int bigint_mul_small(bigint_t *x, uint64_t m);
+
+/**
+ * Multiply two integers
+ * @param r Product; must not be a or b, and its old value is discarded
+ * @param a First factor
+ * @param b Second factor
+ * @param threads Threads to use, at most; 1 multiplies on the calling thread
+ * @return 0 on success, -1 on error
+ */
+int bigint_mul(bigint_t *r, const bigint_t *a, const bigint_t *b, int threads);
+
+/**
+ * Remainder of division by a word
+ * @param x Dividend
+ * @param m Divisor, not 0
+ * @return x mod m
+ */
+uint64_t bigint_mod_small(const bigint_t *x, uint64_t m);
+
+/**
+ * Number of significant bits
+ * @param x Integer
+ * @return Bit length, 0 for zero
+ */
+size_t bigint_bits(const bigint_t *x);
+
+/**
+ * Convert an integer to decimal; quadratic in the size, so meant for
+ * numbers up to some hundred thousand digits
+ * @param x Integer to convert
+ * @return Newly allocated string, NULL on error
+ */
+char *bigint_to_string(const bigint_t *x);
+
+#endif // BIGINT_H
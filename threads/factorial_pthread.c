@@ -7,17 +7,37 @@
  * - Thread-safe operations
  * - Dynamic thread management
  * - Error handling and resource cleanup
+ * - Arbitrary precision past 20!: a binary-splitting product tree whose
+ *   halves are computed on separate threads and joined with the parallel
+ *   Karatsuba multiplication in bigint.c
+ *
+ * Usage: factorial_pthread                        (prompts for n)
+ *        factorial_pthread --big N [threads]
+ *        factorial_pthread --bench [N] [max threads]
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <string.h>
 #include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bigint.h"
 
 // Constants
 #define MAX_THREADS 4
 #define CHUNK_SIZE 1000
+#define MAX_WORD_FACTORIAL 20               // Largest n with n! in 64 bits
+#define MAX_BIG_FACTORIAL 100000000
+#define FACTORIAL_LEAF 256                  // Numbers multiplied word by word per leaf
+#define FACTORIAL_PRINT_MAX 20000           // Largest n printed in full
+#define FACTORIAL_CHECK_PRIME 2305843009213693951ULL   // 2^61 - 1, checks big results
+#define DEFAULT_BENCH_N 1000000
+#define BASELINE_MAX_N 100000               // Largest n for the one-by-one baseline
 
 // Structure to hold thread data
 typedef struct {
@@ -26,6 +46,15 @@ typedef struct {
     unsigned long long result;
 } thread_data_t;
 
+// Product of lo..hi, computed on up to threads threads
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+    int threads;
+    bigint_t result;
+    int status;
+} product_job_t;
+
 // Global variables
 static pthread_mutex_t result_mutex = PTHREAD_MUTEX_INITIALIZER;
 static unsigned long long final_result = 1;
@@ -71,6 +100,11 @@ unsigned long long calculate_factorial(int n) {
         return 0;
     }
 
+    if (n > MAX_WORD_FACTORIAL) {
+        fprintf(stderr, "Error: %d! does not fit in 64 bits\n", n);
+        return 0;
+    }
+
     if (n == 0 || n == 1) {
         return 1;
     }
@@ -110,13 +144,280 @@ unsigned long long calculate_factorial(int n) {
     return final_result;
 }
 
+// Time difference in seconds
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int range_product(bigint_t *r, uint64_t lo, uint64_t hi, int threads);
+
+// Thread body for one half of the product tree
+static void *product_thread(void *arg) {
+    product_job_t *job = (product_job_t *)arg;
+    job->status = range_product(&job->result, job->lo, job->hi, job->threads);
+    return NULL;
+}
+
+/**
+ * Multiply lo..hi by binary splitting, so both factors of every
+ * multiplication have about the same size and Karatsuba pays off
+ * @param r Product; initialized by this function
+ * @param lo First factor
+ * @param hi Last factor, at least lo - 1 (an empty range gives 1)
+ * @param threads Threads to use, at most
+ * @return 0 on success, -1 on error
+ */
+static int range_product(bigint_t *r, uint64_t lo, uint64_t hi, int threads) {
+    if (hi < lo || hi - lo < FACTORIAL_LEAF) {
+        uint64_t word = 1;
+
+        // Pack as many factors as fit into one word before touching r
+        if (bigint_init(r, 1) != 0) {
+            return -1;
+        }
+        for (uint64_t i = lo; i <= hi; i++) {
+            if (word > UINT64_MAX / i) {
+                if (bigint_mul_small(r, word) != 0) {
+                    bigint_free(r);
+                    return -1;
+                }
+                word = 1;
+            }
+            word *= i;
+        }
+        if (bigint_mul_small(r, word) != 0) {
+            bigint_free(r);
+            return -1;
+        }
+        return 0;
+    }
+
+    uint64_t mid = lo + (hi - lo) / 2;
+    product_job_t left = { lo, mid, threads / 2 ? threads / 2 : 1, { NULL, 0, 0 }, 0 };
+    product_job_t right = { mid + 1, hi, threads - threads / 2, { NULL, 0, 0 }, 0 };
+    pthread_t tid;
+    int started = 0;
+
+    if (threads >= 2 && pthread_create(&tid, NULL, product_thread, &left) == 0) {
+        started = 1;
+    } else {
+        product_thread(&left);
+    }
+    product_thread(&right);
+    if (started) {
+        pthread_join(tid, NULL);
+    }
+
+    int status = -1;
+    if (left.status == 0 && right.status == 0 && bigint_init(r, 0) == 0) {
+        status = bigint_mul(r, &left.result, &right.result, threads);
+        if (status != 0) {
+            bigint_free(r);
+        }
+    }
+    if (left.status == 0) {
+        bigint_free(&left.result);
+    }
+    if (right.status == 0) {
+        bigint_free(&right.result);
+    }
+    return status;
+}
+
+/**
+ * Calculate n! to full precision
+ * @param r Result; initialized by this function
+ * @param n Number to calculate factorial of
+ * @param threads Threads to use, at most
+ * @return 0 on success, -1 on error
+ */
+int calculate_big_factorial(bigint_t *r, uint64_t n, int threads) {
+    return range_product(r, 2, n, threads);
+}
+
+// Baseline: multiply 2, 3, ..., n into the result one at a time
+static int linear_factorial(bigint_t *r, uint64_t n) {
+    if (bigint_init(r, 1) != 0) {
+        return -1;
+    }
+    for (uint64_t i = 2; i <= n; i++) {
+        if (bigint_mul_small(r, i) != 0) {
+            bigint_free(r);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// n! mod FACTORIAL_CHECK_PRIME computed directly
+static uint64_t factorial_mod_check(uint64_t n) {
+    unsigned __int128 acc = 1;
+    for (uint64_t i = 2; i <= n; i++) {
+        acc = acc * i % FACTORIAL_CHECK_PRIME;
+    }
+    return (uint64_t)acc;
+}
+
+// Check a big result against the directly computed residue
+static int verify_factorial(const bigint_t *r, uint64_t n) {
+    if (bigint_mod_small(r, FACTORIAL_CHECK_PRIME) != factorial_mod_check(n)) {
+        fprintf(stderr, "Error: %llu! failed the residue check\n", (unsigned long long)n);
+        return -1;
+    }
+    return 0;
+}
+
+// Print a big factorial: in full when short enough, summarized otherwise
+static int print_big_factorial(const bigint_t *r, uint64_t n) {
+    if (n <= FACTORIAL_PRINT_MAX) {
+        char *digits = bigint_to_string(r);
+        if (!digits) {
+            return -1;
+        }
+        printf("Factorial of %llu is %s\n", (unsigned long long)n, digits);
+        free(digits);
+        return 0;
+    }
+
+    // log10(n!) from lgamma gives the length and the leading digits
+    long double log10_value = lgammal((long double)n + 1) / logl(10.0L);
+    long double whole = floorl(log10_value);
+    long double leading = powl(10.0L, log10_value - whole + 9);
+    uint64_t zeros = 0;
+
+    // Legendre's formula: each power of 5 in n! makes one trailing zero
+    for (uint64_t p = 5; p <= n; p *= 5) {
+        zeros += n / p;
+        if (p > UINT64_MAX / 5) {
+            break;
+        }
+    }
+    printf("Factorial of %llu: %.0Lf digits, %zu bits, starts %.0Lf..., "
+           "ends in %llu zeros\n", (unsigned long long)n, whole + 1, bigint_bits(r),
+           floorl(leading), (unsigned long long)zeros);
+    return 0;
+}
+
+// Number of threads to use when none is given
+static int default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+// Parse n for the big modes
+static int parse_big_n(const char *arg, uint64_t *n) {
+    char *end;
+    unsigned long long value = strtoull(arg, &end, 10);
+    if (*end != '\0' || value > MAX_BIG_FACTORIAL) {
+        fprintf(stderr, "Error: n must be between 0 and %d\n", MAX_BIG_FACTORIAL);
+        return -1;
+    }
+    *n = value;
+    return 0;
+}
+
+// --big: compute, verify and print one factorial
+static int run_big(uint64_t n, int threads) {
+    struct timespec start, end;
+    bigint_t result;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (calculate_big_factorial(&result, n, threads) != 0) {
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    int status = verify_factorial(&result, n) == 0 && print_big_factorial(&result, n) == 0;
+    if (status) {
+        printf("Calculated in %.3f seconds on %d threads\n",
+               elapsed_seconds(&start, &end), threads);
+    }
+    bigint_free(&result);
+    return status ? 0 : 1;
+}
+
+// --bench: product tree at increasing thread counts, plus the linear baseline
+static int run_bench(uint64_t n, int max_threads) {
+    struct timespec start, end;
+    bigint_t result;
+    uint64_t baseline_n = n < BASELINE_MAX_N ? n : BASELINE_MAX_N;
+    double single = 0;
+
+    printf("Factorial of %llu\n", (unsigned long long)n);
+    // Powers of two below max_threads, then max_threads itself
+    for (int threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (calculate_big_factorial(&result, n, threads) != 0) {
+            return 1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsed_seconds(&start, &end);
+        if (threads == 1) {
+            single = seconds;
+        }
+        int ok = verify_factorial(&result, n) == 0;
+        printf("product tree, %2d threads: %8.3f s (speedup %.2fx), %zu bits\n",
+               threads, seconds, single / seconds, bigint_bits(&result));
+        bigint_free(&result);
+        if (!ok) {
+            return 1;
+        }
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+    // Multiplying one factor at a time is quadratic, so run it on a smaller n
+    printf("\nFactorial of %llu\n", (unsigned long long)baseline_n);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (linear_factorial(&result, baseline_n) != 0) {
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("one factor at a time:      %8.3f s\n", elapsed_seconds(&start, &end));
+    bigint_free(&result);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (calculate_big_factorial(&result, baseline_n, 1) != 0) {
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("product tree, 1 thread:    %8.3f s\n", elapsed_seconds(&start, &end));
+    bigint_free(&result);
+    return 0;
+}
+
 /**
  * Main function demonstrating factorial calculation
  * @return 0 on success, 1 on error
  */
-int main(void) {
+int main(int argc, char *argv[]) {
     int n;
     unsigned long long result;
+    uint64_t big_n;
+    int threads = default_threads();
+
+    if (argc > 2 && strcmp(argv[1], "--big") == 0) {
+        if (parse_big_n(argv[2], &big_n) != 0) {
+            return 1;
+        }
+        if (argc > 3 && (threads = atoi(argv[3])) < 1) {
+            fprintf(stderr, "Error: Invalid thread count\n");
+            return 1;
+        }
+        return run_big(big_n, threads);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        big_n = DEFAULT_BENCH_N;
+        if (argc > 2 && parse_big_n(argv[2], &big_n) != 0) {
+            return 1;
+        }
+        if (argc > 3 && (threads = atoi(argv[3])) < 1) {
+            fprintf(stderr, "Error: Invalid thread count\n");
+            return 1;
+        }
+        return run_bench(big_n, threads);
+    }
 
     printf("Enter a number to calculate factorial: ");
     if (scanf("%d", &n) != 1) {
@@ -124,6 +425,11 @@ int main(void) {
         return 1;
     }
 
+    // Past 20! switch to arbitrary precision
+    if (n > MAX_WORD_FACTORIAL && n <= MAX_BIG_FACTORIAL) {
+        return run_big((uint64_t)n, threads);
+    }
+
     result = calculate_factorial(n);
     if (result == 0) {
         return 1;
@@ -1,33 +1,166 @@
 /**
  * Fibonacci Sequence Calculation using POSIX Threads
- * 
+ *
  * This program demonstrates parallel computation of Fibonacci sequence using multiple threads.
  * Features include:
  * - Parallel computation of large Fibonacci numbers
  * - Thread-safe operations
  * - Dynamic thread management
  * - Error handling and resource cleanup
+ * - Independent chunks: each thread seeds its range with fast doubling,
+ *   F(2k) = F(k) (2 F(k+1) - F(k)) and F(2k+1) = F(k)^2 + F(k+1)^2, in
+ *   O(log n) steps, so no thread reads values another thread writes
+ * - O(log n) queries for a single index, exact to any size via bigint.c
+ *
+ * Usage: fibonacci_pthread                         (prompts for the length)
+ *        fibonacci_pthread --nth N [threads]       (exact F(N))
+ *        fibonacci_pthread --bench [terms] [threads]
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bigint.h"
 
 // Constants
 #define MAX_THREADS 4
-#define MAX_SEQUENCE 100
+#define MAX_SEQUENCE 94                     // F(93) is the largest that fits in 64 bits
+#define MAX_BENCH_THREADS 64
+#define DEFAULT_BENCH_TERMS (64 * 1000 * 1000)
+#define FIBONACCI_PRINT_MAX 100000          // Largest index printed in full
+#define MAX_BIG_FIBONACCI 10000000          // Largest index for --nth, about 7M bits
+#define LOW_DIGITS_MODULUS 10000000000000000000ULL  // 10^19
 
 // Structure to hold thread data
 typedef struct {
-    int start;
-    int end;
+    size_t start;
+    size_t end;
     unsigned long long *sequence;
 } thread_data_t;
 
-// Global variables
-static pthread_mutex_t sequence_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Time difference in seconds
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Calculate F(k) and F(k+1) modulo 2^64 by fast doubling
+ * @param k Index
+ * @param fk Set to F(k)
+ * @param fk1 Set to F(k+1)
+ */
+static void fibonacci_pair(uint64_t k, uint64_t *fk, uint64_t *fk1) {
+    uint64_t a = 0;     // F(i)
+    uint64_t b = 1;     // F(i+1)
+
+    // Walk the bits of k from the top; i doubles, plus one on set bits.
+    // Unsigned wraparound keeps the identities valid modulo 2^64.
+    for (int bit = 63; bit >= 0; bit--) {
+        uint64_t c = a * (2 * b - a);   // F(2i)
+        uint64_t d = a * a + b * b;     // F(2i+1)
+        if ((k >> bit) & 1) {
+            a = d;
+            b = c + d;
+        } else {
+            a = c;
+            b = d;
+        }
+    }
+    *fk = a;
+    *fk1 = b;
+}
+
+/**
+ * Calculate a single Fibonacci number modulo 2^64 in O(log n)
+ * @param n Index
+ * @return F(n) mod 2^64, exact for n < MAX_SEQUENCE
+ */
+unsigned long long fibonacci_nth(uint64_t n) {
+    uint64_t fn, fn1;
+    fibonacci_pair(n, &fn, &fn1);
+    return fn;
+}
+
+/**
+ * Calculate a single Fibonacci number exactly by fast doubling
+ * @param r Result; initialized by this function
+ * @param n Index
+ * @param threads Threads for each multiplication, at most
+ * @return 0 on success, -1 on error
+ */
+int fibonacci_big(bigint_t *r, uint64_t n, int threads) {
+    bigint_t a, b, c, t;
+    int status = -1;
+
+    if (bigint_init(&a, 0) != 0) {
+        return -1;
+    }
+    if (bigint_init(&b, 1) != 0) {
+        goto free_a;
+    }
+    if (bigint_init(&c, 0) != 0) {
+        goto free_b;
+    }
+    if (bigint_init(&t, 0) != 0) {
+        goto free_c;
+    }
+
+    int top = 63;
+    while (top > 0 && !((n >> top) & 1)) {
+        top--;
+    }
+    for (int bit = top; bit >= 0; bit--) {
+        // c = F(2i) = a (2b - a)
+        if (bigint_sub(&t, &b, &a) != 0 || bigint_add(&t, &t, &b) != 0 ||
+            bigint_mul(&c, &a, &t, threads) != 0) {
+            goto out;
+        }
+        // a = F(2i+1) = a^2 + b^2, reusing t for b^2
+        if (bigint_mul(&t, &a, &a, threads) != 0) {
+            goto out;
+        }
+        bigint_t square = a;
+        a = t;
+        t = square;
+        if (bigint_mul(&t, &b, &b, threads) != 0 || bigint_add(&a, &a, &t) != 0) {
+            goto out;
+        }
+        // (a, b) = (F(2i), F(2i+1)) or (F(2i+1), F(2i+2))
+        if ((n >> bit) & 1) {
+            if (bigint_add(&c, &c, &a) != 0) {
+                goto out;
+            }
+            bigint_t next = b;
+            b = c;
+            c = next;
+        } else {
+            bigint_t next = b;
+            b = a;
+            a = c;
+            c = next;
+        }
+    }
+    *r = a;
+    a.limbs = NULL;
+    status = 0;
+
+out:
+    bigint_free(&t);
+free_c:
+    bigint_free(&c);
+free_b:
+    bigint_free(&b);
+free_a:
+    bigint_free(&a);
+    return status;
+}
 
 /**
  * Calculate Fibonacci sequence for a range of numbers
@@ -36,46 +169,78 @@ static pthread_mutex_t sequence_mutex = PTHREAD_MUTEX_INITIALIZER;
  */
 static void *fibonacci_range(void *arg) {
     thread_data_t *data = (thread_data_t *)arg;
-    unsigned long long a, b, temp;
-    int i;
-
-    // Initialize first two numbers in the range
-    if (data->start <= 1) {
-        data->sequence[0] = 0;
-        data->sequence[1] = 1;
-        i = 2;
-    } else {
-        // Calculate previous two numbers
-        a = data->sequence[data->start - 2];
-        b = data->sequence[data->start - 1];
-        i = data->start;
-    }
+    uint64_t a, b, temp;
+
+    // Seed the range independently of the other threads
+    fibonacci_pair(data->start, &a, &b);
 
     // Calculate Fibonacci numbers in the range
-    for (; i <= data->end; i++) {
+    for (size_t i = data->start; i <= data->end; i++) {
+        data->sequence[i] = a;
         temp = a + b;
         a = b;
         b = temp;
-        data->sequence[i] = b;
     }
 
     return NULL;
 }
 
 /**
- * Calculate Fibonacci sequence using multiple threads
+ * Calculate n terms of the sequence modulo 2^64 on up to threads threads
  * @param n Number of elements to calculate
  * @param sequence Array to store the sequence
+ * @param threads Number of threads
  * @return 0 on success, -1 on error
  */
-int calculate_fibonacci(int n, unsigned long long *sequence) {
-    pthread_t threads[MAX_THREADS];
-    thread_data_t thread_data[MAX_THREADS];
-    int num_threads;
-    int chunk_size;
+static int fibonacci_sequence(size_t n, unsigned long long *sequence, int threads) {
+    pthread_t tids[MAX_BENCH_THREADS];
+    thread_data_t thread_data[MAX_BENCH_THREADS];
+    size_t chunk_size;
     int result;
-    int i;
+    int created = 0;
+
+    // Determine number of threads and chunk size
+    if ((size_t)threads > n) {
+        threads = (int)n;
+    }
+    chunk_size = n / threads;
+
+    // Initialize thread data
+    for (int i = 0; i < threads; i++) {
+        thread_data[i].start = i * chunk_size;
+        thread_data[i].end = (i == threads - 1) ? n - 1 : (i + 1) * chunk_size - 1;
+        thread_data[i].sequence = sequence;
+    }
+
+    // Create threads; the calling thread takes the first chunk
+    for (int i = 1; i < threads; i++) {
+        result = pthread_create(&tids[i], NULL, fibonacci_range, &thread_data[i]);
+        if (result != 0) {
+            fprintf(stderr, "Error creating thread %d: %s\n", i, strerror(result));
+            break;
+        }
+        created++;
+    }
+    fibonacci_range(&thread_data[0]);
+
+    // Wait for all threads to complete
+    for (int i = 1; i <= created; i++) {
+        result = pthread_join(tids[i], NULL);
+        if (result != 0) {
+            fprintf(stderr, "Error joining thread %d: %s\n", i, strerror(result));
+        }
+    }
 
+    return created == threads - 1 ? 0 : -1;
+}
+
+/**
+ * Calculate Fibonacci sequence using multiple threads
+ * @param n Number of elements to calculate
+ * @param sequence Array to store the sequence
+ * @return 0 on success, -1 on error
+ */
+int calculate_fibonacci(int n, unsigned long long *sequence) {
     // Input validation
     if (n <= 0 || n > MAX_SEQUENCE) {
         fprintf(stderr, "Error: Invalid sequence length\n");
@@ -87,58 +252,146 @@ int calculate_fibonacci(int n, unsigned long long *sequence) {
         return -1;
     }
 
-    // Initialize first two numbers
-    sequence[0] = 0;
-    if (n > 1) {
-        sequence[1] = 1;
+    return fibonacci_sequence((size_t)n, sequence, MAX_THREADS);
+}
+
+// Number of threads to use when none is given
+static int default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        return 1;
     }
+    return cpus > MAX_BENCH_THREADS ? MAX_BENCH_THREADS : (int)cpus;
+}
 
-    if (n <= 2) {
-        return 0;
+// Parse a thread count argument
+static int parse_threads(const char *arg) {
+    int threads = atoi(arg);
+    if (threads < 1 || threads > MAX_BENCH_THREADS) {
+        fprintf(stderr, "Error: thread count must be between 1 and %d\n", MAX_BENCH_THREADS);
+        return -1;
     }
+    return threads;
+}
 
-    // Determine number of threads and chunk size
-    num_threads = (n < MAX_THREADS) ? n : MAX_THREADS;
-    chunk_size = (n - 2) / num_threads;
+// --nth: print F(n) exactly, in full when short enough
+static int run_nth(uint64_t n, int threads) {
+    struct timespec start, end;
+    bigint_t value;
 
-    // Initialize thread data
-    for (i = 0; i < num_threads; i++) {
-        thread_data[i].start = (i * chunk_size) + 2;
-        thread_data[i].end = (i == num_threads - 1) ? n - 1 : (i + 1) * chunk_size + 1;
-        thread_data[i].sequence = sequence;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (fibonacci_big(&value, n, threads) != 0) {
+        return 1;
     }
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-    // Create threads
-    for (i = 0; i < num_threads; i++) {
-        result = pthread_create(&threads[i], NULL, fibonacci_range, &thread_data[i]);
-        if (result != 0) {
-            fprintf(stderr, "Error creating thread %d: %s\n", i, strerror(result));
-            // Cleanup created threads
-            for (int j = 0; j < i; j++) {
-                pthread_join(threads[j], NULL);
-            }
-            return -1;
-        }
+    // The low 64 bits must agree with the word-sized computation
+    uint64_t low = value.size ? value.limbs[0] : 0;
+    if (low != fibonacci_nth(n)) {
+        fprintf(stderr, "Error: F(%llu) disagrees with the 64-bit result\n",
+                (unsigned long long)n);
+        bigint_free(&value);
+        return 1;
     }
 
-    // Wait for all threads to complete
-    for (i = 0; i < num_threads; i++) {
-        result = pthread_join(threads[i], NULL);
-        if (result != 0) {
-            fprintf(stderr, "Error joining thread %d: %s\n", i, strerror(result));
+    if (n <= FIBONACCI_PRINT_MAX) {
+        char *digits = bigint_to_string(&value);
+        if (!digits) {
+            bigint_free(&value);
+            return 1;
         }
+        printf("F(%llu) = %s\n", (unsigned long long)n, digits);
+        free(digits);
+    } else {
+        printf("F(%llu): %zu bits, last 19 digits %019llu\n", (unsigned long long)n,
+               bigint_bits(&value),
+               (unsigned long long)bigint_mod_small(&value, LOW_DIGITS_MODULUS));
     }
-
+    printf("Calculated in %.6f seconds\n", elapsed_seconds(&start, &end));
+    bigint_free(&value);
     return 0;
 }
 
+// --bench: sequence modulo 2^64, one thread running through vs seeded chunks
+static int run_bench(size_t terms, int threads) {
+    unsigned long long *serial = malloc(terms * sizeof(*serial));
+    unsigned long long *parallel = malloc(terms * sizeof(*parallel));
+    struct timespec start, end;
+    double serial_time, parallel_time;
+    int status = 1;
+
+    if (!serial || !parallel) {
+        perror("Failed to allocate sequence");
+        goto out;
+    }
+    // Touch the pages so neither run pays for page faults
+    memset(serial, 0, terms * sizeof(*serial));
+    memset(parallel, 0, terms * sizeof(*parallel));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (fibonacci_sequence(terms, serial, 1) != 0) {
+        goto out;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    serial_time = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (fibonacci_sequence(terms, parallel, threads) != 0) {
+        goto out;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    parallel_time = elapsed_seconds(&start, &end);
+
+    if (memcmp(serial, parallel, terms * sizeof(*serial)) != 0) {
+        fprintf(stderr, "Error: chunked sequence differs from the serial one\n");
+        goto out;
+    }
+    printf("%zu terms modulo 2^64\n", terms);
+    printf("1 thread:     %.6f s\n", serial_time);
+    printf("%d threads: %s %.6f s (speedup %.2fx)\n", threads, threads < 10 ? " " : "",
+           parallel_time, serial_time / parallel_time);
+    printf("Sequences agree; F(%zu) mod 2^64 = %llu\n", terms - 1, parallel[terms - 1]);
+    status = 0;
+
+out:
+    free(parallel);
+    free(serial);
+    return status;
+}
+
 /**
  * Main function demonstrating Fibonacci sequence calculation
  * @return 0 on success, 1 on error
  */
-int main(void) {
+int main(int argc, char *argv[]) {
     int n;
     unsigned long long sequence[MAX_SEQUENCE];
+    int threads = default_threads();
+
+    if (argc > 2 && strcmp(argv[1], "--nth") == 0) {
+        char *end;
+        unsigned long long index = strtoull(argv[2], &end, 10);
+        // strtoull would accept a sign or leading spaces, and wrap "-1" around
+        if (!isdigit((unsigned char)argv[2][0]) || *end != '\0' || index > MAX_BIG_FIBONACCI) {
+            fprintf(stderr, "Error: index must be between 0 and %d\n", MAX_BIG_FIBONACCI);
+            return 1;
+        }
+        if (argc > 3 && (threads = parse_threads(argv[3])) < 0) {
+            return 1;
+        }
+        return run_nth(index, threads);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        long long terms = argc > 2 ? atoll(argv[2]) : DEFAULT_BENCH_TERMS;
+        if (terms < 1) {
+            fprintf(stderr, "Error: Invalid number of terms\n");
+            return 1;
+        }
+        if (argc > 3 && (threads = parse_threads(argv[3])) < 0) {
+            return 1;
+        }
+        return run_bench((size_t)terms, threads);
+    }
 
     printf("Enter the number of Fibonacci numbers to calculate (1-%d): ", MAX_SEQUENCE);
     if (scanf("%d", &n) != 1) {
@@ -157,4 +410,4 @@ int main(void) {
     printf("\n");
 
     return 0;
-}
\ No newline at end of file
+}
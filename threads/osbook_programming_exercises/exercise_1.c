@@ -1,28 +1,55 @@
 /**
  * Array Statistics with Threads
- * 
- * This program calculates the average, minimum, and maximum values
- * of an array using separate threads for each calculation.
- * 
+ *
+ * This program calculates the average, minimum, maximum and variance
+ * of an array of integers using threads.
+ *
+ * All statistics come from a single pass over the data: the array is split
+ * into one chunk per thread, and each thread walks its chunk in L1-sized
+ * blocks with a vector kernel (AVX2 on x86-64 when the CPU has it, NEON on
+ * AArch64, a scalar loop otherwise) that updates sum, minimum, maximum and
+ * the sum of squares together. Each thread keeps its result in a local
+ * variable and stores it once into a cache-line-sized slot, so threads do
+ * not share cache lines while they run.
+ *
  * Features:
  * - Parallel computation of statistics
  * - Thread-safe memory management
  * - Error handling
  * - Input validation
  * - Performance monitoring
+ * - Streaming mode for inputs of any length
+ *
+ * Usage: exercise_1                          (prompts for the elements)
+ *        exercise_1 --stream [threads] < in  (any number of integers)
+ *        exercise_1 --bench [elements] [threads]
  */
 
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <string.h>
 #include <limits.h>
 #include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 // Constants
 #define MAX_ELEMENTS 1000000
 #define MAX_THREADS 3
+#define MAX_STATS_THREADS 64
+#define STATS_BLOCK 4096                    // Elements per kernel call (16 KiB)
+#define STREAM_CHUNK (1 << 20)              // Elements buffered per streaming round
+#define STREAM_READ_SIZE (1 << 20)          // Bytes per read in streaming mode
+#define DEFAULT_BENCH_ELEMENTS (16 * 1000 * 1000)
+#define CACHE_LINE 64
 
 // Thread arguments structure
 typedef struct {
@@ -33,22 +60,55 @@ typedef struct {
     struct timespec end_time;
 } thread_args_t;
 
+// Statistics of a run of elements; merged with Chan's parallel formula
+typedef struct {
+    uint64_t count;
+    int64_t sum;        // Exact sum
+    int min;
+    int max;
+    double mean;
+    double m2;          // Sum of squared deviations from the mean
+} stats_t;
+
+// Per-thread result, padded to its own cache line
+typedef struct {
+    stats_t stats;
+    char padding[CACHE_LINE - sizeof(stats_t) % CACHE_LINE];
+} stats_slot_t;
+
+// Block kernel: sum, minimum and maximum of x, and the sum of (x - shift)^2
+typedef void (*stats_kernel_t)(const int *x, size_t n, int shift, int64_t *sum,
+                               double *squares, int *min, int *max);
+
+// Chunk of the array handled by one statistics thread
+typedef struct {
+    const int *array;
+    size_t n;
+    stats_kernel_t kernel;
+    stats_slot_t *slot;
+} stats_args_t;
+
 // Thread function prototypes
 static void *average_thread(void *args);
 static void *min_val_thread(void *args);
 static void *max_val_thread(void *args);
 
+// Time difference in seconds
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
 // Calculate average in a separate thread
 static void *average_thread(void *args) {
     thread_args_t *t_args = (thread_args_t *)args;
     clock_gettime(CLOCK_MONOTONIC, &t_args->start_time);
-    
+
     double sum = 0.0;
     for (int i = 0; i < t_args->n; i++) {
         sum += t_args->array[i];
     }
     t_args->result = sum / t_args->n;
-    
+
     clock_gettime(CLOCK_MONOTONIC, &t_args->end_time);
     return NULL;
 }
@@ -57,14 +117,14 @@ static void *average_thread(void *args) {
 static void *min_val_thread(void *args) {
     thread_args_t *t_args = (thread_args_t *)args;
     clock_gettime(CLOCK_MONOTONIC, &t_args->start_time);
-    
+
     t_args->result = t_args->array[0];
     for (int i = 1; i < t_args->n; i++) {
         if (t_args->array[i] < t_args->result) {
             t_args->result = t_args->array[i];
         }
     }
-    
+
     clock_gettime(CLOCK_MONOTONIC, &t_args->end_time);
     return NULL;
 }
@@ -73,32 +133,521 @@ static void *min_val_thread(void *args) {
 static void *max_val_thread(void *args) {
     thread_args_t *t_args = (thread_args_t *)args;
     clock_gettime(CLOCK_MONOTONIC, &t_args->start_time);
-    
+
     t_args->result = t_args->array[0];
     for (int i = 1; i < t_args->n; i++) {
         if (t_args->array[i] > t_args->result) {
             t_args->result = t_args->array[i];
         }
     }
-    
+
     clock_gettime(CLOCK_MONOTONIC, &t_args->end_time);
     return NULL;
 }
 
-// Print thread statistics
-static void print_thread_stats(thread_args_t *args, const char *operation) {
-    double runtime = (args->end_time.tv_sec - args->start_time.tv_sec) +
-                    (args->end_time.tv_nsec - args->start_time.tv_nsec) / 1e9;
-    printf("%s: %.2f (calculated in %.6f seconds)\n",
-           operation, args->result, runtime);
+// Scalar block kernel
+static void stats_kernel_scalar(const int *x, size_t n, int shift, int64_t *sum,
+                                double *squares, int *min, int *max) {
+    int64_t s = 0;
+    double q = 0.0;
+    int lo = x[0];
+    int hi = x[0];
+
+    for (size_t i = 0; i < n; i++) {
+        double d = (double)x[i] - shift;
+        s += x[i];
+        q += d * d;
+        lo = x[i] < lo ? x[i] : lo;
+        hi = x[i] > hi ? x[i] : hi;
+    }
+    *sum = s;
+    *squares = q;
+    *min = lo;
+    *max = hi;
 }
 
-int main(void) {
-    int num_elements;
-    int *array = NULL;
+#if defined(__x86_64__) || defined(__i386__)
+// AVX2 block kernel: eight elements per step
+__attribute__((target("avx2")))
+static void stats_kernel_avx2(const int *x, size_t n, int shift, int64_t *sum,
+                              double *squares, int *min, int *max) {
+    __m256i vmin = _mm256_set1_epi32(x[0]);
+    __m256i vmax = vmin;
+    __m256i vsum = _mm256_setzero_si256();
+    __m256d vsq_lo = _mm256_setzero_pd();
+    __m256d vsq_hi = _mm256_setzero_pd();
+    __m256d vshift = _mm256_set1_pd((double)shift);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m128i low = _mm256_castsi256_si128(v);
+        __m128i high = _mm256_extracti128_si256(v, 1);
+        __m256d d_lo = _mm256_sub_pd(_mm256_cvtepi32_pd(low), vshift);
+        __m256d d_hi = _mm256_sub_pd(_mm256_cvtepi32_pd(high), vshift);
+
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+        vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(low));
+        vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(high));
+        vsq_lo = _mm256_add_pd(vsq_lo, _mm256_mul_pd(d_lo, d_lo));
+        vsq_hi = _mm256_add_pd(vsq_hi, _mm256_mul_pd(d_hi, d_hi));
+    }
+
+    // Reduce the lanes
+    int lanes_min[8], lanes_max[8];
+    int64_t lanes_sum[4];
+    double lanes_sq[4];
+    _mm256_storeu_si256((__m256i *)lanes_min, vmin);
+    _mm256_storeu_si256((__m256i *)lanes_max, vmax);
+    _mm256_storeu_si256((__m256i *)lanes_sum, vsum);
+    _mm256_storeu_pd(lanes_sq, _mm256_add_pd(vsq_lo, vsq_hi));
+
+    int lo = lanes_min[0];
+    int hi = lanes_max[0];
+    for (int k = 1; k < 8; k++) {
+        lo = lanes_min[k] < lo ? lanes_min[k] : lo;
+        hi = lanes_max[k] > hi ? lanes_max[k] : hi;
+    }
+    int64_t s = lanes_sum[0] + lanes_sum[1] + lanes_sum[2] + lanes_sum[3];
+    double q = (lanes_sq[0] + lanes_sq[1]) + (lanes_sq[2] + lanes_sq[3]);
+
+    // Remaining elements
+    for (; i < n; i++) {
+        double d = (double)x[i] - shift;
+        s += x[i];
+        q += d * d;
+        lo = x[i] < lo ? x[i] : lo;
+        hi = x[i] > hi ? x[i] : hi;
+    }
+    *sum = s;
+    *squares = q;
+    *min = lo;
+    *max = hi;
+}
+#elif defined(__aarch64__)
+// NEON block kernel: four elements per step
+static void stats_kernel_neon(const int *x, size_t n, int shift, int64_t *sum,
+                              double *squares, int *min, int *max) {
+    int32x4_t vmin = vdupq_n_s32(x[0]);
+    int32x4_t vmax = vmin;
+    int64x2_t vsum = vdupq_n_s64(0);
+    float64x2_t vsq = vdupq_n_f64(0.0);
+    float64x2_t vshift = vdupq_n_f64((double)shift);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(x + i);
+        float64x2_t d_lo = vsubq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(v))), vshift);
+        float64x2_t d_hi = vsubq_f64(vcvtq_f64_s64(vmovl_s32(vget_high_s32(v))), vshift);
+
+        vmin = vminq_s32(vmin, v);
+        vmax = vmaxq_s32(vmax, v);
+        vsum = vpadalq_s32(vsum, v);
+        vsq = vfmaq_f64(vsq, d_lo, d_lo);
+        vsq = vfmaq_f64(vsq, d_hi, d_hi);
+    }
+
+    int lo = vminvq_s32(vmin);
+    int hi = vmaxvq_s32(vmax);
+    int64_t s = vaddvq_s64(vsum);
+    double q = vaddvq_f64(vsq);
+
+    // Remaining elements
+    for (; i < n; i++) {
+        double d = (double)x[i] - shift;
+        s += x[i];
+        q += d * d;
+        lo = x[i] < lo ? x[i] : lo;
+        hi = x[i] > hi ? x[i] : hi;
+    }
+    *sum = s;
+    *squares = q;
+    *min = lo;
+    *max = hi;
+}
+#endif
+
+// Pick the fastest kernel this CPU supports
+static stats_kernel_t select_kernel(const char **name) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return stats_kernel_avx2;
+    }
+#elif defined(__aarch64__)
+    *name = "neon";
+    return stats_kernel_neon;
+#endif
+    *name = "scalar";
+    return stats_kernel_scalar;
+}
+
+// Initialize empty statistics
+static void stats_init(stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->min = INT_MAX;
+    stats->max = INT_MIN;
+}
+
+// Merge statistics b into a
+static void stats_merge(stats_t *a, const stats_t *b) {
+    if (b->count == 0) {
+        return;
+    }
+    if (a->count == 0) {
+        *a = *b;
+        return;
+    }
+
+    double na = (double)a->count;
+    double nb = (double)b->count;
+    double n = na + nb;
+    double delta = b->mean - a->mean;
+
+    a->mean += delta * nb / n;
+    a->m2 += b->m2 + delta * delta * na * nb / n;
+    a->count += b->count;
+    a->sum += b->sum;
+    a->min = b->min < a->min ? b->min : a->min;
+    a->max = b->max > a->max ? b->max : a->max;
+}
+
+// Compute the statistics of one chunk, one block at a time
+static void stats_chunk(const int *array, size_t n, stats_kernel_t kernel, stats_t *out) {
+    stats_t total;
+
+    stats_init(&total);
+    for (size_t start = 0; start < n; start += STATS_BLOCK) {
+        size_t len = n - start < STATS_BLOCK ? n - start : STATS_BLOCK;
+        const int *x = array + start;
+        stats_t block;
+        double squares;
+
+        // Deviations from the block's first element keep the squares small
+        block.count = len;
+        kernel(x, len, x[0], &block.sum, &squares, &block.min, &block.max);
+        double shifted = (double)(block.sum - (int64_t)len * x[0]);
+        block.mean = (double)block.sum / len;
+        block.m2 = squares - shifted * shifted / len;
+        if (block.m2 < 0) {
+            block.m2 = 0;
+        }
+        stats_merge(&total, &block);
+    }
+    *out = total;
+}
+
+// Statistics thread: one chunk, result stored once into the thread's slot
+static void *stats_thread(void *args) {
+    stats_args_t *s_args = (stats_args_t *)args;
+    stats_t local;
+
+    stats_chunk(s_args->array, s_args->n, s_args->kernel, &local);
+    s_args->slot->stats = local;
+    return NULL;
+}
+
+/**
+ * Compute statistics of an array in one pass split across threads
+ * @param array Elements
+ * @param n Number of elements
+ * @param threads Number of threads (at most MAX_STATS_THREADS)
+ * @param kernel Block kernel
+ * @param out Merged statistics
+ * @return 0 on success, -1 on error
+ */
+static int parallel_stats(const int *array, size_t n, int threads,
+                          stats_kernel_t kernel, stats_t *out) {
+    pthread_t tids[MAX_STATS_THREADS];
+    stats_args_t args[MAX_STATS_THREADS];
+    stats_slot_t *slots;
+    size_t per_thread;
+    int created = 0;
+    int ret;
+
+    if (threads > 1 && n < (size_t)threads * STATS_BLOCK) {
+        threads = (int)(n / STATS_BLOCK) + 1;  // Not worth more threads
+    }
+    slots = aligned_alloc(CACHE_LINE, threads * sizeof(stats_slot_t));
+    if (!slots) {
+        perror("Failed to allocate thread results");
+        return -1;
+    }
+
+    // Chunk boundaries fall on block boundaries
+    per_thread = ((n + threads - 1) / threads + STATS_BLOCK - 1) / STATS_BLOCK * STATS_BLOCK;
+    for (int i = 0; i < threads; i++) {
+        size_t start = (size_t)i * per_thread;
+        args[i].array = array + (start < n ? start : n);
+        args[i].n = start < n ? (n - start < per_thread ? n - start : per_thread) : 0;
+        args[i].kernel = kernel;
+        args[i].slot = &slots[i];
+    }
+
+    // The calling thread takes the first chunk
+    for (int i = 1; i < threads; i++) {
+        if ((ret = pthread_create(&tids[i], NULL, stats_thread, &args[i])) != 0) {
+            fprintf(stderr, "Failed to create statistics thread: %s\n", strerror(ret));
+            break;
+        }
+        created++;
+    }
+    stats_thread(&args[0]);
+    for (int i = 1; i <= created; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    if (created != threads - 1) {
+        free(slots);
+        return -1;
+    }
+
+    stats_init(out);
+    for (int i = 0; i < threads; i++) {
+        stats_merge(out, &slots[i].stats);
+    }
+    free(slots);
+    return 0;
+}
+
+// Number of threads to use when none is given
+static int default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        return 1;
+    }
+    return cpus > MAX_STATS_THREADS ? MAX_STATS_THREADS : (int)cpus;
+}
+
+// Parse a thread count argument
+static int parse_threads(const char *arg) {
+    int threads = atoi(arg);
+    if (threads < 1 || threads > MAX_STATS_THREADS) {
+        fprintf(stderr, "Invalid thread count (between 1 and %d)\n", MAX_STATS_THREADS);
+        return -1;
+    }
+    return threads;
+}
+
+// Print merged statistics
+static void print_stats(const stats_t *stats, double runtime) {
+    printf("Elements: %llu\n", (unsigned long long)stats->count);
+    printf("Average: %.2f\n", (double)stats->sum / stats->count);
+    printf("Minimum: %d\n", stats->min);
+    printf("Maximum: %d\n", stats->max);
+    printf("Variance: %.2f\n", stats->m2 / stats->count);
+    printf("Calculated in %.6f seconds\n", runtime);
+}
+
+/**
+ * Streaming mode: read whitespace-separated integers from stdin in chunks,
+ * computing each chunk in parallel and merging, so memory use is fixed
+ * @param threads Number of threads
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int run_stream(int threads) {
+    const char *kernel_name;
+    stats_kernel_t kernel = select_kernel(&kernel_name);
+    int *chunk = malloc(STREAM_CHUNK * sizeof(int));
+    char *input = malloc(STREAM_READ_SIZE);
+    stats_t total, part;
+    size_t filled = 0;
+    size_t got;
+    int in_number = 0, negative = 0;
+    long long value = 0;
+    double compute_time = 0.0;
+    struct timespec start, end;
+    int status = EXIT_FAILURE;
+
+    if (!chunk || !input) {
+        perror("Failed to allocate stream buffers");
+        goto out;
+    }
+    stats_init(&total);
+
+    for (;;) {
+        got = fread(input, 1, STREAM_READ_SIZE, stdin);
+
+        // A number may continue across reads, so the parse state persists
+        for (size_t i = 0; i <= got; i++) {
+            int c = i < got ? (unsigned char)input[i] : (got == 0 ? ' ' : -1);
+
+            if (c == -1) {
+                break;              // End of this read, more may follow
+            }
+            if (c >= '0' && c <= '9') {
+                value = value * 10 + (c - '0');
+                in_number = 1;
+                if (value > (long long)INT_MAX + negative) {
+                    fprintf(stderr, "Invalid input: number out of range\n");
+                    goto out;
+                }
+            } else if (c == '-' && !in_number && !negative) {
+                negative = 1;
+            } else if (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+                if (negative && !in_number) {
+                    fprintf(stderr, "Invalid input\n");
+                    goto out;
+                }
+                if (in_number) {
+                    chunk[filled++] = (int)(negative ? -value : value);
+                    in_number = negative = 0;
+                    value = 0;
+                }
+                if (filled == STREAM_CHUNK || (got == 0 && filled > 0)) {
+                    clock_gettime(CLOCK_MONOTONIC, &start);
+                    if (parallel_stats(chunk, filled, threads, kernel, &part) != 0) {
+                        goto out;
+                    }
+                    clock_gettime(CLOCK_MONOTONIC, &end);
+                    compute_time += elapsed_seconds(&start, &end);
+                    stats_merge(&total, &part);
+                    filled = 0;
+                }
+            } else {
+                fprintf(stderr, "Invalid input\n");
+                goto out;
+            }
+        }
+        if (got == 0) {
+            break;
+        }
+    }
+    if (ferror(stdin)) {
+        perror("Failed to read input");
+        goto out;
+    }
+    if (total.count == 0) {
+        fprintf(stderr, "No input\n");
+        goto out;
+    }
+
+    printf("Array Statistics (%d threads, %s kernel):\n", threads, kernel_name);
+    print_stats(&total, compute_time);
+    status = EXIT_SUCCESS;
+
+out:
+    free(input);
+    free(chunk);
+    return status;
+}
+
+// Baseline: three threads, one full pass each
+static double run_three_pass(int *array, int n, double results[MAX_THREADS]) {
+    void *(*functions[MAX_THREADS])(void *) = { average_thread, min_val_thread, max_val_thread };
     pthread_t threads[MAX_THREADS];
     thread_args_t thread_args[MAX_THREADS];
-    int ret;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < MAX_THREADS; i++) {
+        thread_args[i].array = array;
+        thread_args[i].n = n;
+        if (pthread_create(&threads[i], NULL, functions[i], &thread_args[i]) != 0) {
+            functions[i](&thread_args[i]);
+            threads[i] = 0;
+        }
+    }
+    for (int i = 0; i < MAX_THREADS; i++) {
+        if (threads[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        results[i] = thread_args[i].result;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return elapsed_seconds(&start, &end);
+}
+
+/**
+ * Benchmark mode: three separate passes against the single-pass kernels
+ * @param elements Number of random elements
+ * @param threads Threads for the single-pass runs
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int run_bench(int elements, int threads) {
+    const char *kernel_name;
+    stats_kernel_t kernel = select_kernel(&kernel_name);
+    int *array = malloc((size_t)elements * sizeof(int));
+    double results[MAX_THREADS];
+    double bytes = (double)elements * sizeof(int);
+    struct timespec start, end;
+    stats_t scalar, vector;
+    double time_three, time_scalar, time_vector;
+
+    if (!array) {
+        perror("Failed to allocate array");
+        return EXIT_FAILURE;
+    }
+    srand(1);
+    for (int i = 0; i < elements; i++) {
+        array[i] = rand() - RAND_MAX / 2;
+    }
+
+    time_three = run_three_pass(array, elements, results);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (parallel_stats(array, elements, threads, stats_kernel_scalar, &scalar) != 0) {
+        free(array);
+        return EXIT_FAILURE;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    time_scalar = elapsed_seconds(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (parallel_stats(array, elements, threads, kernel, &vector) != 0) {
+        free(array);
+        return EXIT_FAILURE;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    time_vector = elapsed_seconds(&start, &end);
+
+    printf("%d elements, %d threads for the single pass\n", elements, threads);
+    printf("%-28s %10.6f s %8.2f GB/s\n", "three threads, three passes",
+           time_three, bytes / time_three / 1e9);
+    printf("%-28s %10.6f s %8.2f GB/s\n", "single pass, scalar",
+           time_scalar, bytes / time_scalar / 1e9);
+    printf("single pass, %-15s %10.6f s %8.2f GB/s\n", kernel_name,
+           time_vector, bytes / time_vector / 1e9);
+
+    if (scalar.min != (int)results[1] || scalar.max != (int)results[2] ||
+        vector.min != scalar.min || vector.max != scalar.max || vector.sum != scalar.sum) {
+        fprintf(stderr, "Results differ between methods\n");
+        free(array);
+        return EXIT_FAILURE;
+    }
+    printf("Results agree: average %.2f, min %d, max %d, variance %.4g\n",
+           (double)vector.sum / vector.count, vector.min, vector.max,
+           vector.m2 / vector.count);
+    free(array);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+    int num_elements;
+    int *array = NULL;
+    int threads = default_threads();
+    const char *kernel_name;
+    stats_kernel_t kernel = select_kernel(&kernel_name);
+    struct timespec start, end;
+    stats_t stats;
+
+    if (argc > 1 && strcmp(argv[1], "--stream") == 0) {
+        if (argc > 2 && (threads = parse_threads(argv[2])) < 0) {
+            return EXIT_FAILURE;
+        }
+        return run_stream(threads);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        int elements = argc > 2 ? atoi(argv[2]) : DEFAULT_BENCH_ELEMENTS;
+        if (elements <= 0) {
+            fprintf(stderr, "Invalid number of elements\n");
+            return EXIT_FAILURE;
+        }
+        if (argc > 3 && (threads = parse_threads(argv[3])) < 0) {
+            return EXIT_FAILURE;
+        }
+        return run_bench(elements, threads);
+    }
 
     // Get number of elements
     printf("Enter number of elements (max %d): ", MAX_ELEMENTS);
@@ -124,49 +673,19 @@ int main(void) {
         }
     }
 
-    // Initialize thread arguments
-    for (int i = 0; i < MAX_THREADS; i++) {
-        thread_args[i].array = array;
-        thread_args[i].n = num_elements;
-    }
-
-    // Create threads
-    if ((ret = pthread_create(&threads[0], NULL, average_thread, &thread_args[0])) != 0) {
-        fprintf(stderr, "Failed to create average thread: %s\n", strerror(ret));
-        free(array);
-        return EXIT_FAILURE;
-    }
-
-    if ((ret = pthread_create(&threads[1], NULL, min_val_thread, &thread_args[1])) != 0) {
-        fprintf(stderr, "Failed to create min thread: %s\n", strerror(ret));
-        pthread_join(threads[0], NULL);
-        free(array);
-        return EXIT_FAILURE;
-    }
-
-    if ((ret = pthread_create(&threads[2], NULL, max_val_thread, &thread_args[2])) != 0) {
-        fprintf(stderr, "Failed to create max thread: %s\n", strerror(ret));
-        pthread_join(threads[0], NULL);
-        pthread_join(threads[1], NULL);
+    // Compute all statistics in one pass
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (parallel_stats(array, num_elements, threads, kernel, &stats) != 0) {
         free(array);
         return EXIT_FAILURE;
     }
-
-    // Wait for threads to complete
-    for (int i = 0; i < MAX_THREADS; i++) {
-        if ((ret = pthread_join(threads[i], NULL)) != 0) {
-            fprintf(stderr, "Failed to join thread %d: %s\n", i, strerror(ret));
-        }
-    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
     // Print results
-    printf("\nArray Statistics:\n");
-    print_thread_stats(&thread_args[0], "Average");
-    print_thread_stats(&thread_args[1], "Minimum");
-    print_thread_stats(&thread_args[2], "Maximum");
+    printf("\nArray Statistics (%d threads, %s kernel):\n", threads, kernel_name);
+    print_stats(&stats, elapsed_seconds(&start, &end));
 
     // Clean up
     free(array);
     return EXIT_SUCCESS;
 }
-
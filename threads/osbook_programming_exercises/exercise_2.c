@@ -1,93 +1,320 @@
 /**
  * Sieve of Eratosthenes with Threads
- * 
+ *
  * This program implements the Sieve of Eratosthenes algorithm
  * to find all prime numbers up to a given upper bound using threads.
- * 
+ *
+ * The sieve is segmented: numbers are split into segments whose bitset
+ * fits in the L1 cache, and the segments are sieved in parallel as tasks
+ * on the thread pool (../thread_pool.h). Only odd numbers are stored, one
+ * bit each, so the table takes 1/16 of a byte per number instead of the
+ * 4 bytes an int array needs. The counting mode keeps no table at all:
+ * each task sieves its segment in a thread-local buffer and only returns
+ * the number of primes, which lets it count primes up to 10^10 and beyond.
+ *
  * Features:
  * - Parallel prime number calculation
  * - Memory-efficient implementation
  * - Error handling
  * - Input validation
  * - Performance monitoring
+ *
+ * Usage: exercise_2                       (prompts, prints the primes)
+ *        exercise_2 --count N [threads]   (counts primes up to N)
  */
 
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <string.h>
 #include <math.h>
 #include <time.h>
 
+#include "thread_pool.h"
+
 // Constants
 #define MAX_UPPER_BOUND 100000000
 #define MIN_UPPER_BOUND 2
+#define MAX_COUNT_BOUND 1000000000000ULL            // Counting mode limit, 10^12
+#define SEGMENT_BYTES (32 * 1024)                   // Bitset per segment, sized for L1
+#define SEGMENT_WORDS (SEGMENT_BYTES / sizeof(uint64_t))
+#define SEGMENT_BITS ((uint64_t)SEGMENT_BYTES * 8)  // Odd numbers per segment
+#define PRINT_BUFFER_SIZE (64 * 1024)
 
-// Thread arguments structure
+// Segment task: bit i stands for the odd number 2 * (first_bit + i) + 1,
+// and a set bit means composite
 typedef struct {
-    int upper_bound;
-    int *is_prime;
-    int start;
-    int end;
-    struct timespec start_time;
-    struct timespec end_time;
-} sieve_args_t;
-
-// Sieve thread function
-static void *sieve_thread(void *args) {
-    sieve_args_t *s_args = (sieve_args_t *)args;
-    clock_gettime(CLOCK_MONOTONIC, &s_args->start_time);
-    
-    // Mark multiples of each prime number
-    for (int i = s_args->start; i <= s_args->end; i++) {
-        if (s_args->is_prime[i]) {
-            for (int j = i * i; j <= s_args->upper_bound; j += i) {
-                s_args->is_prime[j] = 0;
+    uint64_t first_bit;     // Index of the segment's first odd number
+    uint64_t bits;          // Odd numbers in this segment
+    uint64_t *table;        // Whole-range bitset to fill, NULL when only counting
+    uint64_t primes;        // Counting mode result
+} segment_task_t;
+
+// Shared sieve state
+typedef struct {
+    uint32_t *base_primes;  // Odd primes up to sqrt(upper_bound)
+    size_t base_count;
+} sieve_base_t;
+
+static sieve_base_t sieve_base;
+
+// Segment buffer of the worker thread, used in counting mode
+static __thread uint64_t segment_buffer[SEGMENT_WORDS];
+
+// Time difference in seconds
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Find the odd primes up to limit with a plain byte sieve
+static int find_base_primes(uint32_t limit) {
+    unsigned char *composite = calloc((size_t)limit + 1, 1);
+    if (!composite) {
+        perror("Failed to allocate base sieve");
+        return -1;
+    }
+
+    size_t count = 0;
+    for (uint32_t i = 3; i <= limit; i += 2) {
+        if (!composite[i]) {
+            count++;
+            for (uint64_t j = (uint64_t)i * i; j <= limit; j += 2 * i) {
+                composite[j] = 1;
             }
         }
     }
-    
-    clock_gettime(CLOCK_MONOTONIC, &s_args->end_time);
-    return NULL;
+
+    sieve_base.base_primes = malloc((count ? count : 1) * sizeof(uint32_t));
+    if (!sieve_base.base_primes) {
+        perror("Failed to allocate base primes");
+        free(composite);
+        return -1;
+    }
+    sieve_base.base_count = 0;
+    for (uint32_t i = 3; i <= limit; i += 2) {
+        if (!composite[i]) {
+            sieve_base.base_primes[sieve_base.base_count++] = i;
+        }
+    }
+
+    free(composite);
+    return 0;
 }
 
-// Print prime numbers
-static void print_primes(const int *is_prime, int upper_bound) {
-    printf("\nPrime numbers up to %d:\n", upper_bound);
-    int count = 0;
-    for (int i = 2; i <= upper_bound; i++) {
-        if (is_prime[i]) {
-            printf("%d ", i);
-            count++;
-            if (count % 10 == 0) {
-                printf("\n");
+// Pool task: cross off the multiples of every base prime in one segment
+static void sieve_segment(void *arg) {
+    segment_task_t *task = arg;
+    uint64_t *bits = task->table ? task->table + task->first_bit / 64 : segment_buffer;
+    uint64_t low = 2 * task->first_bit + 1;                 // First odd number
+    uint64_t high = 2 * (task->first_bit + task->bits) - 1; // Last odd number
+
+    if (!task->table) {
+        memset(segment_buffer, 0, sizeof(segment_buffer));
+    }
+
+    for (size_t k = 0; k < sieve_base.base_count; k++) {
+        uint64_t p = sieve_base.base_primes[k];
+        uint64_t multiple = p * p;
+
+        if (multiple > high) {
+            break;
+        }
+        // First odd multiple of p in the segment
+        if (multiple < low) {
+            multiple = (low + p - 1) / p * p;
+            if ((multiple & 1) == 0) {
+                multiple += p;
             }
         }
+        // Consecutive odd multiples are 2p apart, i.e. p bits apart
+        for (uint64_t bit = (multiple - low) / 2; bit < task->bits; bit += p) {
+            bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+        }
+    }
+
+    // 1 is not prime
+    if (task->first_bit == 0) {
+        bits[0] |= 1;
+    }
+
+    if (!task->table) {
+        uint64_t primes = 0;
+        uint64_t words = task->bits / 64;
+        for (uint64_t w = 0; w < words; w++) {
+            primes += (uint64_t)__builtin_popcountll(~bits[w]);
+        }
+        if (task->bits % 64) {
+            uint64_t mask = ((uint64_t)1 << (task->bits % 64)) - 1;
+            primes += (uint64_t)__builtin_popcountll(~bits[words] & mask);
+        }
+        task->primes = primes;
+    }
+}
+
+/**
+ * Sieve all odd numbers up to upper_bound on a thread pool
+ * @param upper_bound Largest number to sieve
+ * @param table Bitset of (upper_bound + 1) / 2 bits to fill, or NULL to only count
+ * @param threads Worker threads, 0 for one per CPU
+ * @param segments Set to the number of segments
+ * @return Number of primes up to upper_bound, 0 on error
+ */
+static uint64_t run_sieve(uint64_t upper_bound, uint64_t *table, size_t threads,
+                          size_t *segments) {
+    uint64_t odd_count = (upper_bound + 1) / 2;     // 1, 3, 5, ... up to upper_bound
+    size_t count = (size_t)((odd_count + SEGMENT_BITS - 1) / SEGMENT_BITS);
+    segment_task_t *tasks = calloc(count, sizeof(*tasks));
+    thread_pool_task_t *submits = calloc(count, sizeof(*submits));
+    thread_pool_t *pool = NULL;
+    uint64_t primes = 0;
+
+    if (!tasks || !submits) {
+        perror("Failed to allocate segment tasks");
+        goto out;
+    }
+    if (find_base_primes((uint32_t)sqrt((double)upper_bound) + 1) != 0) {
+        goto out;
+    }
+
+    pool = thread_pool_create(threads, 0);
+    if (!pool) {
+        goto out;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        tasks[i].first_bit = i * SEGMENT_BITS;
+        tasks[i].bits = odd_count - tasks[i].first_bit < SEGMENT_BITS ?
+                        odd_count - tasks[i].first_bit : SEGMENT_BITS;
+        tasks[i].table = table;
+        submits[i] = (thread_pool_task_t){ sieve_segment, &tasks[i], 0 };
+    }
+    if (thread_pool_submit_batch(pool, submits, count) != 0) {
+        fprintf(stderr, "Failed to submit segments\n");
+        thread_pool_shutdown(pool);
+        goto out;
+    }
+
+    // Shutting down runs every queued segment first
+    thread_pool_shutdown(pool);
+
+    if (!table) {
+        primes = upper_bound >= 2 ? 1 : 0;  // 2
+        for (size_t i = 0; i < count; i++) {
+            primes += tasks[i].primes;
+        }
+    } else {
+        primes = 1;
+        for (uint64_t w = 0; w < odd_count / 64; w++) {
+            primes += (uint64_t)__builtin_popcountll(~table[w]);
+        }
+        if (odd_count % 64) {
+            uint64_t mask = ((uint64_t)1 << (odd_count % 64)) - 1;
+            primes += (uint64_t)__builtin_popcountll(~table[odd_count / 64] & mask);
+        }
+    }
+    *segments = count;
+
+out:
+    free(sieve_base.base_primes);
+    sieve_base.base_primes = NULL;
+    free(submits);
+    free(tasks);
+    return primes;
+}
+
+// Append a number and a separator to the output buffer
+static size_t format_number(char *out, uint64_t value, char separator) {
+    char digits[24];
+    size_t n = 0;
+    size_t length = 0;
+
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) {
+        out[length++] = digits[--n];
+    }
+    out[length++] = separator;
+    return length;
+}
+
+// Print prime numbers, formatting into a large buffer written with fwrite
+static void print_primes(const uint64_t *table, int upper_bound) {
+    static char buffer[PRINT_BUFFER_SIZE];
+    size_t used = 0;
+    uint64_t odd_count = ((uint64_t)upper_bound + 1) / 2;
+    int count = 0;
+
+    printf("\nPrime numbers up to %d:\n", upper_bound);
+    for (uint64_t bit = 0; bit < odd_count; bit++) {
+        uint64_t number = bit == 0 ? 2 : 2 * bit + 1;    // Bit 0 (the number 1) stands in for 2
+
+        if (bit != 0 && (table[bit / 64] >> (bit % 64) & 1)) {
+            continue;
+        }
+        count++;
+        used += format_number(buffer + used, number, ' ');
+        if (count % 10 == 0) {
+            buffer[used++] = '\n';
+        }
+        if (used > PRINT_BUFFER_SIZE - 32) {
+            fwrite(buffer, 1, used, stdout);
+            used = 0;
+        }
     }
+    fwrite(buffer, 1, used, stdout);
     printf("\n\nTotal primes found: %d\n", count);
 }
 
-// Print thread statistics
-static void print_thread_stats(sieve_args_t *args) {
-    double runtime = (args->end_time.tv_sec - args->start_time.tv_sec) +
-                    (args->end_time.tv_nsec - args->start_time.tv_nsec) / 1e9;
-    printf("Thread processed range %d-%d in %.6f seconds\n",
-           args->start, args->end, runtime);
+// Print sieve statistics
+static void print_sieve_stats(size_t segments, double runtime) {
+    printf("Sieved %zu segments of %d KiB in %.6f seconds\n",
+           segments, SEGMENT_BYTES / 1024, runtime);
 }
 
-int main(void) {
+// Counting mode: no table, only the number of primes
+static int count_primes(int argc, char *argv[]) {
+    char *end;
+    unsigned long long upper_bound = strtoull(argv[2], &end, 10);
+    size_t threads = argc > 3 ? (size_t)atoi(argv[3]) : 0;
+    struct timespec start, finish;
+    size_t segments = 0;
+
+    if (*end != '\0' || upper_bound < MIN_UPPER_BOUND || upper_bound > MAX_COUNT_BOUND) {
+        fprintf(stderr, "Invalid upper bound (between %d and %llu)\n",
+                MIN_UPPER_BOUND, MAX_COUNT_BOUND);
+        return EXIT_FAILURE;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t primes = run_sieve(upper_bound, NULL, threads, &segments);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+
+    if (primes == 0) {
+        return EXIT_FAILURE;
+    }
+    print_sieve_stats(segments, elapsed_seconds(&start, &finish));
+    printf("Primes up to %llu: %llu\n", upper_bound, (unsigned long long)primes);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
     int upper_bound;
-    int *is_prime = NULL;
-    pthread_t thread;
-    sieve_args_t args;
-    int ret;
+    uint64_t *table = NULL;
     struct timespec total_start, total_end;
+    size_t segments = 0;
+
+    if (argc > 2 && strcmp(argv[1], "--count") == 0) {
+        return count_primes(argc, argv);
+    }
 
     // Get upper bound
     printf("Enter upper bound (between %d and %d): ", MIN_UPPER_BOUND, MAX_UPPER_BOUND);
-    if (scanf("%d", &upper_bound) != 1 || 
-        upper_bound < MIN_UPPER_BOUND || 
+    if (scanf("%d", &upper_bound) != 1 ||
+        upper_bound < MIN_UPPER_BOUND ||
         upper_bound > MAX_UPPER_BOUND) {
         fprintf(stderr, "Invalid upper bound\n");
         return EXIT_FAILURE;
@@ -96,54 +323,34 @@ int main(void) {
     // Start timing
     clock_gettime(CLOCK_MONOTONIC, &total_start);
 
-    // Allocate and initialize array
-    is_prime = malloc((upper_bound + 1) * sizeof(int));
-    if (!is_prime) {
-        perror("Failed to allocate array");
-        return EXIT_FAILURE;
-    }
-
-    // Initialize array
-    for (int i = 0; i <= upper_bound; i++) {
-        is_prime[i] = 1;
-    }
-    is_prime[0] = is_prime[1] = 0;
-
-    // Set up thread arguments
-    args.upper_bound = upper_bound;
-    args.is_prime = is_prime;
-    args.start = 2;
-    args.end = (int)sqrt(upper_bound);
-
-    // Create thread
-    if ((ret = pthread_create(&thread, NULL, sieve_thread, &args)) != 0) {
-        fprintf(stderr, "Failed to create thread: %s\n", strerror(ret));
-        free(is_prime);
+    // Allocate the odd-number bitset, rounded up to whole segments so every
+    // task writes only its own words; zero means "possibly prime"
+    uint64_t odd_count = ((uint64_t)upper_bound + 1) / 2;
+    size_t words = (size_t)((odd_count + SEGMENT_BITS - 1) / SEGMENT_BITS) * SEGMENT_WORDS;
+    table = calloc(words, sizeof(uint64_t));
+    if (!table) {
+        perror("Failed to allocate bitset");
         return EXIT_FAILURE;
     }
 
-    // Wait for thread to complete
-    if ((ret = pthread_join(thread, NULL)) != 0) {
-        fprintf(stderr, "Failed to join thread: %s\n", strerror(ret));
-        free(is_prime);
+    if (run_sieve((uint64_t)upper_bound, table, 0, &segments) == 0) {
+        free(table);
         return EXIT_FAILURE;
     }
 
     // End timing
     clock_gettime(CLOCK_MONOTONIC, &total_end);
 
-    // Print thread statistics
-    print_thread_stats(&args);
+    // Print sieve statistics
+    print_sieve_stats(segments, elapsed_seconds(&total_start, &total_end));
 
     // Print total runtime
-    double total_runtime = (total_end.tv_sec - total_start.tv_sec) +
-                          (total_end.tv_nsec - total_start.tv_nsec) / 1e9;
-    printf("\nTotal runtime: %.6f seconds\n", total_runtime);
+    printf("\nTotal runtime: %.6f seconds\n", elapsed_seconds(&total_start, &total_end));
 
     // Print prime numbers
-    print_primes(is_prime, upper_bound);
+    print_primes(table, upper_bound);
 
     // Clean up
-    free(is_prime);
+    free(table);
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
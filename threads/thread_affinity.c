@@ -0,0 +1,250 @@
+/**
+ * Thread Placement Implementation
+ *
+ * Topology comes from /sys/devices/system/cpu/cpuN: topology/core_id and
+ * topology/physical_package_id identify the physical core, and a nodeM
+ * entry names the NUMA node.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sched.h>
+
+#include "thread_affinity.h"
+
+// Constants
+#define SYSFS_CPU_PATH "/sys/devices/system/cpu"
+
+// Read a single integer from a sysfs file, -1 if it cannot be read
+static int read_sysfs_int(int cpu, const char *file) {
+    char path[128];
+    FILE *f;
+    int value = -1;
+
+    snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%d/%s", cpu, file);
+    f = fopen(path, "r");
+    if (!f) {
+        return -1;
+    }
+    if (fscanf(f, "%d", &value) != 1) {
+        value = -1;
+    }
+    fclose(f);
+    return value;
+}
+
+// Find the NUMA node of a CPU from its nodeM entry, 0 if there is none
+static int read_cpu_node(int cpu) {
+    char path[128];
+    struct dirent *entry;
+    DIR *dir;
+    int node = 0;
+
+    snprintf(path, sizeof(path), SYSFS_CPU_PATH "/cpu%d", cpu);
+    dir = opendir(path);
+    if (!dir) {
+        return 0;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        char *end;
+        if (strncmp(entry->d_name, "node", 4) == 0) {
+            long value = strtol(entry->d_name + 4, &end, 10);
+            if (end != entry->d_name + 4 && *end == '\0') {
+                node = (int)value;
+                break;
+            }
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+int cpu_topology_discover(cpu_topology_t *topo) {
+    cpu_set_t allowed;
+    int *core_keys;     // (package, core_id) of each numbered core
+    int count;
+
+    memset(topo, 0, sizeof(*topo));
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        perror("Failed to get CPU affinity");
+        return -1;
+    }
+    count = CPU_COUNT(&allowed);
+
+    topo->cpus = malloc(count * sizeof(*topo->cpus));
+    core_keys = malloc(2 * count * sizeof(*core_keys));
+    if (!topo->cpus || !core_keys) {
+        perror("Failed to allocate CPU topology");
+        free(topo->cpus);
+        free(core_keys);
+        topo->cpus = NULL;
+        return -1;
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE && topo->cpu_count < count; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        cpu_info_t *info = &topo->cpus[topo->cpu_count++];
+        int core_id = read_sysfs_int(cpu, "topology/core_id");
+        int package = read_sysfs_int(cpu, "topology/physical_package_id");
+        int core;
+
+        // Without topology information each CPU is a core of its own
+        if (core_id < 0) {
+            core_id = cpu;
+            package = -1;
+        }
+        for (core = 0; core < topo->core_count; core++) {
+            if (core_keys[2 * core] == package && core_keys[2 * core + 1] == core_id) {
+                break;
+            }
+        }
+        if (core == topo->core_count) {
+            core_keys[2 * core] = package;
+            core_keys[2 * core + 1] = core_id;
+            topo->core_count++;
+        }
+
+        info->cpu = cpu;
+        info->core = core;
+        info->node = read_cpu_node(cpu);
+        if (info->node + 1 > topo->node_count) {
+            topo->node_count = info->node + 1;
+        }
+    }
+
+    free(core_keys);
+    return 0;
+}
+
+void cpu_topology_free(cpu_topology_t *topo) {
+    free(topo->cpus);
+    memset(topo, 0, sizeof(*topo));
+}
+
+// Apply a CPU set to a thread
+static int apply_affinity(pthread_t thread, const cpu_set_t *set) {
+    int result = pthread_setaffinity_np(thread, sizeof(*set), set);
+    if (result != 0) {
+        errno = result;
+        perror("Failed to set thread affinity");
+        return -1;
+    }
+    return 0;
+}
+
+int affinity_pin_cpu(pthread_t thread, int cpu) {
+    cpu_set_t set;
+
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        fprintf(stderr, "Invalid CPU %d\n", cpu);
+        errno = EINVAL;
+        return -1;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return apply_affinity(thread, &set);
+}
+
+int affinity_pin_core(pthread_t thread, const cpu_topology_t *topo, int core) {
+    cpu_set_t set;
+
+    if (core < 0 || core >= topo->core_count) {
+        fprintf(stderr, "Invalid core %d (have %d)\n", core, topo->core_count);
+        errno = EINVAL;
+        return -1;
+    }
+    CPU_ZERO(&set);
+    for (int i = 0; i < topo->cpu_count; i++) {
+        if (topo->cpus[i].core == core) {
+            CPU_SET(topo->cpus[i].cpu, &set);
+        }
+    }
+    return apply_affinity(thread, &set);
+}
+
+int affinity_pin_node(pthread_t thread, const cpu_topology_t *topo, int node) {
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    for (int i = 0; i < topo->cpu_count; i++) {
+        if (topo->cpus[i].node == node) {
+            CPU_SET(topo->cpus[i].cpu, &set);
+        }
+    }
+    if (CPU_COUNT(&set) == 0) {
+        fprintf(stderr, "No usable CPUs on node %d\n", node);
+        errno = EINVAL;
+        return -1;
+    }
+    return apply_affinity(thread, &set);
+}
+
+int affinity_place_worker(pthread_t thread, const cpu_topology_t *topo, int index) {
+    if (topo->core_count == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return affinity_pin_core(thread, topo, index % topo->core_count);
+}
+
+int sched_policy_validate(int policy, int priority) {
+    int min = sched_get_priority_min(policy);
+    int max = sched_get_priority_max(policy);
+
+    if (min < 0 || max < 0) {
+        fprintf(stderr, "Unknown scheduling policy %d\n", policy);
+        errno = EINVAL;
+        return -1;
+    }
+    if (priority < min || priority > max) {
+        fprintf(stderr, "Priority %d out of range for %s (%d-%d)\n",
+                priority, sched_policy_name(policy), min, max);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int thread_set_policy(pthread_t thread, int policy, int priority) {
+    struct sched_param param;
+    int result;
+
+    if (sched_policy_validate(policy, priority) != 0) {
+        return -1;
+    }
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    result = pthread_setschedparam(thread, policy, &param);
+    if (result != 0) {
+        errno = result;
+        if (result == EPERM) {
+            fprintf(stderr, "Not permitted to use %s (needs root or CAP_SYS_NICE)\n",
+                    sched_policy_name(policy));
+        } else {
+            perror("Failed to set scheduling policy");
+        }
+        return -1;
+    }
+    return 0;
+}
+
+const char *sched_policy_name(int policy) {
+    switch (policy) {
+        case SCHED_OTHER: return "SCHED_OTHER";
+        case SCHED_FIFO: return "SCHED_FIFO";
+        case SCHED_RR: return "SCHED_RR";
+#ifdef SCHED_BATCH
+        case SCHED_BATCH: return "SCHED_BATCH";
+#endif
+#ifdef SCHED_IDLE
+        case SCHED_IDLE: return "SCHED_IDLE";
+#endif
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * Thread Placement Interface
+ *
+ * CPU topology discovery and thread placement helpers. Features include:
+ * - Topology from sysfs: which CPUs share a physical core (SMT siblings)
+ *   and which NUMA node each CPU belongs to, limited to the CPUs this
+ *   process may run on
+ * - Pinning a thread to one CPU, to all CPUs of a physical core, or to all
+ *   CPUs of a NUMA node
+ * - Worker placement: one worker per physical core, wrapping around when
+ *   there are more workers than cores
+ * - Real-time policies (SCHED_FIFO, SCHED_RR) with priorities validated
+ *   against the range the kernel reports
+ */
+
+#ifndef THREAD_AFFINITY_H
+#define THREAD_AFFINITY_H
+
+#include <pthread.h>
+
+// One usable CPU
+typedef struct {
+    int cpu;        // Kernel CPU number
+    int core;       // Physical core, numbered 0..core_count-1
+    int node;       // NUMA node
+} cpu_info_t;
+
+// CPUs the process may use, in ascending order
+typedef struct {
+    cpu_info_t *cpus;
+    int cpu_count;
+    int core_count;
+    int node_count; // Highest node number plus one
+} cpu_topology_t;
+
+/**
+ * Discover the CPU topology; without sysfs every CPU counts as its own
+ * core on node 0
+ * @param topo Topology to fill
+ * @return 0 on success, -1 on error
+ */
+int cpu_topology_discover(cpu_topology_t *topo);
+
+/**
+ * Free a discovered topology
+ * @param topo Topology to free
+ */
+void cpu_topology_free(cpu_topology_t *topo);
+
+/**
+ * Pin a thread to a single CPU
+ * @param thread Thread to pin
+ * @param cpu Kernel CPU number
+ * @return 0 on success, -1 on error
+ */
+int affinity_pin_cpu(pthread_t thread, int cpu);
+
+/**
+ * Pin a thread to all CPUs of a physical core
+ * @param thread Thread to pin
+ * @param topo Discovered topology
+ * @param core Core number, 0..core_count-1
+ * @return 0 on success, -1 on error
+ */
+int affinity_pin_core(pthread_t thread, const cpu_topology_t *topo, int core);
+
+/**
+ * Pin a thread to all CPUs of a NUMA node
+ * @param thread Thread to pin
+ * @param topo Discovered topology
+ * @param node Node number
+ * @return 0 on success, -1 on error (including a node without usable CPUs)
+ */
+int affinity_pin_node(pthread_t thread, const cpu_topology_t *topo, int node);
+
+/**
+ * Place the index-th worker of a pool on its own physical core
+ * @param thread Worker thread
+ * @param topo Discovered topology
+ * @param index Worker index; cores are reused round-robin past core_count
+ * @return 0 on success, -1 on error
+ */
+int affinity_place_worker(pthread_t thread, const cpu_topology_t *topo, int index);
+
+/**
+ * Check a scheduling policy and priority before applying them
+ * @param policy SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO or SCHED_RR
+ * @param priority Static priority; must lie in the policy's range
+ * @return 0 if valid, -1 with errno set to EINVAL otherwise
+ */
+int sched_policy_validate(int policy, int priority);
+
+/**
+ * Set a thread's scheduling policy and priority after validating them
+ * @param thread Thread to change
+ * @param policy Scheduling policy
+ * @param priority Static priority
+ * @return 0 on success, -1 with errno set on error (EPERM without the
+ *         privilege for real-time policies)
+ */
+int thread_set_policy(pthread_t thread, int policy, int priority);
+
+/**
+ * Name of a scheduling policy
+ * @param policy Scheduling policy
+ * @return Constant name such as "SCHED_FIFO"
+ */
+const char *sched_policy_name(int policy);
+
+#endif // THREAD_AFFINITY_H
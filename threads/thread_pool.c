@@ -1,13 +1,21 @@
 /**
  * Thread Pool Implementation
- * 
- * A thread pool implementation that manages a fixed number of worker threads
+ *
+ * A thread pool implementation that manages a set of worker threads
  * to execute tasks concurrently. Features include:
  * - Dynamic task queue management
  * - Thread-safe operations
  * - Graceful shutdown
  * - Task prioritization
  * - Resource cleanup
+ * - Optional work-stealing mode with per-worker lock-free queues
+ * - Independent pool instances sized at runtime
+ * - Workers that grow with load and retire after idling
+ * - Futures for waiting on individual tasks
+ * - Batch submission and batch dequeue to amortize locking
+ * - Small task arguments stored inline, larger ones in per-thread slabs
+ * - Optional one-worker-per-physical-core placement
+ * - Queue lock contention, task latency and queue depth in stats.h
  */
 
 #include <stdio.h>
@@ -17,291 +25,1470 @@
 #include <errno.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "thread_pool.h"
+#include "thread_affinity.h"
+#include "async_log.h"
+#include "stats.h"
 
 // Constants
-#define MAX_THREADS 4
-#define MAX_TASKS 100
-#define TASK_QUEUE_SIZE 1000
-#define LOG_FILE "thread_pool.log"
+#define MIN_THREADS 1               // Workers the shared-queue mode keeps when idle
+#define TASK_QUEUE_SIZE 1000        // Default shared queue capacity
+#define WS_QUEUE_SIZE 256           // Per-worker queue slots, must be a power of two
+#define CACHE_LINE_SIZE 64
+#define PRIORITY_LEVELS THREAD_POOL_PRIORITY_LEVELS
+#define PRIORITY_AGING_INTERVAL 32  // Dequeues the top level may take before a lower level is served
+#define IDLE_TIMEOUT_MS 2000        // Idle time after which a surplus worker retires
+#define WORKER_BATCH_SIZE 16        // Most tasks a worker takes per lock acquisition
+#define INLINE_ARG_SIZE THREAD_POOL_INLINE_ARG_SIZE
+#define SLAB_BLOCK_SIZE 256         // Bytes per slab block, header included
+#define SLAB_CHUNK_BLOCKS 64        // Blocks carved from each chunk allocation
+
+// Completion handle shared by a submitter and the task's worker
+struct thread_pool_future {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int done;
+};
+
+// How a task's argument is stored
+typedef enum {
+    TASK_ARG_POINTER,   // arg is the caller's pointer
+    TASK_ARG_INLINE,    // argument bytes live in inline_arg
+    TASK_ARG_SLAB       // arg is a slab block released after the task runs
+} task_arg_kind_t;
 
 // Task structure
 typedef struct {
     void (*function)(void *);
     void *arg;
     int priority;
+    thread_pool_future_t *future;   // Completed after the task runs, may be NULL
+    task_arg_kind_t arg_kind;
+    uint64_t submit_ns;             // Sampled submit time, 0 if not sampled
+    _Alignas(max_align_t) unsigned char inline_arg[INLINE_ARG_SIZE];
 } task_t;
 
-// Thread pool structure
+typedef struct slab_cache slab_cache_t;
+
+// Fixed-size slab block; the header stays in front of the payload
+typedef struct slab_block {
+    slab_cache_t *owner;        // Cache to return the block to, NULL if malloc'd
+    struct slab_block *next;    // Free-list link while the block is free
+    _Alignas(max_align_t) unsigned char data[];
+} slab_block_t;
+
+#define SLAB_PAYLOAD_SIZE (SLAB_BLOCK_SIZE - offsetof(slab_block_t, data))
+
+// Per-thread block cache. Only the owning thread touches local_free; other
+// threads return blocks through remote_free, which the owner takes over
+// wholesale, so the lock-free stack never pops single nodes and has no ABA.
+struct slab_cache {
+    slab_block_t *local_free;
+    slab_cache_t *next_orphan;  // Link in slab_orphans after the owner exits
+    _Alignas(CACHE_LINE_SIZE) _Atomic(slab_block_t *) remote_free;
+};
+
+// Node of the shared queue; nodes of one priority level form a FIFO list
+typedef struct {
+    task_t task;
+    unsigned long long seq;     // Enqueue order, used to find the oldest waiter
+    int next;                   // Next node in the same level or free list, -1 at end
+} queue_node_t;
+
+// Slot of a per-worker queue; the sequence number tells producers and
+// consumers whether the slot is free, full, or still being written
+typedef struct {
+    atomic_size_t sequence;
+    task_t task;
+} ws_slot_t;
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov). Any thread
+// may push (submitters) and any thread may pop (the owner and thieves), so the
+// indices live on separate cache lines to keep producers and consumers apart.
 typedef struct {
-    pthread_t threads[MAX_THREADS];
-    task_t task_queue[TASK_QUEUE_SIZE];
-    int queue_size;
-    int queue_front;
-    int queue_rear;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t head;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t tail;
+    _Alignas(CACHE_LINE_SIZE) ws_slot_t slots[WS_QUEUE_SIZE];
+} ws_queue_t;
+
+// Lifecycle of a worker slot
+typedef enum {
+    WORKER_UNUSED,      // No thread, or its thread has been joined
+    WORKER_RUNNING,
+    WORKER_EXITED       // Thread has retired and is waiting to be joined
+} worker_state_t;
+
+// Per-worker state; queue is only used in work-stealing mode
+typedef struct {
+    ws_queue_t queue;
+    pthread_t thread;
+    worker_state_t state;
+    thread_pool_t *pool;
+    int index;
+} worker_t;
+
+// Thread pool structure
+struct thread_pool {
+    worker_t *workers;
+    int max_threads;
+    int min_threads;
+    thread_pool_mode_t mode;
+    atomic_uint next_queue;     // Round-robin cursor for external submits
+    atomic_int idle_workers;    // Workers parked on queue_not_empty
+    queue_node_t *task_queue;
+    int queue_capacity;
+    int level_head[PRIORITY_LEVELS];
+    int level_tail[PRIORITY_LEVELS];
+    unsigned int level_mask;    // Bit n set when level n is non-empty
+    int free_list;
+    unsigned long long next_seq;
+    int bypass_count;           // Top-level dequeues since a lower level was served
+    atomic_int queue_size;      // Written under queue_mutex, read without it
     pthread_mutex_t queue_mutex;
+    int lock_class;             // Statistics class of queue_mutex
     pthread_cond_t queue_not_empty;
     pthread_cond_t queue_not_full;
-    int shutdown;
-    int active_threads;
-} thread_pool_t;
+    atomic_int shutdown;
+    atomic_int active_threads;  // Written under queue_mutex, read without it
+    cpu_topology_t *topology;   // Set when workers are placed on cores
+};
+
+// Worker running on this thread, NULL for non-pool threads
+static _Thread_local worker_t *current_worker = NULL;
+
+// Slab cache of this thread, created on first use
+static _Thread_local slab_cache_t *current_cache = NULL;
 
-// Global thread pool instance
-static thread_pool_t pool;
+// Caches of exited threads, adopted by new threads. Blocks in flight may
+// still point at a cache, so caches are recycled rather than freed.
+static slab_cache_t *slab_orphans = NULL;
+static pthread_mutex_t slab_orphan_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t slab_key;
+static pthread_once_t slab_key_once = PTHREAD_ONCE_INIT;
 
 // Function declarations
 static void *worker_thread(void *arg);
-static int add_task(void (*function)(void *), void *arg, int priority);
+static void *stealing_worker_thread(void *arg);
+static int add_task(thread_pool_t *pool, const task_t *task);
 static void execute_task(task_t *task);
-static void log_message(const char *message);
-void thread_pool_action(const char *action);
 
 /**
- * Initialize the thread pool
+ * Hand the cache of an exiting thread to the orphan list
+ * @param arg Cache of the exiting thread
+ */
+static void slab_release_cache(void *arg) {
+    slab_cache_t *cache = (slab_cache_t *)arg;
+
+    pthread_mutex_lock(&slab_orphan_mutex);
+    cache->next_orphan = slab_orphans;
+    slab_orphans = cache;
+    pthread_mutex_unlock(&slab_orphan_mutex);
+}
+
+// Create the key whose destructor orphans a thread's cache
+static void slab_make_key(void) {
+    if (pthread_key_create(&slab_key, slab_release_cache) != 0) {
+        perror("Failed to create slab key");
+    }
+}
+
+/**
+ * Get the calling thread's slab cache, adopting or creating one if needed
+ * @return Cache, NULL on error
+ */
+static slab_cache_t *slab_local_cache(void) {
+    slab_cache_t *cache;
+
+    if (current_cache != NULL) {
+        return current_cache;
+    }
+
+    pthread_once(&slab_key_once, slab_make_key);
+
+    pthread_mutex_lock(&slab_orphan_mutex);
+    cache = slab_orphans;
+    if (cache != NULL) {
+        slab_orphans = cache->next_orphan;
+    }
+    pthread_mutex_unlock(&slab_orphan_mutex);
+
+    if (cache == NULL) {
+        cache = aligned_alloc(CACHE_LINE_SIZE, sizeof(*cache));
+        if (!cache) {
+            perror("Failed to allocate slab cache");
+            return NULL;
+        }
+        cache->local_free = NULL;
+        atomic_init(&cache->remote_free, NULL);
+    }
+    cache->next_orphan = NULL;
+
+    if (pthread_setspecific(slab_key, cache) != 0) {
+        perror("Failed to register slab cache");
+    }
+    current_cache = cache;
+    return cache;
+}
+
+/**
+ * Carve a new chunk into blocks on a cache's local free list
+ * @param cache Cache to refill
  * @return 0 on success, -1 on error
  */
-int thread_pool_init(void) {
-    int i;
-    int result;
+static int slab_refill(slab_cache_t *cache) {
+    unsigned char *chunk = aligned_alloc(CACHE_LINE_SIZE,
+                                         SLAB_CHUNK_BLOCKS * SLAB_BLOCK_SIZE);
+    if (!chunk) {
+        perror("Failed to allocate slab chunk");
+        return -1;
+    }
+
+    for (int i = SLAB_CHUNK_BLOCKS - 1; i >= 0; i--) {
+        slab_block_t *block = (slab_block_t *)(chunk + (size_t)i * SLAB_BLOCK_SIZE);
+        block->owner = cache;
+        block->next = cache->local_free;
+        cache->local_free = block;
+    }
+
+    return 0;
+}
+
+/**
+ * Allocate a task payload from the calling thread's slab
+ * Payloads larger than a slab block fall back to malloc.
+ * @param size Payload size in bytes
+ * @return Payload pointer, NULL on error
+ */
+static void *slab_alloc(size_t size) {
+    slab_cache_t *cache;
+    slab_block_t *block;
+
+    if (size > SLAB_PAYLOAD_SIZE) {
+        block = malloc(offsetof(slab_block_t, data) + size);
+        if (!block) {
+            perror("Failed to allocate task argument");
+            return NULL;
+        }
+        block->owner = NULL;
+        return block->data;
+    }
+
+    cache = slab_local_cache();
+    if (!cache) {
+        return NULL;
+    }
+
+    // Reclaim everything other threads have freed before growing
+    if (cache->local_free == NULL) {
+        cache->local_free = atomic_exchange_explicit(&cache->remote_free, NULL,
+                                                     memory_order_acquire);
+    }
+    if (cache->local_free == NULL && slab_refill(cache) != 0) {
+        return NULL;
+    }
+
+    block = cache->local_free;
+    cache->local_free = block->next;
+    return block->data;
+}
+
+/**
+ * Return a payload from slab_alloc to the cache it came from
+ * @param ptr Payload pointer
+ */
+static void slab_free(void *ptr) {
+    slab_block_t *block = (slab_block_t *)((unsigned char *)ptr -
+                                           offsetof(slab_block_t, data));
+    slab_cache_t *owner = block->owner;
+    slab_block_t *head;
+
+    if (owner == NULL) {
+        free(block);
+        return;
+    }
+
+    if (owner == current_cache) {
+        block->next = owner->local_free;
+        owner->local_free = block;
+        return;
+    }
+
+    head = atomic_load_explicit(&owner->remote_free, memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&owner->remote_free, &head, block,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+/**
+ * Initialize a per-worker queue
+ * @param queue Queue to initialize
+ */
+static void ws_queue_init(ws_queue_t *queue) {
+    for (size_t i = 0; i < WS_QUEUE_SIZE; i++) {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+/**
+ * Push a task onto a per-worker queue without blocking
+ * @param queue Target queue
+ * @param task Task to copy into the queue
+ * @return 0 on success, -1 if the queue is full
+ */
+static int ws_queue_push(ws_queue_t *queue, const task_t *task) {
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    for (;;) {
+        ws_slot_t *slot = &queue->slots[pos & (WS_QUEUE_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            // Slot is free, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                slot->task = *task;
+                atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            // Slot still holds a task from the previous lap
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Pop a task from a per-worker queue without blocking
+ * @param queue Source queue (own or a victim's)
+ * @param task Receives the popped task
+ * @return 0 on success, -1 if the queue is empty
+ */
+static int ws_queue_pop(ws_queue_t *queue, task_t *task) {
+    size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    for (;;) {
+        ws_slot_t *slot = &queue->slots[pos & (WS_QUEUE_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            // Slot is full, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *task = slot->task;
+                atomic_store_explicit(&slot->sequence, pos + WS_QUEUE_SIZE,
+                                      memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            // Producer has not published this slot yet
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * Find work for a worker: own queue first, then other workers' queues
+ * @param self Calling worker
+ * @param task Receives the task
+ * @return 0 if a task was found, -1 otherwise
+ */
+static int ws_find_task(worker_t *self, task_t *task) {
+    thread_pool_t *pool = self->pool;
+
+    if (ws_queue_pop(&self->queue, task) == 0) {
+        return 0;
+    }
+
+    // Steal, starting from the next worker so thieves spread out
+    for (int i = 1; i < pool->max_threads; i++) {
+        int victim = (self->index + i) % pool->max_threads;
+        if (ws_queue_pop(&pool->workers[victim].queue, task) == 0) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Map a task priority onto a queue level
+ * @param priority Task priority (higher number = higher priority)
+ * @return Level between 0 and PRIORITY_LEVELS - 1
+ */
+static int priority_level(int priority) {
+    if (priority < 0) {
+        return 0;
+    }
+    if (priority >= PRIORITY_LEVELS) {
+        return PRIORITY_LEVELS - 1;
+    }
+    return priority;
+}
+
+/**
+ * Reset the shared queue to empty, with every node on the free list
+ * @param pool Pool whose queue to reset
+ */
+static void init_global_queue(thread_pool_t *pool) {
+    for (int i = 0; i < pool->queue_capacity; i++) {
+        pool->task_queue[i].next = (i + 1 < pool->queue_capacity) ? i + 1 : -1;
+    }
+    for (int i = 0; i < PRIORITY_LEVELS; i++) {
+        pool->level_head[i] = -1;
+        pool->level_tail[i] = -1;
+    }
+    pool->free_list = 0;
+    pool->level_mask = 0;
+    pool->next_seq = 0;
+    pool->bypass_count = 0;
+    atomic_store_explicit(&pool->queue_size, 0, memory_order_relaxed);
+}
+
+/**
+ * Append a task to the tail of its priority level
+ * Caller must hold queue_mutex and ensure the queue is not full.
+ * @param pool Target pool
+ * @param task Task to enqueue
+ */
+static void put_global_task(thread_pool_t *pool, const task_t *task) {
+    int level = priority_level(task->priority);
+    int index = pool->free_list;
+    queue_node_t *node = &pool->task_queue[index];
+
+    pool->free_list = node->next;
+    node->task = *task;
+    node->seq = pool->next_seq++;
+    node->next = -1;
+
+    if (pool->level_tail[level] == -1) {
+        pool->level_head[level] = index;
+    } else {
+        pool->task_queue[pool->level_tail[level]].next = index;
+    }
+    pool->level_tail[level] = index;
+    pool->level_mask |= 1u << level;
+    atomic_store_explicit(&pool->queue_size, pool->queue_size + 1, memory_order_relaxed);
+    stats_queue_depth((uint64_t)pool->queue_size);
+}
+
+/**
+ * Take the next task from the shared queue
+ *
+ * Normally the head of the highest non-empty level is taken. Once the top
+ * level has been served PRIORITY_AGING_INTERVAL times in a row while lower
+ * levels were waiting, the oldest task among the lower levels is taken
+ * instead, so low priorities keep draining and high-priority tasks are
+ * delayed by at most one extra task per interval.
+ * Caller must hold queue_mutex and ensure the queue is not empty.
+ * @param pool Source pool
+ * @param task Receives the task
+ */
+static void take_global_task(thread_pool_t *pool, task_t *task) {
+    int top = 31 - __builtin_clz(pool->level_mask);
+    unsigned int lower = pool->level_mask & ~(1u << top);
+    int level = top;
+    int index;
+    queue_node_t *node;
+
+    if (lower == 0) {
+        pool->bypass_count = 0;
+    } else if (++pool->bypass_count >= PRIORITY_AGING_INTERVAL) {
+        // Age: serve whichever lower level has waited longest
+        unsigned long long oldest = ~0ULL;
+        while (lower != 0) {
+            int candidate = __builtin_ctz(lower);
+            unsigned long long seq = pool->task_queue[pool->level_head[candidate]].seq;
+            if (seq < oldest) {
+                oldest = seq;
+                level = candidate;
+            }
+            lower &= lower - 1;
+        }
+        pool->bypass_count = 0;
+    }
+
+    index = pool->level_head[level];
+    node = &pool->task_queue[index];
+    *task = node->task;
+
+    pool->level_head[level] = node->next;
+    if (node->next == -1) {
+        pool->level_tail[level] = -1;
+        pool->level_mask &= ~(1u << level);
+    }
+    node->next = pool->free_list;
+    pool->free_list = index;
+    atomic_store_explicit(&pool->queue_size, pool->queue_size - 1, memory_order_relaxed);
+
+    pthread_cond_signal(&pool->queue_not_full);
+}
+
+/**
+ * Take up to WORKER_BATCH_SIZE tasks from the shared queue
+ *
+ * The batch is capped at this worker's share of the backlog so one worker
+ * cannot hoard tasks that idle workers could start right away.
+ * Caller must hold queue_mutex and ensure the queue is not empty.
+ * @param pool Source pool
+ * @param tasks Receives the tasks, in scheduling order
+ * @return Number of tasks taken (at least 1)
+ */
+static int take_global_batch(thread_pool_t *pool, task_t *tasks) {
+    int workers = pool->active_threads > 0 ? pool->active_threads : 1;
+    int count = (pool->queue_size + workers - 1) / workers;
+
+    if (count > WORKER_BATCH_SIZE) {
+        count = WORKER_BATCH_SIZE;
+    }
+    for (int i = 0; i < count; i++) {
+        take_global_task(pool, &tasks[i]);
+    }
+
+    return count;
+}
+
+/**
+ * Start a worker in a free slot
+ * Caller must hold queue_mutex (or be the only thread touching the pool).
+ * @param pool Target pool
+ * @return 0 on success, -1 if no slot is free or thread creation failed
+ */
+static int spawn_worker(thread_pool_t *pool) {
+    for (int i = 0; i < pool->max_threads; i++) {
+        worker_t *worker = &pool->workers[i];
+        int result;
+
+        if (worker->state == WORKER_RUNNING) {
+            continue;
+        }
+
+        // A retired thread has already dropped the lock, so this is brief
+        if (worker->state == WORKER_EXITED) {
+            pthread_join(worker->thread, NULL);
+            worker->state = WORKER_UNUSED;
+        }
+
+        result = pthread_create(&worker->thread, NULL,
+                                pool->mode == THREAD_POOL_WORK_STEALING ?
+                                stealing_worker_thread : worker_thread,
+                                worker);
+        if (result != 0) {
+            errno = result;
+            perror("Failed to create thread");
+            return -1;
+        }
+        worker->state = WORKER_RUNNING;
+        atomic_store_explicit(&pool->active_threads, pool->active_threads + 1,
+                              memory_order_relaxed);
+        if (pool->topology) {
+            affinity_place_worker(worker->thread, pool->topology, worker->index);
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * Mark the calling worker as finished
+ * Caller must hold queue_mutex.
+ * @param self Calling worker
+ */
+static void retire_worker(worker_t *self) {
+    self->state = WORKER_EXITED;
+    atomic_store_explicit(&self->pool->active_threads, self->pool->active_threads - 1,
+                          memory_order_relaxed);
+}
+
+/**
+ * Free a pool's memory
+ * @param pool Pool to free
+ */
+static void free_pool(thread_pool_t *pool) {
+    if (pool->topology) {
+        cpu_topology_free(pool->topology);
+        free(pool->topology);
+    }
+    free(pool->task_queue);
+    free(pool->workers);
+    free(pool);
+}
+
+/**
+ * Create a thread pool with the given scheduling mode
+ * @param threads Maximum number of workers, 0 for the number of online CPUs
+ * @param queue_cap Capacity of the shared queue, 0 for the default
+ * @param mode THREAD_POOL_GLOBAL_QUEUE or THREAD_POOL_WORK_STEALING
+ * @return New pool, NULL on error
+ */
+thread_pool_t *thread_pool_create_mode(size_t threads, size_t queue_cap,
+                                       thread_pool_mode_t mode) {
+    thread_pool_t *pool;
+    size_t workers_size;
+
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (queue_cap == 0) {
+        queue_cap = TASK_QUEUE_SIZE;
+    }
+    if (threads > INT32_MAX || queue_cap > INT32_MAX) {
+        fprintf(stderr, "Thread pool size out of range\n");
+        return NULL;
+    }
+
+    pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        perror("Failed to allocate thread pool");
+        return NULL;
+    }
+
+    // Worker queues are cache-line aligned, so the array must be too
+    workers_size = (threads * sizeof(worker_t) + CACHE_LINE_SIZE - 1) /
+                   CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    pool->max_threads = (int)threads;
+    pool->queue_capacity = (int)queue_cap;
+    pool->task_queue = malloc(queue_cap * sizeof(*pool->task_queue));
+    pool->workers = aligned_alloc(CACHE_LINE_SIZE, workers_size);
+    if (!pool->task_queue || !pool->workers) {
+        perror("Failed to allocate thread pool queues");
+        free_pool(pool);
+        return NULL;
+    }
 
     // Initialize mutex and condition variables
-    if (pthread_mutex_init(&pool.queue_mutex, NULL) != 0) {
+    if (pthread_mutex_init(&pool->queue_mutex, NULL) != 0) {
         perror("Failed to initialize mutex");
-        return -1;
+        free_pool(pool);
+        return NULL;
     }
 
-    if (pthread_cond_init(&pool.queue_not_empty, NULL) != 0) {
-        pthread_mutex_destroy(&pool.queue_mutex);
+    if (pthread_cond_init(&pool->queue_not_empty, NULL) != 0) {
+        pthread_mutex_destroy(&pool->queue_mutex);
         perror("Failed to initialize condition variable");
-        return -1;
+        free_pool(pool);
+        return NULL;
     }
 
-    if (pthread_cond_init(&pool.queue_not_full, NULL) != 0) {
-        pthread_mutex_destroy(&pool.queue_mutex);
-        pthread_cond_destroy(&pool.queue_not_empty);
+    if (pthread_cond_init(&pool->queue_not_full, NULL) != 0) {
+        pthread_mutex_destroy(&pool->queue_mutex);
+        pthread_cond_destroy(&pool->queue_not_empty);
         perror("Failed to initialize condition variable");
-        return -1;
+        free_pool(pool);
+        return NULL;
     }
 
     // Initialize pool state
-    pool.queue_size = 0;
-    pool.queue_front = 0;
-    pool.queue_rear = 0;
-    pool.shutdown = 0;
-    pool.active_threads = 0;
+    init_global_queue(pool);
+    atomic_init(&pool->shutdown, 0);
+    atomic_init(&pool->active_threads, 0);
+    pool->lock_class = stats_lock_class("thread_pool.queue");
+    pool->mode = mode;
+    atomic_init(&pool->next_queue, 0);
+    atomic_init(&pool->idle_workers, 0);
+    for (int i = 0; i < pool->max_threads; i++) {
+        ws_queue_init(&pool->workers[i].queue);
+        pool->workers[i].state = WORKER_UNUSED;
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+
+    // Tasks sit in per-worker queues in work-stealing mode, so every
+    // worker stays up; the shared-queue mode starts small and grows
+    if (mode == THREAD_POOL_WORK_STEALING || pool->max_threads < MIN_THREADS) {
+        pool->min_threads = pool->max_threads;
+    } else {
+        pool->min_threads = MIN_THREADS;
+    }
 
     // Create worker threads
-    for (i = 0; i < MAX_THREADS; i++) {
-        result = pthread_create(&pool.threads[i], NULL, worker_thread, NULL);
-        if (result != 0) {
+    for (int i = 0; i < pool->min_threads; i++) {
+        if (spawn_worker(pool) != 0) {
             // Cleanup on error
-            thread_pool_shutdown();
-            errno = result;
-            perror("Failed to create thread");
-            return -1;
+            thread_pool_shutdown(pool);
+            return NULL;
         }
-        pool.active_threads++;
     }
 
-    return 0;
+    return pool;
+}
+
+/**
+ * Create a thread pool with a shared priority queue
+ * @param threads Maximum number of workers, 0 for the number of online CPUs
+ * @param queue_cap Capacity of the shared queue, 0 for the default
+ * @return New pool, NULL on error
+ */
+thread_pool_t *thread_pool_create(size_t threads, size_t queue_cap) {
+    return thread_pool_create_mode(threads, queue_cap, THREAD_POOL_GLOBAL_QUEUE);
+}
+
+/**
+ * Wait on queue_not_empty, giving up after IDLE_TIMEOUT_MS
+ * Caller must hold queue_mutex.
+ * @param pool Pool to wait on
+ * @return 0 when woken, ETIMEDOUT on timeout
+ */
+static int wait_for_task(thread_pool_t *pool) {
+    struct timespec deadline;
+    int result;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += IDLE_TIMEOUT_MS / 1000;
+    deadline.tv_nsec += (IDLE_TIMEOUT_MS % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    atomic_fetch_add(&pool->idle_workers, 1);
+    result = pthread_cond_timedwait(&pool->queue_not_empty, &pool->queue_mutex, &deadline);
+    atomic_fetch_sub(&pool->idle_workers, 1);
+
+    return result;
 }
 
 /**
  * Worker thread function
- * @param arg Unused parameter
+ *
+ * Surplus workers above min_threads retire after idling for
+ * IDLE_TIMEOUT_MS; add_task starts new ones when the backlog grows.
+ * @param arg Worker slot
  * @return NULL
  */
 static void *worker_thread(void *arg) {
-    task_t task;
+    worker_t *self = (worker_t *)arg;
+    thread_pool_t *pool = self->pool;
+    task_t batch[WORKER_BATCH_SIZE];
+    int count;
+
+    current_worker = self;
 
     while (1) {
-        pthread_mutex_lock(&pool.queue_mutex);
+        stats_mutex_lock(&pool->queue_mutex, pool->lock_class);
 
         // Wait for tasks or shutdown
-        while (pool.queue_size == 0 && !pool.shutdown) {
-            pthread_cond_wait(&pool.queue_not_empty, &pool.queue_mutex);
+        while (pool->queue_size == 0 && !pool->shutdown) {
+            if (wait_for_task(pool) == ETIMEDOUT &&
+                pool->queue_size == 0 &&
+                pool->active_threads > pool->min_threads) {
+                retire_worker(self);
+                pthread_mutex_unlock(&pool->queue_mutex);
+                return NULL;
+            }
         }
 
         // Check for shutdown
-        if (pool.shutdown && pool.queue_size == 0) {
-            pool.active_threads--;
-            pthread_mutex_unlock(&pool.queue_mutex);
-            pthread_exit(NULL);
+        if (pool->shutdown && pool->queue_size == 0) {
+            retire_worker(self);
+            pthread_mutex_unlock(&pool->queue_mutex);
+            return NULL;
         }
 
-        // Get task from queue
-        task = pool.task_queue[pool.queue_front];
-        pool.queue_front = (pool.queue_front + 1) % TASK_QUEUE_SIZE;
-        pool.queue_size--;
+        // Get a batch of tasks from queue
+        count = take_global_batch(pool, batch);
+        pthread_mutex_unlock(&pool->queue_mutex);
 
-        // Signal that queue is not full
-        pthread_cond_signal(&pool.queue_not_full);
-        pthread_mutex_unlock(&pool.queue_mutex);
+        // Execute tasks
+        for (int i = 0; i < count; i++) {
+            execute_task(&batch[i]);
+        }
+    }
+
+    return NULL;
+}
 
-        // Execute task
-        execute_task(&task);
+/**
+ * Work-stealing worker thread function
+ *
+ * Runs tasks from its own queue, steals from other workers when that is
+ * empty, and falls back to the shared overflow queue before parking.
+ * @param arg Worker slot
+ * @return NULL
+ */
+static void *stealing_worker_thread(void *arg) {
+    worker_t *self = (worker_t *)arg;
+    thread_pool_t *pool = self->pool;
+    task_t batch[WORKER_BATCH_SIZE];
+    task_t task;
+    int count;
+
+    current_worker = self;
+
+    while (1) {
+        // Fast path: no locks while any worker queue has work
+        if (ws_find_task(self, &task) == 0) {
+            execute_task(&task);
+            continue;
+        }
+
+        stats_mutex_lock(&pool->queue_mutex, pool->lock_class);
+
+        if (pool->queue_size > 0) {
+            count = take_global_batch(pool, batch);
+            pthread_mutex_unlock(&pool->queue_mutex);
+            for (int i = 0; i < count; i++) {
+                execute_task(&batch[i]);
+            }
+            continue;
+        }
+
+        // Announce that we are about to sleep, then look once more so a
+        // submitter that missed the announcement cannot strand its task
+        atomic_fetch_add(&pool->idle_workers, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ws_find_task(self, &task) == 0) {
+            atomic_fetch_sub(&pool->idle_workers, 1);
+            pthread_mutex_unlock(&pool->queue_mutex);
+            execute_task(&task);
+            continue;
+        }
+
+        if (atomic_load(&pool->shutdown)) {
+            atomic_fetch_sub(&pool->idle_workers, 1);
+            retire_worker(self);
+            pthread_mutex_unlock(&pool->queue_mutex);
+            return NULL;
+        }
+
+        pthread_cond_wait(&pool->queue_not_empty, &pool->queue_mutex);
+        atomic_fetch_sub(&pool->idle_workers, 1);
+        pthread_mutex_unlock(&pool->queue_mutex);
     }
 
     return NULL;
 }
 
 /**
- * Add a task to the thread pool
- * @param function Task function to execute
- * @param arg Argument to pass to the task function
- * @param priority Task priority (higher number = higher priority)
+ * Push a task onto one of the per-worker queues
+ *
+ * Tasks submitted from inside a pool task go to the submitting worker's
+ * own queue; external submissions are spread round-robin.
+ * @param pool Target pool
+ * @param task Task to push
+ * @return 0 on success, -1 if every worker queue is full
+ */
+static int push_stealing_task(thread_pool_t *pool, const task_t *task) {
+    int start;
+
+    if (current_worker != NULL && current_worker->pool == pool) {
+        start = current_worker->index;
+    } else {
+        start = (int)(atomic_fetch_add_explicit(&pool->next_queue, 1,
+                                                memory_order_relaxed) %
+                      (unsigned int)pool->max_threads);
+    }
+
+    for (int i = 0; i < pool->max_threads; i++) {
+        worker_t *worker = &pool->workers[(start + i) % pool->max_threads];
+        if (ws_queue_push(&worker->queue, task) == 0) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Wake parked work-stealing workers for newly pushed tasks
+ * @param pool Target pool
+ * @param count Number of tasks pushed
+ */
+static void wake_stealing_workers(thread_pool_t *pool, size_t count) {
+    int idle;
+
+    // Only take the lock when someone is actually asleep
+    atomic_thread_fence(memory_order_seq_cst);
+    if (count == 0 || atomic_load(&pool->idle_workers) == 0) {
+        return;
+    }
+
+    stats_mutex_lock(&pool->queue_mutex, pool->lock_class);
+    idle = atomic_load(&pool->idle_workers);
+    if (count >= (size_t)idle) {
+        pthread_cond_broadcast(&pool->queue_not_empty);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            pthread_cond_signal(&pool->queue_not_empty);
+        }
+    }
+    pthread_mutex_unlock(&pool->queue_mutex);
+}
+
+/**
+ * Wake or start shared-queue workers for newly queued tasks
+ *
+ * Starts up to count new workers while the backlog exceeds the number of
+ * idle workers and the pool is below its maximum size, then wakes at most
+ * count idle workers.
+ * Caller must hold queue_mutex.
+ * @param pool Target pool
+ * @param count Number of tasks just queued
+ */
+static void wake_global_workers(thread_pool_t *pool, size_t count) {
+    int idle = atomic_load(&pool->idle_workers);
+
+    // Grow if queued work outnumbers the workers waiting for it
+    for (size_t i = 0; i < count; i++) {
+        if (pool->active_threads >= pool->max_threads ||
+            pool->queue_size <= idle ||
+            spawn_worker(pool) != 0) {
+            break;
+        }
+    }
+
+    // Signal that queue is not empty
+    if (count > 1 && count >= (size_t)idle) {
+        pthread_cond_broadcast(&pool->queue_not_empty);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            pthread_cond_signal(&pool->queue_not_empty);
+        }
+    }
+}
+
+/**
+ * Add a task to a worker queue in work-stealing mode
+ *
+ * If every worker queue is full the task goes to the shared overflow queue.
+ * Per-worker queues are FIFO; only the shared queue orders by priority.
+ * @param pool Target pool
+ * @param task Task to submit
  * @return 0 on success, -1 on error
  */
-static int add_task(void (*function)(void *), void *arg, int priority) {
-    pthread_mutex_lock(&pool.queue_mutex);
+static int add_stealing_task(thread_pool_t *pool, const task_t *task) {
+    if (atomic_load(&pool->shutdown)) {
+        return -1;
+    }
 
-    // Wait for queue space
-    while (pool.queue_size == TASK_QUEUE_SIZE && !pool.shutdown) {
-        pthread_cond_wait(&pool.queue_not_full, &pool.queue_mutex);
+    if (push_stealing_task(pool, task) == 0) {
+        wake_stealing_workers(pool, 1);
+        return 0;
     }
 
-    if (pool.shutdown) {
-        pthread_mutex_unlock(&pool.queue_mutex);
+    return add_task(pool, task);
+}
+
+/**
+ * Add a batch of tasks to the worker queues in work-stealing mode
+ *
+ * Sleeping workers are woken once for the whole batch rather than once
+ * per task.
+ * @param pool Target pool
+ * @param tasks Tasks to submit
+ * @param n Number of tasks
+ * @return 0 on success, -1 on error
+ */
+static int add_stealing_batch(thread_pool_t *pool, const thread_pool_task_t *tasks,
+                              size_t n) {
+    size_t pushed = 0;
+    int result = 0;
+
+    if (atomic_load(&pool->shutdown)) {
         return -1;
     }
 
-    // Add task to queue
-    pool.task_queue[pool.queue_rear].function = function;
-    pool.task_queue[pool.queue_rear].arg = arg;
-    pool.task_queue[pool.queue_rear].priority = priority;
-    pool.queue_rear = (pool.queue_rear + 1) % TASK_QUEUE_SIZE;
-    pool.queue_size++;
+    for (size_t i = 0; i < n; i++) {
+        task_t task = { .function = tasks[i].function, .arg = tasks[i].arg,
+                        .priority = tasks[i].priority, .submit_ns = stats_sample_start() };
 
-    // Signal that queue is not empty
-    pthread_cond_signal(&pool.queue_not_empty);
-    pthread_mutex_unlock(&pool.queue_mutex);
+        if (push_stealing_task(pool, &task) == 0) {
+            pushed++;
+            stats_add(STATS_TASKS_SUBMITTED, 1);
+        } else {
+            // Let the workers start on what is queued before we block
+            wake_stealing_workers(pool, pushed);
+            pushed = 0;
+            if (add_task(pool, &task) != 0) {
+                result = -1;
+                break;
+            }
+            stats_add(STATS_TASKS_SUBMITTED, 1);
+        }
+    }
+
+    wake_stealing_workers(pool, pushed);
+    return result;
+}
+
+/**
+ * Add a task to the shared queue
+ * @param pool Target pool
+ * @param task Task to submit
+ * @return 0 on success, -1 on error
+ */
+static int add_task(thread_pool_t *pool, const task_t *task) {
+    stats_mutex_lock(&pool->queue_mutex, pool->lock_class);
+
+    // Wait for queue space
+    while (pool->queue_size == pool->queue_capacity && !pool->shutdown) {
+        pthread_cond_wait(&pool->queue_not_full, &pool->queue_mutex);
+    }
+
+    if (pool->shutdown) {
+        pthread_mutex_unlock(&pool->queue_mutex);
+        return -1;
+    }
+
+    // Add task to its priority level
+    put_global_task(pool, task);
+    wake_global_workers(pool, 1);
+    pthread_mutex_unlock(&pool->queue_mutex);
 
     return 0;
 }
 
 /**
- * Execute a task
+ * Add a batch of tasks to the shared queue under one lock acquisition
+ *
+ * If the queue fills up, the tasks queued so far are handed to the
+ * workers before waiting for space.
+ * @param pool Target pool
+ * @param tasks Tasks to submit
+ * @param n Number of tasks
+ * @return 0 on success, -1 on error
+ */
+static int add_task_batch(thread_pool_t *pool, const thread_pool_task_t *tasks,
+                          size_t n) {
+    size_t next = 0;
+
+    stats_mutex_lock(&pool->queue_mutex, pool->lock_class);
+
+    while (next < n) {
+        size_t added = 0;
+
+        // Wait for queue space
+        while (pool->queue_size == pool->queue_capacity && !pool->shutdown) {
+            pthread_cond_wait(&pool->queue_not_full, &pool->queue_mutex);
+        }
+
+        if (pool->shutdown) {
+            break;
+        }
+
+        while (next < n && pool->queue_size < pool->queue_capacity) {
+            task_t task = { .function = tasks[next].function, .arg = tasks[next].arg,
+                            .priority = tasks[next].priority,
+                            .submit_ns = stats_sample_start() };
+            put_global_task(pool, &task);
+            next++;
+            added++;
+        }
+        wake_global_workers(pool, added);
+    }
+
+    pthread_mutex_unlock(&pool->queue_mutex);
+    stats_add(STATS_TASKS_SUBMITTED, next);
+
+    return next == n ? 0 : -1;
+}
+
+/**
+ * Route a task to the queue used by the pool's mode
+ * @param pool Target pool
+ * @param task Task to submit; stamped with the submit time when sampled
+ * @return 0 on success, -1 on error
+ */
+static int submit_task(thread_pool_t *pool, task_t *task) {
+    int result;
+
+    if (!pool) {
+        return -1;
+    }
+    task->submit_ns = stats_sample_start();
+    if (pool->mode == THREAD_POOL_WORK_STEALING) {
+        result = add_stealing_task(pool, task);
+    } else {
+        result = add_task(pool, task);
+    }
+    if (result == 0) {
+        stats_add(STATS_TASKS_SUBMITTED, 1);
+    }
+    return result;
+}
+
+/**
+ * Execute a task and complete its future, if any
+ *
+ * Sampled tasks also record their time in the queue and their run time.
  * @param task Task to execute
  */
 static void execute_task(task_t *task) {
+    void *arg = (task->arg_kind == TASK_ARG_INLINE) ? task->inline_arg : task->arg;
+    uint64_t start = task->submit_ns != 0 ? stats_now_ns() : 0;
+
+    stats_add(STATS_TASKS_STARTED, 1);
+    if (start != 0) {
+        stats_record(STATS_HIST_TASK_QUEUED, start - task->submit_ns);
+    }
+
     if (task->function != NULL) {
-        task->function(task->arg);
+        task->function(arg);
+    }
+
+    if (start != 0) {
+        stats_record(STATS_HIST_TASK_RUN, stats_now_ns() - start);
+    }
+    stats_add(STATS_TASKS_COMPLETED, 1);
+
+    if (task->arg_kind == TASK_ARG_SLAB) {
+        slab_free(task->arg);
+    }
+
+    if (task->future != NULL) {
+        thread_pool_future_t *future = task->future;
+        pthread_mutex_lock(&future->mutex);
+        future->done = 1;
+        pthread_cond_broadcast(&future->cond);
+        pthread_mutex_unlock(&future->mutex);
     }
 }
 
 /**
  * Submit a task to the thread pool
+ * @param pool Target pool
  * @param function Task function to execute
  * @param arg Argument to pass to the task function
  * @return 0 on success, -1 on error
  */
-int thread_pool_submit(void (*function)(void *), void *arg) {
-    return add_task(function, arg, 0);
+int thread_pool_submit(thread_pool_t *pool, void (*function)(void *), void *arg) {
+    task_t task = { .function = function, .arg = arg };
+    return submit_task(pool, &task);
 }
 
 /**
  * Submit a prioritized task to the thread pool
+ *
+ * In shared-queue mode tasks run highest priority first, FIFO within a
+ * priority, with aging so lower priorities cannot starve.
+ * @param pool Target pool
+ * @param function Task function to execute
+ * @param arg Argument to pass to the task function
+ * @param priority Task priority (0 to PRIORITY_LEVELS - 1, higher runs first)
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_submit_priority(thread_pool_t *pool, void (*function)(void *),
+                                void *arg, int priority) {
+    task_t task = { .function = function, .arg = arg, .priority = priority };
+    return submit_task(pool, &task);
+}
+
+/**
+ * Submit a task with a copy of its argument owned by the pool
+ *
+ * Arguments up to THREAD_POOL_INLINE_ARG_SIZE bytes are stored in the task
+ * itself; larger ones are copied into a block from the submitting thread's
+ * slab, which is recycled once the task returns. Either way the caller
+ * needs no malloc, and the task must not free its argument.
+ * @param pool Target pool
+ * @param function Task function, called with a pointer to the copy
+ * @param arg Argument bytes to copy
+ * @param size Size of the argument in bytes
+ * @param priority Task priority (higher runs first)
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_submit_inline(thread_pool_t *pool, void (*function)(void *),
+                              const void *arg, size_t size, int priority) {
+    task_t task = { .function = function, .priority = priority };
+    int result;
+
+    if (size > 0 && !arg) {
+        return -1;
+    }
+
+    if (size <= INLINE_ARG_SIZE) {
+        task.arg_kind = TASK_ARG_INLINE;
+        if (size > 0) {
+            memcpy(task.inline_arg, arg, size);
+        }
+        return submit_task(pool, &task);
+    }
+
+    task.arg = slab_alloc(size);
+    if (!task.arg) {
+        return -1;
+    }
+    memcpy(task.arg, arg, size);
+    task.arg_kind = TASK_ARG_SLAB;
+
+    result = submit_task(pool, &task);
+    if (result != 0) {
+        slab_free(task.arg);
+    }
+    return result;
+}
+
+/**
+ * Submit several tasks at once
+ *
+ * The shared queue is locked once per batch (or once per queue-full of
+ * tasks) and only as many workers as there are tasks are woken. If the
+ * pool shuts down part-way, tasks already queued still run.
+ * @param pool Target pool
+ * @param tasks Tasks to submit
+ * @param n Number of tasks
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_submit_batch(thread_pool_t *pool, const thread_pool_task_t *tasks,
+                             size_t n) {
+    if (!pool || (!tasks && n > 0)) {
+        return -1;
+    }
+    if (pool->mode == THREAD_POOL_WORK_STEALING) {
+        return add_stealing_batch(pool, tasks, n);
+    }
+    return add_task_batch(pool, tasks, n);
+}
+
+/**
+ * Submit a task and get a handle that completes when the task has run
+ * @param pool Target pool
  * @param function Task function to execute
  * @param arg Argument to pass to the task function
- * @param priority Task priority
+ * @param priority Task priority (higher runs first)
+ * @return Future to wait on and destroy, NULL on error
+ */
+thread_pool_future_t *thread_pool_submit_future(thread_pool_t *pool,
+                                                void (*function)(void *),
+                                                void *arg, int priority) {
+    thread_pool_future_t *future = slab_alloc(sizeof(*future));
+    if (!future) {
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&future->mutex, NULL) != 0) {
+        perror("Failed to initialize mutex");
+        slab_free(future);
+        return NULL;
+    }
+
+    if (pthread_cond_init(&future->cond, NULL) != 0) {
+        perror("Failed to initialize condition variable");
+        pthread_mutex_destroy(&future->mutex);
+        slab_free(future);
+        return NULL;
+    }
+    future->done = 0;
+
+    task_t task = { .function = function, .arg = arg, .priority = priority,
+                     .future = future };
+    if (submit_task(pool, &task) != 0) {
+        pthread_cond_destroy(&future->cond);
+        pthread_mutex_destroy(&future->mutex);
+        slab_free(future);
+        return NULL;
+    }
+
+    return future;
+}
+
+/**
+ * Block until the task behind a future has finished
+ * @param future Future returned by thread_pool_submit_future
  * @return 0 on success, -1 on error
  */
-int thread_pool_submit_priority(void (*function)(void *), void *arg, int priority) {
-    return add_task(function, arg, priority);
+int thread_pool_future_wait(thread_pool_future_t *future) {
+    if (!future) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&future->mutex);
+    while (!future->done) {
+        pthread_cond_wait(&future->cond, &future->mutex);
+    }
+    pthread_mutex_unlock(&future->mutex);
+
+    return 0;
+}
+
+/**
+ * Check whether the task behind a future has finished, without blocking
+ * @param future Future returned by thread_pool_submit_future
+ * @return 1 if finished, 0 otherwise
+ */
+int thread_pool_future_done(thread_pool_future_t *future) {
+    int done;
+
+    if (!future) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&future->mutex);
+    done = future->done;
+    pthread_mutex_unlock(&future->mutex);
+
+    return done;
+}
+
+/**
+ * Release a future; waits for the task first if it is still pending
+ * @param future Future returned by thread_pool_submit_future
+ */
+void thread_pool_future_destroy(thread_pool_future_t *future) {
+    if (!future) {
+        return;
+    }
+
+    // The worker touches the future until it unlocks, so wait it out
+    thread_pool_future_wait(future);
+    pthread_cond_destroy(&future->cond);
+    pthread_mutex_destroy(&future->mutex);
+    slab_free(future);
+}
+
+/**
+ * Pin workers one per physical core
+ *
+ * Running workers are pinned now; spawn_worker pins later ones.
+ * @param pool Target pool
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_place_on_cores(thread_pool_t *pool) {
+    cpu_topology_t *topology;
+    int status = 0;
+
+    if (!pool) {
+        return -1;
+    }
+    topology = malloc(sizeof(*topology));
+    if (!topology) {
+        perror("Failed to allocate topology");
+        return -1;
+    }
+    if (cpu_topology_discover(topology) != 0) {
+        free(topology);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->queue_mutex);
+    if (pool->topology) {
+        cpu_topology_free(pool->topology);
+        free(pool->topology);
+    }
+    pool->topology = topology;
+    for (int i = 0; i < pool->max_threads; i++) {
+        if (pool->workers[i].state == WORKER_RUNNING &&
+            affinity_place_worker(pool->workers[i].thread, topology, i) != 0) {
+            status = -1;
+        }
+    }
+    pthread_mutex_unlock(&pool->queue_mutex);
+    return status;
 }
 
 /**
  * Shutdown the thread pool
+ *
+ * Queued tasks still run; the pool is freed once every worker has exited.
+ * @param pool Pool to shut down
  * @return 0 on success, -1 on error
  */
-int thread_pool_shutdown(void) {
-    int i;
+int thread_pool_shutdown(thread_pool_t *pool) {
     int result;
 
-    pthread_mutex_lock(&pool.queue_mutex);
-    pool.shutdown = 1;
-    pthread_cond_broadcast(&pool.queue_not_empty);
-    pthread_mutex_unlock(&pool.queue_mutex);
+    if (!pool) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->queue_mutex);
+    atomic_store(&pool->shutdown, 1);
+    pthread_cond_broadcast(&pool->queue_not_empty);
+    pthread_cond_broadcast(&pool->queue_not_full);
+    pthread_mutex_unlock(&pool->queue_mutex);
+
+    // Wait for all threads to finish; no new workers start after shutdown
+    for (int i = 0; i < pool->max_threads; i++) {
+        worker_t *worker = &pool->workers[i];
+        worker_state_t state;
 
-    // Wait for all threads to finish
-    for (i = 0; i < MAX_THREADS; i++) {
-        result = pthread_join(pool.threads[i], NULL);
+        // Workers update their own state under the lock as they retire
+        pthread_mutex_lock(&pool->queue_mutex);
+        state = worker->state;
+        pthread_mutex_unlock(&pool->queue_mutex);
+        if (state == WORKER_UNUSED) {
+            continue;
+        }
+        result = pthread_join(worker->thread, NULL);
         if (result != 0) {
             errno = result;
             perror("Failed to join thread");
         }
+        worker->state = WORKER_UNUSED;
+    }
+
+    // Run anything a racing submitter pushed after the workers left
+    if (pool->mode == THREAD_POOL_WORK_STEALING) {
+        task_t task;
+        for (int i = 0; i < pool->max_threads; i++) {
+            while (ws_queue_pop(&pool->workers[i].queue, &task) == 0) {
+                execute_task(&task);
+            }
+        }
     }
 
     // Cleanup resources
-    pthread_mutex_destroy(&pool.queue_mutex);
-    pthread_cond_destroy(&pool.queue_not_empty);
-    pthread_cond_destroy(&pool.queue_not_full);
+    pthread_mutex_destroy(&pool->queue_mutex);
+    pthread_cond_destroy(&pool->queue_not_empty);
+    pthread_cond_destroy(&pool->queue_not_full);
+    free_pool(pool);
 
     return 0;
 }
 
 /**
  * Get the number of active threads
+ *
+ * Reads the count without taking the queue lock.
+ * @param pool Pool to query
  * @return Number of active threads
  */
-int thread_pool_active_threads(void) {
-    int count;
-    pthread_mutex_lock(&pool.queue_mutex);
-    count = pool.active_threads;
-    pthread_mutex_unlock(&pool.queue_mutex);
-    return count;
+int thread_pool_active_threads(thread_pool_t *pool) {
+    return atomic_load_explicit(&pool->active_threads, memory_order_relaxed);
 }
 
 /**
  * Get the number of queued tasks
+ *
+ * Every queue is sampled without locking, so while tasks are moving the
+ * result is a snapshot rather than an exact count.
+ * @param pool Pool to query
  * @return Number of queued tasks
  */
-int thread_pool_queued_tasks(void) {
-    int count;
-    pthread_mutex_lock(&pool.queue_mutex);
-    count = pool.queue_size;
-    pthread_mutex_unlock(&pool.queue_mutex);
-    return count;
-}
+int thread_pool_queued_tasks(thread_pool_t *pool) {
+    int count = atomic_load_explicit(&pool->queue_size, memory_order_relaxed);
+
+    if (pool->mode == THREAD_POOL_WORK_STEALING) {
+        for (int i = 0; i < pool->max_threads; i++) {
+            ws_queue_t *queue = &pool->workers[i].queue;
+            size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+            size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
 
-// Function to log messages to a file
-static void log_message(const char *message) {
-    FILE *log_file = fopen(LOG_FILE, "a");
-    if (log_file) {
-        time_t now = time(NULL);
-        fprintf(log_file, "%s: %s\n", ctime(&now), message);
-        fclose(log_file);
+            // A pop between the two loads can leave head ahead of tail
+            if (tail > head) {
+                count += (int)(tail - head);
+            }
+        }
     }
+    return count;
 }
 
 void thread_pool_action(const char *action) {
-    log_message(action);
+    async_log(ASYNC_LOG_INFO, "%s", action);
 }
-
-// Example task function
-void example_task(void* arg) {
-    int* number = (int*)arg;
-    printf("Processing task with number: %d\n", *number);
-    free(number);
-}
-
-/**
- * @brief Main function demonstrating thread pool usage
- */
-int main(void) {
-    log_message("Thread pool started");
-    thread_pool_init();
-    
-    // Add some tasks
-    for (int i = 0; i < 10; i++) {
-        int* number = malloc(sizeof(int));
-        *number = i;
-        thread_pool_submit(example_task, number);
-    }
-    
-    // Wait for tasks to complete
-    sleep(2);
-    
-    thread_pool_shutdown();
-    log_message("Thread pool finished");
-    return 0;
-}
\ No newline at end of file
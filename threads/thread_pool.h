@@ -0,0 +1,178 @@
+/**
+ * Thread Pool Interface
+ *
+ * Public API of the thread pool in thread_pool.c. Each pool is an
+ * independent instance, so a program can run separate pools, e.g. one
+ * for I/O-bound work and one for CPU-bound work.
+ * Features include:
+ * - Pools sized at creation (0 means "one worker per online CPU")
+ * - Workers that grow with load and retire when idle
+ * - Priority scheduling with aging on the shared queue
+ * - Optional work-stealing mode with per-worker lock-free queues
+ * - Waitable futures for submitted tasks
+ * - Batch submission for fine-grained tasks
+ * - Allocation-free submission of small by-value arguments
+ * - Optional placement of one worker per physical core
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+// Constants
+#define THREAD_POOL_PRIORITY_LEVELS 8   // Priorities are clamped to 0..LEVELS-1
+#define THREAD_POOL_INLINE_ARG_SIZE 32  // Largest argument stored inside a task
+
+// Scheduling modes
+typedef enum {
+    THREAD_POOL_GLOBAL_QUEUE,   // All workers share one locked queue
+    THREAD_POOL_WORK_STEALING   // Each worker owns a queue, idle workers steal
+} thread_pool_mode_t;
+
+// Opaque pool and completion handle types
+typedef struct thread_pool thread_pool_t;
+typedef struct thread_pool_future thread_pool_future_t;
+
+// Task description for batch submission
+typedef struct {
+    void (*function)(void *);
+    void *arg;
+    int priority;   // Higher runs first
+} thread_pool_task_t;
+
+/**
+ * Create a thread pool with a shared priority queue
+ * @param threads Maximum number of workers, 0 for the number of online CPUs
+ * @param queue_cap Capacity of the shared queue, 0 for the default
+ * @return New pool, NULL on error
+ */
+thread_pool_t *thread_pool_create(size_t threads, size_t queue_cap);
+
+/**
+ * Create a thread pool with the given scheduling mode
+ * @param threads Maximum number of workers, 0 for the number of online CPUs
+ * @param queue_cap Capacity of the shared queue, 0 for the default
+ * @param mode THREAD_POOL_GLOBAL_QUEUE or THREAD_POOL_WORK_STEALING
+ * @return New pool, NULL on error
+ */
+thread_pool_t *thread_pool_create_mode(size_t threads, size_t queue_cap,
+                                       thread_pool_mode_t mode);
+
+/**
+ * Submit a task to the thread pool
+ * @param pool Target pool
+ * @param function Task function to execute
+ * @param arg Argument to pass to the task function
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_submit(thread_pool_t *pool, void (*function)(void *), void *arg);
+
+/**
+ * Submit a prioritized task to the thread pool
+ * @param pool Target pool
+ * @param function Task function to execute
+ * @param arg Argument to pass to the task function
+ * @param priority Task priority (higher runs first)
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_submit_priority(thread_pool_t *pool, void (*function)(void *),
+                                void *arg, int priority);
+
+/**
+ * Submit a task with a copy of its argument owned by the pool
+ *
+ * Arguments up to THREAD_POOL_INLINE_ARG_SIZE bytes are stored in the task
+ * itself, larger ones in a per-thread slab; the task must not free them.
+ * @param pool Target pool
+ * @param function Task function, called with a pointer to the copy
+ * @param arg Argument bytes to copy
+ * @param size Size of the argument in bytes
+ * @param priority Task priority (higher runs first)
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_submit_inline(thread_pool_t *pool, void (*function)(void *),
+                              const void *arg, size_t size, int priority);
+
+/**
+ * Submit several tasks at once, taking the queue lock once per batch
+ * @param pool Target pool
+ * @param tasks Tasks to submit
+ * @param n Number of tasks
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_submit_batch(thread_pool_t *pool, const thread_pool_task_t *tasks,
+                             size_t n);
+
+/**
+ * Submit a task and get a handle that completes when the task has run
+ * @param pool Target pool
+ * @param function Task function to execute
+ * @param arg Argument to pass to the task function
+ * @param priority Task priority (higher runs first)
+ * @return Future to wait on and destroy, NULL on error
+ */
+thread_pool_future_t *thread_pool_submit_future(thread_pool_t *pool,
+                                                void (*function)(void *),
+                                                void *arg, int priority);
+
+/**
+ * Block until the task behind a future has finished
+ * @param future Future returned by thread_pool_submit_future
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_future_wait(thread_pool_future_t *future);
+
+/**
+ * Check whether the task behind a future has finished, without blocking
+ * @param future Future returned by thread_pool_submit_future
+ * @return 1 if finished, 0 otherwise
+ */
+int thread_pool_future_done(thread_pool_future_t *future);
+
+/**
+ * Release a future; waits for the task first if it is still pending
+ * @param future Future returned by thread_pool_submit_future
+ */
+void thread_pool_future_destroy(thread_pool_future_t *future);
+
+/**
+ * Pin each worker to its own physical core (worker i to core i, wrapping
+ * around when there are more workers than cores), including workers
+ * started later; uses the topology from thread_affinity.h
+ * @param pool Target pool
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_place_on_cores(thread_pool_t *pool);
+
+/**
+ * Run all queued tasks, stop the workers and free the pool
+ * @param pool Pool to shut down
+ * @return 0 on success, -1 on error
+ */
+int thread_pool_shutdown(thread_pool_t *pool);
+
+/**
+ * Get the number of live worker threads, without taking the queue lock
+ * @param pool Pool to query
+ * @return Number of live workers
+ */
+int thread_pool_active_threads(thread_pool_t *pool);
+
+/**
+ * Get the number of queued tasks, without taking any lock
+ *
+ * A snapshot while tasks are moving; the counters in stats.h also give
+ * the depth as tasks submitted minus tasks started.
+ * @param pool Pool to query
+ * @return Number of queued tasks
+ */
+int thread_pool_queued_tasks(thread_pool_t *pool);
+
+/**
+ * Log a message through the asynchronous logger (see async_log.h)
+ * @param action Message to log
+ */
+void thread_pool_action(const char *action);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,252 @@
+/**
+ * Thread Pool Demonstration
+ *
+ * Submits a handful of tasks to a pool from thread_pool.h and waits for
+ * each one through its future before shutting the pool down.
+ * With --bench, measures submission throughput for one million tiny tasks:
+ * one at a time versus in batches, and with malloc'd versus pool-owned
+ * arguments, through the shared harness in bench.h. With --pin, workers
+ * are placed one per physical core. Either way the pool's counters are
+ * published through stats.h for ui/menu to display.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "thread_pool.h"
+#include "async_log.h"
+#include "bench.h"
+#include "stats.h"
+
+// Constants
+#define NUM_TASKS 10
+#define BENCH_TASKS 1000000
+#define BENCH_BATCH 256
+#define BENCH_THREADS 4
+#define BENCH_ARG_SIZE 64
+#define LOG_FILE "thread_pool.log"
+
+static int pin_workers = 0;
+
+// Example task function; arg points into main's numbers[], which the pool does not copy
+void example_task(void* arg) {
+    int* number = (int*)arg;
+    printf("Processing task with number: %d\n", *number);
+}
+
+// Benchmark variants
+typedef enum {
+    BENCH_SUBMIT,       // thread_pool_submit, no argument
+    BENCH_BATCH_SUBMIT, // thread_pool_submit_batch, no argument
+    BENCH_MALLOC_ARG,   // 64-byte argument malloc'd by the caller, freed by the task
+    BENCH_INLINE_ARG,   // 16-byte argument stored inline in the task
+    BENCH_SLAB_ARG      // 64-byte argument copied into the pool's slab
+} bench_kind_t;
+
+// Payload carried by the argument-passing benchmarks
+typedef struct {
+    long value;
+    char padding[BENCH_ARG_SIZE - sizeof(long)];
+} bench_arg_t;
+
+// Counter bumped by the benchmark tasks
+static atomic_long bench_counter;
+
+// Benchmark task: as little work as possible, so queue overhead dominates
+static void bench_task(void *arg) {
+    (void)arg;
+    atomic_fetch_add_explicit(&bench_counter, 1, memory_order_relaxed);
+}
+
+// Benchmark task that reads its argument
+static void bench_arg_task(void *arg) {
+    atomic_fetch_add_explicit(&bench_counter, ((bench_arg_t *)arg)->value,
+                              memory_order_relaxed);
+}
+
+// Benchmark task that owns and frees a malloc'd argument
+static void bench_malloc_task(void *arg) {
+    bench_arg_task(arg);
+    free(arg);
+}
+
+/**
+ * Submit one benchmark task (or batch) of the given kind
+ * @param pool Target pool
+ * @param kind Benchmark variant
+ * @param tasks Prepared batch for BENCH_BATCH_SUBMIT
+ * @param n Tasks to submit in this call
+ * @return 0 on success, -1 on error
+ */
+static int bench_submit(thread_pool_t *pool, bench_kind_t kind,
+                        const thread_pool_task_t *tasks, int n) {
+    bench_arg_t payload = { .value = 1 };
+    bench_arg_t *copy;
+
+    switch (kind) {
+    case BENCH_BATCH_SUBMIT:
+        return thread_pool_submit_batch(pool, tasks, (size_t)n);
+    case BENCH_MALLOC_ARG:
+        copy = malloc(sizeof(*copy));
+        if (!copy) {
+            perror("Failed to allocate task argument");
+            return -1;
+        }
+        *copy = payload;
+        if (thread_pool_submit(pool, bench_malloc_task, copy) != 0) {
+            free(copy);
+            return -1;
+        }
+        return 0;
+    case BENCH_INLINE_ARG:
+        return thread_pool_submit_inline(pool, bench_arg_task, &payload,
+                                         THREAD_POOL_INLINE_ARG_SIZE / 2, 0);
+    case BENCH_SLAB_ARG:
+        return thread_pool_submit_inline(pool, bench_arg_task, &payload,
+                                         sizeof(payload), 0);
+    default:
+        return thread_pool_submit(pool, bench_task, NULL);
+    }
+}
+
+// One benchmark configuration
+typedef struct {
+    thread_pool_mode_t mode;
+    bench_kind_t kind;
+    long tasks;
+} bench_case_t;
+
+/**
+ * One repetition: run the tiny tasks through a fresh pool
+ * @param arg Benchmark configuration
+ * @param latency Unused; the harness records the mean time per task
+ * @return Tasks run, -1 on error
+ */
+static long bench_repetition(void *arg, bench_histogram_t *latency) {
+    bench_case_t *bench = arg;
+    thread_pool_task_t tasks[BENCH_BATCH];
+    int batch = (bench->kind == BENCH_BATCH_SUBMIT) ? BENCH_BATCH : 1;
+    thread_pool_t *pool;
+
+    (void)latency;
+    for (int i = 0; i < BENCH_BATCH; i++) {
+        tasks[i].function = bench_task;
+        tasks[i].arg = NULL;
+        tasks[i].priority = 0;
+    }
+    atomic_store(&bench_counter, 0);
+
+    pool = thread_pool_create_mode(BENCH_THREADS, 0, bench->mode);
+    if (!pool) {
+        return -1;
+    }
+    if (pin_workers) {
+        thread_pool_place_on_cores(pool);
+    }
+
+    for (long i = 0; i < bench->tasks; i += batch) {
+        int n = bench->tasks - i < batch ? (int)(bench->tasks - i) : batch;
+        if (bench_submit(pool, bench->kind, tasks, n) != 0) {
+            fprintf(stderr, "Failed to submit benchmark tasks\n");
+            thread_pool_shutdown(pool);
+            return -1;
+        }
+    }
+
+    // Shutdown runs every queued task before returning
+    thread_pool_shutdown(pool);
+    if (atomic_load(&bench_counter) != bench->tasks) {
+        fprintf(stderr, "Ran %ld of %ld tasks\n", atomic_load(&bench_counter), bench->tasks);
+        return -1;
+    }
+    return bench->tasks;
+}
+
+/**
+ * Time every submission variant in one scheduling mode
+ * @param mode Scheduling mode of the pool
+ * @return 0 on success, -1 on error
+ */
+static int run_bench(thread_pool_mode_t mode) {
+    static const char *names[] = {
+        "submit", "batch-submit", "malloc-arg", "inline-arg", "slab-arg"
+    };
+    bench_config_t config;
+    char name[64];
+
+    bench_config_init(&config, "thread_pool");
+    for (int kind = BENCH_SUBMIT; kind <= BENCH_SLAB_ARG; kind++) {
+        bench_case_t bench = { mode, (bench_kind_t)kind, bench_scaled(&config, BENCH_TASKS) };
+
+        snprintf(name, sizeof(name), "%s/%s",
+                 mode == THREAD_POOL_WORK_STEALING ? "work-stealing" : "shared-queue",
+                 names[kind]);
+        if (bench_case(&config, name, bench_repetition, &bench) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Main function demonstrating thread pool usage
+ *
+ * Pass "--steal" to run the same workload in work-stealing mode,
+ * "--bench" to run the submission benchmark instead of the demo, and
+ * "--pin" to place the workers one per physical core.
+ */
+int main(int argc, char *argv[]) {
+    thread_pool_mode_t mode = THREAD_POOL_GLOBAL_QUEUE;
+    thread_pool_future_t *futures[NUM_TASKS];
+    int numbers[NUM_TASKS];
+    thread_pool_t *pool;
+    int bench = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--steal") == 0) {
+            mode = THREAD_POOL_WORK_STEALING;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench = 1;
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin_workers = 1;
+        }
+    }
+
+    // Statistics are optional; the pool runs the same without them
+    stats_init("thread_pool");
+
+    if (bench) {
+        return run_bench(mode) == 0 ? 0 : 1;
+    }
+
+    if (async_log_init(LOG_FILE, ASYNC_LOG_INFO) != 0) {
+        return 1;
+    }
+    thread_pool_action("Thread pool started");
+    pool = thread_pool_create_mode(0, 0, mode);
+    if (!pool) {
+        async_log_shutdown();
+        return 1;
+    }
+    if (pin_workers) {
+        thread_pool_place_on_cores(pool);
+    }
+
+    // Add some tasks; numbers[] outlives them because we wait below
+    for (int i = 0; i < NUM_TASKS; i++) {
+        numbers[i] = i;
+        futures[i] = thread_pool_submit_future(pool, example_task, &numbers[i], 0);
+    }
+
+    // Wait for tasks to complete
+    for (int i = 0; i < NUM_TASKS; i++) {
+        thread_pool_future_destroy(futures[i]);
+    }
+
+    thread_pool_shutdown(pool);
+    thread_pool_action("Thread pool finished");
+    async_log_shutdown();
+    return 0;
+}
@@ -7,8 +7,14 @@
  * - Priority-based scheduling
  * - Thread state tracking
  * - Performance monitoring
+ * - Placement through thread_affinity.h: pinned to a CPU, a physical core
+ *   (the default) or a NUMA node, with migrations counted during the work
+ * - SCHED_FIFO, SCHED_RR or SCHED_OTHER with validated priorities
+ *
+ * Usage: thread_priority [--policy fifo|rr|other] [--pin none|cpu|core|node]
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
@@ -16,24 +22,41 @@
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#include <unistd.h>
+
+#include "thread_affinity.h"
 
 // Constants
 #define MAX_THREADS 5
 #define MAX_ITERATIONS 1000000
 #define PRIORITY_LEVELS 5
 #define LOG_FILE "thread_priority.log"
+#define CPU_CHECK_INTERVAL 4096     // Iterations between sched_getcpu() samples
+
+// Where threads are allowed to run
+typedef enum {
+    PIN_NONE,
+    PIN_CPU,    // Thread i on the i-th usable CPU
+    PIN_CORE,   // Thread i on all CPUs of the i-th physical core
+    PIN_NODE    // Thread i on all CPUs of NUMA node i mod node_count
+} pin_mode_t;
 
 // Structure to hold thread data
 typedef struct {
     int id;
+    int policy;
     int priority;
     int iterations;
+    int migrations;     // CPU changes seen during the work
+    int last_cpu;
     struct timespec start_time;
     struct timespec end_time;
 } thread_data_t;
 
 // Global variables
 static pthread_mutex_t output_mutex = PTHREAD_MUTEX_INITIALIZER;
+static cpu_topology_t topology;
+static pin_mode_t pin_mode = PIN_CORE;
 
 // Function to log messages to a file
 static void log_message(const char *message) {
@@ -56,28 +79,55 @@ void thread_priority_action(const char *action) {
  */
 static void *thread_function(void *arg) {
     thread_data_t *data = (thread_data_t *)arg;
-    struct sched_param param;
-    int result;
+    pthread_t self = pthread_self();
+    int placed = 0;
     int i;
     double dummy = 0.0;
 
-    // Set thread priority
-    param.sched_priority = data->priority;
-    result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
-    if (result != 0) {
+    // Place the thread before it touches its working set
+    switch (pin_mode) {
+        case PIN_CPU:
+            placed = affinity_pin_cpu(self, topology.cpus[data->id % topology.cpu_count].cpu);
+            break;
+        case PIN_CORE:
+            placed = affinity_place_worker(self, &topology, data->id);
+            break;
+        case PIN_NODE:
+            placed = affinity_pin_node(self, &topology, data->id % topology.node_count);
+            break;
+        case PIN_NONE:
+            break;
+    }
+    if (placed != 0) {
+        pthread_mutex_lock(&output_mutex);
+        fprintf(stderr, "Thread %d runs unpinned\n", data->id);
+        pthread_mutex_unlock(&output_mutex);
+    }
+
+    // Set thread priority; without the privilege keep the default policy
+    if (thread_set_policy(self, data->policy, data->priority) != 0) {
         pthread_mutex_lock(&output_mutex);
-        fprintf(stderr, "Error setting priority for thread %d: %s\n", 
-                data->id, strerror(result));
+        fprintf(stderr, "Thread %d keeps SCHED_OTHER\n", data->id);
         pthread_mutex_unlock(&output_mutex);
-        return NULL;
+        data->policy = SCHED_OTHER;
+        data->priority = 0;
     }
 
     // Record start time
     clock_gettime(CLOCK_MONOTONIC, &data->start_time);
+    data->last_cpu = sched_getcpu();
+    data->migrations = 0;
 
-    // Perform work
+    // Perform work, sampling the CPU to count migrations
     for (i = 0; i < data->iterations; i++) {
         dummy += (double)i / (i + 1);
+        if (i % CPU_CHECK_INTERVAL == 0) {
+            int cpu = sched_getcpu();
+            if (cpu != data->last_cpu) {
+                data->migrations++;
+                data->last_cpu = cpu;
+            }
+        }
     }
 
     // Record end time
@@ -88,23 +138,85 @@ static void *thread_function(void *arg) {
                           (data->end_time.tv_nsec - data->start_time.tv_nsec) / 1e9;
 
     pthread_mutex_lock(&output_mutex);
-    printf("Thread %d (Priority %d): Completed %d iterations in %.6f seconds\n",
-           data->id, data->priority, data->iterations, execution_time);
+    printf("Thread %d (%s priority %d, CPU %d): Completed %d iterations in %.6f seconds, "
+           "%d migrations\n",
+           data->id, sched_policy_name(data->policy), data->priority, data->last_cpu,
+           data->iterations, execution_time, data->migrations);
     pthread_mutex_unlock(&output_mutex);
 
     return NULL;
 }
 
+// Print the discovered topology
+static void print_topology(void) {
+    printf("Topology: %d CPUs, %d physical cores, %d NUMA nodes\n",
+           topology.cpu_count, topology.core_count, topology.node_count);
+    for (int i = 0; i < topology.cpu_count; i++) {
+        printf("  CPU %d: core %d, node %d\n",
+               topology.cpus[i].cpu, topology.cpus[i].core, topology.cpus[i].node);
+    }
+}
+
+// Parse a policy name
+static int parse_policy(const char *name) {
+    if (strcmp(name, "fifo") == 0) {
+        return SCHED_FIFO;
+    }
+    if (strcmp(name, "rr") == 0) {
+        return SCHED_RR;
+    }
+    if (strcmp(name, "other") == 0) {
+        return SCHED_OTHER;
+    }
+    return -1;
+}
+
+// Parse a placement name
+static int parse_pin(const char *name) {
+    const char *names[] = { "none", "cpu", "core", "node" };
+    for (int i = 0; i < 4; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 /**
  * Main function demonstrating thread priority management
  * @return 0 on success, 1 on error
  */
-int main(void) {
+int main(int argc, char *argv[]) {
     pthread_t threads[MAX_THREADS];
     thread_data_t thread_data[MAX_THREADS];
+    int policy = SCHED_FIFO;
     int result;
     int i;
 
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            policy = parse_policy(argv[++i]);
+        } else if (strcmp(argv[i], "--pin") == 0 && i + 1 < argc) {
+            int mode = parse_pin(argv[++i]);
+            pin_mode = mode < 0 ? PIN_NONE : (pin_mode_t)mode;
+            if (mode < 0) {
+                policy = -1;
+            }
+        } else {
+            policy = -1;
+        }
+        if (policy < 0) {
+            fprintf(stderr, "Usage: %s [--policy fifo|rr|other] [--pin none|cpu|core|node]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (cpu_topology_discover(&topology) != 0) {
+        return 1;
+    }
+    print_topology();
+
     log_message("Thread priority management started");
 
     // Check if we have sufficient privileges for real-time scheduling
@@ -112,11 +224,16 @@ int main(void) {
         fprintf(stderr, "Warning: Program should be run with root privileges for real-time scheduling\n");
     }
 
-    // Initialize thread data
+    // Initialize thread data; reject bad priorities before starting anything
     for (i = 0; i < MAX_THREADS; i++) {
         thread_data[i].id = i;
-        thread_data[i].priority = (i % PRIORITY_LEVELS) + 1;
+        thread_data[i].policy = policy;
+        thread_data[i].priority = policy == SCHED_OTHER ? 0 : (i % PRIORITY_LEVELS) + 1;
         thread_data[i].iterations = MAX_ITERATIONS / (i + 1);
+        if (sched_policy_validate(policy, thread_data[i].priority) != 0) {
+            cpu_topology_free(&topology);
+            return 1;
+        }
     }
 
     // Create threads
@@ -128,6 +245,7 @@ int main(void) {
             for (int j = 0; j < i; j++) {
                 pthread_join(threads[j], NULL);
             }
+            cpu_topology_free(&topology);
             return 1;
         }
     }
@@ -141,6 +259,7 @@ int main(void) {
     }
 
     log_message("Thread priority management finished");
+    cpu_topology_free(&topology);
 
     return 0;
 }
\ No newline at end of file
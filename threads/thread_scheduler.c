@@ -1,28 +1,58 @@
 /**
  * Thread Scheduling Visualization using POSIX Threads and ncurses
- * 
+ *
  * This program demonstrates thread scheduling with real-time visualization
  * using POSIX threads and ncurses library. Features include:
  * - Real-time display of thread states
- * - Priority-based scheduling
+ * - Multi-level feedback queue (MLFQ) scheduling
  * - Thread state tracking
  * - Performance monitoring
+ *
+ * The simulated CPU is a token: exactly one worker runs at a time, and the
+ * worker giving up the CPU picks its successor and hands over directly by
+ * setting the successor's futex word, so each switch wakes one thread.
+ * Only the token holder touches the runqueues, so they need no lock;
+ * threads returning from simulated I/O push themselves onto a lock-free
+ * wakeup stack that the holder drains. MLFQ rules:
+ * - New threads start at level 0, the highest
+ * - Using a whole quantum demotes a thread; quanta double per level
+ * - Giving up the CPU early (interactive threads) keeps the level
+ * - Every BOOST_INTERVAL dispatches all threads return to level 0
+ * CPU time comes from CLOCK_THREAD_CPUTIME_ID around each slice, and the
+ * display only reads counters, so it never delays a switch.
+ *
+ * Usage: thread_scheduler [threads]
+ *        thread_scheduler --bench [threads] [seconds]
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <ncurses.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
 #include <unistd.h>
+#include <stdatomic.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 // Constants
-#define MAX_THREADS 5
+#define MAX_THREADS 5                   // Threads in the default visualization
+#define MAX_SIM_THREADS 4096
 #define MAX_ITERATIONS 1000000
 #define PRIORITY_LEVELS 5
-#define REFRESH_RATE 100000  // microseconds
+#define REFRESH_RATE 100000             // microseconds
+#define WORK_UNIT 1000                  // Loop iterations per unit of work
+#define BASE_QUANTUM 4                  // Work units per slice at level 0, doubling per level
+#define BOOST_INTERVAL 1000             // Dispatches between priority boosts
+#define IO_SLEEP_US 2000                // Simulated I/O of interactive threads
+#define INTERACTIVE_EVERY 3             // Every third thread is interactive
+#define THREAD_STACK_SIZE (64 * 1024)
+#define DEFAULT_BENCH_THREADS 1000
+#define DEFAULT_BENCH_SECONDS 2
 
 // Thread states
 typedef enum {
@@ -32,66 +62,259 @@ typedef enum {
     TERMINATED
 } thread_state_t;
 
+// How the CPU token is passed
+typedef enum {
+    HANDOFF_FUTEX,      // Wake exactly the chosen thread
+    HANDOFF_BROADCAST   // Baseline: one condition variable shared by all
+} handoff_mode_t;
+
 // Structure to hold thread information
-typedef struct {
+typedef struct thread_info {
     int id;
-    int priority;
-    thread_state_t state;
-    unsigned long long cpu_time;
-    unsigned long long total_time;
-    struct timespec start_time;
-    struct timespec end_time;
+    _Atomic int priority;                   // MLFQ level, 0 is the highest
+    int interactive;                        // Gives up the CPU early for I/O
+    _Atomic int state;
+    _Atomic int go;                         // Futex word, 1 once handed the CPU
+    _Atomic unsigned long long cpu_time;    // Nanoseconds of thread CPU time
+    _Atomic unsigned long slices;
+    unsigned epoch;                         // Boost epoch of the level
+    unsigned seed;
+    struct thread_info *next;               // Runqueue link, owned by the CPU holder
+    struct thread_info *wake_next;          // Wakeup stack link
+    pthread_t tid;
 } thread_info_t;
 
 // Global variables
 static pthread_mutex_t scheduler_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t scheduler_cond = PTHREAD_COND_INITIALIZER;
-static thread_info_t thread_info[MAX_THREADS];
-static int running_thread = -1;
-static int should_exit = 0;
+static thread_info_t *thread_info;
+static int num_threads;
+static int running_thread = -1;         // Broadcast mode: thread given the CPU
+static _Atomic int should_exit;
+static handoff_mode_t handoff_mode = HANDOFF_FUTEX;
+
+// Runqueues, touched only by the thread holding the CPU
+static thread_info_t *run_head[PRIORITY_LEVELS];
+static thread_info_t *run_tail[PRIORITY_LEVELS];
+static unsigned run_bitmap;             // Bit n set when level n is not empty
+static unsigned boost_epoch;
+static unsigned long dispatch_count;
+static struct timespec handoff_time;    // When the last handoff started
+
+// Wakeups from simulated I/O, and whether nobody holds the CPU
+static _Atomic(thread_info_t *) wakeups;
+static _Atomic int cpu_idle;
+
+// Statistics
+static _Atomic unsigned long handoffs;
+static _Atomic unsigned long long handoff_ns;
+static _Atomic unsigned long boosts;
+static volatile double work_sink;
+
+// Futex wrappers (private: all waiters are threads of this process)
+static void futex_wait(_Atomic int *addr, int value) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void futex_wake(_Atomic int *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+// Time difference in nanoseconds
+static unsigned long long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1000000000ULL + end->tv_nsec - start->tv_nsec;
+}
 
 /**
  * Initialize thread information
  */
 static void init_threads(void) {
-    for (int i = 0; i < MAX_THREADS; i++) {
+    for (int i = 0; i < num_threads; i++) {
         thread_info[i].id = i;
-        thread_info[i].priority = (i % PRIORITY_LEVELS) + 1;
+        thread_info[i].priority = 0;
+        thread_info[i].interactive = (i % INTERACTIVE_EVERY) == 0;
         thread_info[i].state = READY;
+        thread_info[i].go = 0;
         thread_info[i].cpu_time = 0;
-        thread_info[i].total_time = 0;
+        thread_info[i].slices = 0;
+        thread_info[i].epoch = boost_epoch;
+        thread_info[i].seed = (unsigned)i * 2654435761u + 1;
+    }
+}
+
+// Append a thread at the tail of its level; a stale epoch means a boost
+// happened since the thread was last queued
+static void runqueue_push(thread_info_t *t) {
+    if (t->epoch != boost_epoch) {
+        t->epoch = boost_epoch;
+        t->priority = 0;
+    }
+    int level = t->priority;
+
+    t->next = NULL;
+    if (run_tail[level]) {
+        run_tail[level]->next = t;
+    } else {
+        run_head[level] = t;
+    }
+    run_tail[level] = t;
+    run_bitmap |= 1u << level;
+    t->state = READY;
+}
+
+// Take the first thread of the highest non-empty level
+static thread_info_t *runqueue_pop(void) {
+    if (!run_bitmap) {
+        return NULL;
+    }
+    int level = __builtin_ctz(run_bitmap);
+    thread_info_t *t = run_head[level];
+
+    run_head[level] = t->next;
+    if (!run_head[level]) {
+        run_tail[level] = NULL;
+        run_bitmap &= ~(1u << level);
+    }
+    if (t->epoch != boost_epoch) {
+        t->epoch = boost_epoch;
+        t->priority = 0;
+    }
+    return t;
+}
+
+// Move every queued thread to level 0, keeping their order; threads not
+// queued are reset when they are next queued (see runqueue_push)
+static void priority_boost(void) {
+    boost_epoch++;
+    boosts++;
+    for (int level = 1; level < PRIORITY_LEVELS; level++) {
+        if (!run_head[level]) {
+            continue;
+        }
+        if (run_tail[0]) {
+            run_tail[0]->next = run_head[level];
+        } else {
+            run_head[0] = run_head[level];
+        }
+        run_tail[0] = run_tail[level];
+        run_head[level] = run_tail[level] = NULL;
+    }
+    run_bitmap = run_head[0] ? 1 : 0;
+}
+
+// Queue every thread that came back from I/O, oldest first
+static void drain_wakeups(void) {
+    thread_info_t *stack = atomic_exchange(&wakeups, NULL);
+    thread_info_t *fifo = NULL;
+
+    while (stack) {
+        thread_info_t *next = stack->wake_next;
+        stack->wake_next = fifo;
+        fifo = stack;
+        stack = next;
+    }
+    while (fifo) {
+        thread_info_t *next = fifo->wake_next;
+        runqueue_push(fifo);
+        fifo = next;
+    }
+}
+
+// Give the CPU to another thread
+static void hand_to(thread_info_t *next) {
+    clock_gettime(CLOCK_MONOTONIC, &handoff_time);
+    handoffs++;
+
+    if (handoff_mode == HANDOFF_FUTEX) {
+        atomic_store_explicit(&next->go, 1, memory_order_release);
+        futex_wake(&next->go);
+    } else {
+        pthread_mutex_lock(&scheduler_mutex);
+        running_thread = next->id;
+        pthread_cond_broadcast(&scheduler_cond);
+        pthread_mutex_unlock(&scheduler_mutex);
+    }
+}
+
+// Block until handed the CPU (or told to exit)
+static void wait_for_cpu(thread_info_t *self) {
+    struct timespec now;
+
+    if (handoff_mode == HANDOFF_FUTEX) {
+        while (atomic_exchange_explicit(&self->go, 0, memory_order_acquire) == 0) {
+            futex_wait(&self->go, 0);
+        }
+    } else {
+        pthread_mutex_lock(&scheduler_mutex);
+        while (running_thread != self->id && !should_exit) {
+            pthread_cond_wait(&scheduler_cond, &scheduler_mutex);
+        }
+        running_thread = -1;
+        pthread_mutex_unlock(&scheduler_mutex);
+    }
+
+    if (!should_exit) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        handoff_ns += elapsed_ns(&handoff_time, &now);
     }
 }
 
 /**
- * Display thread states and information
+ * Pick the next thread and pass the CPU to it; the caller holds the CPU
+ * @param self Caller when it is queued and may keep running, else NULL
+ * @return 1 if self was picked and keeps the CPU, 0 if the CPU was passed on
  */
-static void display_threads(void) {
-    clear();
-    mvprintw(0, 0, "Thread Scheduler Visualization");
-    mvprintw(1, 0, "Press 'q' to quit");
-    mvprintw(3, 0, "Thread ID  Priority  State      CPU Time    Total Time");
-    mvprintw(4, 0, "------------------------------------------------------");
-
-    for (int i = 0; i < MAX_THREADS; i++) {
-        const char *state_str;
-        switch (thread_info[i].state) {
-            case READY: state_str = "READY"; break;
-            case RUNNING: state_str = "RUNNING"; break;
-            case BLOCKED: state_str = "BLOCKED"; break;
-            case TERMINATED: state_str = "TERMINATED"; break;
-            default: state_str = "UNKNOWN"; break;
+static int schedule_next(thread_info_t *self) {
+    for (;;) {
+        drain_wakeups();
+        if (++dispatch_count % BOOST_INTERVAL == 0) {
+            priority_boost();
+        }
+
+        thread_info_t *next = runqueue_pop();
+        if (next) {
+            next->state = RUNNING;
+            if (next == self) {
+                return 1;
+            }
+            hand_to(next);
+            return 0;
         }
 
-        mvprintw(5 + i, 0, "%-9d %-9d %-10s %-11llu %-11llu",
-                thread_info[i].id,
-                thread_info[i].priority,
-                state_str,
-                thread_info[i].cpu_time,
-                thread_info[i].total_time);
+        // Nothing runnable: leave the CPU idle, unless a wakeup arrived
+        // after the drain and its thread saw the CPU still held
+        atomic_store(&cpu_idle, 1);
+        if (atomic_load(&wakeups) == NULL) {
+            return 0;
+        }
+        int expected = 1;
+        if (!atomic_compare_exchange_strong(&cpu_idle, &expected, 0)) {
+            return 0;   // The waking thread took the CPU itself
+        }
     }
+}
 
-    refresh();
+// Return from I/O: queue for the CPU, dispatching if the CPU is idle
+static void wake_thread(thread_info_t *self) {
+    thread_info_t *head = atomic_load(&wakeups);
+    int expected = 1;
+
+    do {
+        self->wake_next = head;
+    } while (!atomic_compare_exchange_weak(&wakeups, &head, self));
+
+    if (atomic_compare_exchange_strong(&cpu_idle, &expected, 0)) {
+        schedule_next(NULL);
+    }
+}
+
+// Simulated computation
+static void do_work(int units) {
+    double dummy = 0.0;
+    for (int i = 0; i < units * WORK_UNIT; i++) {
+        dummy += (double)i / (i + 1);
+    }
+    work_sink = dummy;
 }
 
 /**
@@ -102,93 +325,237 @@ static void display_threads(void) {
 static void *thread_function(void *arg) {
     thread_info_t *info = (thread_info_t *)arg;
     struct timespec start, end;
-    double dummy = 0.0;
 
+    wait_for_cpu(info);
     while (!should_exit) {
-        pthread_mutex_lock(&scheduler_mutex);
-        
-        // Wait until this thread is selected to run
-        while (running_thread != info->id && !should_exit) {
-            pthread_cond_wait(&scheduler_cond, &scheduler_mutex);
-        }
+        int quantum = BASE_QUANTUM << info->priority;
+        int units = info->interactive ? 1 + (int)(rand_r(&info->seed) % (BASE_QUANTUM - 1))
+                                      : quantum;
+
+        // Perform work, timing only this thread's CPU use
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+        do_work(units);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+        info->cpu_time += elapsed_ns(&start, &end);
+        info->slices++;
 
+        // A thread that used its whole quantum moves down a level
+        if (units >= quantum && info->priority < PRIORITY_LEVELS - 1) {
+            info->priority++;
+        }
         if (should_exit) {
-            pthread_mutex_unlock(&scheduler_mutex);
             break;
         }
 
-        // Update thread state
-        info->state = RUNNING;
-        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (info->interactive) {
+            info->state = BLOCKED;
+            schedule_next(NULL);
+            usleep(IO_SLEEP_US);
+            if (should_exit) {
+                break;
+            }
+            wake_thread(info);
+            wait_for_cpu(info);
+        } else {
+            runqueue_push(info);
+            if (!schedule_next(info)) {
+                wait_for_cpu(info);
+            }
+        }
+    }
 
-        pthread_mutex_unlock(&scheduler_mutex);
+    info->state = TERMINATED;
+    return NULL;
+}
+
+// State name for the display
+static const char *state_name(int state) {
+    switch (state) {
+        case READY: return "READY";
+        case RUNNING: return "RUNNING";
+        case BLOCKED: return "BLOCKED";
+        case TERMINATED: return "TERMINATED";
+        default: return "UNKNOWN";
+    }
+}
 
-        // Perform work
-        for (int i = 0; i < info->priority * 1000; i++) {
-            dummy += (double)i / (i + 1);
+/**
+ * Display thread states and information; reads counters only
+ */
+static void display_threads(void) {
+    int per_level[PRIORITY_LEVELS] = { 0 };
+    int rows = LINES - 8;
+
+    for (int i = 0; i < num_threads; i++) {
+        per_level[thread_info[i].priority]++;
+    }
+
+    clear();
+    mvprintw(0, 0, "Thread Scheduler Visualization (MLFQ, %d threads)", num_threads);
+    mvprintw(1, 0, "Press 'q' to quit");
+    mvprintw(2, 0, "Handoffs: %lu  Boosts: %lu  Threads per level:",
+             (unsigned long)handoffs, (unsigned long)boosts);
+    for (int level = 0; level < PRIORITY_LEVELS; level++) {
+        printw(" %d", per_level[level]);
+    }
+    mvprintw(4, 0, "Thread ID  Level  Type         State      CPU Time (ms)  Slices");
+    mvprintw(5, 0, "---------------------------------------------------------------");
+
+    for (int i = 0; i < num_threads && i < rows; i++) {
+        mvprintw(6 + i, 0, "%-10d %-6d %-12s %-10s %-14.3f %lu",
+                 thread_info[i].id,
+                 (int)thread_info[i].priority,
+                 thread_info[i].interactive ? "interactive" : "cpu-bound",
+                 state_name(thread_info[i].state),
+                 thread_info[i].cpu_time / 1e6,
+                 (unsigned long)thread_info[i].slices);
+    }
+
+    refresh();
+}
+
+/**
+ * Create the workers and hand the CPU to the first one
+ * @return 0 on success, -1 on error (no workers left running)
+ */
+static int start_threads(void) {
+    pthread_attr_t attr;
+    int result;
+
+    should_exit = 0;
+    handoffs = 0;
+    handoff_ns = 0;
+    boosts = 0;
+    dispatch_count = 0;
+    cpu_idle = 0;
+    wakeups = NULL;
+    init_threads();
+    for (int i = 0; i < num_threads; i++) {
+        runqueue_push(&thread_info[i]);
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+    for (int i = 0; i < num_threads; i++) {
+        result = pthread_create(&thread_info[i].tid, &attr,
+                                thread_function, &thread_info[i]);
+        if (result != 0) {
+            fprintf(stderr, "Error creating thread %d: %s\n", i, strerror(result));
+            num_threads = i;
+            pthread_attr_destroy(&attr);
+            return -1;
         }
+    }
+    pthread_attr_destroy(&attr);
 
-        pthread_mutex_lock(&scheduler_mutex);
-        
-        // Update timing information
-        clock_gettime(CLOCK_MONOTONIC, &end);
-        info->cpu_time += (end.tv_sec - start.tv_sec) * 1000000000 + 
-                         (end.tv_nsec - start.tv_nsec);
-        info->total_time = info->cpu_time;
-        
-        // Change state back to ready
-        info->state = READY;
-        running_thread = -1;
-        
-        pthread_cond_broadcast(&scheduler_cond);
-        pthread_mutex_unlock(&scheduler_mutex);
+    // The main thread holds the CPU until it passes it to the first worker
+    schedule_next(NULL);
+    return 0;
+}
+
+// Tell every worker to exit, wake them all and wait for them
+static void stop_threads(void) {
+    should_exit = 1;
+    for (int i = 0; i < num_threads; i++) {
+        thread_info[i].go = 1;
+        futex_wake(&thread_info[i].go);
     }
+    pthread_mutex_lock(&scheduler_mutex);
+    pthread_cond_broadcast(&scheduler_cond);
+    pthread_mutex_unlock(&scheduler_mutex);
 
-    return NULL;
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(thread_info[i].tid, NULL);
+    }
+
+    // Leave the runqueues empty for the next run
+    for (int level = 0; level < PRIORITY_LEVELS; level++) {
+        run_head[level] = run_tail[level] = NULL;
+    }
+    run_bitmap = 0;
 }
 
 /**
- * Scheduler function that selects the next thread to run
+ * Benchmark mode: futex handoff against the broadcast baseline
+ * @param threads Simulated threads
+ * @param seconds Run time per mode
+ * @return 0 on success, 1 on error
  */
-static void *scheduler_function(void *arg) {
-    (void)arg;  // Unused parameter
-    
-    while (!should_exit) {
-        pthread_mutex_lock(&scheduler_mutex);
-        
-        // Find highest priority ready thread
-        int highest_priority = -1;
-        int selected_thread = -1;
-        
-        for (int i = 0; i < MAX_THREADS; i++) {
-            if (thread_info[i].state == READY && 
-                thread_info[i].priority > highest_priority) {
-                highest_priority = thread_info[i].priority;
-                selected_thread = i;
-            }
+static int run_bench(int threads, int seconds) {
+    const char *names[] = { "futex handoff", "broadcast" };
+
+    printf("%d threads (every %d%s interactive), %d s per mode\n",
+           threads, INTERACTIVE_EVERY, INTERACTIVE_EVERY == 3 ? "rd" : "th", seconds);
+    printf("%-14s %12s %14s %10s %12s %12s\n", "Mode", "Handoffs/s", "Latency (us)",
+           "Boosts", "In slices", "Fairness");
+
+    for (int mode = HANDOFF_FUTEX; mode <= HANDOFF_BROADCAST; mode++) {
+        struct timespec start, end, cpu_start, cpu_end;
+        unsigned long long accounted = 0;
+        double sum = 0, sum_sq = 0;
+        int cpu_bound = 0;
+
+        handoff_mode = (handoff_mode_t)mode;
+        num_threads = threads;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+        if (start_threads() != 0) {
+            stop_threads();
+            return 1;
         }
-        
-        if (selected_thread != -1) {
-            running_thread = selected_thread;
-            pthread_cond_broadcast(&scheduler_cond);
+        sleep(seconds);
+        stop_threads();
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        // Jain's index over the CPU-bound threads' CPU time
+        for (int i = 0; i < threads; i++) {
+            double t = (double)thread_info[i].cpu_time;
+            accounted += thread_info[i].cpu_time;
+            if (!thread_info[i].interactive) {
+                sum += t;
+                sum_sq += t * t;
+                cpu_bound++;
+            }
         }
-        
-        pthread_mutex_unlock(&scheduler_mutex);
-        usleep(REFRESH_RATE);
+        unsigned long n = handoffs;
+        printf("%-14s %12.0f %14.2f %10lu %11.1f%% %12.3f\n", names[mode],
+               n / (elapsed_ns(&start, &end) / 1e9),
+               n ? handoff_ns / 1e3 / n : 0.0,
+               (unsigned long)boosts,
+               100.0 * accounted / elapsed_ns(&cpu_start, &cpu_end),
+               sum_sq > 0 ? sum * sum / (cpu_bound * sum_sq) : 1.0);
     }
-    
-    return NULL;
+    printf("In slices: time measured from CLOCK_THREAD_CPUTIME_ID as a share of process CPU time\n");
+    return 0;
 }
 
 /**
  * Main function demonstrating thread scheduling visualization
  * @return 0 on success, 1 on error
  */
-int main(void) {
-    pthread_t threads[MAX_THREADS];
-    pthread_t scheduler_thread;
-    int result;
+int main(int argc, char *argv[]) {
     int ch;
+    int bench = argc > 1 && strcmp(argv[1], "--bench") == 0;
+    int arg = bench ? 2 : 1;
+    int threads = argc > arg ? atoi(argv[arg]) : (bench ? DEFAULT_BENCH_THREADS : MAX_THREADS);
+    int seconds = bench && argc > 3 ? atoi(argv[3]) : DEFAULT_BENCH_SECONDS;
+
+    if (threads < 1 || threads > MAX_SIM_THREADS || seconds < 1) {
+        fprintf(stderr, "Usage: %s [threads] | --bench [threads] [seconds] "
+                "(threads 1-%d)\n", argv[0], MAX_SIM_THREADS);
+        return 1;
+    }
+    thread_info = calloc(threads, sizeof(*thread_info));
+    if (!thread_info) {
+        perror("Failed to allocate threads");
+        return 1;
+    }
+    if (bench) {
+        int status = run_bench(threads, seconds);
+        free(thread_info);
+        return status;
+    }
 
     // Initialize ncurses
     initscr();
@@ -197,49 +564,25 @@ int main(void) {
     nodelay(stdscr, TRUE);
     keypad(stdscr, TRUE);
 
-    // Initialize thread information
-    init_threads();
-
-    // Create scheduler thread
-    result = pthread_create(&scheduler_thread, NULL, scheduler_function, NULL);
-    if (result != 0) {
+    // Create worker threads
+    num_threads = threads;
+    if (start_threads() != 0) {
+        stop_threads();
         endwin();
-        fprintf(stderr, "Error creating scheduler thread: %s\n", strerror(result));
+        free(thread_info);
         return 1;
     }
 
-    // Create worker threads
-    for (int i = 0; i < MAX_THREADS; i++) {
-        result = pthread_create(&threads[i], NULL, thread_function, &thread_info[i]);
-        if (result != 0) {
-            should_exit = 1;
-            pthread_cond_broadcast(&scheduler_cond);
-            for (int j = 0; j < i; j++) {
-                pthread_join(threads[j], NULL);
-            }
-            pthread_join(scheduler_thread, NULL);
-            endwin();
-            fprintf(stderr, "Error creating thread %d: %s\n", i, strerror(result));
-            return 1;
-        }
-    }
-
-    // Main loop
+    // Main loop: the display runs on its own schedule, off the handoff path
     while ((ch = getch()) != 'q') {
         display_threads();
         usleep(REFRESH_RATE);
     }
 
     // Cleanup
-    should_exit = 1;
-    pthread_cond_broadcast(&scheduler_cond);
-    
-    for (int i = 0; i < MAX_THREADS; i++) {
-        pthread_join(threads[i], NULL);
-    }
-    
-    pthread_join(scheduler_thread, NULL);
+    stop_threads();
     endwin();
+    free(thread_info);
 
     return 0;
-} 
\ No newline at end of file
+}
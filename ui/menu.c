@@ -11,6 +11,11 @@
  * - Input validation
  * - Error handling
  * - Graceful exit
+ * - Live view of the counters other programs publish through stats.h
+ *
+ * Usage: menu
+ *        menu --stats [seconds]   (print the statistics once, with rates
+ *                                  over the given interval, and exit)
  */
 
 #include <stdio.h>
@@ -22,12 +27,16 @@
 #include <signal.h>
 #include <time.h>
 
+#include "stats.h"
+
 // Constants
 #define MAX_OPTIONS 10
 #define MAX_TITLE_LENGTH 50
 #define MAX_DESC_LENGTH 200
 #define MAX_INPUT_LENGTH 10
 #define LOG_FILE "menu.log"
+#define STATS_VIEW_MAX 16           // Processes shown on the statistics screen
+#define STATS_REFRESH_MS 1000
 
 // Menu option structure
 typedef struct {
@@ -43,10 +52,21 @@ typedef struct {
     int option_count;
 } Menu;
 
+// Statistics of one process at one refresh
+typedef struct {
+    pid_t pid;
+    uint64_t taken_ns;
+    stats_totals_t totals;
+} StatsSnapshot;
+
+// Output function: printf outside ncurses, printw on the live screen
+typedef int (*PrintFn)(const char *format, ...);
+
 // Function prototypes
 static void show_threads_menu(void);
 static void show_process_menu(void);
 static void show_sync_menu(void);
+static void show_stats(void);
 static void clear_screen(void);
 static void print_header(const char* title);
 static void print_footer(void);
@@ -67,9 +87,10 @@ static Menu main_menu = {
         {"Threads", "Thread creation, management and synchronization", show_threads_menu},
         {"Processes", "Process creation, management and IPC", show_process_menu},
         {"Synchronization", "Synchronization problems and solutions", show_sync_menu},
+        {"Live Statistics", "Lock, task queue and network counters of running programs", show_stats},
         {"Exit", "Exit program", NULL}
     },
-    4
+    5
 };
 
 static Menu threads_menu = {
@@ -224,6 +245,222 @@ static void show_sync_menu(void) {
     show_menu(&sync_menu);
 }
 
+// Format a duration with a unit that keeps it short
+static const char *format_ns(char *buffer, size_t size, uint64_t ns) {
+    if (ns < 10000) {
+        snprintf(buffer, size, "%llu ns", (unsigned long long)ns);
+    } else if (ns < 10000000) {
+        snprintf(buffer, size, "%.1f us", ns / 1e3);
+    } else if (ns < 10000000000ULL) {
+        snprintf(buffer, size, "%.1f ms", ns / 1e6);
+    } else {
+        snprintf(buffer, size, "%.1f s", ns / 1e9);
+    }
+    return buffer;
+}
+
+// Format a byte count in binary units
+static const char *format_bytes(char *buffer, size_t size, double bytes) {
+    static const char *units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+    int unit = 0;
+
+    while (bytes >= 1024 && unit < 4) {
+        bytes /= 1024;
+        unit++;
+    }
+    snprintf(buffer, size, unit == 0 ? "%.0f %s" : "%.1f %s", bytes, units[unit]);
+    return buffer;
+}
+
+// Output function that discards everything
+static int print_nothing(const char *format, ...) {
+    (void)format;
+    return 0;
+}
+
+// Difference of a counter since the previous snapshot, per second
+static double stats_rate(uint64_t now, uint64_t before, double seconds) {
+    return seconds > 0 && now >= before ? (now - before) / seconds : 0;
+}
+
+/**
+ * Print the statistics of one process
+ * @param out printf or printw
+ * @param page The process's page
+ * @param now Current totals
+ * @param prev Totals at the previous refresh, NULL for none
+ * @param seconds Time since the previous refresh
+ */
+static void print_stats(PrintFn out, const stats_page_t *page, const stats_totals_t *now,
+                        const stats_totals_t *prev, double seconds) {
+    const uint64_t *c = now->counters;
+    char a[32], b[32];
+
+    out("%s (pid %d): %d threads, up %s\n", page->program, (int)page->pid, now->threads,
+        format_ns(a, sizeof(a), stats_now_ns() - page->start_ns));
+
+    if (c[STATS_TASKS_SUBMITTED] > 0) {
+        uint64_t started = c[STATS_TASKS_STARTED];
+        uint64_t completed = c[STATS_TASKS_COMPLETED];
+
+        // Counters are read slot by slot, so clamp the differences
+        out("  Tasks     %llu submitted, %llu started, %llu completed",
+            (unsigned long long)c[STATS_TASKS_SUBMITTED], (unsigned long long)started,
+            (unsigned long long)completed);
+        if (prev) {
+            out(" (%.0f/s)", stats_rate(completed, prev->counters[STATS_TASKS_COMPLETED],
+                                        seconds));
+        }
+        out("\n            %llu queued, %llu running, deepest shared queue %llu\n",
+            (unsigned long long)(c[STATS_TASKS_SUBMITTED] > started ?
+                                 c[STATS_TASKS_SUBMITTED] - started : 0),
+            (unsigned long long)(started > completed ? started - completed : 0),
+            (unsigned long long)now->queue_high_water);
+        out("  Waiting   p50 %s, p99 %s, 1 task in %d sampled\n",
+            format_ns(a, sizeof(a), stats_quantile(now->histograms[STATS_HIST_TASK_QUEUED], 0.50)),
+            format_ns(b, sizeof(b), stats_quantile(now->histograms[STATS_HIST_TASK_QUEUED], 0.99)),
+            STATS_SAMPLE_INTERVAL);
+        out("  Running   p50 %s, p99 %s\n",
+            format_ns(a, sizeof(a), stats_quantile(now->histograms[STATS_HIST_TASK_RUN], 0.50)),
+            format_ns(b, sizeof(b), stats_quantile(now->histograms[STATS_HIST_TASK_RUN], 0.99)));
+    }
+
+    for (int l = 0; l < now->lock_classes; l++) {
+        uint64_t acquires = now->locks[l].acquires;
+
+        if (acquires == 0) {
+            continue;
+        }
+        out("  Lock %-20s %llu acquired", page->lock_names[l], (unsigned long long)acquires);
+        if (prev) {
+            out(" (%.0f/s)", stats_rate(acquires, prev->locks[l].acquires, seconds));
+        }
+        out(", %.2f%% contended, %s waited\n", 100.0 * now->locks[l].contended / acquires,
+            format_ns(a, sizeof(a), now->locks[l].wait_ns));
+    }
+    if (now->lock_classes > 0 && stats_quantile(now->histograms[STATS_HIST_LOCK_WAIT], 1.0) > 0) {
+        out("  Lock wait p50 %s, p99 %s when contended\n",
+            format_ns(a, sizeof(a), stats_quantile(now->histograms[STATS_HIST_LOCK_WAIT], 0.50)),
+            format_ns(b, sizeof(b), stats_quantile(now->histograms[STATS_HIST_LOCK_WAIT], 0.99)));
+    }
+
+    if (c[STATS_NET_RX_PACKETS] > 0 || c[STATS_NET_TX_PACKETS] > 0) {
+        out("  Network   rx %llu packets, %s", (unsigned long long)c[STATS_NET_RX_PACKETS],
+            format_bytes(a, sizeof(a), (double)c[STATS_NET_RX_BYTES]));
+        out("; tx %llu packets, %s", (unsigned long long)c[STATS_NET_TX_PACKETS],
+            format_bytes(b, sizeof(b), (double)c[STATS_NET_TX_BYTES]));
+        if (prev) {
+            out(" (%s/s in, ", format_bytes(a, sizeof(a),
+                stats_rate(c[STATS_NET_RX_BYTES], prev->counters[STATS_NET_RX_BYTES], seconds)));
+            out("%s/s out)", format_bytes(b, sizeof(b),
+                stats_rate(c[STATS_NET_TX_BYTES], prev->counters[STATS_NET_TX_BYTES], seconds)));
+        }
+        out("\n");
+    }
+
+    if (atomic_load(&page->dropped_threads) > 0) {
+        out("  %u threads not recorded (more than %d at once)\n",
+            atomic_load(&page->dropped_threads), STATS_MAX_SLOTS);
+    }
+    out("\n");
+}
+
+/**
+ * Take a snapshot of every process publishing statistics and print it
+ * @param out printf or printw
+ * @param snapshots In: previous snapshots; out: these ones
+ * @param count In: number of previous snapshots; out: number taken
+ */
+static void print_all_stats(PrintFn out, StatsSnapshot *snapshots, int *count) {
+    StatsSnapshot *current = malloc(STATS_VIEW_MAX * sizeof(*current));
+    pid_t pids[STATS_VIEW_MAX];
+    int found = stats_list(pids, STATS_VIEW_MAX);
+    int taken = 0;
+
+    if (!current) {
+        out("Out of memory\n");
+        return;
+    }
+    if (found <= 0) {
+        out("No running program is publishing statistics.\n"
+            "Start one, e.g. threads/thread_pool --bench or network/udp_server.\n");
+    }
+
+    for (int i = 0; i < found; i++) {
+        const stats_page_t *page = stats_attach(pids[i]);
+        const StatsSnapshot *prev = NULL;
+        StatsSnapshot *snapshot = &current[taken];
+
+        if (!page) {
+            continue;
+        }
+        snapshot->pid = pids[i];
+        snapshot->taken_ns = stats_now_ns();
+        stats_sum(page, &snapshot->totals);
+        for (int j = 0; j < *count; j++) {
+            if (snapshots[j].pid == pids[i]) {
+                prev = &snapshots[j];
+            }
+        }
+        print_stats(out, page, &snapshot->totals, prev ? &prev->totals : NULL,
+                    prev ? (snapshot->taken_ns - prev->taken_ns) / 1e9 : 0);
+        stats_detach(page);
+        taken++;
+    }
+
+    memcpy(snapshots, current, taken * sizeof(*current));
+    *count = taken;
+    free(current);
+}
+
+// Refresh the statistics of running programs until a key is pressed
+static void show_stats(void) {
+    StatsSnapshot *snapshots = malloc(STATS_VIEW_MAX * sizeof(*snapshots));
+    int count = 0;
+
+    if (!snapshots) {
+        perror("Failed to allocate statistics");
+        return;
+    }
+
+    timeout(STATS_REFRESH_MS);
+    do {
+        erase();
+        printw("Live Statistics (every %d ms, press any key to return)\n\n", STATS_REFRESH_MS);
+        print_all_stats(printw, snapshots, &count);
+        refresh();
+    } while (running && getch() == ERR);
+    timeout(-1);
+
+    // Hand the terminal back to the stdio menus
+    erase();
+    refresh();
+    free(snapshots);
+}
+
+/**
+ * Print the statistics once without ncurses
+ * @param seconds Interval for rates, 0 for totals only
+ * @return Exit status
+ */
+static int print_stats_once(int seconds) {
+    StatsSnapshot *snapshots = malloc(STATS_VIEW_MAX * sizeof(*snapshots));
+    int count = 0;
+
+    if (!snapshots) {
+        perror("Failed to allocate statistics");
+        return EXIT_FAILURE;
+    }
+    if (seconds > 0) {
+        // A silent first pass provides the baseline for the rates
+        print_all_stats(print_nothing, snapshots, &count);
+        sleep((unsigned int)seconds);
+    }
+    print_all_stats(printf, snapshots, &count);
+    free(snapshots);
+    return EXIT_SUCCESS;
+}
+
 // Function to log messages to a file
 static void log_message(const char *message) {
     FILE *log_file = fopen(LOG_FILE, "a");
@@ -238,7 +475,11 @@ void menu_action(const char *action) {
     log_message(action);
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--stats") == 0) {
+        return print_stats_once(argc > 2 ? atoi(argv[2]) : 0);
+    }
+
     // Set up signal handlers
     signal(SIGINT, handle_signal);
     signal(SIGTERM, handle_signal);